@@ -0,0 +1,50 @@
+#include "Benchmarks.h"
+
+#include "JobSystem.h"
+
+#include <cstring>
+
+std::vector<BenchmarkCase>& GetBenchmarkCases()
+{
+	static std::vector<BenchmarkCase> benchmarkCases;
+
+	return benchmarkCases;
+}
+
+std::filesystem::path GetSandboxDirectory()
+{
+	return "../Examples/Sandbox";
+}
+
+std::filesystem::path GetScratchDirectory()
+{
+	return std::filesystem::temp_directory_path() / "tsBenchmarks";
+}
+
+// Benchmarks [filter], only the ones whose name contains filter run
+int main(int argc, char** argv)
+{
+	const char* filter = argc > 1 ? argv[1] : "";
+
+	std::error_code error;
+	std::filesystem::remove_all(GetScratchDirectory(), error);
+	std::filesystem::create_directories(GetScratchDirectory(), error);
+
+	JobSystem::Init();
+
+	for (const auto& benchmarkCase : GetBenchmarkCases())
+	{
+		if (!std::strstr(benchmarkCase.Name, filter))
+			continue;
+
+		printf("\n[%s]\n", benchmarkCase.Name);
+
+		benchmarkCase.Function();
+	}
+
+	JobSystem::Shutdown();
+
+	std::filesystem::remove_all(GetScratchDirectory(), error);
+
+	return 0;
+}
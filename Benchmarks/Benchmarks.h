@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Timer.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <vector>
+
+// Micro-benchmarks for the CPU side of Core, meant for Release builds
+// Run from this directory, the Sandbox assets are read from ../Examples/Sandbox
+// Benchmarks register themselves through BENCHMARK() and print their own results
+
+struct BenchmarkCase
+{
+	const char* Name = nullptr;
+	void(*Function)() = nullptr;
+};
+
+std::vector<BenchmarkCase>& GetBenchmarkCases();
+
+struct BenchmarkRegistrar
+{
+	BenchmarkRegistrar(const char* name, void(*function)()) { GetBenchmarkCases().push_back({ name, function }); }
+};
+
+#define BENCHMARK(NAME) \
+static void NAME(); \
+static BenchmarkRegistrar NAME##Registrar(#NAME, NAME); \
+static void NAME()
+
+std::filesystem::path GetSandboxDirectory();
+// Emptied on every run, for the files and caches the benchmarks write
+std::filesystem::path GetScratchDirectory();
+
+// Best of runCount, in ms
+template<typename F>
+float MeasureBest(uint32_t runCount, F&& function)
+{
+	float best = FLT_MAX;
+
+	for (uint32_t i = 0; i < runCount; i++)
+	{
+		Timer timer;
+		function();
+
+		best = std::min(best, timer.ElapsedMS());
+	}
+
+	return best;
+}
+
+inline double ToMB(uint64_t size)
+{
+	return static_cast<double>(size) / (1024.0 * 1024.0);
+}
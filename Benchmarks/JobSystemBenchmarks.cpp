@@ -0,0 +1,107 @@
+#include "Benchmarks.h"
+
+#include "Thread.h"
+
+#include "Base.h"
+#include "JobSystem.h"
+
+#include <atomic>
+#include <thread>
+
+static constexpr uint32_t s_RunCount = 5;
+
+// Stands in for the job's work, xorshift so it can't be folded away
+static uint32_t Work(uint32_t seed, uint32_t iterations)
+{
+	seed |= 1;
+
+	for (uint32_t i = 0; i < iterations; i++)
+	{
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+	}
+
+	return seed;
+}
+
+// Jobs spread round-robin over threadCount Threads, the most the old class allowed
+// Starting the threads isn't timed, the JobSystem's workers are already running too
+static float RunOnThreads(uint32_t threadCount, uint32_t jobCount, uint32_t iterations, std::atomic<uint32_t>& sink)
+{
+	float best = FLT_MAX;
+
+	for (uint32_t run = 0; run < s_RunCount; run++)
+	{
+		std::vector<Scope<Thread>> threads(threadCount);
+
+		for (auto& thread : threads)
+		{
+			thread = CreateScope<Thread>();
+			thread->Start();
+		}
+
+		Timer timer;
+
+		for (uint32_t i = 0; i < jobCount; i++)
+			threads[i % threadCount]->Submit([i, iterations, &sink]() { sink.fetch_add(Work(i, iterations), std::memory_order_relaxed); });
+
+		// Waits for each queue to empty
+		for (auto& thread : threads)
+			thread->Stop();
+
+		best = std::min(best, timer.ElapsedMS());
+	}
+
+	return best;
+}
+
+static float RunOnJobSystem(uint32_t jobCount, uint32_t iterations, std::atomic<uint32_t>& sink)
+{
+	return MeasureBest(s_RunCount, [&]()
+		{
+			JobCounter counter;
+
+			for (uint32_t i = 0; i < jobCount; i++)
+				JobSystem::Execute([i, iterations, &sink]() { sink.fetch_add(Work(i, iterations), std::memory_order_relaxed); }, &counter);
+
+			JobSystem::WaitFor(counter);
+		});
+}
+
+// Job throughput from tiny jobs, where the queue overhead dominates, up to shader-compile sized ones
+BENCHMARK(JobSystem_VersusThread)
+{
+	struct Workload
+	{
+		const char* Name = nullptr;
+		uint32_t JobCount = 0;
+		uint32_t Iterations = 0;
+	};
+
+	static constexpr Workload workloads[] =
+	{
+		{ "tiny", 20000, 16 },
+		{ "small", 5000, 4096 },
+		{ "large", 64, 1 << 20 },
+	};
+
+	const uint32_t threadCount = JobSystem::GetWorkerCount() + 1;
+
+	printf("%u workers + the calling thread, best of %u runs, jobs/s\n", JobSystem::GetWorkerCount(), s_RunCount);
+	printf("%-8s %8s %14s %14s %14s %10s\n", "", "jobs", "1 Thread", "Thread x N", "JobSystem", "vs x N");
+
+	std::atomic<uint32_t> sink = 0;
+
+	for (const auto& workload : workloads)
+	{
+		const float single = RunOnThreads(1, workload.JobCount, workload.Iterations, sink);
+		const float perCore = RunOnThreads(threadCount, workload.JobCount, workload.Iterations, sink);
+		const float jobSystem = RunOnJobSystem(workload.JobCount, workload.Iterations, sink);
+
+		const auto perSecond = [&workload](float ms) { return workload.JobCount / (ms * 0.001); };
+
+		printf("%-8s %8u %14.0f %14.0f %14.0f %9.2fx\n", workload.Name, workload.JobCount,
+			perSecond(single), perSecond(perCore), perSecond(jobSystem), perCore / jobSystem);
+	}
+}
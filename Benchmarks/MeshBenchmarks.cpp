@@ -0,0 +1,165 @@
+#include "Benchmarks.h"
+
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "ObjParser.h"
+
+#include <fstream>
+
+static constexpr uint32_t s_RunCount = 3;
+
+// A gridSize x gridSize quad grid with v, vt, vn and v/vt/vn faces, close to what exporters write
+// Written once per run, around 70 MB at 768
+static std::filesystem::path WriteSyntheticObj(uint32_t gridSize)
+{
+	const auto path = GetScratchDirectory() / "Synthetic.obj";
+
+	if (std::filesystem::exists(path))
+		return path;
+
+	std::ofstream file(path, std::ios::binary);
+	char line[128];
+
+	const auto write = [&file, &line](int length) { file.write(line, length); };
+
+	for (uint32_t y = 0; y <= gridSize; y++)
+	{
+		for (uint32_t x = 0; x <= gridSize; x++)
+		{
+			const float u = static_cast<float>(x) / gridSize;
+			const float v = static_cast<float>(y) / gridSize;
+
+			write(snprintf(line, sizeof(line), "v %.6f %.6f %.6f\n", u * 100.0f - 50.0f, 0.25f * (x % 7), v * 100.0f - 50.0f));
+			write(snprintf(line, sizeof(line), "vt %.6f %.6f\n", u, v));
+		}
+	}
+
+	write(snprintf(line, sizeof(line), "vn 0.000000 1.000000 0.000000\n"));
+
+	for (uint32_t y = 0; y < gridSize; y++)
+	{
+		for (uint32_t x = 0; x < gridSize; x++)
+		{
+			// 1-based
+			const uint32_t a = y * (gridSize + 1) + x + 1;
+			const uint32_t b = a + gridSize + 1;
+
+			write(snprintf(line, sizeof(line), "f %u/%u/1 %u/%u/1 %u/%u/1 %u/%u/1\n", a, a, b, b, b + 1, b + 1, a + 1, a + 1));
+		}
+	}
+
+	return path;
+}
+
+static std::vector<std::filesystem::path> GetObjFiles()
+{
+	std::vector<std::filesystem::path> files;
+
+	for (const char* name : { "Xwing.obj", "VikingRoom.obj" })
+	{
+		const auto path = GetSandboxDirectory() / "Models" / name;
+
+		if (std::filesystem::exists(path))
+			files.push_back(path);
+		else
+			printf("%s not found, run from the Benchmarks directory\n", path.string().c_str());
+	}
+
+	files.push_back(WriteSyntheticObj(768));
+
+	return files;
+}
+
+static MeshBounds ComputeBounds(const std::vector<Vertex>& vertices)
+{
+	MeshBounds bounds = { vertices.front().Position, vertices.front().Position };
+
+	for (const auto& vertex : vertices)
+	{
+		bounds.Min = glm::min(bounds.Min, vertex.Position);
+		bounds.Max = glm::max(bounds.Max, vertex.Position);
+	}
+
+	return bounds;
+}
+
+// Page cache is warm for both, the parser's MB/s are what it does with the bytes
+BENCHMARK(Mesh_ObjParser)
+{
+	printf("best of %u runs\n", s_RunCount);
+	printf("%-16s %10s %10s %10s %10s\n", "", "MB", "vertices", "ms", "MB/s");
+
+	for (const auto& path : GetObjFiles())
+	{
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+
+		const float ms = MeasureBest(s_RunCount, [&]()
+			{
+				vertices.clear();
+				indices.clear();
+
+				ParseObj(path, vertices, indices);
+			});
+
+		const double size = ToMB(std::filesystem::file_size(path));
+
+		printf("%-16s %10.1f %10zu %10.2f %10.1f\n", path.filename().string().c_str(), size, vertices.size(), ms, size / (ms * 0.001));
+	}
+}
+
+// What Mesh::Create() does before the upload, without a cache and with one
+// Copies of the sources are used, the caches are written next to them
+BENCHMARK(Mesh_Cache)
+{
+	printf("best of %u runs\n", s_RunCount);
+	printf("%-16s %12s %12s %10s %10s\n", "", "parse ms", "+ optimize", "cached ms", "speedup");
+
+	for (const auto& source : GetObjFiles())
+	{
+		auto path = GetScratchDirectory() / source.filename();
+
+		if (source != path)
+			std::filesystem::copy_file(source, path, std::filesystem::copy_options::overwrite_existing);
+
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+
+		const float parse = MeasureBest(s_RunCount, [&]()
+			{
+				vertices.clear();
+				indices.clear();
+
+				ParseObj(path, vertices, indices);
+			});
+
+		const float cold = MeasureBest(s_RunCount, [&]()
+			{
+				vertices.clear();
+				indices.clear();
+
+				ParseObj(path, vertices, indices);
+				MeshOptimizer::Optimize(vertices, indices);
+				MeshCache::Write(path, vertices, indices, ComputeBounds(vertices));
+			});
+
+		// Summing the indices touches every page of the mapping
+		uint64_t sum = 0;
+
+		const float cached = MeasureBest(s_RunCount, [&]()
+			{
+				const auto cache = MeshCache::Open(path);
+
+				if (!cache)
+					return;
+
+				for (const uint32_t index : cache->GetIndices())
+					sum += index;
+			});
+
+		printf("%-16s %12.2f %12.2f %10.2f %9.1fx\n", path.filename().string().c_str(), parse, cold, cached, cold / cached);
+
+		if (0 == sum)
+			printf("\tNo cache for %s\n", path.string().c_str());
+	}
+}
@@ -0,0 +1,124 @@
+#include "Benchmarks.h"
+
+#include "Buffer.h"
+#include "ReflectionCache.h"
+#include "ShaderCompiler.h"
+#include "Utils.h"
+
+static constexpr uint32_t s_RunCount = 3;
+
+// The shaders of every example
+static std::vector<ShaderSource> GetShaderSources()
+{
+	std::vector<ShaderSource> sources;
+
+	for (const char* example : { "Sandbox", "Cube", "Wireframe" })
+	{
+		for (const auto& path : ShaderCompiler::GetSources(GetSandboxDirectory().parent_path() / example / "Shaders"))
+		{
+			Buffer code;
+
+			if (!ReadFromFile(code, path))
+				continue;
+
+			auto& source = sources.emplace_back();
+			source.Stage = ShaderCompiler::GetStage(path);
+			source.Name = path.string();
+			source.Code = std::string(code.As<const char*>(), code.GetSize());
+
+			code.Release();
+		}
+	}
+
+	if (sources.empty())
+		printf("No shaders found, run from the Benchmarks directory\n");
+
+	return sources;
+}
+
+// Size and compile time of each spirv-opt preset, the ShaderCache is disabled so everything is compiled
+// What the smaller modules save in pipeline creation and in the driver needs a device, it isn't measured here
+BENCHMARK(Shader_Optimization)
+{
+	const auto sources = GetShaderSources();
+
+	if (sources.empty())
+		return;
+
+	struct Preset
+	{
+		const char* Name = nullptr;
+		ShaderOptimization Optimization = ShaderOptimization::NONE;
+	};
+
+	static constexpr Preset presets[] =
+	{
+		{ "none", ShaderOptimization::NONE },
+		{ "performance", ShaderOptimization::PERFORMANCE },
+		{ "size", ShaderOptimization::SIZE },
+	};
+
+	printf("%zu shaders, one batch, best of %u runs\n", sources.size(), s_RunCount);
+	printf("%-12s %10s %14s %12s\n", "", "words", "instructions", "compile ms");
+
+	for (const auto& preset : presets)
+	{
+		ShaderCompiler::Init({}, preset.Optimization);
+
+		std::vector<CompiledShader> results;
+
+		const float ms = MeasureBest(s_RunCount, [&]() { results = ShaderCompiler::CompileBatch(sources); });
+
+		SpirVStatistics total;
+
+		for (const auto& result : results)
+		{
+			const auto stats = ShaderCompiler::GetStatistics(result.SpirV);
+
+			total.WordCount += stats.WordCount;
+			total.InstructionCount += stats.InstructionCount;
+		}
+
+		printf("%-12s %10u %14u %12.2f\n", preset.Name, total.WordCount, total.InstructionCount, ms);
+
+		ShaderCompiler::Shutdown();
+	}
+}
+
+// What a warm ReflectionCache skips, per module
+// The cache itself is keyed by ShaderModules, which need a device, it logs its hits, misses and SPIRV-Reflect time when destroyed
+BENCHMARK(Shader_Reflection)
+{
+	const auto sources = GetShaderSources();
+
+	if (sources.empty())
+		return;
+
+	ShaderCompiler::Init({}, ShaderOptimization::NONE);
+
+	auto results = ShaderCompiler::CompileBatch(sources);
+
+	ShaderCompiler::Shutdown();
+
+	printf("SPIRV-Reflect, best of %u runs\n", s_RunCount);
+	printf("%-20s %10s %10s\n", "", "words", "ms");
+
+	float total = 0.0f;
+
+	for (size_t i = 0; i < sources.size(); i++)
+	{
+		auto& spirv = results[i].SpirV;
+
+		if (spirv.empty())
+			continue;
+
+		const Buffer code(spirv.data(), spirv.size() * sizeof(spirv[0]));
+
+		const float ms = MeasureBest(s_RunCount, [&]() { ReflectionCache::Reflect(sources[i].Stage, code); });
+		total += ms;
+
+		printf("%-20s %10zu %10.3f\n", std::filesystem::path(sources[i].Name).filename().string().c_str(), spirv.size(), ms);
+	}
+
+	printf("%-20s %10s %10.3f\n", "total", "", total);
+}
@@ -0,0 +1,177 @@
+#include "Benchmarks.h"
+
+#include "JobSystem.h"
+#include "MipGenerator.h"
+
+#include <stb_image.h>
+
+#include <cstring>
+#include <span>
+#include <string>
+
+static constexpr uint32_t s_RunCount = 3;
+
+struct Image
+{
+	std::string Path;
+	int Width = 0;
+	int Height = 0;
+};
+
+static std::vector<Image> GetImages(std::initializer_list<const char*> names)
+{
+	std::vector<Image> images;
+
+	for (const char* name : names)
+	{
+		const auto path = GetSandboxDirectory() / "Textures" / name;
+
+		Image image;
+		image.Path = path.string();
+
+		int channels = 0;
+
+		if (stbi_info(image.Path.c_str(), &image.Width, &image.Height, &channels))
+			images.push_back(image);
+		else
+			printf("%s not found, run from the Benchmarks directory\n", image.Path.c_str());
+	}
+
+	return images;
+}
+
+// Into what stands in for the staging memory, same as Texture.cpp
+static void Decode(const Image& image, uint8_t* dst)
+{
+	int width = 0, height = 0, channels = 0;
+
+	if (stbi_uc* data = stbi_load(image.Path.c_str(), &width, &height, &channels, STBI_rgb_alpha))
+	{
+		std::memcpy(dst, data, static_cast<size_t>(width) * height * 4);
+		stbi_image_free(data);
+	}
+}
+
+// Before: a full decode for the size, another one for the pixels, one image after the other
+static void DecodeTwice(std::span<const Image> images, std::vector<uint8_t>& staging)
+{
+	size_t offset = 0;
+
+	for (const auto& image : images)
+	{
+		int width = 0, height = 0, channels = 0;
+
+		stbi_uc* probe = stbi_load(image.Path.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+		stbi_image_free(probe);
+
+		Decode(image, staging.data() + offset);
+		offset += static_cast<size_t>(width) * height * 4;
+	}
+}
+
+// stbi_info() for the size, which GetImages() did, then a single decode each
+static void DecodeOnce(std::span<const Image> images, std::vector<uint8_t>& staging, bool parallel)
+{
+	std::vector<size_t> offsets(images.size());
+
+	for (size_t i = 1; i < images.size(); i++)
+		offsets[i] = offsets[i - 1] + static_cast<size_t>(images[i - 1].Width) * images[i - 1].Height * 4;
+
+	if (!parallel)
+	{
+		for (size_t i = 0; i < images.size(); i++)
+			Decode(images[i], staging.data() + offsets[i]);
+
+		return;
+	}
+
+	JobSystem::ParallelFor(static_cast<uint32_t>(images.size()), 1, [&](uint32_t i) { Decode(images[i], staging.data() + offsets[i]); });
+}
+
+static size_t GetTotalSize(std::span<const Image> images)
+{
+	size_t size = 0;
+
+	for (const auto& image : images)
+		size += static_cast<size_t>(image.Width) * image.Height * 4;
+
+	return size;
+}
+
+BENCHMARK(Texture_Decode)
+{
+	struct Batch
+	{
+		const char* Name = nullptr;
+		std::vector<Image> Images;
+	};
+
+	const Batch batches[] =
+	{
+		{ "Cubemap", GetImages({ "sky/right.png", "sky/left.png", "sky/top.png", "sky/bottom.png", "sky/front.png", "sky/back.png" }) },
+		{ "Sandbox", GetImages({ "VikingRoom.png", "XwingColors.png", "Fonts.png" }) },
+	};
+
+	printf("best of %u runs, ms\n", s_RunCount);
+	printf("%-10s %8s %14s %14s %14s\n", "", "images", "decode twice", "decode once", "in parallel");
+
+	for (const auto& batch : batches)
+	{
+		if (batch.Images.empty())
+			continue;
+
+		std::vector<uint8_t> staging(GetTotalSize(batch.Images));
+
+		const float twice = MeasureBest(s_RunCount, [&]() { DecodeTwice(batch.Images, staging); });
+		const float once = MeasureBest(s_RunCount, [&]() { DecodeOnce(batch.Images, staging, false); });
+		const float parallel = MeasureBest(s_RunCount, [&]() { DecodeOnce(batch.Images, staging, true); });
+
+		printf("%-10s %8zu %14.2f %14.2f %14.2f   %.2fx from the single decode, %.2fx overall\n", batch.Name, batch.Images.size(),
+			twice, once, parallel, twice / once, twice / parallel);
+	}
+}
+
+// The GPU blit chain it replaces needs a device, it isn't measured here
+BENCHMARK(Texture_MipGenerator)
+{
+	const auto images = GetImages({ "VikingRoom.png" });
+	const auto cubemap = GetImages({ "sky/right.png", "sky/left.png", "sky/top.png", "sky/bottom.png", "sky/front.png", "sky/back.png" });
+
+	if (images.empty() || cubemap.empty())
+		return;
+
+	struct Source
+	{
+		const char* Name = nullptr;
+		std::vector<uint8_t> Pixels;
+		uint32_t Width = 0;
+		uint32_t Height = 0;
+		uint32_t LayerCount = 0;
+	};
+
+	Source sources[] =
+	{
+		{ "VikingRoom", std::vector<uint8_t>(GetTotalSize(images)), static_cast<uint32_t>(images[0].Width), static_cast<uint32_t>(images[0].Height), 1 },
+		{ "Cubemap", std::vector<uint8_t>(GetTotalSize(cubemap)), static_cast<uint32_t>(cubemap[0].Width), static_cast<uint32_t>(cubemap[0].Height), 6 },
+	};
+
+	DecodeOnce(images, sources[0].Pixels, true);
+	DecodeOnce(cubemap, sources[1].Pixels, true);
+
+	printf("best of %u runs, ms\n", s_RunCount);
+	printf("%-12s %12s %10s %10s %10s %10s\n", "", "size", "box", "box sRGB", "kaiser", "kai. sRGB");
+
+	for (const auto& source : sources)
+	{
+		const uint32_t levelCount = MipGenerator::GetLevelCount(source.Width, source.Height);
+
+		const auto measure = [&source, levelCount](Format format, MipFilter filter)
+			{
+				return MeasureBest(s_RunCount, [&]() { MipGenerator::Generate(source.Pixels.data(), source.Width, source.Height, source.LayerCount, format, filter, levelCount); });
+			};
+
+		printf("%-12s %6ux%-4ux%u %10.2f %10.2f %10.2f %10.2f\n", source.Name, source.Width, source.Height, source.LayerCount,
+			measure(Format::RGBA_8_UNORM, MipFilter::BOX), measure(Format::RGBA_8_SRGB, MipFilter::BOX),
+			measure(Format::RGBA_8_UNORM, MipFilter::KAISER), measure(Format::RGBA_8_SRGB, MipFilter::KAISER));
+	}
+}
@@ -6,6 +6,8 @@
 #include <mutex>
 #include <condition_variable>
 
+// The single-queue Thread the JobSystem replaced, as it was, kept as the baseline of JobSystemBenchmarks.cpp
+// Runs each job while holding m_QueueMutex, a Thread can't be restarted after Stop()
 class Thread
 {
 	enum class State : int { IDLE = 0, WORKING };
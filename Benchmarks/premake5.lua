@@ -0,0 +1,32 @@
+project "Benchmarks"
+	kind "ConsoleApp"
+
+	targetdir ("%{wks.location}/bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("%{wks.location}/bin-int/" .. outputdir .. "/%{prj.name}")
+
+	files
+	{
+		"*.h",
+		"*.cpp"
+	}
+
+	includedirs
+	{
+		"%{wks.location}/Core/src",
+		"%{IncludeDir.glm}",
+		"%{IncludeDir.stb}",
+	}
+
+	links
+	{
+		"Core",
+	}
+
+	filter "system:windows"
+		systemversion "latest"
+
+	filter "configurations:Debug"
+		symbols "On"
+
+	filter "configurations:Release"
+		optimize "On"
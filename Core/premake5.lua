@@ -47,11 +47,6 @@ project "Core"
 		"SPIRV-Reflect",
 	}
 
-	defines
-	{
-		"GLSLANG_VALIDATOR_EXECUTABLE_RELATIVE_PATH=" .."\"" .. "%{BinDir.glslang}" .. "\""
-	}
-
 	filter "configurations:Debug"
 		runtime "Debug"
 		symbols "on"
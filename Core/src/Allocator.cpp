@@ -0,0 +1,433 @@
+#include "Allocator.h"
+
+#include "Device.h"
+
+#include "Log.h"
+
+#include <volk.h>
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+
+static constexpr const char* s_LogTag = "[Allocator]";
+
+static constexpr VkDeviceSize s_DefaultBlockSize = 64ull * 1024 * 1024;
+// Allocations bigger than this fraction of a block get their own VkDeviceMemory
+static constexpr VkDeviceSize s_DedicatedThresholdDivisor = 2;
+
+static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+struct DeviceMemoryBlock
+{
+	VkDeviceMemory Memory = nullptr;
+	void* MappedData = nullptr;
+	MemoryBlock Bookkeeping;
+
+	// Pool the block lives in, std::map nodes don't move
+	std::vector<Scope<DeviceMemoryBlock>>* Pool = nullptr;
+
+	DeviceMemoryBlock(VkDeviceMemory memory, void* mappedData, VkDeviceSize size, std::vector<Scope<DeviceMemoryBlock>>* pool)
+		: Memory(memory), MappedData(mappedData), Bookkeeping(size), Pool(pool)
+	{
+	}
+};
+
+DeviceAllocator::DeviceAllocator(const Device& device)
+	: m_Device(device)
+{
+	VkPhysicalDeviceMemoryProperties memoryProperties;
+	vkGetPhysicalDeviceMemoryProperties(m_Device.GetPhysicalDevice().GetHandle(), &memoryProperties);
+
+	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+		m_MemoryTypes.push_back({ .PropertyFlags = memoryProperties.memoryTypes[i].propertyFlags, .HeapIndex = memoryProperties.memoryTypes[i].heapIndex });
+
+	for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++)
+		m_HeapSizes.push_back(memoryProperties.memoryHeaps[i].size);
+}
+
+DeviceAllocator::~DeviceAllocator()
+{
+	const auto& vkDevice = m_Device.GetHandle();
+
+	for (auto& [_, blocks] : m_Pools)
+	{
+		for (auto& block : blocks)
+		{
+			if (!block->Bookkeeping.IsEmpty())
+				LOG_TAGGED(s_LogTag, "Block destroyed with %i live allocation(s)", block->Bookkeeping.GetAllocationCount());
+
+			if (block->MappedData)
+				vkUnmapMemory(vkDevice, block->Memory);
+
+			vkFreeMemory(vkDevice, block->Memory, nullptr);
+		}
+	}
+
+	m_Pools.clear();
+}
+
+Allocation DeviceAllocator::AllocateBuffer(VkBuffer buffer, VkMemoryPropertyFlags properties)
+{
+	ASSERT(buffer);
+
+	const auto& vkDevice = m_Device.GetHandle();
+
+	VkBufferMemoryRequirementsInfo2 requirementsInfo;
+	ZeroInitVkStruct(requirementsInfo, VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2);
+	requirementsInfo.buffer = buffer;
+
+	VkMemoryDedicatedRequirements dedicatedRequirements;
+	ZeroInitVkStruct(dedicatedRequirements, VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS);
+
+	VkMemoryRequirements2 requirements;
+	ZeroInitVkStruct(requirements, VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2);
+	requirements.pNext = &dedicatedRequirements;
+
+	vkGetBufferMemoryRequirements2(vkDevice, &requirementsInfo, &requirements);
+
+	const bool prefersDedicated = dedicatedRequirements.prefersDedicatedAllocation || dedicatedRequirements.requiresDedicatedAllocation;
+
+	Allocation allocation = Allocate(requirements.memoryRequirements, properties, ResourceKind::BUFFER, prefersDedicated, buffer, VK_NULL_HANDLE);
+	ASSERT(allocation, "Failed to allocate buffer memory");
+
+	VkResult result = vkBindBufferMemory(vkDevice, buffer, allocation.Memory, allocation.Offset);
+	VK_CHECK_RESULT(result);
+
+	return allocation;
+}
+
+Allocation DeviceAllocator::AllocateImage(VkImage image, VkMemoryPropertyFlags properties)
+{
+	ASSERT(image);
+
+	const auto& vkDevice = m_Device.GetHandle();
+
+	VkImageMemoryRequirementsInfo2 requirementsInfo;
+	ZeroInitVkStruct(requirementsInfo, VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2);
+	requirementsInfo.image = image;
+
+	VkMemoryDedicatedRequirements dedicatedRequirements;
+	ZeroInitVkStruct(dedicatedRequirements, VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS);
+
+	VkMemoryRequirements2 requirements;
+	ZeroInitVkStruct(requirements, VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2);
+	requirements.pNext = &dedicatedRequirements;
+
+	vkGetImageMemoryRequirements2(vkDevice, &requirementsInfo, &requirements);
+
+	const bool prefersDedicated = dedicatedRequirements.prefersDedicatedAllocation || dedicatedRequirements.requiresDedicatedAllocation;
+
+	Allocation allocation = Allocate(requirements.memoryRequirements, properties, ResourceKind::IMAGE, prefersDedicated, VK_NULL_HANDLE, image);
+	ASSERT(allocation, "Failed to allocate image memory");
+
+	VkResult result = vkBindImageMemory(vkDevice, image, allocation.Memory, allocation.Offset);
+	VK_CHECK_RESULT(result);
+
+	return allocation;
+}
+
+void DeviceAllocator::Free(Allocation& allocation)
+{
+	if (!allocation)
+		return;
+
+	std::scoped_lock lock(m_Mutex);
+
+	if (allocation.IsDedicated())
+	{
+		auto& stats = m_DedicatedStatistics[allocation.MemoryTypeIndex];
+		stats.Count--;
+		stats.Size -= allocation.Size;
+
+		if (allocation.MappedData)
+			vkUnmapMemory(m_Device.GetHandle(), allocation.Memory);
+
+		vkFreeMemory(m_Device.GetHandle(), allocation.Memory, nullptr);
+	}
+	else
+	{
+		DeviceMemoryBlock* block = allocation.Block;
+		block->Bookkeeping.Free(allocation.Offset, allocation.Size);
+
+		// Keep one empty block around per pool, so create/destroy patterns don't hit the driver every time
+		if (block->Bookkeeping.IsEmpty())
+		{
+			auto& blocks = *block->Pool;
+
+			const auto emptyCount = std::ranges::count_if(blocks, [](const auto& ptr) { return ptr->Bookkeeping.IsEmpty(); });
+
+			if (emptyCount > 1)
+			{
+				if (block->MappedData)
+					vkUnmapMemory(m_Device.GetHandle(), block->Memory);
+
+				vkFreeMemory(m_Device.GetHandle(), block->Memory, nullptr);
+
+				std::erase_if(blocks, [block](const auto& ptr) { return ptr.get() == block; });
+			}
+		}
+	}
+
+	allocation = {};
+}
+
+void DeviceAllocator::Flush(const Allocation& allocation, VkDeviceSize offset, VkDeviceSize size) const
+{
+	VkMappedMemoryRange range;
+	ZeroInitVkStruct(range, VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE);
+
+	if (!GetNonCoherentRange(allocation, offset, size, range.offset, range.size))
+		return;
+
+	range.memory = allocation.Memory;
+
+	VkResult result = vkFlushMappedMemoryRanges(m_Device.GetHandle(), 1, &range);
+	VK_CHECK_RESULT(result);
+}
+
+void DeviceAllocator::Invalidate(const Allocation& allocation, VkDeviceSize offset, VkDeviceSize size) const
+{
+	VkMappedMemoryRange range;
+	ZeroInitVkStruct(range, VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE);
+
+	if (!GetNonCoherentRange(allocation, offset, size, range.offset, range.size))
+		return;
+
+	range.memory = allocation.Memory;
+
+	VkResult result = vkInvalidateMappedMemoryRanges(m_Device.GetHandle(), 1, &range);
+	VK_CHECK_RESULT(result);
+}
+
+std::vector<HeapStatistics> DeviceAllocator::GetStatistics() const
+{
+	std::scoped_lock lock(m_Mutex);
+
+	std::vector<HeapStatistics> statistics(m_HeapSizes.size());
+	std::vector<VkDeviceSize> totalFreeSizes(statistics.size(), 0);
+
+	for (uint32_t i = 0; auto & stats : statistics)
+	{
+		stats.HeapIndex = i;
+		stats.HeapSize = m_HeapSizes[i];
+
+		i++;
+	}
+
+	for (const auto& [key, blocks] : m_Pools)
+	{
+		auto& stats = statistics[GetHeapIndex(key.first)];
+
+		for (const auto& block : blocks)
+		{
+			const auto& bookkeeping = block->Bookkeeping;
+
+			stats.AllocatedSize += bookkeeping.GetSize();
+			stats.UsedSize += bookkeeping.GetUsedSize();
+			stats.BlockCount++;
+			stats.AllocationCount += bookkeeping.GetAllocationCount();
+			stats.FreeRangeCount += bookkeeping.GetFreeRangeCount();
+			stats.LargestFreeRange = std::max(stats.LargestFreeRange, bookkeeping.GetLargestFreeRange());
+
+			totalFreeSizes[stats.HeapIndex] += bookkeeping.GetSize() - bookkeeping.GetUsedSize();
+		}
+	}
+
+	for (const auto& [memoryTypeIndex, dedicated] : m_DedicatedStatistics)
+	{
+		auto& stats = statistics[GetHeapIndex(memoryTypeIndex)];
+
+		stats.AllocatedSize += dedicated.Size;
+		stats.UsedSize += dedicated.Size;
+		stats.DedicatedCount += dedicated.Count;
+		stats.AllocationCount += dedicated.Count;
+	}
+
+	for (auto& stats : statistics)
+	{
+		const VkDeviceSize totalFree = totalFreeSizes[stats.HeapIndex];
+
+		stats.Fragmentation = totalFree > 0 ? 1.0f - float(stats.LargestFreeRange) / float(totalFree) : 0.0f;
+	}
+
+	if (m_Device.IsExtensionEnabled(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME))
+	{
+		VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties;
+		ZeroInitVkStruct(budgetProperties, VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT);
+
+		VkPhysicalDeviceMemoryProperties2 memoryProperties;
+		ZeroInitVkStruct(memoryProperties, VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2);
+
+		memoryProperties.pNext = &budgetProperties;
+
+		// Cheap, the driver keeps these up to date
+		vkGetPhysicalDeviceMemoryProperties2(m_Device.GetPhysicalDevice().GetHandle(), &memoryProperties);
+
+		for (auto& stats : statistics)
+		{
+			stats.Budget = budgetProperties.heapBudget[stats.HeapIndex];
+			stats.Usage = budgetProperties.heapUsage[stats.HeapIndex];
+		}
+	}
+
+	return statistics;
+}
+
+uint32_t DeviceAllocator::FindHeapIndex(VkMemoryPropertyFlags properties) const
+{
+	return GetHeapIndex(m_Device.GetPhysicalDevice().GetMemoryType(~0U, properties));
+}
+
+void DeviceAllocator::LogStatistics() const
+{
+	constexpr float toMiB = 1.0f / (1024.0f * 1024.0f);
+
+	for (const auto& stats : GetStatistics())
+	{
+		if (0 == stats.AllocatedSize)
+			continue;
+
+		LOG_TAGGED(s_LogTag, "Heap #%i: %.2f/%.2f MiB used of %.2f MiB, blocks: %i, dedicated: %i, allocations: %i, fragmentation: %.2f",
+			stats.HeapIndex, stats.UsedSize * toMiB, stats.AllocatedSize * toMiB, stats.HeapSize * toMiB,
+			stats.BlockCount, stats.DedicatedCount, stats.AllocationCount, stats.Fragmentation);
+	}
+}
+
+Allocation DeviceAllocator::Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, ResourceKind kind, bool prefersDedicated, VkBuffer buffer, VkImage image)
+{
+	std::scoped_lock lock(m_Mutex);
+
+	const uint32_t memoryTypeIndex = m_Device.GetPhysicalDevice().GetMemoryType(requirements.memoryTypeBits, properties);
+	const VkMemoryPropertyFlags propertyFlags = m_MemoryTypes[memoryTypeIndex].PropertyFlags;
+	const VkDeviceSize blockSize = GetBlockSize(memoryTypeIndex);
+
+	if (prefersDedicated || requirements.size > blockSize / s_DedicatedThresholdDivisor)
+		return AllocateDedicated(requirements, memoryTypeIndex, buffer, image);
+
+	VkDeviceSize size = requirements.size;
+	VkDeviceSize alignment = requirements.alignment;
+
+	if ((propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) && !(propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT))
+		AlignToAtom(size, alignment, m_Device.GetPhysicalDevice().GetProperties().limits.nonCoherentAtomSize);
+
+	auto& blocks = m_Pools[{ memoryTypeIndex, kind }];
+
+	for (auto& block : blocks)
+	{
+		const auto offset = block->Bookkeeping.Allocate(size, alignment);
+
+		if (offset.has_value())
+			return { .Memory = block->Memory, .Offset = offset.value(), .Size = size, .MemoryTypeIndex = memoryTypeIndex,
+				.PropertyFlags = propertyFlags, .MappedData = block->MappedData ? static_cast<char*>(block->MappedData) + offset.value() : nullptr, .Block = block.get() };
+	}
+
+	VkMemoryAllocateInfo allocInfo;
+	ZeroInitVkStruct(allocInfo, VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO);
+
+	allocInfo.allocationSize = blockSize;
+	allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+	VkDeviceMemory memory = VK_NULL_HANDLE;
+
+	VkResult result = vkAllocateMemory(m_Device.GetHandle(), &allocInfo, nullptr, &memory);
+	VK_CHECK_RESULT(result);
+
+	if (VK_SUCCESS != result)
+		return {};
+
+	LOG_TAGGED(s_LogTag, "New %s block: %.2f MiB, memory type #%i", kind == ResourceKind::BUFFER ? "buffer" : "image",
+		blockSize / (1024.0f * 1024.0f), memoryTypeIndex);
+
+	auto& block = blocks.emplace_back(CreateScope<DeviceMemoryBlock>(memory, MapIfHostVisible(memory, memoryTypeIndex), blockSize, &blocks));
+
+	const auto offset = block->Bookkeeping.Allocate(size, alignment);
+	ASSERT(offset.has_value());
+
+	return { .Memory = block->Memory, .Offset = offset.value(), .Size = size, .MemoryTypeIndex = memoryTypeIndex,
+		.PropertyFlags = propertyFlags, .MappedData = block->MappedData ? static_cast<char*>(block->MappedData) + offset.value() : nullptr, .Block = block.get() };
+}
+
+Allocation DeviceAllocator::AllocateDedicated(const VkMemoryRequirements& requirements, uint32_t memoryTypeIndex, VkBuffer buffer, VkImage image)
+{
+	VkMemoryDedicatedAllocateInfo dedicatedInfo;
+	ZeroInitVkStruct(dedicatedInfo, VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO);
+
+	dedicatedInfo.buffer = buffer;
+	dedicatedInfo.image = image;
+
+	VkMemoryAllocateInfo allocInfo;
+	ZeroInitVkStruct(allocInfo, VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO);
+
+	allocInfo.pNext = &dedicatedInfo;
+	allocInfo.allocationSize = requirements.size;
+	allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+	VkDeviceMemory memory = VK_NULL_HANDLE;
+
+	VkResult result = vkAllocateMemory(m_Device.GetHandle(), &allocInfo, nullptr, &memory);
+	VK_CHECK_RESULT(result);
+
+	if (VK_SUCCESS != result)
+		return {};
+
+	auto& stats = m_DedicatedStatistics[memoryTypeIndex];
+	stats.Count++;
+	stats.Size += requirements.size;
+
+	return { .Memory = memory, .Offset = 0, .Size = requirements.size, .MemoryTypeIndex = memoryTypeIndex,
+		.PropertyFlags = m_MemoryTypes[memoryTypeIndex].PropertyFlags, .MappedData = MapIfHostVisible(memory, memoryTypeIndex), .Block = nullptr };
+}
+
+void* DeviceAllocator::MapIfHostVisible(VkDeviceMemory memory, uint32_t memoryTypeIndex) const
+{
+	if (!(m_MemoryTypes[memoryTypeIndex].PropertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT))
+		return nullptr;
+
+	void* mappedData = nullptr;
+
+	VkResult result = vkMapMemory(m_Device.GetHandle(), memory, 0, VK_WHOLE_SIZE, 0, &mappedData);
+	VK_CHECK_RESULT(result);
+	ASSERT(mappedData, "Failed to map memory");
+
+	return mappedData;
+}
+
+bool DeviceAllocator::GetNonCoherentRange(const Allocation& allocation, VkDeviceSize offset, VkDeviceSize size, VkDeviceSize& alignedOffset, VkDeviceSize& alignedSize) const
+{
+	if (!allocation.IsMapped() || (allocation.PropertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT))
+		return false;
+
+	if (VK_WHOLE_SIZE == size)
+		size = allocation.Size - offset;
+
+	ASSERT(offset + size <= allocation.Size);
+
+	const VkDeviceSize atomSize = m_Device.GetPhysicalDevice().GetProperties().limits.nonCoherentAtomSize;
+	const VkDeviceSize memorySize = allocation.Block ? allocation.Block->Bookkeeping.GetSize() : allocation.Size;
+
+	const VkDeviceSize begin = allocation.Offset + offset;
+	const VkDeviceSize end = std::min(AlignUp(begin + size, atomSize), memorySize);
+
+	alignedOffset = begin / atomSize * atomSize;
+	alignedSize = end - alignedOffset;
+
+	return true;
+}
+
+VkDeviceSize DeviceAllocator::GetBlockSize(uint32_t memoryTypeIndex) const
+{
+	const VkDeviceSize heapSize = m_HeapSizes[GetHeapIndex(memoryTypeIndex)];
+
+	// Small heaps (e.g. 256 MiB BAR) shouldn't be eaten by a couple of blocks
+	return std::min(s_DefaultBlockSize, heapSize / 8);
+}
+
+uint32_t DeviceAllocator::GetHeapIndex(uint32_t memoryTypeIndex) const
+{
+	ASSERT(memoryTypeIndex < m_MemoryTypes.size());
+
+	return m_MemoryTypes[memoryTypeIndex].HeapIndex;
+}
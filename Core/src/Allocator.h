@@ -0,0 +1,125 @@
+#pragma once
+
+#include "Base.h"
+
+#include "VK.h"
+
+#include "MemoryBlock.h"
+
+#include <vector>
+#include <map>
+#include <mutex>
+
+class Device;
+
+struct DeviceMemoryBlock;
+
+struct Allocation
+{
+	VkDeviceMemory Memory = nullptr;
+	VkDeviceSize Offset = 0;
+	// Can be larger than requested, non-coherent memory is padded to whole nonCoherentAtomSize atoms
+	VkDeviceSize Size = 0;
+	uint32_t MemoryTypeIndex = ~0;
+	// Property flags of the memory type, can be a superset of the requested ones
+	VkMemoryPropertyFlags PropertyFlags = 0;
+
+	// Points at Offset, host-visible memory stays mapped for the lifetime of the block
+	void* MappedData = nullptr;
+
+	// nullptr when the allocation owns its VkDeviceMemory (dedicated)
+	DeviceMemoryBlock* Block = nullptr;
+
+	explicit operator bool() const { return Memory; }
+
+	bool IsDedicated() const { return Memory && !Block; }
+	bool IsMapped() const { return MappedData; }
+};
+
+struct HeapStatistics
+{
+	uint32_t HeapIndex = 0;
+	VkDeviceSize HeapSize = 0;
+
+	// Memory requested from the driver (blocks + dedicated allocations)
+	VkDeviceSize AllocatedSize = 0;
+	// Memory handed out to resources
+	VkDeviceSize UsedSize = 0;
+
+	uint32_t BlockCount = 0;
+	uint32_t DedicatedCount = 0;
+	uint32_t AllocationCount = 0;
+
+	uint32_t FreeRangeCount = 0;
+	VkDeviceSize LargestFreeRange = 0;
+
+	// 0 when all free space in the blocks is one contiguous range, approaches 1 as it gets scattered
+	float Fragmentation = 0.0f;
+
+	// From VK_EXT_memory_budget, 0 without it
+	// Usage is the whole process' (other allocators, the driver), Budget is how much it can use before things get paged out
+	VkDeviceSize Budget = 0;
+	VkDeviceSize Usage = 0;
+};
+
+// Sub-allocates GBuffer and Image2D memory from large blocks, one pool per memory type and resource kind
+// Buffers and images never share a block, so bufferImageGranularity can be ignored
+class DeviceAllocator
+{
+	enum class ResourceKind : int { BUFFER = 0, IMAGE };
+
+	struct DedicatedStatistics
+	{
+		uint32_t Count = 0;
+		VkDeviceSize Size = 0;
+	};
+public:
+	DeviceAllocator(const Device& device);
+	~DeviceAllocator();
+
+	DELETE_COPY_AND_MOVE(DeviceAllocator);
+
+	// Allocates and binds memory to the resource
+	Allocation AllocateBuffer(VkBuffer buffer, VkMemoryPropertyFlags properties);
+	Allocation AllocateImage(VkImage image, VkMemoryPropertyFlags properties);
+
+	void Free(Allocation& allocation);
+
+	// No-ops for HOST_COHERENT memory, offset and size are relative to the allocation
+	void Flush(const Allocation& allocation, VkDeviceSize offset, VkDeviceSize size) const;
+	void Invalidate(const Allocation& allocation, VkDeviceSize offset, VkDeviceSize size) const;
+
+	std::vector<HeapStatistics> GetStatistics() const;
+	void LogStatistics() const;
+
+	// Heap of the first memory type with these properties
+	uint32_t FindHeapIndex(VkMemoryPropertyFlags properties) const;
+private:
+	Allocation Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, ResourceKind kind, bool prefersDedicated, VkBuffer buffer, VkImage image);
+	Allocation AllocateDedicated(const VkMemoryRequirements& requirements, uint32_t memoryTypeIndex, VkBuffer buffer, VkImage image);
+
+	void* MapIfHostVisible(VkDeviceMemory memory, uint32_t memoryTypeIndex) const;
+	// Expands the range to nonCoherentAtomSize, as required by vkFlushMappedMemoryRanges/vkInvalidateMappedMemoryRanges
+	bool GetNonCoherentRange(const Allocation& allocation, VkDeviceSize offset, VkDeviceSize size, VkDeviceSize& alignedOffset, VkDeviceSize& alignedSize) const;
+
+	VkDeviceSize GetBlockSize(uint32_t memoryTypeIndex) const;
+	uint32_t GetHeapIndex(uint32_t memoryTypeIndex) const;
+private:
+	const Device& m_Device;
+
+	// Copied from VkPhysicalDeviceMemoryProperties, which VK.h only forward declares
+	struct MemoryType
+	{
+		VkMemoryPropertyFlags PropertyFlags = 0;
+		uint32_t HeapIndex = 0;
+	};
+
+	std::vector<MemoryType> m_MemoryTypes;
+	std::vector<VkDeviceSize> m_HeapSizes;
+
+	// Key: memory type index and ResourceKind
+	std::map<std::pair<uint32_t, ResourceKind>, std::vector<Scope<DeviceMemoryBlock>>> m_Pools;
+	std::map<uint32_t, DedicatedStatistics> m_DedicatedStatistics;
+
+	mutable std::mutex m_Mutex;
+};
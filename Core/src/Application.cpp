@@ -6,10 +6,21 @@
 #include "Swapchain.h"
 #include "CommandBuffer.h"
 #include "Shader.h"
+#include "ShaderCompiler.h"
+#include "Allocator.h"
+#include "PipelineCache.h"
+#include "ReflectionCache.h"
+#include "ShaderPermutations.h"
+#include "UniformRingBuffer.h"
+#include "ThreadCommandPools.h"
+#include "RenderPass.h"
+#include "TextureStreamer.h"
+#include "ShaderReloader.h"
 
 #include "Event.h"
 
 #include "Input.h"
+#include "JobSystem.h"
 
 #include "Timer.h"
 #include "Log.h"
@@ -18,6 +29,8 @@
 #include "IMGUII.h"
 #include <imgui.h>
 
+#include <algorithm>
+
 void Application::Run()
 {
 	AppInit();
@@ -39,16 +52,33 @@ void Application::Run()
 		{
 			OnUpdate(dt);
 
+			// Nothing is being recorded, reloaded pipelines can be swapped in
+			Context::GetShaderReloader().Update(swapchain.GetImageCount());
+
 			swapchain.BeginFrame();
 			m_ImGui->NewFrame();
 
 			auto& commandBuffer = swapchain.GetCurrentCommandBuffer();
+			const auto& renderPass = *swapchain.GetRenderPass();
+			const auto& framebuffer = swapchain.GetCurrentFramebuffer();
+			auto& commandPools = swapchain.GetThreadCommandPools();
 
+			// Everything inside the render pass is recorded into secondary command buffers, see RecordParallel()
 			commandBuffer.BeginRecording();
-			commandBuffer.BeginRenderPass(*swapchain.GetRenderPass(), swapchain.GetCurrentFramebuffer());
 
-			OnRender(commandBuffer);
+			// Copies can't be recorded inside a render pass, requests made while recording this frame are handled on the next one
+			Context::GetTextureStreamer().Update(commandBuffer, swapchain.GetImageCount());
+
+			commandBuffer.BeginRenderPass(renderPass, framebuffer, true);
+
+			auto& renderCommandBuffer = commandPools.GetSecondary();
+			renderCommandBuffer.BeginRecording(renderPass, framebuffer);
 
+			m_ParallelCommandBuffers.clear();
+
+			OnRender(renderCommandBuffer);
+
+			renderCommandBuffer.EndRecording();
 
 			if (ImGui::Begin("Stats", NULL, ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoResize))
 			{
@@ -56,10 +86,70 @@ void Application::Run()
 
 				for (const auto& [name, frameData] : PerFramePerfProfiler::GetPerFrameData())
 					ImGui::Text("%s Time: %.2f ms", name.data(), frameData.Time);
+
+				constexpr float toMiB = 1.0f / (1024.0f * 1024.0f);
+
+				for (const auto& stats : Context::GetDevice().GetAllocator().GetStatistics())
+				{
+					if (0 == stats.AllocatedSize)
+						continue;
+
+					ImGui::Text("Heap #%i: %.1f/%.1f MiB | Blocks: %i | Dedicated: %i | Allocations: %i | Fragmentation: %.2f",
+						stats.HeapIndex, stats.UsedSize * toMiB, stats.AllocatedSize * toMiB,
+						stats.BlockCount, stats.DedicatedCount, stats.AllocationCount, stats.Fragmentation);
+
+					if (0 != stats.Budget)
+						ImGui::Text("Heap #%i budget: %.1f/%.1f MiB", stats.HeapIndex, stats.Usage * toMiB, stats.Budget * toMiB);
+				}
+
+				const auto& textureStreamer = Context::GetTextureStreamer();
+				const auto streamingStats = textureStreamer.GetStatistics();
+
+				if (0 != streamingStats.TextureCount)
+				{
+					ImGui::Text("Streaming: %.1f/%.1f MiB resident/requested | Budget: %.1f MiB | Loading: %i",
+						streamingStats.ResidentSize * toMiB, streamingStats.RequestedSize * toMiB, streamingStats.Budget * toMiB, streamingStats.PendingLoadCount);
+
+					for (const auto* texture : textureStreamer.GetTextures())
+					{
+						ImGui::Text("  %s: %.2f/%.2f MiB | Mip: %i/%i", texture->GetName().data(),
+							texture->GetResidentSize() * toMiB, texture->GetRequestedSize() * toMiB, texture->GetResidentLevel(), texture->GetRequestedLevel());
+					}
+				}
+
+				const auto& cacheStats = Context::GetDevice().GetPipelineCache().GetStatistics();
+
+				ImGui::Text("Pipelines (%s start): %i in %.2f ms | Cache hits: %i | Misses: %i",
+					cacheStats.LoadedFromDisk ? "warm" : "cold", cacheStats.GetPipelineCount(), cacheStats.GetTotalTime(), cacheStats.Hits, cacheStats.Misses);
+
+				const auto& reflectionStats = Context::GetDevice().GetReflectionCache().GetStatistics();
+
+				ImGui::Text("Reflection (%s start): Cache hits: %i | Misses: %i in %.2f ms",
+					reflectionStats.LoadedFromDisk ? "warm" : "cold", reflectionStats.Hits, reflectionStats.Misses, reflectionStats.ReflectionTime);
+
+				const auto& permutationStats = ShaderPermutations::GetTotalStatistics();
+
+				if (0 != permutationStats.RequestedCount)
+				{
+					ImGui::Text("Shader variants: %i used | Compiled: %i | Cached: %i | Failed: %i in %.2f ms",
+						permutationStats.RequestedCount, permutationStats.CompiledCount, permutationStats.CachedCount, permutationStats.FailedCount, permutationStats.CompileTime);
+				}
 			}
 			ImGui::End();
 
-			m_ImGui->Render(commandBuffer);
+			auto& imGuiCommandBuffer = commandPools.GetSecondary();
+			imGuiCommandBuffer.BeginRecording(renderPass, framebuffer);
+
+			m_ImGui->Render(imGuiCommandBuffer);
+
+			imGuiCommandBuffer.EndRecording();
+
+			// ImGui goes last, on top of everything
+			std::vector<CommandBuffer*> secondaryCommandBuffers = { &renderCommandBuffer };
+			secondaryCommandBuffers.insert(secondaryCommandBuffers.end(), m_ParallelCommandBuffers.begin(), m_ParallelCommandBuffers.end());
+			secondaryCommandBuffers.emplace_back(&imGuiCommandBuffer);
+
+			commandBuffer.ExecuteCommands(secondaryCommandBuffers);
 
 			commandBuffer.EndRenderPass();
 			commandBuffer.EndRecording();
@@ -84,8 +174,60 @@ std::pair<uint32_t, uint32_t> Application::GetSize() const
 	return { desc.Width, desc.Height };
 }
 
+UniformRingBuffer& Application::GetUniformRingBuffer() const
+{
+	return Context::GetSwapchain().GetUniformRingBuffer();
+}
+
+void Application::WatchShaders(const std::filesystem::path& shaderDirectory)
+{
+	Context::GetShaderReloader().Watch(shaderDirectory);
+}
+
+void Application::RecordParallel(uint32_t count, const RecordFunction& record)
+{
+	PROFILE_FUNCTION();
+
+	if (0 == count)
+		return;
+
+	auto& swapchain = Context::GetSwapchain();
+	auto& commandPools = swapchain.GetThreadCommandPools();
+	const auto& renderPass = *swapchain.GetRenderPass();
+	const auto& framebuffer = swapchain.GetCurrentFramebuffer();
+
+	// A few batches per thread, so stealing can even out uneven work
+	const uint32_t batchCount = std::min(count, (JobSystem::GetWorkerCount() + 1) * 4);
+	const uint32_t batchSize = (count + batchCount - 1) / batchCount;
+
+	const size_t first = m_ParallelCommandBuffers.size();
+	m_ParallelCommandBuffers.resize(first + batchCount, nullptr);
+
+	CommandBuffer** commandBuffers = m_ParallelCommandBuffers.data() + first;
+
+	JobSystem::ParallelFor(batchCount, 1, [&, commandBuffers](uint32_t batch)
+		{
+			const uint32_t begin = batch * batchSize;
+			const uint32_t end = std::min(begin + batchSize, count);
+
+			auto& secondary = commandPools.GetSecondary();
+
+			secondary.BeginRecording(renderPass, framebuffer);
+
+			if (begin < end)
+				record(secondary, begin, end);
+
+			secondary.EndRecording();
+
+			commandBuffers[batch] = &secondary;
+		});
+}
+
 void Application::AppInit()
 {
+	JobSystem::Init();
+	ShaderCompiler::Init();
+
 	WindowDescription desc;
 
 	desc.VSync = true;
@@ -107,6 +249,9 @@ void Application::AppShutdown()
 	Context::Shutdown();
 
 	m_Window.reset();
+
+	ShaderCompiler::Shutdown();
+	JobSystem::Shutdown();
 }
 
 void Application::AppEvent(Event& event)
@@ -123,16 +268,11 @@ void Application::AppEvent(Event& event)
 	OnEvent(event);
 }
 
-// For the current architecture works, but ...
-// NOTE: Almost the whole app is destroyed and restarted to work which is far from optimal
-// TODO: Fix somehow
 void Application::OnResize(ResizeEvent& event)
 {
 	const uint32_t width = event.Width;
 	const uint32_t height = event.Height;
 
-	Context::GetDevice().WaitIdle();
-
 	if (0 == width || 0 == height)
 	{
 		m_Minimized = true;
@@ -141,12 +281,8 @@ void Application::OnResize(ResizeEvent& event)
 
 	m_Minimized = false;
 
-	OnShutdown();
-
 	Context::GetSwapchain().OnResize(width, height);
 	m_Window->OnResize(width, height);
 
-	OnInit();
-
-	Context::GetDevice().WaitIdle();
+	OnSwapchainRecreated(width, height);
 }
@@ -2,7 +2,10 @@
 
 #include "Window.h"
 
+#include <filesystem>
 #include <utility>
+#include <vector>
+#include <functional>
 
 struct Event;
 struct ResizeEvent;
@@ -11,6 +14,8 @@ class CommandBuffer;
 
 class IMGUI;
 
+class UniformRingBuffer;
+
 class Application
 {
 public:
@@ -21,11 +26,27 @@ public:
 
 	std::pair<uint32_t, uint32_t> GetSize() const;
 protected:
+	// Valid for the current frame only, push from OnRender
+	UniformRingBuffer& GetUniformRingBuffer() const;
+
+	// Shaders in it are recompiled when they or their includes change, the Pipelines using them are reloaded between frames
+	void WatchShaders(const std::filesystem::path& shaderDirectory);
+
+	// begin and end are indices into the range passed to RecordParallel()
+	using RecordFunction = std::function<void(CommandBuffer& commandBuffer, uint32_t begin, uint32_t end)>;
+
+	// Call from OnRender(), splits [0, count) into batches recorded on the JobSystem's workers, each into its own secondary CommandBuffer
+	// Executed after what's recorded into OnRender()'s CommandBuffer, in index order
+	// record runs on several threads at once, so anything it touches must be read-only (push uniform data before)
+	void RecordParallel(uint32_t count, const RecordFunction& record);
+
 	virtual void OnInit() = 0;
 	virtual void OnUpdate(float dt) = 0;
 	virtual void OnRender(CommandBuffer& commandBuffer) = 0;
 	virtual void OnShutdown() = 0;
 	virtual void OnEvent(Event& event) = 0;
+	// Called after a resize, only the Swapchain's size dependent resources were recreated
+	virtual void OnSwapchainRecreated(uint32_t width, uint32_t height) {}
 private:
 	void AppInit();
 	void AppShutdown();
@@ -37,4 +58,7 @@ private:
 	bool m_Minimized = false;
 
 	Ref<IMGUI> m_ImGui;
+
+	// Recorded this frame by RecordParallel()
+	std::vector<CommandBuffer*> m_ParallelCommandBuffers;
 };
\ No newline at end of file
@@ -3,8 +3,14 @@
 #include "Input.h"
 
 Camera::Camera(float aspectRatio, float fovYdegrees, float near, float far)
+	: m_FovY(glm::radians(fovYdegrees)), m_Near(near), m_Far(far)
 {
-	m_Projection = glm::perspective(glm::radians(fovYdegrees), aspectRatio, near, far);
+	SetAspectRatio(aspectRatio);
+}
+
+void Camera::SetAspectRatio(float aspectRatio)
+{
+	m_Projection = glm::perspective(m_FovY, aspectRatio, m_Near, m_Far);
 	m_Projection[1][1] *= -1.0f;
 }
 
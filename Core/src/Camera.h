@@ -10,12 +10,19 @@ struct Camera
 
 	void OnUpdate(float dt);
 
+	// Rebuilds the projection, keeps the position and rotation
+	void SetAspectRatio(float aspectRatio);
+
 	const glm::mat4& GetProjection() const;
 	const glm::mat4& GetView() const;
 	const glm::mat4 GetViewProjection() const;
 	const glm::vec3& GetPosition() const;
 	const glm::quat& GetRotation() const;
 private:
+	float m_FovY = 0.0f;
+	float m_Near = 0.0f;
+	float m_Far = 0.0f;
+
 	glm::vec3 m_CameraPosition = { 0.0f, 0.0f, 10.0f };
 	glm::quat m_CameraRotation = { 1.0f, 0.0f, 0.0f, 0.0f };
 
@@ -8,6 +8,7 @@
 #include "Shader.h"
 #include "RenderPass.h"
 #include "Framebuffer.h"
+#include "Synchronization.h"
 
 #include "Log.h"
 
@@ -17,6 +18,8 @@
 #include <glm/glm.hpp>
 
 #include <array>
+#include <limits>
+#include <vector>
 
 template<typename T>
 static void PushConstants(VkCommandBuffer cmdBuffer, const Pipeline* pipeline, const std::string& name, const T& value)
@@ -43,14 +46,20 @@ Ref<CommandBuffer> CommandBuffer::Create(bool isPrimary)
 	return CreateRef<CommandBuffer>(isPrimary);
 }
 
-CommandBuffer::CommandBuffer(bool isPrimary)
+Ref<CommandBuffer> CommandBuffer::Create(bool isPrimary, const CommandPool& commandPool)
+{
+	return CreateRef<CommandBuffer>(isPrimary, &commandPool);
+}
+
+CommandBuffer::CommandBuffer(bool isPrimary, const CommandPool* commandPool)
+	: m_CommandPool(commandPool ? commandPool : &Context::GetDevice().GetCommandPool()), m_IsPrimary(isPrimary)
 {
 	CreateCommandBuffer(isPrimary);
 }
 
 CommandBuffer::~CommandBuffer()
 {
-	vkFreeCommandBuffers(Context::GetDevice().GetHandle(), Context::GetDevice().GetCommandPool().GetHandle(), 1, &Handle::GetHandle());
+	vkFreeCommandBuffers(Context::GetDevice().GetHandle(), m_CommandPool->GetHandle(), 1, &Handle::GetHandle());
 }
 
 void CommandBuffer::BeginRecording(bool singleTime)
@@ -63,19 +72,59 @@ void CommandBuffer::BeginRecording(bool singleTime)
 	if (singleTime)
 		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
+	m_BoundPipeline = nullptr;
+
 	VkResult result = vkBeginCommandBuffer(Handle::GetHandle(), &beginInfo);
 	VK_CHECK_RESULT(result);
 }
 
+void CommandBuffer::BeginRecording(const RenderPass& renderPass, const Framebuffer& framebuffer)
+{
+	ASSERT(!m_IsPrimary, "Only secondary command buffers continue a render pass");
+
+	VkCommandBufferInheritanceInfo inheritanceInfo;
+	ZeroInitVkStruct(inheritanceInfo, VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO);
+
+	inheritanceInfo.renderPass = renderPass.GetHandle();
+	inheritanceInfo.subpass = 0;
+	inheritanceInfo.framebuffer = framebuffer.GetHandle();
+
+	VkCommandBufferBeginInfo beginInfo;
+	ZeroInitVkStruct(beginInfo, VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO);
+
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+	m_BoundPipeline = nullptr;
+
+	VkResult result = vkBeginCommandBuffer(Handle::GetHandle(), &beginInfo);
+	VK_CHECK_RESULT(result);
+
+	// Dynamic state isn't inherited from the primary
+	const auto& framebufferDesc = framebuffer.GetDescription();
+	SetViewport(framebufferDesc.Width, framebufferDesc.Height);
+}
+
 void CommandBuffer::EndRecording()
 {
 	VkResult result = vkEndCommandBuffer(Handle::GetHandle());
 	VK_CHECK_RESULT(result);
 }
 
-void CommandBuffer::Submit()
+void CommandBuffer::Submit(const Fence* fence)
 {
-	const auto& graphicsQueue = Context::GetDevice().GetGraphicsQueue();
+	const auto& device = Context::GetDevice();
+
+	Ref<Fence> localFence;
+
+	if (!fence)
+	{
+		FenceDescription desc;
+		desc.CreateFlags = 0;
+
+		localFence = Fence::Create(device, desc);
+		fence = localFence.get();
+	}
 
 	VkSubmitInfo submitInfo;
 	ZeroInitVkStruct(submitInfo, VK_STRUCTURE_TYPE_SUBMIT_INFO);
@@ -83,17 +132,20 @@ void CommandBuffer::Submit()
 	submitInfo.commandBufferCount = 1;
 	submitInfo.pCommandBuffers = &Handle::GetHandle();
 
-	vkQueueSubmit(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
-	vkQueueWaitIdle(graphicsQueue);
+	VkResult result = vkQueueSubmit(device.GetGraphicsQueue(), 1, &submitInfo, fence->GetHandle());
+	VK_CHECK_RESULT(result);
+
+	if (localFence)
+		localFence->Wait(std::numeric_limits<uint64_t>::max());
 }
 
-void CommandBuffer::EndRecordingAndSubmit()
+void CommandBuffer::EndRecordingAndSubmit(const Fence* fence)
 {
 	EndRecording();
-	Submit();
+	Submit(fence);
 }
 
-void CommandBuffer::BeginRenderPass(const RenderPass& renderPass, const Framebuffer& framebuffer)
+void CommandBuffer::BeginRenderPass(const RenderPass& renderPass, const Framebuffer& framebuffer, bool secondaryContents)
 {
 	VkRenderPassBeginInfo renderPassInfo;
 	ZeroInitVkStruct(renderPassInfo, VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO);
@@ -113,7 +165,12 @@ void CommandBuffer::BeginRenderPass(const RenderPass& renderPass, const Framebuf
 	renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
 	renderPassInfo.pClearValues = clearValues.data();
 
-	vkCmdBeginRenderPass(Handle::GetHandle(), &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+	vkCmdBeginRenderPass(Handle::GetHandle(), &renderPassInfo, secondaryContents ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
+
+	// Pipelines have dynamic viewport and scissor, default to the whole framebuffer
+	// Secondary command buffers set their own, see BeginRecording()
+	if (!secondaryContents)
+		SetViewport(framebufferDesc.Width, framebufferDesc.Height);
 }
 
 void CommandBuffer::EndRenderPass()
@@ -121,6 +178,25 @@ void CommandBuffer::EndRenderPass()
 	vkCmdEndRenderPass(Handle::GetHandle());
 }
 
+void CommandBuffer::ExecuteCommands(std::span<CommandBuffer* const> commandBuffers)
+{
+	ASSERT(m_IsPrimary, "Only primary command buffers can execute secondary ones");
+
+	if (commandBuffers.empty())
+		return;
+
+	std::vector<VkCommandBuffer> handles;
+	handles.reserve(commandBuffers.size());
+
+	for (const auto* commandBuffer : commandBuffers)
+	{
+		ASSERT(commandBuffer && !commandBuffer->IsPrimary());
+		handles.emplace_back(commandBuffer->GetHandle());
+	}
+
+	vkCmdExecuteCommands(Handle::GetHandle(), static_cast<uint32_t>(handles.size()), handles.data());
+}
+
 void CommandBuffer::Reset()
 {
 	vkResetCommandBuffer(Handle::GetHandle(), 0);
@@ -128,11 +204,6 @@ void CommandBuffer::Reset()
 
 void CommandBuffer::SetViewport(uint32_t width, uint32_t height, uint32_t x, uint32_t y)
 {
-	ASSERT(m_BoundPipeline, "Pipeline must be valid");
-
-	if (!m_BoundPipeline->GetDescription().EnableDynamicStates)
-		LOG(STR(PipelineDescription::EnableDynamicStates) " is not enabled");
-
 	VkViewport viewport = {};
 
 	viewport.x = float(x);
@@ -161,14 +232,15 @@ void CommandBuffer::SetLineWidth(float lineWidth)
 	vkCmdSetLineWidth(Handle::GetHandle(), lineWidth);
 }
 
-void CommandBuffer::BindDescriptorSet(const DescriptorSet& set)
+void CommandBuffer::BindDescriptorSet(const DescriptorSet& set, std::span<const uint32_t> dynamicOffsets)
 {
 	ASSERT(m_BoundPipeline);
 
 	const auto& descSetHandle = set.GetDescriptorSet();
 	ASSERT(descSetHandle);
 
-	vkCmdBindDescriptorSets(Handle::GetHandle(), VK_PIPELINE_BIND_POINT_GRAPHICS, m_BoundPipeline->GetHandle<VkPipelineLayout>(), 0, 1, &descSetHandle, 0, nullptr);
+	vkCmdBindDescriptorSets(Handle::GetHandle(), VK_PIPELINE_BIND_POINT_GRAPHICS, m_BoundPipeline->GetHandle<VkPipelineLayout>(), 0, 1, &descSetHandle,
+		static_cast<uint32_t>(dynamicOffsets.size()), dynamicOffsets.data());
 }
 
 void CommandBuffer::BindVertexBuffer(const GBuffer& buffer)
@@ -209,6 +281,11 @@ void CommandBuffer::DrawIndexed(uint32_t indexCount, uint32_t firstIndex)
 	vkCmdDrawIndexed(Handle::GetHandle(), indexCount, 1, firstIndex, 0, 0);
 }
 
+bool CommandBuffer::IsPrimary() const
+{
+	return m_IsPrimary;
+}
+
 void CommandBuffer::CreateCommandBuffer(bool isPrimary)
 {
 	const auto& device = Context::GetDevice();
@@ -217,7 +294,7 @@ void CommandBuffer::CreateCommandBuffer(bool isPrimary)
 	ZeroInitVkStruct(bufferAllocInfo, VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO);
 
 	bufferAllocInfo.commandBufferCount = 1;
-	bufferAllocInfo.commandPool = device.GetCommandPool().GetHandle();
+	bufferAllocInfo.commandPool = m_CommandPool->GetHandle();
 	bufferAllocInfo.level = isPrimary ? VK_COMMAND_BUFFER_LEVEL_PRIMARY : VK_COMMAND_BUFFER_LEVEL_SECONDARY;
 
 	VkResult result = vkAllocateCommandBuffers(device.GetHandle(), &bufferAllocInfo, &Handle::GetHandle());
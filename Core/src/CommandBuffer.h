@@ -5,35 +5,49 @@
 #include "VK.h"
 
 #include <string>
+#include <span>
 
 class GBuffer;
 class Pipeline;
 class DescriptorSet;
 class RenderPass;
 class Framebuffer;
+class CommandPool;
+class Fence;
 
 class CommandBuffer : public Handle<VkCommandBuffer>
 {
 public:
 	static Ref<CommandBuffer> Create(bool isPrimary);
+	static Ref<CommandBuffer> Create(bool isPrimary, const CommandPool& commandPool);
 
-	CommandBuffer(bool isPrimary);
+	// Allocated from the Device's graphics CommandPool if commandPool is nullptr
+	CommandBuffer(bool isPrimary, const CommandPool* commandPool = nullptr);
 	~CommandBuffer();
 
 	void BeginRecording(bool singleTime = false);
+	// Secondary only, for recording inside the render pass, the viewport is set to the whole framebuffer
+	void BeginRecording(const RenderPass& renderPass, const Framebuffer& framebuffer);
 	void EndRecording();
-	void Submit();
-	void EndRecordingAndSubmit();
+	// Signals the fence when done, without one it waits on a temporary fence (not on the whole queue)
+	void Submit(const Fence* fence = nullptr);
+	void EndRecordingAndSubmit(const Fence* fence = nullptr);
 
-	void BeginRenderPass(const RenderPass& renderPass, const Framebuffer& framebuffer);
+	// With secondaryContents the render pass can only be recorded into with ExecuteCommands()
+	void BeginRenderPass(const RenderPass& renderPass, const Framebuffer& framebuffer, bool secondaryContents = false);
 	void EndRenderPass();
 
+	// Primary only, executed in order
+	void ExecuteCommands(std::span<CommandBuffer* const> commandBuffers);
+
 	void Reset();
 
+	// Also sets the scissor, BeginRenderPass() sets both to the whole framebuffer
 	void SetViewport(uint32_t width, uint32_t height, uint32_t x = 0, uint32_t y = 0);
 	void SetLineWidth(float lineWidth);
 
-	void BindDescriptorSet(const DescriptorSet& set);
+	// dynamicOffsets are consumed in binding order, one per dynamic uniform buffer
+	void BindDescriptorSet(const DescriptorSet& set, std::span<const uint32_t> dynamicOffsets = {});
 	void BindVertexBuffer(const GBuffer& buffer);
 	void BindIndexBuffer(const GBuffer& buffer);
 	void BindPipeline(const Pipeline& pipeline);
@@ -43,8 +57,13 @@ public:
 
 	template<typename T>
 	void PushConstant(const std::string& name, const T& value);
+
+	bool IsPrimary() const;
 private:
 	void CreateCommandBuffer(bool isPrimary);
 private:
+	const CommandPool* m_CommandPool = nullptr;
 	const Pipeline* m_BoundPipeline = nullptr;
+
+	bool m_IsPrimary = true;
 };
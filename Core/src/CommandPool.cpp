@@ -6,8 +6,8 @@
 
 #include <volk.h>
 
-CommandPool::CommandPool(const Device& device)
-	: m_Device(device)
+CommandPool::CommandPool(const Device& device, uint32_t queueFamilyIndex)
+	: m_Device(device), m_QueueFamilyIndex(queueFamilyIndex)
 {
 	CreateCommandPool();
 }
@@ -17,13 +17,24 @@ CommandPool::~CommandPool()
 	vkDestroyCommandPool(m_Device.GetHandle(), Handle::GetHandle(), nullptr);
 }
 
+uint32_t CommandPool::GetQueueFamilyIndex() const
+{
+	return m_QueueFamilyIndex;
+}
+
+void CommandPool::Reset()
+{
+	VkResult result = vkResetCommandPool(m_Device.GetHandle(), Handle::GetHandle(), 0);
+	VK_CHECK_RESULT(result);
+}
+
 void CommandPool::CreateCommandPool()
 {
 	VkCommandPoolCreateInfo poolInfo;
 	ZeroInitVkStruct(poolInfo, VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO);
 
 	poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-	poolInfo.queueFamilyIndex = m_Device.GetPhysicalDevice().GetQueueFamilyIndices().GraphicsIndex.value();
+	poolInfo.queueFamilyIndex = m_QueueFamilyIndex;
 
 	VkResult result = vkCreateCommandPool(m_Device.GetHandle(), &poolInfo, nullptr, &Handle::GetHandle());
 	VK_CHECK_RESULT(result);
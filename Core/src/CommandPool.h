@@ -7,10 +7,17 @@ class Device;
 class CommandPool : public Handle<VkCommandPool>
 {
 public:
-	CommandPool(const Device& device);
+	CommandPool(const Device& device, uint32_t queueFamilyIndex);
 	~CommandPool();
+
+	uint32_t GetQueueFamilyIndex() const;
+
+	// Resets every CommandBuffer allocated from the pool, none of them can be in use by the GPU
+	void Reset();
 private:
 	void CreateCommandPool();
 private:
 	const Device& m_Device;
+
+	uint32_t m_QueueFamilyIndex = ~0;
 };
\ No newline at end of file
@@ -6,6 +6,9 @@
 #include "Device.h"
 #include "Swapchain.h"
 #include "DescriptorPool.h"
+#include "UploadQueue.h"
+#include "TextureStreamer.h"
+#include "ShaderReloader.h"
 
 #include "Log.h"
 
@@ -14,16 +17,25 @@ struct ContextData
 	Scope<Instance> Inst;
 	Scope<Surface> Surf;
 	Scope<Device> Dev;
+	// Owned here and not by the Device, its buffers need Context::GetDevice() on destruction
+	Scope<UploadQueue> Uploads;
+	// Same, holds images replaced while frames were in flight
+	Scope<TextureStreamer> Streamer;
 	Scope<Swapchain> SwapChain;
 
 	Scope<DescriptorPool> DescPool;
 
+	// Its reload job uses the Swapchain's render pass, destroyed first
+	Scope<ShaderReloader> Reloader;
+
 	void Init(const Window& window)
 	{
 
 		Inst = CreateScope<Instance>(window);
 		Surf = CreateScope<Surface>(*Inst, window);
 		Dev = CreateScope<Device>(*Inst, *Surf);
+		Uploads = CreateScope<UploadQueue>(*Dev);
+		Streamer = CreateScope<TextureStreamer>(*Dev);
 
 		{
 			SwapchainDescription desc = {};
@@ -36,12 +48,16 @@ struct ContextData
 		}
 
 		DescPool = CreateScope<DescriptorPool>(*Dev);
+		Reloader = CreateScope<ShaderReloader>(*Dev);
 	}
 
 	void Shutdown()
 	{
+		Reloader.reset();
 		DescPool.reset();
 		SwapChain.reset();
+		Streamer.reset();
+		Uploads.reset();
 		Dev.reset();
 		Surf.reset();
 		Inst.reset();
@@ -82,3 +98,21 @@ Swapchain& Context::GetSwapchain()
 	ASSERT(s_Data && s_Data->SwapChain);
 	return *s_Data->SwapChain;
 }
+
+UploadQueue& Context::GetUploadQueue()
+{
+	ASSERT(s_Data && s_Data->Uploads);
+	return *s_Data->Uploads;
+}
+
+TextureStreamer& Context::GetTextureStreamer()
+{
+	ASSERT(s_Data && s_Data->Streamer);
+	return *s_Data->Streamer;
+}
+
+ShaderReloader& Context::GetShaderReloader()
+{
+	ASSERT(s_Data && s_Data->Reloader);
+	return *s_Data->Reloader;
+}
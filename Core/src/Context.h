@@ -19,6 +19,10 @@ class Device;
 class Swapchain;
 #endif
 
+class UploadQueue;
+class TextureStreamer;
+class ShaderReloader;
+
 class Context
 {
 public:
@@ -29,4 +33,7 @@ public:
 	//static Surface& GetSurface();
 	static Device& GetDevice();
 	static Swapchain& GetSwapchain();
+	static UploadQueue& GetUploadQueue();
+	static TextureStreamer& GetTextureStreamer();
+	static ShaderReloader& GetShaderReloader();
 };
\ No newline at end of file
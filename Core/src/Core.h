@@ -8,16 +8,24 @@
 
 #include "Utils.h"
 
+#include "JobSystem.h"
+
 #include "Input.h"
 
 #include "Camera.h"
 
 #include "Buffer.h"
 #include "GBuffer.h"
+#include "UniformRingBuffer.h"
+#include "UploadContext.h"
 #include "Layout.h"
 
 #include "Texture.h"
+#include "MipGenerator.h"
+#include "TextureCompressor.h"
+#include "TextureStreamer.h"
 #include "Mesh.h"
+#include "MeshOptimizer.h"
 #include "Skybox.h"
 
 #include "CommandBuffer.h"
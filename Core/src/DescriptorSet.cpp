@@ -15,6 +15,8 @@
 #include <volk.h>
 #include <vulkan/vulkan.h>
 
+#include <algorithm>
+
 Ref<DescriptorSet> DescriptorSet::Create(const DescriptorSetDescription& desc)
 {
 	return CreateRef<DescriptorSet>(desc);
@@ -35,6 +37,15 @@ void DescriptorSet::SetBuffer(uint32_t binding, const GBuffer& buffer)
 	auto& bufferHandle = buffer.GetHandle<VkBuffer>();
 	ASSERT(bufferHandle);
 
+	auto shader = m_Shader.lock();
+	ASSERT(shader);
+
+	const auto resource = shader->TryGetResource(binding);
+	ASSERT(resource);
+
+	// Dynamic uniform buffers are bound with an offset per draw, so the range can't be the whole buffer
+	const bool isDynamic = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC == resource->Type;
+
 	VkDescriptorBufferInfo bufferInfo = {};
 
 	VkWriteDescriptorSet descriptorWrite;
@@ -44,13 +55,13 @@ void DescriptorSet::SetBuffer(uint32_t binding, const GBuffer& buffer)
 	{
 		bufferInfo.buffer = bufferHandle;
 		bufferInfo.offset = 0;
-		bufferInfo.range = VK_WHOLE_SIZE;
+		bufferInfo.range = isDynamic ? resource->Size : VK_WHOLE_SIZE;
 
 		descriptorWrite.dstSet = m_DescriptorSets[i];
 		descriptorWrite.dstBinding = binding;
 		descriptorWrite.dstArrayElement = 0;
 
-		descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		descriptorWrite.descriptorType = resource->Type;
 		descriptorWrite.descriptorCount = 1;
 
 		descriptorWrite.pBufferInfo = &bufferInfo;
@@ -74,31 +85,20 @@ void DescriptorSet::SetTexture(uint32_t binding, const Texture& texture)
 {
 	ASSERT(binding != ~0);
 
-	VkDescriptorImageInfo imageInfo = {};
-	imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-	VkWriteDescriptorSet descriptorWrite;
-	ZeroInitVkStruct(descriptorWrite, VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET);
-
-	for (uint32_t i = 0; i < m_ImageCount; i++)
-	{
-		//const auto textureType = texture.GetType();
-		imageInfo.imageView = texture.GetImage().GetHandle<VkImageView>();
+	std::scoped_lock lock(m_Mutex);
 
-		auto sampler = texture.GetSampler();
-		if (sampler)
-			imageInfo.sampler = sampler->GetHandle();
+	auto it = std::find_if(m_TextureBindings.begin(), m_TextureBindings.end(), [binding](const TextureBinding& textureBinding) { return textureBinding.Binding == binding; });
 
-		descriptorWrite.dstSet = m_DescriptorSets[i];
-		descriptorWrite.dstBinding = binding;
-		descriptorWrite.dstArrayElement = 0;
+	if (it == m_TextureBindings.end())
+		it = m_TextureBindings.insert(m_TextureBindings.end(), TextureBinding{ binding, &texture, std::vector<VkImageView>(m_ImageCount) });
 
-		descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		descriptorWrite.descriptorCount = 1;
+	it->Texture = &texture;
 
-		descriptorWrite.pImageInfo = &imageInfo;
+	for (uint32_t i = 0; i < m_ImageCount; i++)
+	{
+		WriteTexture(i, binding, texture);
 
-		vkUpdateDescriptorSets(Context::GetDevice().GetHandle(), 1, &descriptorWrite, 0, nullptr);
+		it->ImageViews[i] = texture.GetImage().GetHandle<VkImageView>();
 	}
 }
 
@@ -119,9 +119,52 @@ VkDescriptorSet DescriptorSet::GetDescriptorSet() const
 		return VK_NULL_HANDLE;
 
 	uint32_t currentFrame = Context::GetSwapchain().GetCurrentFrame();
+
+	std::scoped_lock lock(m_Mutex);
+
+	// The GPU is done with this frame's set, images replaced since it was last written can be swapped in
+	for (const auto& textureBinding : m_TextureBindings)
+	{
+		const auto& imageView = textureBinding.Texture->GetImage().GetHandle<VkImageView>();
+
+		if (textureBinding.ImageViews[currentFrame] == imageView)
+			continue;
+
+		WriteTexture(currentFrame, textureBinding.Binding, *textureBinding.Texture);
+
+		textureBinding.ImageViews[currentFrame] = imageView;
+	}
+
 	return m_DescriptorSets.at(currentFrame);
 }
 
+void DescriptorSet::WriteTexture(uint32_t frame, uint32_t binding, const Texture& texture) const
+{
+	VkDescriptorImageInfo imageInfo = {};
+	imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	//const auto textureType = texture.GetType();
+	imageInfo.imageView = texture.GetImage().GetHandle<VkImageView>();
+
+	auto sampler = texture.GetSampler();
+	if (sampler)
+		imageInfo.sampler = sampler->GetHandle();
+
+	VkWriteDescriptorSet descriptorWrite;
+	ZeroInitVkStruct(descriptorWrite, VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET);
+
+	descriptorWrite.dstSet = m_DescriptorSets[frame];
+	descriptorWrite.dstBinding = binding;
+	descriptorWrite.dstArrayElement = 0;
+
+	descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	descriptorWrite.descriptorCount = 1;
+
+	descriptorWrite.pImageInfo = &imageInfo;
+
+	vkUpdateDescriptorSets(Context::GetDevice().GetHandle(), 1, &descriptorWrite, 0, nullptr);
+}
+
 void DescriptorSet::CreateDescriptorSet()
 {
 	ASSERT(0 < m_ImageCount);
@@ -8,6 +8,7 @@
 
 #include <string>
 #include <vector>
+#include <mutex>
 
 // DescriptorSetLayout is analogous to a struct definition
 // DescriptorSet is an instance of that struct
@@ -37,14 +38,28 @@ public:
 	void SetBuffer(uint32_t binding, const GBuffer& buffer);
 	void SetBuffer(const std::string& name, const GBuffer& buffer);
 
+	// The texture must outlive the set, its image can change (see StreamedTexture), the current frame's set is rewritten then
 	void SetTexture(uint32_t binding, const Texture& texture);
 	void SetTexture(const std::string& name, const Texture& texture);
 
 	VkDescriptorSet GetDescriptorSet() const;
 private:
 	void CreateDescriptorSet();
+
+	void WriteTexture(uint32_t frame, uint32_t binding, const Texture& texture) const;
 private:
+	struct TextureBinding
+	{
+		uint32_t Binding = 0;
+		const Texture* Texture = nullptr;
+		// Per frame, the view last written to that frame's set
+		mutable std::vector<VkImageView> ImageViews;
+	};
+
 	std::vector<VkDescriptorSet> m_DescriptorSets;
+	std::vector<TextureBinding> m_TextureBindings;
+	// GetDescriptorSet() can be called from several recording threads
+	mutable std::mutex m_Mutex;
 
 	uint32_t m_ImageCount = 0;
 	WeakRef<Shader> m_Shader;
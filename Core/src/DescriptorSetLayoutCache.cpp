@@ -0,0 +1,98 @@
+#include "DescriptorSetLayoutCache.h"
+
+#include "Device.h"
+#include "Utils.h"
+
+#include "Log.h"
+
+#include <volk.h>
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <vector>
+
+static constexpr const char* s_LogTag = "[DescriptorSetLayoutCache]";
+
+// Immutable samplers aren't used, the rest of the binding is the key
+static uint64_t HashBindings(std::span<const VkDescriptorSetLayoutBinding> bindings)
+{
+	uint64_t hash = 0;
+
+	for (const auto& binding : bindings)
+	{
+		HashCombine(hash, HashBytes(binding.binding));
+		HashCombine(hash, HashBytes(binding.descriptorType));
+		HashCombine(hash, HashBytes(binding.descriptorCount));
+		HashCombine(hash, HashBytes(binding.stageFlags));
+	}
+
+	return hash;
+}
+
+static bool IsSameBinding(const VkDescriptorSetLayoutBinding& first, const VkDescriptorSetLayoutBinding& second)
+{
+	return first.binding == second.binding && first.descriptorType == second.descriptorType
+		&& first.descriptorCount == second.descriptorCount && first.stageFlags == second.stageFlags;
+}
+
+DescriptorSetLayoutCache::DescriptorSetLayoutCache(const Device& device)
+	: m_Device(device)
+{
+}
+
+DescriptorSetLayoutCache::~DescriptorSetLayoutCache()
+{
+	LOG_TAGGED(s_LogTag, "%i layouts shared by %i requests", m_LayoutCount, m_RequestCount);
+
+	for (const auto& [_, entries] : m_Layouts)
+	{
+		for (const auto& entry : entries)
+			vkDestroyDescriptorSetLayout(m_Device.GetHandle(), entry.Layout, nullptr);
+	}
+}
+
+VkDescriptorSetLayout DescriptorSetLayoutCache::GetOrCreate(std::span<const VkDescriptorSetLayoutBinding> bindings)
+{
+	std::vector<VkDescriptorSetLayoutBinding> sortedBindings(bindings.begin(), bindings.end());
+	std::ranges::sort(sortedBindings, [](const auto& first, const auto& second)
+		{
+			return first.binding < second.binding;
+		});
+
+	const uint64_t hash = HashBindings(sortedBindings);
+
+	std::scoped_lock lock(m_Mutex);
+
+	m_RequestCount++;
+
+	auto& entries = m_Layouts[hash];
+
+	for (const auto& entry : entries)
+	{
+		if (std::ranges::equal(entry.Bindings, sortedBindings, IsSameBinding))
+			return entry.Layout;
+	}
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo;
+	ZeroInitVkStruct(layoutInfo, VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO);
+
+	layoutInfo.bindingCount = static_cast<uint32_t>(sortedBindings.size());
+	layoutInfo.pBindings = sortedBindings.data();
+
+	VkDescriptorSetLayout setLayout = {};
+	VkResult result = vkCreateDescriptorSetLayout(m_Device.GetHandle(), &layoutInfo, nullptr, &setLayout);
+	VK_CHECK_RESULT(result);
+	ASSERT(setLayout, "Desriptor set layout creation failed");
+
+	entries.push_back({ .Bindings = std::move(sortedBindings), .Layout = setLayout });
+	m_LayoutCount++;
+
+	return setLayout;
+}
+
+uint32_t DescriptorSetLayoutCache::GetLayoutCount() const
+{
+	std::scoped_lock lock(m_Mutex);
+
+	return m_LayoutCount;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Base.h"
+
+#include "VK.h"
+
+#include <mutex>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+class Device;
+
+// Descriptor set layouts shared by every Shader with the same bindings, they live as long as the Device
+class DescriptorSetLayoutCache
+{
+public:
+	DescriptorSetLayoutCache(const Device& device);
+	~DescriptorSetLayoutCache();
+
+	DELETE_COPY_AND_MOVE(DescriptorSetLayoutCache);
+
+	// Thread-safe, the order of the bindings doesn't matter
+	VkDescriptorSetLayout GetOrCreate(std::span<const VkDescriptorSetLayoutBinding> bindings);
+
+	uint32_t GetLayoutCount() const;
+private:
+	struct Entry
+	{
+		// Sorted by binding, compared on a hit, hashes can collide
+		std::vector<VkDescriptorSetLayoutBinding> Bindings;
+		VkDescriptorSetLayout Layout = nullptr;
+	};
+
+	const Device& m_Device;
+
+	std::unordered_map<uint64_t, std::vector<Entry>> m_Layouts;
+	uint32_t m_LayoutCount = 0;
+	uint32_t m_RequestCount = 0;
+
+	mutable std::mutex m_Mutex;
+};
@@ -5,6 +5,10 @@
 #include "SwapchainSupportDetails.h"
 #include "Context.h"
 #include "DescriptorPool.h"
+#include "Allocator.h"
+#include "PipelineCache.h"
+#include "ReflectionCache.h"
+#include "DescriptorSetLayoutCache.h"
 
 #include "Log.h"
 
@@ -23,6 +27,17 @@ static const std::vector<const char*> s_DeviceExtensions = {
 	VK_KHR_SWAPCHAIN_EXTENSION_NAME
 };
 
+// Enabled only when supported
+static const std::vector<const char*> s_OptionalDeviceExtensions = {
+	// Tells whether a pipeline was found in the PipelineCache, core in Vulkan 1.3
+	VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME,
+	// Per-heap budget and usage of the whole process, the TextureStreamer sizes itself from it
+	VK_EXT_MEMORY_BUDGET_EXTENSION_NAME
+};
+
+static constexpr const char* s_PipelineCachePath = "PipelineCache.bin";
+static constexpr const char* s_ReflectionCachePath = "ReflectionCache.bin";
+
 static QueueFamilyIndices FindQueueFamilies(const VkPhysicalDevice device, const VkSurfaceKHR surface)
 {
 	QueueFamilyIndices indices;
@@ -50,6 +65,26 @@ static QueueFamilyIndices FindQueueFamilies(const VkPhysicalDevice device, const
 		i++;
 	}
 
+	// Prefer a family with transfer support only, fall back to one without graphics
+	for (uint32_t i = 0; const VkQueueFamilyProperties & property : queueFamiliesProperties)
+	{
+		const VkQueueFlags flags = property.queueFlags;
+
+		if (property.queueCount > 0 && (flags & VK_QUEUE_TRANSFER_BIT) && !(flags & VK_QUEUE_GRAPHICS_BIT))
+		{
+			if (!(flags & VK_QUEUE_COMPUTE_BIT))
+			{
+				indices.TransferIndex = i;
+				break;
+			}
+
+			if (!indices.TransferIndex.has_value())
+				indices.TransferIndex = i;
+		}
+
+		i++;
+	}
+
 	return indices;
 }
 
@@ -154,6 +189,9 @@ void PhysicalDevice::Select(const Surface& surface)
 	ASSERT(m_QueueFamilyIndices.IsComplete());
 
 	LOG_TAGGED(s_LogTag, "Selected GPU: %s", QUOTED(m_Properties->deviceName));
+
+	if (m_QueueFamilyIndices.HasDedicatedTransfer())
+		LOG_TAGGED(s_LogTag, "Dedicated transfer queue family: #%i", m_QueueFamilyIndices.TransferIndex.value());
 }
 
 const VkPhysicalDeviceProperties& PhysicalDevice::GetProperties() const
@@ -193,6 +231,14 @@ VkFormat PhysicalDevice::GetDepthFormat() const
 	return {};
 }
 
+bool PhysicalDevice::HasFormatFeatures(VkFormat format, VkFormatFeatureFlags features) const
+{
+	VkFormatProperties props;
+	vkGetPhysicalDeviceFormatProperties(Handle::GetHandle(), format, &props);
+
+	return (props.optimalTilingFeatures & features) == features;
+}
+
 uint32_t PhysicalDevice::GetMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const
 {
 	VkPhysicalDeviceMemoryProperties memProperties;
@@ -215,14 +261,24 @@ Device::Device(const Instance& instance, const Surface& surface)
 	m_PhysicalDevice.Select(surface);
 	CreateDeviceAndQueues();
 
-	m_CommandPool = CreateScope<CommandPool>(*this);
+	m_Allocator = CreateScope<DeviceAllocator>(*this);
+	m_CommandPool = CreateScope<CommandPool>(*this, m_PhysicalDevice.GetQueueFamilyIndices().GraphicsIndex.value());
 	m_DescriptorPool = CreateScope<DescriptorPool>(*this);
+	m_PipelineCache = CreateScope<PipelineCache>(*this, s_PipelineCachePath);
+	m_ReflectionCache = CreateScope<ReflectionCache>(s_ReflectionCachePath);
+	m_DescriptorSetLayoutCache = CreateScope<DescriptorSetLayoutCache>(*this);
 }
 
 Device::~Device()
 {
 	m_CommandPool.reset();
 	m_DescriptorPool.reset();
+	m_PipelineCache.reset();
+	m_ReflectionCache.reset();
+	m_DescriptorSetLayoutCache.reset();
+
+	m_Allocator->LogStatistics();
+	m_Allocator.reset();
 
 	vkDestroyDevice(Handle::GetHandle(), nullptr);
 }
@@ -247,6 +303,11 @@ VkQueue Device::GetPresentQueue() const
 	return m_PresentQueue;
 }
 
+VkQueue Device::GetTransferQueue() const
+{
+	return m_TransferQueue;
+}
+
 const CommandPool& Device::GetCommandPool() const
 {
 	return *m_CommandPool;
@@ -257,6 +318,36 @@ const DescriptorPool& Device::GetDescriptorPool() const
 	return *m_DescriptorPool;
 }
 
+DeviceAllocator& Device::GetAllocator() const
+{
+	return *m_Allocator;
+}
+
+PipelineCache& Device::GetPipelineCache() const
+{
+	return *m_PipelineCache;
+}
+
+ReflectionCache& Device::GetReflectionCache() const
+{
+	return *m_ReflectionCache;
+}
+
+DescriptorSetLayoutCache& Device::GetDescriptorSetLayoutCache() const
+{
+	return *m_DescriptorSetLayoutCache;
+}
+
+bool Device::IsExtensionEnabled(const std::string& name) const
+{
+	return m_EnabledExtensions.contains(name);
+}
+
+bool Device::IsTextureCompressionBCEnabled() const
+{
+	return m_TextureCompressionBC;
+}
+
 void Device::CreateDeviceAndQueues()
 {
 	constexpr float queuePriority = 1.0f;
@@ -264,8 +355,9 @@ void Device::CreateDeviceAndQueues()
 	const QueueFamilyIndices& indices = m_PhysicalDevice.GetQueueFamilyIndices();
 	const uint32_t& graphicsIndex = indices.GraphicsIndex.value();
 	const uint32_t& presentIndex = indices.PresentIndex.value();
+	const uint32_t transferIndex = indices.GetTransferIndex();
 
-	std::set<uint32_t> uniqueIndices = { graphicsIndex, presentIndex };
+	std::set<uint32_t> uniqueIndices = { graphicsIndex, presentIndex, transferIndex };
 
 	std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
 	for (uint32_t queueFamily : uniqueIndices)
@@ -286,15 +378,59 @@ void Device::CreateDeviceAndQueues()
 	deviceFeatures.fillModeNonSolid = VK_TRUE;
 	deviceFeatures.wideLines = VK_TRUE;
 
+	{
+		VkPhysicalDeviceFeatures supportedFeatures;
+		vkGetPhysicalDeviceFeatures(m_PhysicalDevice.GetHandle(), &supportedFeatures);
+
+		// Optional, textures fall back to uncompressed formats without it
+		deviceFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;
+	}
+
+	m_TextureCompressionBC = deviceFeatures.textureCompressionBC;
+
+	// Core in Vulkan 1.2, used by the UploadQueue
+	VkPhysicalDeviceVulkan12Features vulkan12Features;
+	ZeroInitVkStruct(vulkan12Features, VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES);
+
+	vulkan12Features.timelineSemaphore = VK_TRUE;
+
 	VkDeviceCreateInfo createInfo;
 	ZeroInitVkStruct(createInfo, VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO);
 
+	createInfo.pNext = &vulkan12Features;
+
 	createInfo.pQueueCreateInfos = queueCreateInfos.data();
 	createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
 
+	std::vector<const char*> extensions = s_DeviceExtensions;
+
+	{
+		uint32_t count;
+		vkEnumerateDeviceExtensionProperties(m_PhysicalDevice.GetHandle(), nullptr, &count, nullptr);
+
+		std::vector<VkExtensionProperties> availableExtensions(count);
+		vkEnumerateDeviceExtensionProperties(m_PhysicalDevice.GetHandle(), nullptr, &count, availableExtensions.data());
+
+		for (const auto& optionalExtension : s_OptionalDeviceExtensions)
+		{
+			for (const auto& extension : availableExtensions)
+			{
+				if (std::string(optionalExtension) != extension.extensionName)
+					continue;
+
+				extensions.emplace_back(optionalExtension);
+				m_EnabledExtensions.emplace(optionalExtension);
+
+				LOG_TAGGED(s_LogTag, "Optional extension enabled: %s", optionalExtension);
+
+				break;
+			}
+		}
+	}
+
 	createInfo.pEnabledFeatures = &deviceFeatures;
-	createInfo.enabledExtensionCount = static_cast<uint32_t>(s_DeviceExtensions.size());
-	createInfo.ppEnabledExtensionNames = s_DeviceExtensions.data();
+	createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+	createInfo.ppEnabledExtensionNames = extensions.data();
 
 	createInfo.enabledLayerCount = static_cast<uint32_t>(g_ValidationLayers.size());
 	createInfo.ppEnabledLayerNames = g_ValidationLayers.data();
@@ -305,5 +441,6 @@ void Device::CreateDeviceAndQueues()
 
 	vkGetDeviceQueue(Handle::GetHandle(), graphicsIndex, 0, &m_GraphicsQueue);
 	vkGetDeviceQueue(Handle::GetHandle(), presentIndex, 0, &m_PresentQueue);
-	ASSERT(m_GraphicsQueue && m_PresentQueue, "Queue creation failed");
+	vkGetDeviceQueue(Handle::GetHandle(), transferIndex, 0, &m_TransferQueue);
+	ASSERT(m_GraphicsQueue && m_PresentQueue && m_TransferQueue, "Queue creation failed");
 }
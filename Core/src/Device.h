@@ -7,6 +7,8 @@
 #include "CommandPool.h"
 
 #include <optional>
+#include <set>
+#include <string>
 
 class Instance;
 class Surface;
@@ -15,10 +17,17 @@ struct QueueFamilyIndices
 {
 	std::optional<uint32_t> GraphicsIndex;
 	std::optional<uint32_t> PresentIndex;
+	// Transfer-only family (DMA engine on discrete GPUs), optional
+	std::optional<uint32_t> TransferIndex;
 
 	bool IsComplete() const { return GraphicsIndex.has_value() && PresentIndex.has_value(); }
 
 	bool IsSame() const { return GraphicsIndex == PresentIndex; }
+
+	bool HasDedicatedTransfer() const { return TransferIndex.has_value() && TransferIndex != GraphicsIndex; }
+
+	// Falls back to the graphics family
+	uint32_t GetTransferIndex() const { return HasDedicatedTransfer() ? TransferIndex.value() : GraphicsIndex.value(); }
 };
 
 class PhysicalDevice : public Handle<VkPhysicalDevice>
@@ -34,6 +43,8 @@ public:
 	const QueueFamilyIndices& GetQueueFamilyIndices() const;
 
 	VkFormat GetDepthFormat() const;
+	// With optimal tiling
+	bool HasFormatFeatures(VkFormat format, VkFormatFeatureFlags features) const;
 	uint32_t GetMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
 private:
 	const Instance& m_Instance;
@@ -44,6 +55,10 @@ private:
 };
 
 class DescriptorPool;
+class DeviceAllocator;
+class PipelineCache;
+class ReflectionCache;
+class DescriptorSetLayoutCache;
 
 class Device : public Handle<VkDevice>
 {
@@ -56,16 +71,35 @@ public:
 	const PhysicalDevice& GetPhysicalDevice() const;
 	VkQueue GetGraphicsQueue() const;
 	VkQueue GetPresentQueue() const;
+	// Same as the graphics queue when there's no dedicated transfer family
+	VkQueue GetTransferQueue() const;
 	const CommandPool& GetCommandPool() const;
 	const DescriptorPool& GetDescriptorPool() const;
+	DeviceAllocator& GetAllocator() const;
+	PipelineCache& GetPipelineCache() const;
+	ReflectionCache& GetReflectionCache() const;
+	DescriptorSetLayoutCache& GetDescriptorSetLayoutCache() const;
+
+	// Only for the optional extensions, the required ones are always enabled
+	bool IsExtensionEnabled(const std::string& name) const;
+	// Optional feature, enabled if supported
+	bool IsTextureCompressionBCEnabled() const;
 private:
 	void CreateDeviceAndQueues();
 private:
 	PhysicalDevice m_PhysicalDevice;
 	VkQueue m_GraphicsQueue;
 	VkQueue m_PresentQueue;
+	VkQueue m_TransferQueue;
+
+	std::set<std::string> m_EnabledExtensions;
+	bool m_TextureCompressionBC = false;
 
 	// Should it be here?
 	Scope<CommandPool> m_CommandPool;
 	Scope<DescriptorPool> m_DescriptorPool;
+	Scope<DeviceAllocator> m_Allocator;
+	Scope<PipelineCache> m_PipelineCache;
+	Scope<ReflectionCache> m_ReflectionCache;
+	Scope<DescriptorSetLayoutCache> m_DescriptorSetLayoutCache;
 };
\ No newline at end of file
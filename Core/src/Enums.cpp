@@ -28,6 +28,28 @@ VkFormat Convert(Format format)
 		return VK_FORMAT_R32G32B32_SFLOAT;
 	case Format::RG_32_SFLOAT:
 		return VK_FORMAT_R32G32_SFLOAT;
+	case Format::RGBA_16_SNORM:
+		return VK_FORMAT_R16G16B16A16_SNORM;
+	case Format::RGBA_16_SFLOAT:
+		return VK_FORMAT_R16G16B16A16_SFLOAT;
+	case Format::RG_16_SNORM:
+		return VK_FORMAT_R16G16_SNORM;
+	case Format::RG_16_UNORM:
+		return VK_FORMAT_R16G16_UNORM;
+	case Format::RG_16_SFLOAT:
+		return VK_FORMAT_R16G16_SFLOAT;
+	case Format::RGBA_8_UNORM:
+		return VK_FORMAT_R8G8B8A8_UNORM;
+	case Format::RGBA_8_SNORM:
+		return VK_FORMAT_R8G8B8A8_SNORM;
+	case Format::BC1_RGBA_SRGB:
+		return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+	case Format::BC3_RGBA_SRGB:
+		return VK_FORMAT_BC3_SRGB_BLOCK;
+	case Format::BC5_RG_UNORM:
+		return VK_FORMAT_BC5_UNORM_BLOCK;
+	case Format::BC7_RGBA_SRGB:
+		return VK_FORMAT_BC7_SRGB_BLOCK;
 	case Format::D32_SFLOAT:
 		return VK_FORMAT_D32_SFLOAT;
 	default:
@@ -44,6 +66,36 @@ uint32_t GetStrideFromFormat(VkFormat format)
 	{
 	case VK_FORMAT_R8_SINT:
 		return sizeof(int);
+	case VK_FORMAT_R8_UINT:
+		return sizeof(uint8_t);
+	case VK_FORMAT_R8G8B8A8_UNORM:
+	case VK_FORMAT_R8G8B8A8_SNORM:
+	case VK_FORMAT_R8G8B8A8_UINT:
+	case VK_FORMAT_R8G8B8A8_SINT:
+		return 4 * sizeof(uint8_t);
+	case VK_FORMAT_R16_UINT:
+	case VK_FORMAT_R16_SINT:
+	case VK_FORMAT_R16_SFLOAT:
+		return sizeof(uint16_t);
+	case VK_FORMAT_R16G16_UNORM:
+	case VK_FORMAT_R16G16_SNORM:
+	case VK_FORMAT_R16G16_UINT:
+	case VK_FORMAT_R16G16_SINT:
+	case VK_FORMAT_R16G16_SFLOAT:
+		return 2 * sizeof(uint16_t);
+	case VK_FORMAT_R16G16B16_UINT:
+	case VK_FORMAT_R16G16B16_SINT:
+	case VK_FORMAT_R16G16B16_SFLOAT:
+		return 3 * sizeof(uint16_t);
+	case VK_FORMAT_R16G16B16A16_UNORM:
+	case VK_FORMAT_R16G16B16A16_SNORM:
+	case VK_FORMAT_R16G16B16A16_UINT:
+	case VK_FORMAT_R16G16B16A16_SINT:
+	case VK_FORMAT_R16G16B16A16_SFLOAT:
+		return 4 * sizeof(uint16_t);
+	case VK_FORMAT_R32_UINT:
+	case VK_FORMAT_R32_SINT:
+		return sizeof(uint32_t);
 	case VK_FORMAT_R32_SFLOAT:
 		return sizeof(float);
 	case VK_FORMAT_R32G32_SFLOAT:
@@ -52,6 +104,9 @@ uint32_t GetStrideFromFormat(VkFormat format)
 		return sizeof(glm::vec3);
 	case VK_FORMAT_R32G32B32A32_SFLOAT:
 		return sizeof(glm::vec4);
+	case VK_FORMAT_A2B10G10R10_UNORM_PACK32:
+	case VK_FORMAT_A2B10G10R10_SNORM_PACK32:
+		return sizeof(uint32_t);
 	case VK_FORMAT_R32G32_SINT:
 		return sizeof(glm::ivec2);
 	case VK_FORMAT_R32G32B32_SINT:
@@ -77,6 +132,7 @@ uint32_t FormatBytesPerPixel(Format format)
 	switch (format)
 	{
 	case Format::RGBA_8_SRGB:
+	case Format::RGBA_8_UNORM:
 		return 4;
 	default:
 		break;
@@ -100,6 +156,71 @@ Format FormatBytesPerPixel(uint32_t channels)
 	return Format::UNDEFINED;
 }
 
+bool IsBlockCompressed(Format format)
+{
+	switch (format)
+	{
+	case Format::BC1_RGBA_SRGB:
+	case Format::BC3_RGBA_SRGB:
+	case Format::BC5_RG_UNORM:
+	case Format::BC7_RGBA_SRGB:
+		return true;
+	default:
+		break;
+	}
+
+	return false;
+}
+
+bool IsSRGB(Format format)
+{
+	switch (format)
+	{
+	case Format::RGBA_8_SRGB:
+	case Format::BGRA_8_SRGB:
+	case Format::BC1_RGBA_SRGB:
+	case Format::BC3_RGBA_SRGB:
+	case Format::BC7_RGBA_SRGB:
+		return true;
+	default:
+		break;
+	}
+
+	return false;
+}
+
+uint32_t FormatBlockExtent(Format format)
+{
+	return IsBlockCompressed(format) ? 4 : 1;
+}
+
+uint32_t FormatBytesPerBlock(Format format)
+{
+	switch (format)
+	{
+	case Format::BC1_RGBA_SRGB:
+		return 8;
+	case Format::BC3_RGBA_SRGB:
+	case Format::BC5_RG_UNORM:
+	case Format::BC7_RGBA_SRGB:
+		return 16;
+	default:
+		break;
+	}
+
+	return FormatBytesPerPixel(format);
+}
+
+uint64_t FormatImageSize(Format format, uint32_t width, uint32_t height)
+{
+	const uint32_t extent = FormatBlockExtent(format);
+
+	const uint64_t blocksX = (width + extent - 1) / extent;
+	const uint64_t blocksY = (height + extent - 1) / extent;
+
+	return blocksX * blocksY * FormatBytesPerBlock(format);
+}
+
 VkSampleCountFlagBits Convert(uint8_t msaaNumSamples)
 {
 #define MSAA_NUM_SAMPLE_CASE(msaaNumSample) \
@@ -127,6 +248,14 @@ VkShaderStageFlagBits Convert(StageFlag stage)
 		return VK_SHADER_STAGE_VERTEX_BIT;
 	case StageFlag::FRAGMENT:
 		return VK_SHADER_STAGE_FRAGMENT_BIT;
+	case StageFlag::GEOMETRY:
+		return VK_SHADER_STAGE_GEOMETRY_BIT;
+	case StageFlag::TESSELLATION_CONTROL:
+		return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+	case StageFlag::TESSELLATION_EVALUATION:
+		return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+	case StageFlag::COMPUTE:
+		return VK_SHADER_STAGE_COMPUTE_BIT;
 	case StageFlag::ALL_GRAPHICS:
 		return VK_SHADER_STAGE_ALL_GRAPHICS;
 	default:
@@ -145,6 +274,14 @@ const char* ShaderStageString(StageFlag stage)
 		return "Vertex";
 	case StageFlag::FRAGMENT:
 		return "Fragment";
+	case StageFlag::GEOMETRY:
+		return "Geometry";
+	case StageFlag::TESSELLATION_CONTROL:
+		return "Tessellation Control";
+	case StageFlag::TESSELLATION_EVALUATION:
+		return "Tessellation Evaluation";
+	case StageFlag::COMPUTE:
+		return "Compute";
 	default:
 		break;
 	}
@@ -153,6 +290,26 @@ const char* ShaderStageString(StageFlag stage)
 	return nullptr;
 }
 
+const char* SpecializationConstantTypeString(SpecializationConstantType type)
+{
+	switch (type)
+	{
+	case SpecializationConstantType::BOOL:
+		return "bool";
+	case SpecializationConstantType::INT:
+		return "int";
+	case SpecializationConstantType::UINT:
+		return "uint";
+	case SpecializationConstantType::FLOAT:
+		return "float";
+	default:
+		break;
+	}
+
+	ASSERT(false, "Unknown specialization constant type");
+	return nullptr;
+}
+
 VkDescriptorType Convert(DescriptorType type)
 {
 	switch (type)
@@ -161,6 +318,8 @@ VkDescriptorType Convert(DescriptorType type)
 		return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
 	case DescriptorType::COMBINED_IMAGE_SAMPLER:
 		return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	case DescriptorType::DYNAMIC_UNIFORM_BUFFER:
+		return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	default:
 		break;
 	}
@@ -177,6 +336,8 @@ DescriptorType Convert(VkDescriptorType type)
 		return DescriptorType::COMBINED_IMAGE_SAMPLER;
 	case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
 		return DescriptorType::UNIFORM_BUFFER;
+	case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+		return DescriptorType::DYNAMIC_UNIFORM_BUFFER;
 	default:
 		break;
 	}
@@ -25,6 +25,27 @@ enum class Format : int
 	// 32 bits/component
 	RG_32_SFLOAT,
 
+	// Packed vertex attributes, see PackedVertex
+
+	// 16 bits/component
+	RGBA_16_SNORM,
+	RGBA_16_SFLOAT,
+	RG_16_SNORM,
+	RG_16_UNORM,
+	RG_16_SFLOAT,
+	// 8 bits/component
+	RGBA_8_UNORM,
+	RGBA_8_SNORM,
+
+	// Block compressed, 4x4 texels per block, see TextureCompressor
+
+	// 8 bytes/block
+	BC1_RGBA_SRGB,
+	// 16 bytes/block
+	BC3_RGBA_SRGB,
+	BC5_RG_UNORM,
+	BC7_RGBA_SRGB,
+
 	// Depth
 
 	D32_SFLOAT
@@ -34,6 +55,14 @@ VkFormat Convert(Format format);
 uint32_t GetStrideFromFormat(VkFormat format);
 uint32_t FormatBytesPerPixel(Format format);
 Format FormatBytesPerPixel(uint32_t channels);
+bool IsBlockCompressed(Format format);
+bool IsSRGB(Format format);
+// Width and height of a block in texels, 1 for uncompressed formats
+uint32_t FormatBlockExtent(Format format);
+// Same as FormatBytesPerPixel() for uncompressed formats
+uint32_t FormatBytesPerBlock(Format format);
+// Size of a single width x height image, partial blocks are rounded up
+uint64_t FormatImageSize(Format format, uint32_t width, uint32_t height);
 
 // Unused
 enum class MSAASamples
@@ -48,6 +77,10 @@ enum class StageFlag : int
 
 	VERTEX,
 	FRAGMENT,
+	GEOMETRY,
+	TESSELLATION_CONTROL,
+	TESSELLATION_EVALUATION,
+	COMPUTE,
 	ALL_GRAPHICS
 };
 
@@ -72,7 +105,6 @@ enum class DescriptorType : int
 	// Also, describes a VkSampler object
 	SAMPLER,
 
-	// Unused
 	// A uniform buffer whose offset is specified each time the uniform buffer is bound to 
 	// a command buffer via a descriptor set
 	DYNAMIC_UNIFORM_BUFFER,
@@ -86,6 +118,19 @@ VkDescriptorType Convert(DescriptorType type);
 DescriptorType Convert(VkDescriptorType type);
 const char* DescriptorTypeString(DescriptorType type);
 
+// All 32-bit, bools are VkBool32
+enum class SpecializationConstantType
+{
+	UNDEFINED = 0,
+
+	BOOL,
+	INT,
+	UINT,
+	FLOAT
+};
+
+const char* SpecializationConstantTypeString(SpecializationConstantType type);
+
 enum class CullMode
 {
 	NONE,
@@ -166,6 +211,36 @@ enum class AttachmentType
 	DEPTH_STNCIL
 };
 
+enum class TextureCompression : int
+{
+	NONE = 0,
+
+	// RGB + 1-bit alpha, 4 bits/texel
+	BC1,
+	// RGBA, 8 bits/texel
+	BC3,
+	// Two channels, for normal maps, 8 bits/texel
+	BC5,
+	// RGBA, best quality, 8 bits/texel
+	BC7
+};
+
+enum class MipGeneration : int
+{
+	// Filtered on load (see MipGenerator), cached with the texture when it comes from a single file
+	CPU = 0,
+	// vkCmdBlitImage chain, the default, formats without linear blit support fall back to the CPU
+	GPU
+};
+
+enum class MipFilter : int
+{
+	// 2x2 average
+	BOX = 0,
+	// Windowed sinc, sharper, the default for CPU mips
+	KAISER
+};
+
 enum class MeshPrimitiveType : int
 {
 	NONE = 0,
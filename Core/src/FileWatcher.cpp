@@ -0,0 +1,167 @@
+#include "FileWatcher.h"
+
+#include "Utils.h"
+
+#include "Log.h"
+
+#include <algorithm>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <array>
+#endif
+
+static constexpr const char* s_LogTag = "[FileWatcher]";
+
+#ifdef __linux__
+// Editors either write in place or write a copy and rename it over the original
+static constexpr uint32_t s_EventMask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE;
+
+FileWatcher::FileWatcher()
+	: m_Handle(inotify_init1(IN_NONBLOCK | IN_CLOEXEC))
+{
+	if (-1 == m_Handle)
+		LOG_TAGGED(s_LogTag, "inotify is unavailable, changes won't be reported");
+}
+
+FileWatcher::~FileWatcher()
+{
+	if (-1 != m_Handle)
+		close(m_Handle);
+}
+
+void FileWatcher::AddDirectory(const std::filesystem::path& directory)
+{
+	const int descriptor = inotify_add_watch(m_Handle, directory.c_str(), s_EventMask);
+
+	if (-1 == descriptor)
+	{
+		LOG_TAGGED(s_LogTag, "Failed to watch %s", directory.string().data());
+		return;
+	}
+
+	m_Directories[descriptor] = directory;
+}
+
+std::vector<std::filesystem::path> FileWatcher::Poll()
+{
+	std::vector<std::filesystem::path> changes;
+
+	if (-1 == m_Handle)
+		return changes;
+
+	alignas(inotify_event) std::array<char, 4096> buffer;
+
+	while (true)
+	{
+		const ssize_t size = read(m_Handle, buffer.data(), buffer.size());
+
+		// EAGAIN, nothing left
+		if (size <= 0)
+			break;
+
+		for (ssize_t offset = 0; offset < size;)
+		{
+			const auto* event = reinterpret_cast<const inotify_event*>(buffer.data() + offset);
+			offset += sizeof(inotify_event) + event->len;
+
+			if (0 == event->len || (event->mask & IN_ISDIR))
+				continue;
+
+			const auto it = m_Directories.find(event->wd);
+
+			if (it == m_Directories.end())
+				continue;
+
+			auto path = it->second / event->name;
+			NormalizePath(path);
+
+			if (std::ranges::find(changes, path) == changes.end())
+				changes.push_back(std::move(path));
+		}
+	}
+
+	return changes;
+}
+#else
+FileWatcher::FileWatcher()
+{
+}
+
+FileWatcher::~FileWatcher()
+{
+}
+
+void FileWatcher::AddDirectory(const std::filesystem::path& directory)
+{
+	m_Directories.push_back(directory);
+
+	std::error_code error;
+
+	for (const auto& entry : std::filesystem::directory_iterator(directory, error))
+	{
+		if (entry.is_regular_file())
+			m_Timestamps[entry.path().string()] = GetFileTimestamp(entry.path());
+	}
+}
+
+std::vector<std::filesystem::path> FileWatcher::Poll()
+{
+	std::vector<std::filesystem::path> changes;
+
+	if (m_Timer.Elapsed() < s_PollInterval)
+		return changes;
+
+	m_Timer.Reset();
+
+	for (const auto& directory : m_Directories)
+	{
+		std::error_code error;
+
+		for (const auto& entry : std::filesystem::directory_iterator(directory, error))
+		{
+			if (!entry.is_regular_file())
+				continue;
+
+			const int64_t timestamp = GetFileTimestamp(entry.path());
+			auto& previous = m_Timestamps[entry.path().string()];
+
+			if (previous == timestamp)
+				continue;
+
+			previous = timestamp;
+
+			auto path = entry.path();
+			NormalizePath(path);
+
+			changes.push_back(std::move(path));
+		}
+	}
+
+	return changes;
+}
+#endif
+
+bool FileWatcher::Watch(const std::filesystem::path& directory)
+{
+	std::error_code error;
+
+	if (!std::filesystem::is_directory(directory, error))
+	{
+		LOG_TAGGED(s_LogTag, "%s isn't a directory", directory.string().data());
+		return false;
+	}
+
+	AddDirectory(directory);
+
+	for (const auto& entry : std::filesystem::recursive_directory_iterator(directory, error))
+	{
+		if (entry.is_directory())
+			AddDirectory(entry.path());
+	}
+
+	return true;
+}
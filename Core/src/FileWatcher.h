@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Base.h"
+
+#include "Timer.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Reports the files created or modified in the watched directories, along with their subdirectories present when Watch() was called
+// inotify on Linux, elsewhere the timestamps are compared, every s_PollInterval at most
+class FileWatcher
+{
+public:
+	FileWatcher();
+	~FileWatcher();
+
+	DELETE_COPY_AND_MOVE(FileWatcher);
+
+	bool Watch(const std::filesystem::path& directory);
+
+	// Non-blocking, every file changed since the last call, once each
+	std::vector<std::filesystem::path> Poll();
+
+	static constexpr float s_PollInterval = 0.25f;
+private:
+	void AddDirectory(const std::filesystem::path& directory);
+private:
+#ifdef __linux__
+	int m_Handle = -1;
+	// Watch descriptor to directory
+	std::unordered_map<int, std::filesystem::path> m_Directories;
+#else
+	std::vector<std::filesystem::path> m_Directories;
+	std::unordered_map<std::string, int64_t> m_Timestamps;
+
+	Timer m_Timer;
+#endif
+};
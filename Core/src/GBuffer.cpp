@@ -2,12 +2,15 @@
 
 #include "Context.h"
 #include "Device.h"
+#include "UploadQueue.h"
 
 #include "Log.h"
 
 #include <volk.h>
 #include <vulkan/vulkan.h>
 
+#include <array>
+
 Ref<GBuffer> GBuffer::Create(const GBufferDescription& desc)
 {
 	return CreateRef<GBuffer>(desc);
@@ -18,8 +21,8 @@ Ref<GBuffer> GBuffer::CreateVertex(VkDeviceSize size, const void* data)
 	GBufferDescription desc;
 
 	desc.Size = size;
-	desc.Usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-	desc.Properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	desc.Usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	desc.Properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
 
 	Ref<GBuffer> buffer = GBuffer::Create(desc);
 
@@ -34,8 +37,8 @@ Ref<GBuffer> GBuffer::CreateIndex(VkDeviceSize size, uint32_t count, const void*
 	GBufferDescription desc;
 
 	desc.Size = size;
-	desc.Usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
-	desc.Properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	desc.Usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	desc.Properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
 	desc.IndexCount = count;
 
 	Ref<GBuffer> buffer = GBuffer::Create(desc);
@@ -76,10 +79,10 @@ GBuffer::GBuffer(const GBufferDescription& desc)
 
 GBuffer::~GBuffer()
 {
-	const auto& device = Context::GetDevice().GetHandle();
+	auto& device = Context::GetDevice();
 
-	vkDestroyBuffer(device, Handle::GetHandle<VkBuffer>(), nullptr);
-	vkFreeMemory(device, Handle::GetHandle<VkDeviceMemory>(), nullptr);
+	vkDestroyBuffer(device.GetHandle(), Handle::GetHandle<VkBuffer>(), nullptr);
+	device.GetAllocator().Free(m_Allocation);
 }
 
 void GBuffer::SetData(const void* data, VkDeviceSize size, VkDeviceSize offset)
@@ -87,14 +90,17 @@ void GBuffer::SetData(const void* data, VkDeviceSize size, VkDeviceSize offset)
 	ASSERT(data);
 	ASSERT(offset + size <= m_Description.Size);
 
-	const auto& device = Context::GetDevice().GetHandle();
-	auto& memoryHandle = Handle::GetHandle<VkDeviceMemory>();
+	// Device-local memory is filled through a staging buffer, the copy completes asynchronously
+	if (!m_Allocation.IsMapped())
+	{
+		Context::GetUploadQueue().Upload(*this, data, size, offset);
 
-	void* mappedData = nullptr;
+		return;
+	}
 
-	vkMapMemory(device, memoryHandle, 0, size, 0, (void**)&mappedData);
-	memcpy(static_cast<char*>(mappedData) + offset, data, static_cast<size_t>(size));
-	vkUnmapMemory(device, memoryHandle);
+	memcpy(GetMappedData(offset + size) + offset, data, static_cast<size_t>(size));
+
+	Flush(offset, size);
 }
 
 void GBuffer::SetData(const void* data)
@@ -102,6 +108,26 @@ void GBuffer::SetData(const void* data)
 	SetData(data, m_Description.Size);
 }
 
+std::span<std::byte> GBuffer::GetMappedSpan() const
+{
+	return { GetMappedData(m_Description.Size), static_cast<size_t>(m_Description.Size) };
+}
+
+void GBuffer::Flush(VkDeviceSize offset, VkDeviceSize size) const
+{
+	Context::GetDevice().GetAllocator().Flush(m_Allocation, offset, size);
+}
+
+void GBuffer::Invalidate(VkDeviceSize offset, VkDeviceSize size) const
+{
+	Context::GetDevice().GetAllocator().Invalidate(m_Allocation, offset, size);
+}
+
+bool GBuffer::IsMapped() const
+{
+	return m_Allocation.IsMapped();
+}
+
 const GBufferDescription& GBuffer::GetDescription() const
 {
 	return m_Description;
@@ -122,27 +148,34 @@ void GBuffer::CreateBuffer()
 	bufferInfo.usage = m_Description.Usage;
 	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
+	const auto& indices = device.GetPhysicalDevice().GetQueueFamilyIndices();
+	const std::array queueFamilies = { indices.GraphicsIndex.value(), indices.GetTransferIndex() };
+
+	// Written by the transfer queue and read by the graphics queue, no ownership transfer needed
+	if ((m_Description.Usage & VK_BUFFER_USAGE_TRANSFER_DST_BIT) && indices.HasDedicatedTransfer())
+	{
+		bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+		bufferInfo.queueFamilyIndexCount = static_cast<uint32_t>(queueFamilies.size());
+		bufferInfo.pQueueFamilyIndices = queueFamilies.data();
+	}
+
 	auto& bufferHandle = Handle::GetHandle<VkBuffer>();
 
 	VkResult result = vkCreateBuffer(vkDevice, &bufferInfo, nullptr, &bufferHandle);
 	VK_CHECK_RESULT(result);
 	ASSERT(bufferHandle, "GBuffer Creation failed");
 
-	VkMemoryRequirements memRequirements;
-	vkGetBufferMemoryRequirements(vkDevice, bufferHandle, &memRequirements);
-
-	VkMemoryAllocateInfo allocInfo;
-	ZeroInitVkStruct(allocInfo, VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO);
-
-	allocInfo.allocationSize = memRequirements.size;
-	allocInfo.memoryTypeIndex = device.GetPhysicalDevice().GetMemoryType(memRequirements.memoryTypeBits, m_Description.Properties);
+	m_Allocation = device.GetAllocator().AllocateBuffer(bufferHandle, m_Description.Properties);
 
 	auto& memoryHandle = Handle::GetHandle<VkDeviceMemory>();
-
-	result = vkAllocateMemory(vkDevice, &allocInfo, nullptr, &memoryHandle);
-	VK_CHECK_RESULT(result);
+	memoryHandle = m_Allocation.Memory;
 	ASSERT(memoryHandle, "Failed to allocate buffer memory");
+}
 
-	result = vkBindBufferMemory(vkDevice, bufferHandle, memoryHandle, 0);
-	VK_CHECK_RESULT(result);
+std::byte* GBuffer::GetMappedData(VkDeviceSize size) const
+{
+	ASSERT(m_Allocation.IsMapped(), "GBuffer is not host visible");
+	ASSERT(size <= m_Description.Size);
+
+	return static_cast<std::byte*>(m_Allocation.MappedData);
 }
@@ -4,6 +4,11 @@
 
 #include "VK.h"
 
+#include "Allocator.h"
+
+#include <span>
+#include <cstddef>
+
 struct GBufferDescription
 {
 	VkDeviceSize Size = 0;
@@ -18,6 +23,9 @@ struct GBufferDescription
 class GBuffer : public Handle<VkBuffer, VkDeviceMemory>
 {
 public:
+	// Same value as VK_WHOLE_SIZE
+	static constexpr VkDeviceSize WholeSize = ~0ULL;
+
 	static Ref<GBuffer> Create(const GBufferDescription& desc);
 
 	static Ref<GBuffer> CreateVertex(VkDeviceSize size, const void* data = nullptr);
@@ -30,13 +38,33 @@ public:
 
 	DELETE_COPY_AND_MOVE(GBuffer);
 
+	// Host-visible buffers are written directly, device-local ones through the UploadQueue
 	void SetData(const void* data, VkDeviceSize size, VkDeviceSize offset = 0);
 	// Will use the size defined with GBufferDescription::Size
 	void SetData(const void* data);
 
+	// Host-visible buffers are mapped once on creation, writes go straight to the GPU-visible memory
+	// Call Flush() after writing/Invalidate() before reading, they do nothing for HOST_COHERENT memory
+	std::span<std::byte> GetMappedSpan() const;
+
+	template<typename T>
+	T* Map() const
+	{
+		return reinterpret_cast<T*>(GetMappedData(sizeof(T)));
+	}
+
+	void Flush(VkDeviceSize offset = 0, VkDeviceSize size = WholeSize) const;
+	void Invalidate(VkDeviceSize offset = 0, VkDeviceSize size = WholeSize) const;
+
+	bool IsMapped() const;
+
 	const GBufferDescription& GetDescription() const;
 private:
 	void CreateBuffer();
+
+	std::byte* GetMappedData(VkDeviceSize size) const;
 private:
 	GBufferDescription m_Description;
+
+	Allocation m_Allocation;
 };
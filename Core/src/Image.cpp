@@ -10,6 +10,9 @@
 #include <volk.h>
 #include <vulkan/vulkan.h>
 
+#include <algorithm>
+#include <vector>
+
 static bool HasStencil(VkFormat format)
 {
 	return format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT;
@@ -48,22 +51,20 @@ Image2D::Image2D(const ImageDescription& desc, VkImage image)
 
 Image2D::~Image2D()
 {
-	const auto& vkDevice = Context::GetDevice().GetHandle();
+	auto& device = Context::GetDevice();
+	const auto& vkDevice = device.GetHandle();
 
 	vkDestroyImageView(vkDevice, Handle::GetHandle<VkImageView>(), nullptr);
 
 	if (!m_Description.IsSwapchainImage)
 	{
 		vkDestroyImage(vkDevice, Handle::GetHandle<VkImage>(), nullptr);
-		vkFreeMemory(vkDevice, Handle::GetHandle<VkDeviceMemory>(), nullptr);
+		device.GetAllocator().Free(m_Allocation);
 	}
 }
 
-void Image2D::TransitionImageLayout(VkImageLayout newLayout, VkImageLayout oldLayout)
+void Image2D::TransitionImageLayout(CommandBuffer& commandBuffer, VkImageLayout newLayout, VkImageLayout oldLayout)
 {
-	Ref<CommandBuffer> commandBuffer = CommandBuffer::Create(true);
-	commandBuffer->BeginRecording(true);
-
 	VkImageMemoryBarrier barrier;
 	ZeroInitVkStruct(barrier, VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER);
 
@@ -121,17 +122,11 @@ void Image2D::TransitionImageLayout(VkImageLayout newLayout, VkImageLayout oldLa
 		ASSERT(false, "Unsupported layout transition");
 	}
 
-	vkCmdPipelineBarrier(commandBuffer->GetHandle(), sourceStage, destinationStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
-
-	commandBuffer->EndRecording();
-	commandBuffer->Submit();
+	vkCmdPipelineBarrier(commandBuffer.GetHandle(), sourceStage, destinationStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
 }
 
-void Image2D::CopyFrom(const GBuffer& buffer)
+void Image2D::CopyFrom(CommandBuffer& commandBuffer, const GBuffer& buffer)
 {
-	Ref<CommandBuffer> commandBuffer = CommandBuffer::Create(true);
-	commandBuffer->BeginRecording(true);
-
 	VkBufferImageCopy region = {};
 
 	region.bufferOffset = 0;
@@ -144,12 +139,37 @@ void Image2D::CopyFrom(const GBuffer& buffer)
 	region.imageOffset = { 0, 0, 0 };
 	region.imageExtent = { m_Description.Width, m_Description.Height, 1 };
 
-	vkCmdCopyBufferToImage(commandBuffer->GetHandle(), buffer.GetHandle<VkBuffer>(), Handle::GetHandle<VkImage>(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+	vkCmdCopyBufferToImage(commandBuffer.GetHandle(), buffer.GetHandle<VkBuffer>(), Handle::GetHandle<VkImage>(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+	GenerateMipMaps(commandBuffer);
+}
+
+void Image2D::CopyFrom(CommandBuffer& commandBuffer, const GBuffer& buffer, std::span<const VkDeviceSize> levelOffsets)
+{
+	ASSERT(levelOffsets.size() == m_Description.MipLevels);
+
+	std::vector<VkBufferImageCopy> regions(levelOffsets.size());
+
+	for (uint32_t level = 0; level < regions.size(); level++)
+	{
+		auto& region = regions[level];
+
+		// Tightly packed, partial blocks of compressed formats are rounded up
+		region.bufferOffset = levelOffsets[level];
+		region.bufferRowLength = 0;
+		region.bufferImageHeight = 0;
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = level;
+		region.imageSubresource.baseArrayLayer = 0;
+		region.imageSubresource.layerCount = m_Description.ImageCount;
+		region.imageOffset = { 0, 0, 0 };
+		region.imageExtent = { std::max(m_Description.Width >> level, 1u), std::max(m_Description.Height >> level, 1u), 1 };
+	}
 
-	commandBuffer->EndRecording();
-	commandBuffer->Submit();
+	vkCmdCopyBufferToImage(commandBuffer.GetHandle(), buffer.GetHandle<VkBuffer>(), Handle::GetHandle<VkImage>(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		static_cast<uint32_t>(regions.size()), regions.data());
 
-	GenerateMipMaps();
+	TransitionImageLayout(commandBuffer, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
 }
 
 uint32_t Image2D::GetWidth() const
@@ -169,7 +189,6 @@ Format Image2D::GetFormat() const
 
 void Image2D::CreateImage()
 {
-	const auto& physicalDevice = Context::GetDevice().GetPhysicalDevice();
 	const auto& device = Context::GetDevice().GetHandle();
 
 	ASSERT(0 < m_Description.ImageCount);
@@ -198,23 +217,11 @@ void Image2D::CreateImage()
 	VK_CHECK_RESULT(result);
 	ASSERT(imageHandle, "Image creation failed");
 
-	VkMemoryRequirements memRequirements;
-	vkGetImageMemoryRequirements(device, imageHandle, &memRequirements);
-
-	VkMemoryAllocateInfo allocInfo;
-	ZeroInitVkStruct(allocInfo, VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO);
-
-	allocInfo.allocationSize = memRequirements.size;
-	allocInfo.memoryTypeIndex = physicalDevice.GetMemoryType(memRequirements.memoryTypeBits, m_Description.Properties);
+	m_Allocation = Context::GetDevice().GetAllocator().AllocateImage(imageHandle, m_Description.Properties);
 
 	auto& memoryHandle = Handle::GetHandle<VkDeviceMemory>();
-
-	result = vkAllocateMemory(device, &allocInfo, nullptr, &memoryHandle);
-	VK_CHECK_RESULT(result);
+	memoryHandle = m_Allocation.Memory;
 	ASSERT(memoryHandle, "Failed to allocate image memory");
-
-	result = vkBindImageMemory(device, imageHandle, memoryHandle, 0);
-	VK_CHECK_RESULT(result);
 }
 
 void Image2D::CreateImageView()
@@ -242,7 +249,7 @@ void Image2D::CreateImageView()
 	ASSERT(imageViewHandle, "ImageView creation failed");
 }
 
-void Image2D::GenerateMipMaps()
+void Image2D::GenerateMipMaps(CommandBuffer& commandBuffer)
 {
 	const auto& physicalDevice = Context::GetDevice().GetPhysicalDevice().GetHandle();
 
@@ -251,9 +258,6 @@ void Image2D::GenerateMipMaps()
 
 	ASSERT(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT, "Image format doesn't support linear blitting");
 
-	Ref<CommandBuffer> commandBuffer = CommandBuffer::Create(true);
-	commandBuffer->BeginRecording(true);
-
 	VkImageMemoryBarrier barrier;
 	ZeroInitVkStruct(barrier, VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER);
 
@@ -280,7 +284,7 @@ void Image2D::GenerateMipMaps()
 		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
 		barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
 
-		vkCmdPipelineBarrier(commandBuffer->GetHandle(), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+		vkCmdPipelineBarrier(commandBuffer.GetHandle(), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
 
 		VkImageBlit blit = {};
 
@@ -300,14 +304,14 @@ void Image2D::GenerateMipMaps()
 		blit.dstSubresource.baseArrayLayer = 0;
 		blit.dstSubresource.layerCount = m_Description.ImageCount;
 
-		vkCmdBlitImage(commandBuffer->GetHandle(), imageHandle, layoutTransferSrcOptimal, imageHandle, layoutTransferDstOptimal, 1, &blit, VK_FILTER_LINEAR);
+		vkCmdBlitImage(commandBuffer.GetHandle(), imageHandle, layoutTransferSrcOptimal, imageHandle, layoutTransferDstOptimal, 1, &blit, VK_FILTER_LINEAR);
 
 		barrier.oldLayout = layoutTransferSrcOptimal;
 		barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 		barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
 		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
 
-		vkCmdPipelineBarrier(commandBuffer->GetHandle(), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+		vkCmdPipelineBarrier(commandBuffer.GetHandle(), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
 
 		if (mipWidth > 1)
 			mipWidth /= 2;
@@ -321,8 +325,5 @@ void Image2D::GenerateMipMaps()
 	barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
 	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-	vkCmdPipelineBarrier(commandBuffer->GetHandle(), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
-
-	commandBuffer->EndRecording();
-	commandBuffer->Submit();
+	vkCmdPipelineBarrier(commandBuffer.GetHandle(), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
 }
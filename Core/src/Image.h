@@ -6,6 +6,10 @@
 
 #include "Enums.h"
 
+#include "Allocator.h"
+
+#include <span>
+
 #pragma region Image
 
 struct ImageDescription
@@ -28,6 +32,7 @@ struct ImageDescription
 };
 
 class GBuffer;
+class CommandBuffer;
 
 class Image2D : public Handle<VkImage, VkImageView, VkDeviceMemory>
 {
@@ -40,8 +45,13 @@ public:
 	Image2D(const ImageDescription& desc, VkImage image);
 	~Image2D();
 
-	void TransitionImageLayout(VkImageLayout newLayout, VkImageLayout oldLayout = (VkImageLayout)0);
-	void CopyFrom(const GBuffer& buffer);
+	// Recorded into commandBuffer, nothing is submitted (see UploadContext)
+	void TransitionImageLayout(CommandBuffer& commandBuffer, VkImageLayout newLayout, VkImageLayout oldLayout = (VkImageLayout)0);
+	// Also generates the mip chain, leaves the image in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+	void CopyFrom(CommandBuffer& commandBuffer, const GBuffer& buffer);
+	// Precomputed mip chain, one region per level starting at levelOffsets[level], each level holds every layer back to back
+	// Leaves the image in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+	void CopyFrom(CommandBuffer& commandBuffer, const GBuffer& buffer, std::span<const VkDeviceSize> levelOffsets);
 
 	uint32_t GetWidth() const;
 	uint32_t GetHeight() const;
@@ -50,7 +60,9 @@ private:
 	void CreateImage();
 	void CreateImageView();
 
-	void GenerateMipMaps();
+	void GenerateMipMaps(CommandBuffer& commandBuffer);
 private:
 	ImageDescription m_Description;
+
+	Allocation m_Allocation;
 };
\ No newline at end of file
@@ -0,0 +1,381 @@
+#include "JobSystem.h"
+
+#include "Log.h"
+
+#include <array>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+static constexpr const char* s_LogTag = "[JobSystem]";
+
+// Per thread, power of two
+static constexpr uint32_t s_QueueCapacity = 1024;
+static constexpr uint32_t s_PoolSize = s_QueueCapacity;
+static constexpr uint32_t s_MaxAllocationAttempts = 16;
+
+// Chase-Lev work-stealing deque, see "Correct and Efficient Work-Stealing for Weak Memory Models" (Le et al. 2013)
+// Push() and Pop() are called by the owner only, Steal() by any thread
+class JobDeque
+{
+	static constexpr int64_t s_Mask = s_QueueCapacity - 1;
+public:
+	bool Push(JobSystem::Job* job);
+	JobSystem::Job* Pop();
+	JobSystem::Job* Steal();
+private:
+	std::atomic<int64_t> m_Top = 0;
+	std::atomic<int64_t> m_Bottom = 0;
+
+	std::array<std::atomic<JobSystem::Job*>, s_QueueCapacity> m_Jobs = {};
+};
+
+bool JobDeque::Push(JobSystem::Job* job)
+{
+	const int64_t bottom = m_Bottom.load(std::memory_order_relaxed);
+	const int64_t top = m_Top.load(std::memory_order_acquire);
+
+	if (bottom - top >= static_cast<int64_t>(s_QueueCapacity))
+		return false;
+
+	m_Jobs[bottom & s_Mask].store(job, std::memory_order_relaxed);
+
+	std::atomic_thread_fence(std::memory_order_release);
+	m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+
+	return true;
+}
+
+JobSystem::Job* JobDeque::Pop()
+{
+	const int64_t bottom = m_Bottom.load(std::memory_order_relaxed) - 1;
+	m_Bottom.store(bottom, std::memory_order_relaxed);
+
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	int64_t top = m_Top.load(std::memory_order_relaxed);
+
+	if (top > bottom)
+	{
+		// Empty
+		m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	JobSystem::Job* job = m_Jobs[bottom & s_Mask].load(std::memory_order_relaxed);
+
+	if (top == bottom)
+	{
+		// Last one, race against the thieves
+		if (!m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			job = nullptr;
+
+		m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+	}
+
+	return job;
+}
+
+JobSystem::Job* JobDeque::Steal()
+{
+	int64_t top = m_Top.load(std::memory_order_acquire);
+
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	const int64_t bottom = m_Bottom.load(std::memory_order_acquire);
+
+	if (top >= bottom)
+		return nullptr;
+
+	JobSystem::Job* job = m_Jobs[top & s_Mask].load(std::memory_order_relaxed);
+
+	if (!m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		return nullptr;
+
+	return job;
+}
+
+struct WorkerData
+{
+	JobDeque Queue;
+
+	// Slots are handed out round-robin and released once their job ran
+	std::array<JobSystem::Job, s_PoolSize> Pool;
+	uint32_t NextJob = 0;
+};
+
+struct JobSystemData
+{
+	// Index 0 belongs to the thread that called Init()
+	std::vector<Scope<WorkerData>> Workers;
+	std::vector<std::jthread> Threads;
+
+	std::atomic<bool> ShouldStop = false;
+	// Queued but not yet picked up, lets idle workers sleep
+	std::atomic<uint32_t> PendingJobs = 0;
+	std::atomic<uint32_t> SleepingWorkers = 0;
+
+	std::mutex SleepMutex;
+	std::condition_variable SleepCV;
+
+	// See ExecuteInBackground(), rare enough for a locked queue, the count spares the lock when it's empty
+	std::deque<JobSystem::Job*> BackgroundJobs;
+	std::atomic<uint32_t> BackgroundJobCount = 0;
+	std::mutex BackgroundMutex;
+};
+
+static JobSystemData* s_Data = nullptr;
+
+static thread_local uint32_t s_ThreadIndex = JobSystem::InvalidThreadIndex;
+
+static WorkerData* GetCurrentWorker()
+{
+	if (!s_Data || s_ThreadIndex >= s_Data->Workers.size())
+		return nullptr;
+
+	return s_Data->Workers[s_ThreadIndex].get();
+}
+
+static JobSystem::Job* PopBackgroundJob()
+{
+	if (0 == s_Data->BackgroundJobCount.load(std::memory_order_acquire))
+		return nullptr;
+
+	std::scoped_lock lock(s_Data->BackgroundMutex);
+
+	if (s_Data->BackgroundJobs.empty())
+		return nullptr;
+
+	JobSystem::Job* job = s_Data->BackgroundJobs.front();
+	s_Data->BackgroundJobs.pop_front();
+
+	s_Data->BackgroundJobCount.fetch_sub(1, std::memory_order_relaxed);
+
+	return job;
+}
+
+JobSystem::Job* JobSystem::GetJob()
+{
+	Job* job = nullptr;
+
+	if (auto* worker = GetCurrentWorker())
+		job = worker->Queue.Pop();
+
+	const uint32_t workerCount = static_cast<uint32_t>(s_Data->Workers.size());
+	// Start with the next one, so not every thief hits the same queue
+	const uint32_t start = (s_ThreadIndex == InvalidThreadIndex) ? 0 : s_ThreadIndex + 1;
+
+	for (uint32_t i = 0; !job && i < workerCount; i++)
+	{
+		const uint32_t victim = (start + i) % workerCount;
+
+		if (victim != s_ThreadIndex)
+			job = s_Data->Workers[victim]->Queue.Steal();
+	}
+
+	// Workers only, the rest of the queued work goes first, once they've stopped Shutdown() runs them
+	if (!job && InvalidThreadIndex != s_ThreadIndex && (0 != s_ThreadIndex || s_Data->ShouldStop.load(std::memory_order_relaxed)))
+		job = PopBackgroundJob();
+
+	if (job)
+		s_Data->PendingJobs.fetch_sub(1, std::memory_order_relaxed);
+
+	return job;
+}
+
+void JobSystem::Run(Job* job)
+{
+	// Other jobs are run meanwhile, so the worker doesn't stall
+	if (job->Dependency)
+		WaitFor(*job->Dependency);
+
+	job->Function(job->Storage);
+
+	if (job->Counter)
+		job->Counter->m_Value.fetch_sub(1, std::memory_order_release);
+
+	job->IsFree.store(true, std::memory_order_release);
+}
+
+void JobSystem::WorkerLoop(uint32_t index)
+{
+	s_ThreadIndex = index;
+
+	while (!s_Data->ShouldStop.load(std::memory_order_acquire))
+	{
+		if (auto* job = GetJob())
+		{
+			Run(job);
+			continue;
+		}
+
+		std::unique_lock lock(s_Data->SleepMutex);
+
+		// Submit() bumps PendingJobs before it reads SleepingWorkers, both seq_cst
+		// Either it sees this worker and notifies it once it's waiting, or the predicate sees the job and it doesn't sleep
+		s_Data->SleepingWorkers.fetch_add(1, std::memory_order_seq_cst);
+
+		s_Data->SleepCV.wait(lock, []()
+			{
+				return s_Data->PendingJobs.load(std::memory_order_seq_cst) > 0 || s_Data->ShouldStop.load(std::memory_order_relaxed);
+			});
+
+		s_Data->SleepingWorkers.fetch_sub(1, std::memory_order_relaxed);
+	}
+}
+
+void JobSystem::Init(uint32_t workerCount)
+{
+	ASSERT(!s_Data, "JobSystem already initialized");
+
+	if (0 == workerCount)
+		workerCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+	s_Data = new JobSystemData();
+
+	s_Data->Workers.resize(workerCount + 1);
+	for (auto& worker : s_Data->Workers)
+		worker = CreateScope<WorkerData>();
+
+	s_ThreadIndex = 0;
+
+	s_Data->Threads.reserve(workerCount);
+	for (uint32_t i = 1; i <= workerCount; i++)
+		s_Data->Threads.emplace_back(WorkerLoop, i);
+
+	LOG_TAGGED(s_LogTag, "Workers: %i", workerCount);
+}
+
+void JobSystem::Shutdown()
+{
+	ASSERT(s_Data);
+
+	// Stopped first, a job still running on a worker could queue more work after a drain
+	// Under the mutex, a worker between its predicate check and the wait would miss the notification
+	{
+		std::scoped_lock lock(s_Data->SleepMutex);
+		s_Data->ShouldStop.store(true, std::memory_order_release);
+	}
+
+	s_Data->SleepCV.notify_all();
+
+	s_Data->Threads.clear();
+
+	// Whatever is left in any of the queues, background jobs included, runs here
+	Job* job = nullptr;
+	while ((job = GetJob()))
+		Run(job);
+
+	s_ThreadIndex = InvalidThreadIndex;
+
+	delete s_Data;
+	s_Data = nullptr;
+}
+
+bool JobSystem::IsInitialized()
+{
+	return s_Data;
+}
+
+uint32_t JobSystem::GetWorkerCount()
+{
+	return s_Data ? static_cast<uint32_t>(s_Data->Threads.size()) : 0;
+}
+
+uint32_t JobSystem::GetThreadIndex()
+{
+	return s_ThreadIndex;
+}
+
+void JobSystem::WaitFor(const JobCounter& counter)
+{
+	while (!counter.IsDone())
+	{
+		if (s_Data)
+		{
+			if (auto* job = GetJob())
+			{
+				Run(job);
+				continue;
+			}
+		}
+
+		std::this_thread::yield();
+	}
+}
+
+JobSystem::Job* JobSystem::AllocateJob()
+{
+	auto* worker = GetCurrentWorker();
+
+	if (!worker)
+		return nullptr;
+
+	// Slots come back roughly in order, the oldest ones are the likeliest to be free
+	// Giving up early is fine, the caller runs the job inline
+	for (uint32_t i = 0; i < s_MaxAllocationAttempts; i++)
+	{
+		auto& job = worker->Pool[worker->NextJob];
+		worker->NextJob = (worker->NextJob + 1) % s_PoolSize;
+
+		bool expected = true;
+		if (job.IsFree.compare_exchange_strong(expected, false, std::memory_order_acquire, std::memory_order_relaxed))
+			return &job;
+	}
+
+	return nullptr;
+}
+
+void JobSystem::Submit(Job* job)
+{
+	if (job->Counter)
+		job->Counter->m_Value.fetch_add(1, std::memory_order_relaxed);
+
+	auto* worker = GetCurrentWorker();
+	ASSERT(worker);
+
+	// Before the push, a thief may pick it up right away
+	s_Data->PendingJobs.fetch_add(1, std::memory_order_seq_cst);
+
+	if (!worker->Queue.Push(job))
+	{
+		s_Data->PendingJobs.fetch_sub(1, std::memory_order_relaxed);
+
+		// Full, no point in queueing
+		Run(job);
+		return;
+	}
+
+	WakeWorker();
+}
+
+void JobSystem::SubmitBackground(Job* job)
+{
+	if (job->Counter)
+		job->Counter->m_Value.fetch_add(1, std::memory_order_relaxed);
+
+	s_Data->PendingJobs.fetch_add(1, std::memory_order_seq_cst);
+
+	{
+		std::scoped_lock lock(s_Data->BackgroundMutex);
+
+		s_Data->BackgroundJobs.push_back(job);
+		s_Data->BackgroundJobCount.fetch_add(1, std::memory_order_release);
+	}
+
+	WakeWorker();
+}
+
+void JobSystem::WakeWorker()
+{
+	// Skips the mutex while every worker is busy
+	if (s_Data->SleepingWorkers.load(std::memory_order_seq_cst) > 0)
+	{
+		{
+			std::scoped_lock lock(s_Data->SleepMutex);
+		}
+		s_Data->SleepCV.notify_one();
+	}
+}
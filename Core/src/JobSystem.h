@@ -0,0 +1,170 @@
+#pragma once
+
+#include "Base.h"
+
+#include <atomic>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Counts the unfinished jobs it was passed to, acts as the handle for a group of jobs
+class JobCounter
+{
+public:
+	JobCounter() = default;
+	~JobCounter() = default;
+
+	DELETE_COPY_AND_MOVE(JobCounter);
+
+	bool IsDone() const { return 0 == m_Value.load(std::memory_order_acquire); }
+	uint32_t GetValue() const { return m_Value.load(std::memory_order_relaxed); }
+private:
+	friend class JobSystem;
+
+	std::atomic<uint32_t> m_Value = 0;
+};
+
+// Fixed number of workers, each with its own lock-free deque, idle workers steal from the others
+// The thread calling Init() takes part too, while in WaitFor()
+class JobSystem
+{
+public:
+	// Internal, public only for the queues
+	struct Job
+	{
+		// Captures must fit, capture large data by reference or pointer
+		static constexpr size_t StorageSize = 64;
+
+		// Invokes and destroys the functor in Storage
+		void (*Function)(void* storage) = nullptr;
+
+		JobCounter* Counter = nullptr;
+		const JobCounter* Dependency = nullptr;
+
+		alignas(std::max_align_t) std::byte Storage[StorageSize];
+
+		std::atomic<bool> IsFree = true;
+	};
+
+	// 0 means one worker per hardware thread, minus the calling one
+	static void Init(uint32_t workerCount = 0);
+	// Joins the workers, then runs every job still queued on the calling thread
+	static void Shutdown();
+
+	static bool IsInitialized();
+	static uint32_t GetWorkerCount();
+	// 0 for the thread that called Init(), 1..GetWorkerCount() for the workers, InvalidThreadIndex for any other thread
+	static uint32_t GetThreadIndex();
+
+	static constexpr uint32_t InvalidThreadIndex = ~0U;
+
+	// Runs after dependency reaches zero, counter is incremented now and decremented once the job is done
+	// Runs inline when called from a thread that isn't part of the system or its job pool is exhausted
+	template<typename F>
+	static void Execute(F&& function, JobCounter* counter = nullptr, const JobCounter* dependency = nullptr)
+	{
+		Job* job = AllocateJob();
+
+		if (!job)
+		{
+			if (dependency)
+				WaitFor(*dependency);
+
+			function();
+
+			return;
+		}
+
+		Prepare(job, std::forward<F>(function), counter, dependency);
+		Submit(job);
+	}
+
+	// Same, but only the workers run it, never the thread that called Init(), not even from its WaitFor()
+	// For long jobs that mustn't land in the middle of that thread's frame, e.g. a shader hot reload
+	template<typename F>
+	static void ExecuteInBackground(F&& function, JobCounter* counter = nullptr)
+	{
+		Job* job = AllocateJob();
+
+		if (!job)
+		{
+			function();
+			return;
+		}
+
+		Prepare(job, std::forward<F>(function), counter, nullptr);
+		SubmitBackground(job);
+	}
+
+	// Runs other jobs while waiting
+	static void WaitFor(const JobCounter& counter);
+
+	// Calls function(index) for every index in [0, count), returns when all are done
+	template<typename F>
+	static void ParallelFor(uint32_t count, uint32_t batchSize, F&& function)
+	{
+		if (0 == count)
+			return;
+
+		batchSize = std::max(batchSize, 1u);
+
+		JobCounter counter;
+
+		for (uint32_t begin = 0; begin < count; begin += batchSize)
+		{
+			const uint32_t end = std::min(begin + batchSize, count);
+
+			Execute([&function, begin, end]()
+				{
+					for (uint32_t i = begin; i < end; i++)
+						function(i);
+				}, &counter);
+		}
+
+		WaitFor(counter);
+	}
+
+	// Batch size picked from the worker count
+	template<typename F>
+	static void ParallelFor(uint32_t count, F&& function)
+	{
+		// A few batches per worker, so stealing can even out uneven work
+		const uint32_t batchCount = std::max(GetWorkerCount() + 1, 1u) * 4;
+
+		ParallelFor(count, (count + batchCount - 1) / batchCount, std::forward<F>(function));
+	}
+private:
+	template<typename F>
+	static void Prepare(Job* job, F&& function, JobCounter* counter, const JobCounter* dependency)
+	{
+		using Functor = std::decay_t<F>;
+
+		static_assert(sizeof(Functor) <= Job::StorageSize, "Job captures too large");
+		static_assert(alignof(Functor) <= alignof(std::max_align_t), "Job captures over-aligned");
+
+		new (job->Storage) Functor(std::forward<F>(function));
+
+		job->Function = [](void* storage)
+			{
+				Functor* functor = std::launder(reinterpret_cast<Functor*>(storage));
+
+				(*functor)();
+				functor->~Functor();
+			};
+
+		job->Counter = counter;
+		job->Dependency = dependency;
+	}
+
+	static Job* AllocateJob();
+	static void Submit(Job* job);
+	static void SubmitBackground(Job* job);
+	static void WakeWorker();
+
+	static Job* GetJob();
+	static void Run(Job* job);
+	static void WorkerLoop(uint32_t index);
+};
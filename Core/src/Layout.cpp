@@ -4,11 +4,30 @@
 
 #include "Log.h"
 
+#include <algorithm>
+
+void Layout::Add(const std::string& name, Format format)
+{
+	Add(name, format, GetStrideFromFormat(Convert(format)));
+}
+
 const std::vector<LayoutElement>& Layout::GetElements() const
 {
 	return m_Elements;
 }
 
+const LayoutElement* Layout::TryGetElement(const std::string& name) const
+{
+	const auto it = std::ranges::find(m_Elements, name, &LayoutElement::Name);
+
+	return (it != m_Elements.end()) ? &(*it) : nullptr;
+}
+
+bool Layout::IsEmpty() const
+{
+	return m_Elements.empty();
+}
+
 uint32_t Layout::GetStride() const
 {
 	ASSERT(m_Stride != 0, "");
@@ -14,12 +14,14 @@ struct LayoutElement
 	std::string Name;
 	Format Format = Format::UNDEFINED;
 	uint32_t Offset = 0;
+
+	bool operator==(const LayoutElement&) const = default;
 };
 
 class Layout
 {
 public:
-	Layout();
+	Layout() = default;
 
 	template <typename T>
 	void Add(const std::string& name)
@@ -27,9 +29,16 @@ public:
 		static_assert(sizeof(T) == 0, "Unknown type");
 	}
 
+	// For packed attributes, which have no matching C++ type
+	void Add(const std::string& name, Format format);
+
 	const std::vector<LayoutElement>& GetElements() const;
+	const LayoutElement* TryGetElement(const std::string& name) const;
 
+	bool IsEmpty() const;
 	uint32_t GetStride() const;
+
+	bool operator==(const Layout&) const = default;
 private:
 	void Add(const std::string& name, Format format, uint32_t size);
 private:
@@ -0,0 +1,110 @@
+#include "MappedFile.h"
+
+#include "Log.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static constexpr const char* s_LogTag = "[MappedFile]";
+
+Scope<MappedFile> MappedFile::Create(const std::filesystem::path& path)
+{
+	auto file = CreateScope<MappedFile>(path);
+
+	if (!file->IsValid())
+		return nullptr;
+
+	return file;
+}
+
+// The file and mapping handles can be closed right away, the view keeps the file alive
+MappedFile::MappedFile(const std::filesystem::path& path)
+{
+#ifdef _WIN32
+	HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+	if (INVALID_HANDLE_VALUE == file)
+		return;
+
+	LARGE_INTEGER size = {};
+
+	if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+	{
+		if (HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr))
+		{
+			m_Data = static_cast<const std::byte*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+			m_Size = m_Data ? static_cast<size_t>(size.QuadPart) : 0;
+
+			CloseHandle(mapping);
+		}
+	}
+
+	CloseHandle(file);
+#else
+	const int file = open(path.c_str(), O_RDONLY);
+
+	if (-1 == file)
+		return;
+
+	struct stat info = {};
+
+	if (0 == fstat(file, &info) && info.st_size > 0)
+	{
+		void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+
+		if (MAP_FAILED != data)
+		{
+			m_Data = static_cast<const std::byte*>(data);
+			m_Size = static_cast<size_t>(info.st_size);
+
+			// Mostly read front to back, once
+			madvise(data, m_Size, MADV_SEQUENTIAL);
+		}
+	}
+
+	close(file);
+#endif
+
+	if (!m_Data)
+		LOG_TAGGED(s_LogTag, "Failed to map %s", path.string().data());
+}
+
+MappedFile::~MappedFile()
+{
+	if (!m_Data)
+		return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(m_Data);
+#else
+	munmap(const_cast<std::byte*>(m_Data), m_Size);
+#endif
+}
+
+bool MappedFile::IsValid() const
+{
+	return m_Data;
+}
+
+const std::byte* MappedFile::GetData() const
+{
+	return m_Data;
+}
+
+size_t MappedFile::GetSize() const
+{
+	return m_Size;
+}
+
+std::span<const std::byte> MappedFile::GetSpan() const
+{
+	return { m_Data, m_Size };
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Base.h"
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+// Read-only view of a whole file, pages are brought in by the OS on first access
+class MappedFile
+{
+public:
+	// nullptr if the file can't be opened or is empty
+	static Scope<MappedFile> Create(const std::filesystem::path& path);
+
+	MappedFile(const std::filesystem::path& path);
+	~MappedFile();
+
+	DELETE_COPY_AND_MOVE(MappedFile);
+
+	bool IsValid() const;
+
+	const std::byte* GetData() const;
+	size_t GetSize() const;
+
+	std::span<const std::byte> GetSpan() const;
+private:
+	const std::byte* m_Data = nullptr;
+	size_t m_Size = 0;
+};
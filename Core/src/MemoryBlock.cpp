@@ -0,0 +1,154 @@
+#include "MemoryBlock.h"
+
+#include "Log.h"
+
+#include <algorithm>
+
+static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+MemoryBlock::MemoryBlock(VkDeviceSize size)
+	: m_Size(size)
+{
+	ASSERT(size > 0);
+
+	m_FreeRanges.emplace(0, size);
+}
+
+std::optional<VkDeviceSize> MemoryBlock::Allocate(VkDeviceSize size, VkDeviceSize alignment)
+{
+	ASSERT(size > 0);
+
+	if (0 == alignment)
+		alignment = 1;
+
+	auto bestFit = m_FreeRanges.end();
+	VkDeviceSize bestFitWaste = ~0ull;
+
+	for (auto it = m_FreeRanges.begin(); it != m_FreeRanges.end(); it++)
+	{
+		const auto& [rangeOffset, rangeSize] = *it;
+
+		const VkDeviceSize alignedOffset = AlignUp(rangeOffset, alignment);
+		const VkDeviceSize padding = alignedOffset - rangeOffset;
+
+		if (padding + size > rangeSize)
+			continue;
+
+		// Measured past the aligned offset, the padding goes back to the free list on its own
+		const VkDeviceSize waste = rangeSize - padding - size;
+		if (waste < bestFitWaste)
+		{
+			bestFit = it;
+			bestFitWaste = waste;
+
+			if (0 == waste)
+				break;
+		}
+	}
+
+	if (bestFit == m_FreeRanges.end())
+		return std::nullopt;
+
+	const auto [rangeOffset, rangeSize] = *bestFit;
+	m_FreeRanges.erase(bestFit);
+
+	const VkDeviceSize alignedOffset = AlignUp(rangeOffset, alignment);
+	const VkDeviceSize rangeEnd = rangeOffset + rangeSize;
+	const VkDeviceSize allocationEnd = alignedOffset + size;
+
+	// The alignment padding stays in the free list, so Free() only needs the exact offset and size
+	if (alignedOffset > rangeOffset)
+		m_FreeRanges.emplace(rangeOffset, alignedOffset - rangeOffset);
+
+	if (rangeEnd > allocationEnd)
+		m_FreeRanges.emplace(allocationEnd, rangeEnd - allocationEnd);
+
+	m_UsedSize += size;
+	m_AllocationCount++;
+
+	return alignedOffset;
+}
+
+void MemoryBlock::Free(VkDeviceSize offset, VkDeviceSize size)
+{
+	ASSERT(size > 0 && offset + size <= m_Size);
+	ASSERT(m_AllocationCount > 0 && m_UsedSize >= size);
+
+	auto [it, inserted] = m_FreeRanges.emplace(offset, size);
+	ASSERT(inserted, "Double free");
+
+	// Merge with the next range
+	auto next = std::next(it);
+	if (next != m_FreeRanges.end())
+	{
+		ASSERT(offset + size <= next->first, "Freed range overlaps a free range");
+
+		if (offset + size == next->first)
+		{
+			it->second += next->second;
+			m_FreeRanges.erase(next);
+		}
+	}
+
+	// Merge with the previous range
+	if (it != m_FreeRanges.begin())
+	{
+		auto prev = std::prev(it);
+
+		ASSERT(prev->first + prev->second <= offset, "Freed range overlaps a free range");
+
+		if (prev->first + prev->second == offset)
+		{
+			prev->second += it->second;
+			m_FreeRanges.erase(it);
+		}
+	}
+
+	m_UsedSize -= size;
+	m_AllocationCount--;
+}
+
+bool MemoryBlock::IsEmpty() const
+{
+	return 0 == m_AllocationCount;
+}
+
+VkDeviceSize MemoryBlock::GetSize() const
+{
+	return m_Size;
+}
+
+VkDeviceSize MemoryBlock::GetUsedSize() const
+{
+	return m_UsedSize;
+}
+
+VkDeviceSize MemoryBlock::GetLargestFreeRange() const
+{
+	VkDeviceSize largest = 0;
+
+	for (const auto& [_, size] : m_FreeRanges)
+		largest = std::max(largest, size);
+
+	return largest;
+}
+
+uint32_t MemoryBlock::GetFreeRangeCount() const
+{
+	return static_cast<uint32_t>(m_FreeRanges.size());
+}
+
+uint32_t MemoryBlock::GetAllocationCount() const
+{
+	return m_AllocationCount;
+}
+
+void AlignToAtom(VkDeviceSize& size, VkDeviceSize& alignment, VkDeviceSize atomSize)
+{
+	// Both are powers of two
+	alignment = std::max(alignment, atomSize);
+	size = AlignUp(size, atomSize);
+}
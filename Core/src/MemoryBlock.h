@@ -0,0 +1,38 @@
+#pragma once
+
+#include "VK.h"
+
+#include <map>
+#include <optional>
+
+// CPU-side bookkeeping of a single VkDeviceMemory block, doesn't touch the GPU
+// Free ranges are kept sorted by offset, so neighbouring ranges can be coalesced on Free()
+class MemoryBlock
+{
+public:
+	MemoryBlock(VkDeviceSize size);
+	~MemoryBlock() = default;
+
+	// Best-fit, returns the aligned offset of the sub-allocation
+	std::optional<VkDeviceSize> Allocate(VkDeviceSize size, VkDeviceSize alignment);
+	void Free(VkDeviceSize offset, VkDeviceSize size);
+
+	bool IsEmpty() const;
+
+	VkDeviceSize GetSize() const;
+	VkDeviceSize GetUsedSize() const;
+	VkDeviceSize GetLargestFreeRange() const;
+	uint32_t GetFreeRangeCount() const;
+	uint32_t GetAllocationCount() const;
+private:
+	VkDeviceSize m_Size = 0;
+	VkDeviceSize m_UsedSize = 0;
+	uint32_t m_AllocationCount = 0;
+
+	// Offset -> Size
+	std::map<VkDeviceSize, VkDeviceSize> m_FreeRanges;
+};
+
+// For non-coherent memory, rounds a sub-allocation out to whole atoms (nonCoherentAtomSize)
+// A flush or invalidate expanded to atoms then stays inside it, instead of reaching into a neighbour
+void AlignToAtom(VkDeviceSize& size, VkDeviceSize& alignment, VkDeviceSize atomSize);
@@ -1,62 +1,36 @@
 #include "Mesh.h"
 
 #include "GBuffer.h"
+#include "JobSystem.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "ObjParser.h"
+#include "Timer.h"
 
 #include "Log.h"
 
 #include <glm/glm.hpp>
 #include <glm/gtx/quaternion.hpp>
+#include <glm/gtc/matrix_transform.hpp>
 
 #include <vulkan/vulkan.h>
 
-#define TINYOBJLOADER_IMPLEMENTATION
-#include <tiny_obj_loader.h>
+static constexpr const char* s_LogTag = "[Mesh]";
 
-static bool LoadFromFile(const std::string_view file, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+static MeshBounds ComputeBounds(const std::span<const Vertex> vertices)
 {
-	tinyobj::attrib_t attrib;
-	std::vector<tinyobj::shape_t> shapes;
-	std::vector<tinyobj::material_t> materials;
+	if (vertices.empty())
+		return {};
 
-	std::string warn, err;
+	MeshBounds bounds = { vertices.front().Position, vertices.front().Position };
 
-	bool sucess = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, file.data());
-	if (!sucess)
+	for (const auto& vertex : vertices)
 	{
-		LOG("%s: %s", file.data(), (warn + err).data());
-		return false;
+		bounds.Min = glm::min(bounds.Min, vertex.Position);
+		bounds.Max = glm::max(bounds.Max, vertex.Position);
 	}
 
-	for (const auto& shape : shapes)
-	{
-		for (const auto& index : shape.mesh.indices)
-		{
-			Vertex vertex = {};
-
-			vertex.Position = {
-				attrib.vertices[3 * index.vertex_index + 0],
-				attrib.vertices[3 * index.vertex_index + 1],
-				attrib.vertices[3 * index.vertex_index + 2]
-			};
-
-			vertex.TexCoord = {
-				attrib.texcoords[2 * index.texcoord_index + 0],
-				1 - attrib.texcoords[2 * index.texcoord_index + 1]
-			};
-
-			vertex.Normal = {
-				attrib.normals[3 * index.normal_index + 0],
-				attrib.normals[3 * index.normal_index + 1],
-				attrib.normals[3 * index.normal_index + 2]
-			};
-
-			vertices.emplace_back(vertex);
-
-			indices.emplace_back(vertices.size() - 1);
-		}
-	}
-
-	return true;
+	return bounds;
 }
 
 static Ref<Mesh> CreateCube()
@@ -176,23 +150,47 @@ static Ref<Mesh> CreateSphere(uint32_t rings = 32, uint32_t sectors = 32, float
 	return Mesh::Create(vertices, indices);
 }
 
-Ref<Mesh> Mesh::Create(const std::string_view file)
+Ref<Mesh> Mesh::Create(const std::string_view file, VertexFormat format)
 {
+	Timer timer;
+
+	// Uploaded straight from the mapping, no intermediate copies
+	if (auto cache = MeshCache::Open(file))
+	{
+		if (cache->GetVertices().empty() || cache->GetIndices().empty())
+			return nullptr;
+
+		auto mesh = CreateRef<Mesh>(cache->GetVertices(), cache->GetIndices(), cache->GetBounds(), format);
+
+		LOG_TAGGED(s_LogTag, "%s loaded from cache in %.2f ms", file.data(), timer.ElapsedMS());
+
+		return mesh;
+	}
+
 	std::vector<Vertex> vertices;
 	std::vector<uint32_t> indices;
 
-	if (LoadFromFile(file, vertices, indices))
-		return CreateRef<Mesh>(vertices, indices);
+	if (!ParseObj(file, vertices, indices) || vertices.empty() || indices.empty())
+		return nullptr;
 
-	return nullptr;
+	// The loader emits one vertex per index, the cache then stores the optimized result
+	MeshOptimizer::Optimize(vertices, indices);
+
+	auto mesh = CreateRef<Mesh>(vertices, indices, format);
+
+	LOG_TAGGED(s_LogTag, "%s parsed and optimized in %.2f ms", file.data(), timer.ElapsedMS());
+
+	MeshCache::Write(file, vertices, indices, mesh->GetBounds());
+
+	return mesh;
 }
 
-Ref<Mesh> Mesh::Create(const std::span<Vertex> vertices, const std::span<uint32_t> indices)
+Ref<Mesh> Mesh::Create(const std::span<const Vertex> vertices, const std::span<const uint32_t> indices, VertexFormat format)
 {
 	if (vertices.empty() || indices.empty())
 		return nullptr;
 
-	return CreateRef<Mesh>(vertices, indices);
+	return CreateRef<Mesh>(vertices, indices, format);
 }
 
 Ref<Mesh> Mesh::Create(const Ref<GBuffer>& vb, const Ref<GBuffer>& ib)
@@ -220,13 +218,37 @@ Ref<Mesh> Mesh::Create(MeshPrimitiveType type)
 	return nullptr;
 }
 
-Mesh::Mesh(const std::span<Vertex> vertices, const std::span<uint32_t> indices)
+Mesh::Mesh(const std::span<const Vertex> vertices, const std::span<const uint32_t> indices, VertexFormat format)
+	: Mesh(vertices, indices, ComputeBounds(vertices), format)
 {
-	const uint64_t verticesSize = static_cast<uint64_t>(sizeof(Vertex) * vertices.size());
+}
+
+Mesh::Mesh(const std::span<const Vertex> vertices, const std::span<const uint32_t> indices, const MeshBounds& bounds, VertexFormat format)
+	: m_Bounds(bounds), m_VertexFormat(format)
+{
+	const uint64_t verticesSize = static_cast<uint64_t>(GetVertexStride(format) * vertices.size());
 	const uint64_t indicesSize = static_cast<uint64_t>(sizeof(uint32_t) * indices.size());
 
 	m_VertexBuffer = GBuffer::CreateVertex(verticesSize);
-	m_VertexBuffer->SetData(static_cast<const void*>(vertices.data()), verticesSize);
+
+	if (VertexFormat::PACKED == format)
+	{
+		const glm::vec3 center = (bounds.Max + bounds.Min) * 0.5f;
+		const glm::vec3 halfExtent = (bounds.Max - bounds.Min) * 0.5f;
+
+		std::vector<PackedVertex> packedVertices(vertices.size());
+
+		JobSystem::ParallelFor(static_cast<uint32_t>(vertices.size()), [&](uint32_t i)
+			{
+				packedVertices[i] = PackVertex(vertices[i], center, halfExtent);
+			});
+
+		m_VertexBuffer->SetData(static_cast<const void*>(packedVertices.data()), verticesSize);
+	}
+	else
+	{
+		m_VertexBuffer->SetData(static_cast<const void*>(vertices.data()), verticesSize);
+	}
 
 	m_IndexBuffer = GBuffer::CreateIndex(indicesSize, static_cast<uint32_t>(indices.size()));
 	m_IndexBuffer->SetData(static_cast<const void*>(indices.data()), indicesSize);
@@ -269,3 +291,25 @@ uint32_t Mesh::GetIndexCount() const
 	return m_IndexBuffer->GetDescription().IndexCount;
 }
 
+const MeshBounds& Mesh::GetBounds() const
+{
+	return m_Bounds;
+}
+
+VertexFormat Mesh::GetVertexFormat() const
+{
+	return m_VertexFormat;
+}
+
+glm::mat4 Mesh::GetDequantizationTransform() const
+{
+	if (VertexFormat::FULL == m_VertexFormat)
+		return glm::mat4(1.0f);
+
+	// Same epsilon as PackVertex()
+	const glm::vec3 center = (m_Bounds.Max + m_Bounds.Min) * 0.5f;
+	const glm::vec3 halfExtent = glm::max((m_Bounds.Max - m_Bounds.Min) * 0.5f, glm::vec3(1e-6f));
+
+	return glm::scale(glm::translate(glm::mat4(1.0f), center), halfExtent);
+}
+
@@ -12,16 +12,25 @@
 
 class GBuffer;
 
+struct MeshBounds
+{
+	glm::vec3 Min = glm::vec3(0.0f);
+	glm::vec3 Max = glm::vec3(0.0f);
+};
+
 class Mesh
 {
 public:
-	static Ref<Mesh> Create(const std::string_view file);
-	static Ref<Mesh> Create(const std::span<Vertex> vertices, const std::span<uint32_t> indices);
+	// OBJ files are parsed once, later loads map the <file>.meshcache written next to them
+	// PACKED meshes need a vertex shader reading PackedVertex and the pipeline's VertexLayout set to GetVertexLayout(VertexFormat::PACKED)
+	static Ref<Mesh> Create(const std::string_view file, VertexFormat format = VertexFormat::FULL);
+	static Ref<Mesh> Create(const std::span<const Vertex> vertices, const std::span<const uint32_t> indices, VertexFormat format = VertexFormat::FULL);
 	static Ref<Mesh> Create(const Ref<GBuffer>& vb, const Ref<GBuffer>& ib);
 
 	static Ref<Mesh> Create(MeshPrimitiveType type);
 
-	Mesh(const std::span<Vertex> vertices, const std::span<uint32_t> indices);
+	Mesh(const std::span<const Vertex> vertices, const std::span<const uint32_t> indices, VertexFormat format = VertexFormat::FULL);
+	Mesh(const std::span<const Vertex> vertices, const std::span<const uint32_t> indices, const MeshBounds& bounds, VertexFormat format = VertexFormat::FULL);
 	Mesh(const Ref<GBuffer>& vb, const Ref<GBuffer>& ib);
 	~Mesh();
 
@@ -31,9 +40,19 @@ public:
 	const GBuffer& GetIndexBuffer() const;
 
 	uint32_t GetIndexCount() const;
+
+	const MeshBounds& GetBounds() const;
+
+	VertexFormat GetVertexFormat() const;
+	// Maps PACKED positions back to object space, prepend it to the model matrix (identity for FULL)
+	// Normals aren't quantized this way, keep deriving the normal matrix from the model matrix alone
+	glm::mat4 GetDequantizationTransform() const;
 private:
 	std::string m_Name;
 
+	MeshBounds m_Bounds;
+	VertexFormat m_VertexFormat = VertexFormat::FULL;
+
 	Ref<GBuffer> m_VertexBuffer;
 	Ref<GBuffer> m_IndexBuffer;
 };
\ No newline at end of file
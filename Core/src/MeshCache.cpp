@@ -0,0 +1,247 @@
+#include "MeshCache.h"
+
+#include "MappedFile.h"
+#include "FileStream.h"
+#include "Utils.h"
+
+#include "Log.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+
+static constexpr const char* s_LogTag = "[MeshCache]";
+
+static constexpr uint32_t s_Magic = 0x4853454D; // "MESH"
+// Bump whenever the layout or Vertex changes
+static constexpr uint32_t s_Version = 2;
+static constexpr uint64_t s_BlockAlignment = 16;
+
+struct MeshCacheHeader
+{
+	uint32_t Magic = s_Magic;
+	uint32_t Version = s_Version;
+
+	uint32_t VertexStride = sizeof(Vertex);
+	uint32_t VertexCount = 0;
+	uint32_t IndexCount = 0;
+	uint32_t Padding = 0;
+
+	uint64_t VertexOffset = 0;
+	uint64_t IndexOffset = 0;
+
+	float BoundsMin[3] = {};
+	float BoundsMax[3] = {};
+
+	// Size and timestamp are the quick check, the hash settles it when only the timestamp changed
+	uint64_t SourceSize = 0;
+	int64_t SourceTimestamp = 0;
+	uint64_t SourceHash = 0;
+};
+
+static_assert(std::is_trivially_copyable_v<MeshCacheHeader>);
+
+static uint64_t AlignUp(uint64_t value)
+{
+	return (value + s_BlockAlignment - 1) & ~(s_BlockAlignment - 1);
+}
+
+static bool IsValid(const MeshCacheHeader& header, size_t fileSize)
+{
+	if (header.Magic != s_Magic || header.Version != s_Version || header.VertexStride != sizeof(Vertex))
+		return false;
+
+	const uint64_t verticesSize = static_cast<uint64_t>(header.VertexCount) * sizeof(Vertex);
+	const uint64_t indicesSize = static_cast<uint64_t>(header.IndexCount) * sizeof(uint32_t);
+
+	return header.VertexOffset % s_BlockAlignment == 0 && header.IndexOffset % s_BlockAlignment == 0 &&
+		header.VertexOffset >= sizeof(MeshCacheHeader) && header.VertexOffset + verticesSize <= header.IndexOffset &&
+		header.IndexOffset + indicesSize <= fileSize;
+}
+
+// Read before the file is mapped, the timestamp in it may have to be rewritten
+static bool ReadHeader(const std::filesystem::path& cachePath, MeshCacheHeader& header, size_t& fileSize)
+{
+	FileStreamReader stream(cachePath);
+
+	if (!stream.IsStreamGood())
+		return false;
+
+	fileSize = stream.GetFileSize();
+
+	if (fileSize < sizeof(MeshCacheHeader))
+		return false;
+
+	stream.Read(header);
+
+	return stream.IsStreamGood();
+}
+
+// The source was touched (checkout, copy) but its content is the same, so later launches don't rehash it
+static void RewriteTimestamp(const std::filesystem::path& cachePath, int64_t timestamp)
+{
+	std::fstream stream(cachePath, std::ios::in | std::ios::out | std::ios::binary);
+
+	if (stream)
+	{
+		stream.seekp(offsetof(MeshCacheHeader, SourceTimestamp));
+		stream.write(reinterpret_cast<const char*>(&timestamp), sizeof(timestamp));
+	}
+
+	if (!stream)
+		LOG_TAGGED(s_LogTag, "Failed to update %s", cachePath.string().data());
+}
+
+std::filesystem::path MeshCache::GetCachePath(const std::filesystem::path& source)
+{
+	auto path = source;
+	path += ".meshcache";
+
+	return path;
+}
+
+Scope<MeshCache> MeshCache::Open(const std::filesystem::path& source)
+{
+	const auto cachePath = GetCachePath(source);
+
+	std::error_code error;
+	if (!std::filesystem::exists(cachePath, error))
+		return nullptr;
+
+	const uint64_t sourceSize = static_cast<uint64_t>(std::filesystem::file_size(source, error));
+	if (error)
+		return nullptr;
+
+	MeshCacheHeader header;
+	size_t fileSize = 0;
+
+	if (!ReadHeader(cachePath, header, fileSize))
+		return nullptr;
+
+	if (!IsValid(header, fileSize))
+	{
+		LOG_TAGGED(s_LogTag, "Discarding invalid cache %s", cachePath.string().data());
+		return nullptr;
+	}
+
+	if (header.SourceSize != sourceSize)
+		return nullptr;
+
+	// Touched (checkout, copy) but possibly unchanged
+	if (const int64_t sourceTimestamp = GetFileTimestamp(source); header.SourceTimestamp != sourceTimestamp)
+	{
+		if (header.SourceHash != HashFile(source))
+		{
+			LOG_TAGGED(s_LogTag, "Stale cache %s", cachePath.string().data());
+			return nullptr;
+		}
+
+		RewriteTimestamp(cachePath, sourceTimestamp);
+	}
+
+	auto file = MappedFile::Create(cachePath);
+	if (!file || file->GetSize() != fileSize)
+		return nullptr;
+
+	MeshBounds bounds;
+	bounds.Min = { header.BoundsMin[0], header.BoundsMin[1], header.BoundsMin[2] };
+	bounds.Max = { header.BoundsMax[0], header.BoundsMax[1], header.BoundsMax[2] };
+
+	// The mapping is page-aligned and the blocks are 16-byte aligned within it
+	const std::span<const Vertex> vertices(reinterpret_cast<const Vertex*>(file->GetData() + header.VertexOffset), header.VertexCount);
+	const std::span<const uint32_t> indices(reinterpret_cast<const uint32_t*>(file->GetData() + header.IndexOffset), header.IndexCount);
+
+	// The header can't vouch for them, an index past the vertices would read out of bounds on the GPU
+	if (!std::ranges::all_of(indices, [&vertices](uint32_t index) { return index < vertices.size(); }))
+	{
+		LOG_TAGGED(s_LogTag, "Discarding invalid cache %s", cachePath.string().data());
+		return nullptr;
+	}
+
+	return CreateScope<MeshCache>(std::move(file), bounds, vertices, indices);
+}
+
+bool MeshCache::Write(const std::filesystem::path& source, std::span<const Vertex> vertices, std::span<const uint32_t> indices, const MeshBounds& bounds)
+{
+	std::error_code error;
+	const uint64_t sourceSize = static_cast<uint64_t>(std::filesystem::file_size(source, error));
+	if (error)
+		return false;
+
+	MeshCacheHeader header;
+	header.VertexCount = static_cast<uint32_t>(vertices.size());
+	header.IndexCount = static_cast<uint32_t>(indices.size());
+
+	header.VertexOffset = AlignUp(sizeof(MeshCacheHeader));
+	header.IndexOffset = AlignUp(header.VertexOffset + vertices.size_bytes());
+
+	std::memcpy(header.BoundsMin, &bounds.Min, sizeof(header.BoundsMin));
+	std::memcpy(header.BoundsMax, &bounds.Max, sizeof(header.BoundsMax));
+
+	header.SourceSize = sourceSize;
+	header.SourceTimestamp = GetFileTimestamp(source);
+	header.SourceHash = HashFile(source);
+
+	const auto cachePath = GetCachePath(source);
+
+	// Same as the pipeline cache, a crash mid-write won't leave a truncated file behind
+	auto tempPath = cachePath;
+	tempPath += ".tmp";
+
+	{
+		FileStreamWriter stream(tempPath);
+
+		if (!stream.IsStreamGood())
+		{
+			LOG_TAGGED(s_LogTag, "Failed to open %s", tempPath.string().data());
+			return false;
+		}
+
+		static constexpr std::array<char, s_BlockAlignment> padding = {};
+
+		stream.Write(header);
+		stream.Write(padding.data(), header.VertexOffset - sizeof(MeshCacheHeader));
+
+		stream.Write(reinterpret_cast<const char*>(vertices.data()), vertices.size_bytes());
+		stream.Write(padding.data(), header.IndexOffset - (header.VertexOffset + vertices.size_bytes()));
+
+		stream.Write(reinterpret_cast<const char*>(indices.data()), indices.size_bytes());
+	}
+
+	std::filesystem::rename(tempPath, cachePath, error);
+
+	if (error)
+	{
+		LOG_TAGGED(s_LogTag, "Failed to write %s", cachePath.string().data());
+		return false;
+	}
+
+	return true;
+}
+
+MeshCache::MeshCache(Scope<MappedFile>&& file, const MeshBounds& bounds, std::span<const Vertex> vertices, std::span<const uint32_t> indices)
+	: m_File(std::move(file)), m_Bounds(bounds), m_Vertices(vertices), m_Indices(indices)
+{
+}
+
+MeshCache::~MeshCache()
+{
+	m_File.reset();
+}
+
+std::span<const Vertex> MeshCache::GetVertices() const
+{
+	return m_Vertices;
+}
+
+std::span<const uint32_t> MeshCache::GetIndices() const
+{
+	return m_Indices;
+}
+
+const MeshBounds& MeshCache::GetBounds() const
+{
+	return m_Bounds;
+}
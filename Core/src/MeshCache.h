@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Base.h"
+
+#include "Mesh.h"
+
+#include <filesystem>
+#include <span>
+
+class MappedFile;
+
+// Parsed mesh stored next to its source as <file>.meshcache, memory-mapped on later loads
+// Layout: header | vertices | indices, blocks are 16-byte aligned so they can be read in place
+class MeshCache
+{
+public:
+	static std::filesystem::path GetCachePath(const std::filesystem::path& source);
+
+	// nullptr if there's no cache for source or it's stale
+	static Scope<MeshCache> Open(const std::filesystem::path& source);
+	static bool Write(const std::filesystem::path& source, std::span<const Vertex> vertices, std::span<const uint32_t> indices, const MeshBounds& bounds);
+
+	MeshCache(Scope<MappedFile>&& file, const MeshBounds& bounds, std::span<const Vertex> vertices, std::span<const uint32_t> indices);
+	~MeshCache();
+
+	DELETE_COPY_AND_MOVE(MeshCache);
+
+	// Point into the mapping, valid as long as the cache is alive
+	std::span<const Vertex> GetVertices() const;
+	std::span<const uint32_t> GetIndices() const;
+
+	const MeshBounds& GetBounds() const;
+private:
+	Scope<MappedFile> m_File;
+
+	MeshBounds m_Bounds;
+
+	std::span<const Vertex> m_Vertices;
+	std::span<const uint32_t> m_Indices;
+};
@@ -0,0 +1,471 @@
+#include "MeshOptimizer.h"
+
+#include "Utils.h"
+
+#include "Log.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+static constexpr const char* s_LogTag = "[MeshOptimizer]";
+
+static constexpr uint32_t s_InvalidIndex = ~0U;
+
+#pragma region Deduplication
+
+// Compared component-wise instead of as a whole, Vertex may have padding
+using VertexComponents = std::array<float, 12>;
+
+static VertexComponents GetComponents(const Vertex& vertex)
+{
+	return {
+		vertex.Position.x, vertex.Position.y, vertex.Position.z,
+		vertex.Normal.x, vertex.Normal.y, vertex.Normal.z,
+		vertex.TexCoord.x, vertex.TexCoord.y,
+		vertex.Color.r, vertex.Color.g, vertex.Color.b, vertex.Color.a
+	};
+}
+
+struct VertexComponentsHash
+{
+	size_t operator()(const VertexComponents& components) const
+	{
+		return static_cast<size_t>(HashBytes(components));
+	}
+};
+
+struct VertexComponentsEqual
+{
+	// Bitwise, so -0.0f and 0.0f stay apart and the hash stays consistent
+	bool operator()(const VertexComponents& lhs, const VertexComponents& rhs) const
+	{
+		return 0 == std::memcmp(lhs.data(), rhs.data(), sizeof(VertexComponents));
+	}
+};
+
+void MeshOptimizer::DeduplicateVertices(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+	std::unordered_map<VertexComponents, uint32_t, VertexComponentsHash, VertexComponentsEqual> uniqueVertices;
+	uniqueVertices.reserve(vertices.size());
+
+	std::vector<uint32_t> remap(vertices.size(), s_InvalidIndex);
+
+	std::vector<Vertex> result;
+	result.reserve(vertices.size());
+
+	for (auto& index : indices)
+	{
+		if (s_InvalidIndex == remap[index])
+		{
+			const auto [it, inserted] = uniqueVertices.try_emplace(GetComponents(vertices[index]), static_cast<uint32_t>(result.size()));
+
+			if (inserted)
+				result.emplace_back(vertices[index]);
+
+			remap[index] = it->second;
+		}
+
+		index = remap[index];
+	}
+
+	vertices = std::move(result);
+}
+
+#pragma endregion
+
+#pragma region VertexCache
+
+// Size of the simulated LRU cache, larger than any real one so the order works well across GPUs
+static constexpr uint32_t s_ScoringCacheSize = 32;
+
+static constexpr float s_CacheDecayPower = 1.5f;
+static constexpr float s_LastTriangleScore = 0.75f;
+static constexpr float s_ValenceBoostScale = 2.0f;
+static constexpr float s_ValenceBoostPower = 0.5f;
+
+static float GetVertexScore(int32_t cachePosition, uint32_t remainingTriangles)
+{
+	// Nothing left to draw with it
+	if (0 == remainingTriangles)
+		return -1.0f;
+
+	float score = 0.0f;
+
+	if (cachePosition >= 0)
+	{
+		// The last triangle's vertices get a fixed score, so its neighbours don't always win
+		if (cachePosition < 3)
+		{
+			score = s_LastTriangleScore;
+		}
+		else
+		{
+			const float scaler = 1.0f / static_cast<float>(s_ScoringCacheSize - 3);
+			score = std::pow(1.0f - static_cast<float>(cachePosition - 3) * scaler, s_CacheDecayPower);
+		}
+	}
+
+	// Favour vertices with few triangles left, so lone triangles don't get stranded
+	score += s_ValenceBoostScale * std::pow(static_cast<float>(remainingTriangles), -s_ValenceBoostPower);
+
+	return score;
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::span<uint32_t> indices, uint32_t vertexCount)
+{
+	const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+
+	if (triangleCount < 2)
+		return;
+
+	// Triangles using each vertex, emitted ones are swapped past the remaining count
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+	std::vector<uint32_t> remainingTriangles(vertexCount, 0);
+
+	for (const auto index : indices)
+		adjacencyOffsets[index + 1]++;
+
+	for (uint32_t i = 0; i < vertexCount; i++)
+		adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+
+	std::vector<uint32_t> adjacency(indices.size());
+
+	for (uint32_t i = 0; i < triangleCount * 3; i++)
+	{
+		const uint32_t vertex = indices[i];
+		adjacency[adjacencyOffsets[vertex] + remainingTriangles[vertex]++] = i / 3;
+	}
+
+	std::vector<int32_t> cachePositions(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+
+	for (uint32_t i = 0; i < vertexCount; i++)
+		vertexScores[i] = GetVertexScore(-1, remainingTriangles[i]);
+
+	std::vector<float> triangleScores(triangleCount);
+	std::vector<bool> isEmitted(triangleCount, false);
+
+	uint32_t bestTriangle = 0;
+
+	for (uint32_t i = 0; i < triangleCount; i++)
+	{
+		triangleScores[i] = vertexScores[indices[i * 3 + 0]] + vertexScores[indices[i * 3 + 1]] + vertexScores[indices[i * 3 + 2]];
+
+		if (triangleScores[i] > triangleScores[bestTriangle])
+			bestTriangle = i;
+	}
+
+	// Written in place, the input is read from the copy
+	const std::vector<uint32_t> source(indices.begin(), indices.end());
+
+	// Room for a full cache plus the incoming triangle
+	std::array<uint32_t, s_ScoringCacheSize + 3> cache = {};
+	std::array<uint32_t, s_ScoringCacheSize + 3> newCache = {};
+	uint32_t cacheCount = 0;
+
+	uint32_t nextUnemitted = 0;
+
+	for (uint32_t output = 0; output < triangleCount; output++)
+	{
+		// Nothing in the cache has triangles left, continue with the next one in the input order
+		if (s_InvalidIndex == bestTriangle)
+		{
+			while (isEmitted[nextUnemitted])
+				nextUnemitted++;
+
+			bestTriangle = nextUnemitted;
+		}
+
+		const uint32_t* triangle = &source[bestTriangle * 3];
+
+		std::copy(triangle, triangle + 3, &indices[output * 3]);
+		isEmitted[bestTriangle] = true;
+
+		uint32_t newCacheCount = 0;
+
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			const uint32_t vertex = triangle[i];
+
+			const auto begin = adjacency.begin() + adjacencyOffsets[vertex];
+			const auto end = begin + remainingTriangles[vertex];
+
+			std::iter_swap(std::find(begin, end, bestTriangle), end - 1);
+			remainingTriangles[vertex]--;
+
+			// Degenerate triangles repeat a vertex
+			if (std::find(newCache.begin(), newCache.begin() + newCacheCount, vertex) == newCache.begin() + newCacheCount)
+				newCache[newCacheCount++] = vertex;
+		}
+
+		const uint32_t triangleVertexCount = newCacheCount;
+
+		for (uint32_t i = 0; i < cacheCount; i++)
+		{
+			const uint32_t vertex = cache[i];
+
+			if (std::find(newCache.begin(), newCache.begin() + triangleVertexCount, vertex) == newCache.begin() + triangleVertexCount)
+				newCache[newCacheCount++] = vertex;
+		}
+
+		// Rescore everything that moved, including the vertices pushed out of the cache
+		bestTriangle = s_InvalidIndex;
+		float bestScore = -1.0f;
+
+		for (uint32_t i = 0; i < newCacheCount; i++)
+		{
+			const uint32_t vertex = newCache[i];
+			const int32_t position = (i < s_ScoringCacheSize) ? static_cast<int32_t>(i) : -1;
+
+			cachePositions[vertex] = position;
+
+			const float score = GetVertexScore(position, remainingTriangles[vertex]);
+			const float delta = score - vertexScores[vertex];
+			vertexScores[vertex] = score;
+
+			const uint32_t begin = adjacencyOffsets[vertex];
+			const uint32_t end = begin + remainingTriangles[vertex];
+
+			for (uint32_t j = begin; j < end; j++)
+			{
+				const uint32_t adjacent = adjacency[j];
+
+				triangleScores[adjacent] += delta;
+
+				if (position >= 0 && triangleScores[adjacent] > bestScore)
+				{
+					bestScore = triangleScores[adjacent];
+					bestTriangle = adjacent;
+				}
+			}
+		}
+
+		cacheCount = std::min(newCacheCount, s_ScoringCacheSize);
+		std::copy(newCache.begin(), newCache.begin() + cacheCount, cache.begin());
+	}
+}
+
+VertexCacheStatistics MeshOptimizer::AnalyzeVertexCache(std::span<const uint32_t> indices, uint32_t vertexCount, uint32_t cacheSize)
+{
+	VertexCacheStatistics stats;
+
+	stats.TriangleCount = static_cast<uint32_t>(indices.size() / 3);
+
+	if (0 == stats.TriangleCount || 0 == vertexCount)
+		return stats;
+
+	// A vertex is cached while fewer than cacheSize misses happened since it was loaded
+	std::vector<uint32_t> timestamps(vertexCount, 0);
+	uint32_t time = cacheSize + 1;
+
+	uint32_t misses = 0;
+
+	for (const auto index : indices)
+	{
+		if (time - timestamps[index] > cacheSize)
+		{
+			timestamps[index] = time++;
+			misses++;
+		}
+	}
+
+	std::vector<bool> isUsed(vertexCount, false);
+
+	for (const auto index : indices)
+	{
+		if (!isUsed[index])
+		{
+			isUsed[index] = true;
+			stats.VertexCount++;
+		}
+	}
+
+	stats.ACMR = static_cast<float>(misses) / static_cast<float>(stats.TriangleCount);
+	stats.ATVR = static_cast<float>(misses) / static_cast<float>(stats.VertexCount);
+
+	return stats;
+}
+
+#pragma endregion
+
+#pragma region Overdraw
+
+struct TriangleCluster
+{
+	uint32_t Begin = 0;
+	uint32_t End = 0;
+
+	float SortKey = 0.0f;
+};
+
+// Sized like a real post-transform cache, unlike the scoring one
+static constexpr uint32_t s_ClusterCacheSize = 16;
+
+void MeshOptimizer::OptimizeOverdraw(std::span<uint32_t> indices, std::span<const Vertex> vertices, float threshold)
+{
+	const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+	const uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+
+	if (triangleCount < 2)
+		return;
+
+	const float meshACMR = AnalyzeVertexCache(indices, vertexCount, s_ClusterCacheSize).ACMR;
+
+	// Every cluster is simulated from a cold cache, once one is about as efficient as the whole mesh
+	// it can be drawn in any order without losing much, see the threshold
+	std::vector<TriangleCluster> clusters;
+
+	std::vector<uint32_t> timestamps(vertexCount, 0);
+	uint32_t time = s_ClusterCacheSize + 1;
+
+	uint32_t clusterBegin = 0;
+	uint32_t clusterMisses = 0;
+
+	for (uint32_t i = 0; i < triangleCount; i++)
+	{
+		for (uint32_t j = 0; j < 3; j++)
+		{
+			const uint32_t index = indices[i * 3 + j];
+
+			if (time - timestamps[index] > s_ClusterCacheSize)
+			{
+				timestamps[index] = time++;
+				clusterMisses++;
+			}
+		}
+
+		const float clusterACMR = static_cast<float>(clusterMisses) / static_cast<float>(i + 1 - clusterBegin);
+
+		if (clusterACMR <= meshACMR * threshold)
+		{
+			clusters.push_back({ clusterBegin, i + 1 });
+
+			clusterBegin = i + 1;
+			clusterMisses = 0;
+
+			// Flush
+			time += s_ClusterCacheSize + 1;
+		}
+	}
+
+	if (clusterBegin < triangleCount)
+		clusters.push_back({ clusterBegin, triangleCount });
+
+	if (clusters.size() < 2)
+		return;
+
+	// Area weighted centroids and normals
+	std::vector<glm::vec3> clusterCentroids(clusters.size(), glm::vec3(0.0f));
+	std::vector<glm::vec3> clusterNormals(clusters.size(), glm::vec3(0.0f));
+
+	glm::vec3 meshCentroid = glm::vec3(0.0f);
+	float meshArea = 0.0f;
+
+	for (size_t c = 0; c < clusters.size(); c++)
+	{
+		float clusterArea = 0.0f;
+
+		for (uint32_t i = clusters[c].Begin; i < clusters[c].End; i++)
+		{
+			const glm::vec3& p0 = vertices[indices[i * 3 + 0]].Position;
+			const glm::vec3& p1 = vertices[indices[i * 3 + 1]].Position;
+			const glm::vec3& p2 = vertices[indices[i * 3 + 2]].Position;
+
+			const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+			const float area = glm::length(normal);
+
+			clusterCentroids[c] += (p0 + p1 + p2) * (area / 3.0f);
+			clusterNormals[c] += normal;
+			clusterArea += area;
+		}
+
+		meshCentroid += clusterCentroids[c];
+		meshArea += clusterArea;
+
+		if (clusterArea > 0.0f)
+			clusterCentroids[c] /= clusterArea;
+	}
+
+	if (meshArea > 0.0f)
+		meshCentroid /= meshArea;
+
+	// Clusters facing away from the center are likelier to occlude the others, draw them first
+	for (size_t c = 0; c < clusters.size(); c++)
+	{
+		const float length = glm::length(clusterNormals[c]);
+
+		if (length > 0.0f)
+			clusters[c].SortKey = glm::dot(clusterCentroids[c] - meshCentroid, clusterNormals[c] / length);
+	}
+
+	std::stable_sort(clusters.begin(), clusters.end(), [](const TriangleCluster& lhs, const TriangleCluster& rhs)
+		{
+			return lhs.SortKey > rhs.SortKey;
+		});
+
+	const std::vector<uint32_t> source(indices.begin(), indices.end());
+
+	uint32_t output = 0;
+
+	for (const auto& cluster : clusters)
+	{
+		const uint32_t count = (cluster.End - cluster.Begin) * 3;
+
+		std::copy_n(source.begin() + cluster.Begin * 3, count, indices.begin() + output);
+		output += count;
+	}
+}
+
+#pragma endregion
+
+#pragma region VertexFetch
+
+void MeshOptimizer::OptimizeVertexFetch(std::vector<Vertex>& vertices, std::span<uint32_t> indices)
+{
+	std::vector<uint32_t> remap(vertices.size(), s_InvalidIndex);
+	uint32_t vertexCount = 0;
+
+	for (auto& index : indices)
+	{
+		if (s_InvalidIndex == remap[index])
+			remap[index] = vertexCount++;
+
+		index = remap[index];
+	}
+
+	std::vector<Vertex> result(vertexCount);
+
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		if (s_InvalidIndex != remap[i])
+			result[remap[i]] = vertices[i];
+	}
+
+	vertices = std::move(result);
+}
+
+#pragma endregion
+
+void MeshOptimizer::Optimize(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+	if (vertices.empty() || indices.size() < 3)
+		return;
+
+	const auto before = AnalyzeVertexCache(indices, static_cast<uint32_t>(vertices.size()));
+	const uint32_t vertexCountBefore = static_cast<uint32_t>(vertices.size());
+
+	DeduplicateVertices(vertices, indices);
+	OptimizeVertexCache(indices, static_cast<uint32_t>(vertices.size()));
+	OptimizeOverdraw(indices, vertices);
+	OptimizeVertexFetch(vertices, indices);
+
+	const auto after = AnalyzeVertexCache(indices, static_cast<uint32_t>(vertices.size()));
+
+	LOG_TAGGED(s_LogTag, "Vertices: %u -> %u | ACMR: %.3f -> %.3f | ATVR: %.3f -> %.3f",
+		vertexCountBefore, static_cast<uint32_t>(vertices.size()), before.ACMR, after.ACMR, before.ATVR, after.ATVR);
+}
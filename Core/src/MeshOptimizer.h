@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Vertex.h"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+struct VertexCacheStatistics
+{
+	uint32_t VertexCount = 0;
+	uint32_t TriangleCount = 0;
+	// Cache misses per triangle, 3 is the worst case, ~0.5 the best for a closed mesh
+	float ACMR = 0.0f;
+	// Cache misses per vertex, 1 is optimal
+	float ATVR = 0.0f;
+};
+
+// Reorders triangle lists so the GPU does less work, meant for static meshes at load time
+// Can be run on anything passed to Mesh::Create(vertices, indices)
+class MeshOptimizer
+{
+public:
+	// Runs every step below in order and logs the before/after statistics
+	static void Optimize(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+	// Merges bitwise identical vertices, indices are remapped and unused vertices dropped
+	static void DeduplicateVertices(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+	// Post-transform cache reorder, see "Linear-Speed Vertex Cache Optimisation" (Forsyth 2006)
+	static void OptimizeVertexCache(std::span<uint32_t> indices, uint32_t vertexCount);
+
+	// Keeps the cache-friendly clusters but sorts them outside-in, see "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw" (Sander et al. 2007)
+	// Expects indices already cache-optimized, threshold > 1 trades cache efficiency for smaller clusters
+	static void OptimizeOverdraw(std::span<uint32_t> indices, std::span<const Vertex> vertices, float threshold = 1.05f);
+
+	// Lays vertices out in first-use order, indices are remapped
+	static void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::span<uint32_t> indices);
+
+	// Simulates a FIFO cache of cacheSize entries
+	static VertexCacheStatistics AnalyzeVertexCache(std::span<const uint32_t> indices, uint32_t vertexCount, uint32_t cacheSize = 16);
+};
@@ -0,0 +1,290 @@
+#include "MipGenerator.h"
+
+#include "JobSystem.h"
+#include "Timer.h"
+
+#include "Log.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <numbers>
+
+static constexpr const char* s_LogTag = "[MipGenerator]";
+
+static constexpr uint32_t s_ChannelCount = 4;
+
+#pragma region ColorSpace
+
+static float SRGBToLinear(float value)
+{
+	return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+}
+
+struct SRGBTables
+{
+	std::array<float, 256> ToLinear;
+	// Linear values halfway between two consecutive sRGB ones, encoding is a search in it so it rounds exactly
+	std::array<float, 255> Thresholds;
+
+	SRGBTables()
+	{
+		for (uint32_t i = 0; i < 256; i++)
+			ToLinear[i] = SRGBToLinear(static_cast<float>(i) / 255.0f);
+
+		for (uint32_t i = 0; i < 255; i++)
+			Thresholds[i] = SRGBToLinear((static_cast<float>(i) + 0.5f) / 255.0f);
+	}
+};
+
+static const SRGBTables& GetSRGBTables()
+{
+	static const SRGBTables tables;
+
+	return tables;
+}
+
+static uint8_t EncodeLinear(float value)
+{
+	return static_cast<uint8_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+static uint8_t EncodeSRGB(float value)
+{
+	const auto& thresholds = GetSRGBTables().Thresholds;
+
+	return static_cast<uint8_t>(std::upper_bound(thresholds.begin(), thresholds.end(), value) - thresholds.begin());
+}
+
+#pragma endregion
+
+#pragma region Filters
+
+// Modified Bessel function of the first kind, order 0, the series converges fast for the alphas used here
+static float BesselI0(float x)
+{
+	float sum = 1.0f, term = 1.0f;
+	const float halfX = x * 0.5f;
+
+	for (uint32_t k = 1; k < 20; k++)
+	{
+		term *= (halfX / static_cast<float>(k)) * (halfX / static_cast<float>(k));
+		sum += term;
+	}
+
+	return sum;
+}
+
+// Kaiser-windowed sinc, 3 destination texels wide, same defaults as NVTT
+static constexpr float s_KaiserRadius = 1.5f;
+static constexpr float s_KaiserAlpha = 4.0f;
+
+static float Kaiser(float x)
+{
+	if (std::abs(x) >= s_KaiserRadius)
+		return 0.0f;
+
+	const float t = x / s_KaiserRadius;
+	const float window = BesselI0(s_KaiserAlpha * std::sqrt(1.0f - t * t)) / BesselI0(s_KaiserAlpha);
+
+	const float px = std::numbers::pi_v<float> * x;
+	const float sinc = std::abs(px) < 1e-5f ? 1.0f : std::sin(px) / px;
+
+	return sinc * window;
+}
+
+// Source texels and weights contributing to each destination texel along one axis, weights sum to 1
+struct FilterTaps
+{
+	// Taps of destination texel i are [Offsets[i], Offsets[i + 1])
+	std::vector<uint32_t> Offsets;
+	std::vector<uint32_t> Indices;
+	std::vector<float> Weights;
+};
+
+static FilterTaps ComputeTaps(uint32_t sourceSize, uint32_t destinationSize, MipFilter filter)
+{
+	FilterTaps taps;
+	taps.Offsets.reserve(destinationSize + 1);
+
+	const float scale = static_cast<float>(sourceSize) / static_cast<float>(destinationSize);
+
+	for (uint32_t i = 0; i < destinationSize; i++)
+	{
+		taps.Offsets.emplace_back(static_cast<uint32_t>(taps.Indices.size()));
+
+		const float begin = static_cast<float>(i) * scale;
+		const float end = begin + scale;
+		const float center = (begin + end) * 0.5f;
+
+		const float radius = (MipFilter::KAISER == filter) ? s_KaiserRadius * scale : scale * 0.5f;
+
+		const int32_t first = static_cast<int32_t>(std::floor(center - radius));
+		const int32_t last = static_cast<int32_t>(std::ceil(center + radius));
+
+		const size_t tapsBegin = taps.Indices.size();
+		float sum = 0.0f;
+
+		for (int32_t source = first; source <= last; source++)
+		{
+			float weight = 0.0f;
+
+			if (MipFilter::KAISER == filter)
+			{
+				weight = Kaiser((static_cast<float>(source) + 0.5f - center) / scale);
+			}
+			else
+			{
+				// Coverage of the source texel by the destination one, handles odd sizes
+				weight = std::max(0.0f, std::min(end, static_cast<float>(source + 1)) - std::max(begin, static_cast<float>(source)));
+			}
+
+			if (0.0f == weight)
+				continue;
+
+			// Clamp to edge, the weight piles up on the border texel
+			const uint32_t index = static_cast<uint32_t>(std::clamp(source, 0, static_cast<int32_t>(sourceSize) - 1));
+
+			taps.Indices.emplace_back(index);
+			taps.Weights.emplace_back(weight);
+
+			sum += weight;
+		}
+
+		for (size_t t = tapsBegin; t < taps.Weights.size(); t++)
+			taps.Weights[t] /= sum;
+	}
+
+	taps.Offsets.emplace_back(static_cast<uint32_t>(taps.Indices.size()));
+
+	return taps;
+}
+
+// Separable, horizontal then vertical, images are RGBA floats
+static void Resample(const std::vector<float>& source, uint32_t sourceWidth, uint32_t sourceHeight,
+	std::vector<float>& destination, uint32_t destinationWidth, uint32_t destinationHeight, MipFilter filter)
+{
+	const FilterTaps horizontal = ComputeTaps(sourceWidth, destinationWidth, filter);
+	const FilterTaps vertical = ComputeTaps(sourceHeight, destinationHeight, filter);
+
+	std::vector<float> temporary(static_cast<size_t>(destinationWidth) * sourceHeight * s_ChannelCount);
+
+	JobSystem::ParallelFor(sourceHeight, [&](uint32_t y)
+		{
+			const float* sourceRow = source.data() + static_cast<size_t>(y) * sourceWidth * s_ChannelCount;
+			float* temporaryRow = temporary.data() + static_cast<size_t>(y) * destinationWidth * s_ChannelCount;
+
+			for (uint32_t x = 0; x < destinationWidth; x++)
+			{
+				float texel[s_ChannelCount] = {};
+
+				for (uint32_t t = horizontal.Offsets[x]; t < horizontal.Offsets[x + 1]; t++)
+				{
+					const float* sourceTexel = sourceRow + static_cast<size_t>(horizontal.Indices[t]) * s_ChannelCount;
+
+					for (uint32_t c = 0; c < s_ChannelCount; c++)
+						texel[c] += sourceTexel[c] * horizontal.Weights[t];
+				}
+
+				std::memcpy(temporaryRow + static_cast<size_t>(x) * s_ChannelCount, texel, sizeof(texel));
+			}
+		});
+
+	destination.assign(static_cast<size_t>(destinationWidth) * destinationHeight * s_ChannelCount, 0.0f);
+
+	JobSystem::ParallelFor(destinationHeight, [&](uint32_t y)
+		{
+			float* destinationRow = destination.data() + static_cast<size_t>(y) * destinationWidth * s_ChannelCount;
+
+			for (uint32_t t = vertical.Offsets[y]; t < vertical.Offsets[y + 1]; t++)
+			{
+				const float* temporaryRow = temporary.data() + static_cast<size_t>(vertical.Indices[t]) * destinationWidth * s_ChannelCount;
+				const float weight = vertical.Weights[t];
+
+				for (size_t i = 0; i < static_cast<size_t>(destinationWidth) * s_ChannelCount; i++)
+					destinationRow[i] += temporaryRow[i] * weight;
+			}
+		});
+}
+
+#pragma endregion
+
+uint32_t MipGenerator::GetLevelCount(uint32_t width, uint32_t height)
+{
+	return static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
+}
+
+MipChain MipGenerator::Generate(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t layerCount, Format format, MipFilter filter, uint32_t levelCount)
+{
+	ASSERT(rgba);
+	ASSERT(width != 0 && height != 0 && layerCount != 0);
+	ASSERT(FormatBytesPerPixel(format) == s_ChannelCount);
+	ASSERT(levelCount != 0 && levelCount <= GetLevelCount(width, height));
+
+	Timer timer;
+
+	MipChain chain;
+
+	chain.Format = format;
+	chain.Width = width;
+	chain.Height = height;
+	chain.LayerCount = layerCount;
+
+	chain.LevelOffsets.resize(levelCount);
+
+	uint64_t size = 0;
+
+	for (uint32_t level = levelCount; level-- > 0;)
+	{
+		chain.LevelOffsets[level] = size;
+		size += chain.GetLevelSize(level);
+	}
+
+	chain.Data.resize(size);
+
+	// Level 0 is the source as is
+	std::memcpy(chain.Data.data() + chain.LevelOffsets[0], rgba, static_cast<size_t>(chain.GetLevelSize(0)));
+
+	const bool isSRGB = IsSRGB(format);
+	const auto& toLinear = GetSRGBTables().ToLinear;
+
+	for (uint32_t layer = 0; layer < layerCount && levelCount > 1; layer++)
+	{
+		const size_t texelCount = static_cast<size_t>(width) * height;
+		const uint8_t* source = rgba + texelCount * s_ChannelCount * layer;
+
+		std::vector<float> current(texelCount * s_ChannelCount);
+
+		for (size_t i = 0; i < texelCount * s_ChannelCount; i++)
+		{
+			const bool isAlpha = (i % s_ChannelCount) == 3;
+			current[i] = (isSRGB && !isAlpha) ? toLinear[source[i]] : static_cast<float>(source[i]) / 255.0f;
+		}
+
+		std::vector<float> next;
+
+		for (uint32_t level = 1; level < levelCount; level++)
+		{
+			const uint32_t levelWidth = chain.GetLevelWidth(level);
+			const uint32_t levelHeight = chain.GetLevelHeight(level);
+
+			Resample(current, chain.GetLevelWidth(level - 1), chain.GetLevelHeight(level - 1), next, levelWidth, levelHeight, filter);
+
+			const size_t levelTexelCount = static_cast<size_t>(levelWidth) * levelHeight;
+			auto* destination = reinterpret_cast<uint8_t*>(chain.Data.data() + chain.LevelOffsets[level]) + levelTexelCount * s_ChannelCount * layer;
+
+			for (size_t i = 0; i < levelTexelCount * s_ChannelCount; i++)
+			{
+				const bool isAlpha = (i % s_ChannelCount) == 3;
+				destination[i] = (isSRGB && !isAlpha) ? EncodeSRGB(next[i]) : EncodeLinear(next[i]);
+			}
+
+			std::swap(current, next);
+		}
+	}
+
+	LOG_TAGGED(s_LogTag, "%ux%u, %u layers, %u levels in %.2f ms", width, height, layerCount, levelCount, timer.ElapsedMS());
+
+	return chain;
+}
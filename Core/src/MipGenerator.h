@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Enums.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// An image and its mip levels, level 0 is the full size one
+// Each level holds every layer back to back, see Image2D::CopyFrom()
+struct MipChain
+{
+	Format Format = Format::UNDEFINED;
+
+	uint32_t Width = 0;
+	uint32_t Height = 0;
+	uint32_t LayerCount = 1;
+
+	// Where each level starts in Data
+	// Stored smallest level first, the tail of the chain can be read without the rest
+	std::vector<uint64_t> LevelOffsets;
+	std::vector<std::byte> Data;
+
+	uint32_t GetLevelCount() const { return static_cast<uint32_t>(LevelOffsets.size()); }
+	uint32_t GetLevelWidth(uint32_t level) const { return Width >> level > 0 ? Width >> level : 1; }
+	uint32_t GetLevelHeight(uint32_t level) const { return Height >> level > 0 ? Height >> level : 1; }
+	uint64_t GetLevelSize(uint32_t level) const { return FormatImageSize(Format, GetLevelWidth(level), GetLevelHeight(level)) * LayerCount; }
+
+	std::span<const std::byte> GetLevel(uint32_t level) const { return { Data.data() + LevelOffsets[level], static_cast<size_t>(GetLevelSize(level)) }; }
+};
+
+// Builds mip chains of RGBA8 images on the CPU, replaces the vkCmdBlitImage chain (see TextureDescription::MipGeneration)
+// Each level is filtered from the previous one, rows are split across the JobSystem workers
+class MipGenerator
+{
+public:
+	// Down to 1x1
+	static uint32_t GetLevelCount(uint32_t width, uint32_t height);
+
+	// rgba holds layerCount images of width * height texels back to back, the result has the same format
+	// sRGB color is filtered in linear space, alpha always is linear
+	static MipChain Generate(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t layerCount, Format format, MipFilter filter, uint32_t levelCount);
+};
@@ -0,0 +1,514 @@
+#include "ObjParser.h"
+
+#include "MappedFile.h"
+#include "JobSystem.h"
+#include "Timer.h"
+
+#include "Log.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <cstring>
+#include <limits>
+
+static constexpr const char* s_LogTag = "[ObjParser]";
+
+// Small files aren't worth the jobs
+static constexpr size_t s_MinChunkSize = 256 * 1024;
+
+static constexpr int32_t s_MissingIndex = std::numeric_limits<int32_t>::min();
+
+// Negative OBJ indices count back from the last element seen, which for a chunk
+// is only known after merging, those are stored relative to the chunk and flagged
+enum ObjCornerFlags : uint8_t
+{
+	OBJ_CORNER_RELATIVE_POSITION = 1 << 0,
+	OBJ_CORNER_RELATIVE_TEXCOORD = 1 << 1,
+	OBJ_CORNER_RELATIVE_NORMAL = 1 << 2
+};
+
+struct ObjCorner
+{
+	int32_t Position = s_MissingIndex;
+	int32_t TexCoord = s_MissingIndex;
+	int32_t Normal = s_MissingIndex;
+
+	uint8_t Flags = 0;
+};
+
+struct ObjChunk
+{
+	const char* Begin = nullptr;
+	const char* End = nullptr;
+
+	std::vector<glm::vec3> Positions;
+	std::vector<glm::vec3> Normals;
+	std::vector<glm::vec2> TexCoords;
+
+	// Already triangulated
+	std::vector<ObjCorner> Corners;
+
+	// Offsets of this chunk's elements in the merged arrays
+	size_t PositionOffset = 0;
+	size_t NormalOffset = 0;
+	size_t TexCoordOffset = 0;
+	size_t CornerOffset = 0;
+
+	uint32_t LineErrors = 0;
+};
+
+#pragma region Parsing
+
+static bool IsSpace(char c)
+{
+	return ' ' == c || '\t' == c || '\r' == c;
+}
+
+static bool IsDigit(char c)
+{
+	return static_cast<unsigned char>(c - '0') < 10;
+}
+
+static const char* SkipSpaces(const char* it, const char* end)
+{
+	while (it < end && IsSpace(*it))
+		it++;
+
+	return it;
+}
+
+// Exactly representable, so mantissa * 10^exponent rounds only once
+static constexpr std::array<double, 23> s_PowersOf10 = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Straight-line digit loop for the common "-0.123456" case (Clinger's fast path),
+// anything with too many digits or a large exponent goes through std::from_chars
+static const char* ParseFloat(const char* it, const char* end, float& value)
+{
+	it = SkipSpaces(it, end);
+
+	if (it < end && '+' == *it)
+		it++;
+
+	const char* start = it;
+
+	const bool isNegative = it < end && '-' == *it;
+	if (isNegative)
+		it++;
+
+	uint64_t mantissa = 0;
+	int32_t exponent = 0;
+	uint32_t significantDigits = 0;
+	bool hasDigits = false;
+
+	for (; it < end && IsDigit(*it); it++)
+	{
+		hasDigits = true;
+
+		if (significantDigits < 19)
+		{
+			mantissa = mantissa * 10 + static_cast<uint64_t>(*it - '0');
+			significantDigits += (mantissa > 0) ? 1 : 0;
+		}
+		else
+		{
+			exponent++;
+		}
+	}
+
+	if (it < end && '.' == *it)
+	{
+		for (it++; it < end && IsDigit(*it); it++)
+		{
+			hasDigits = true;
+
+			if (significantDigits < 19)
+			{
+				mantissa = mantissa * 10 + static_cast<uint64_t>(*it - '0');
+				significantDigits += (mantissa > 0) ? 1 : 0;
+				exponent--;
+			}
+		}
+	}
+
+	if (!hasDigits)
+		return nullptr;
+
+	if (it < end && ('e' == *it || 'E' == *it))
+	{
+		const char* exponentIt = it + 1;
+
+		const bool isExponentNegative = exponentIt < end && '-' == *exponentIt;
+		if (exponentIt < end && ('-' == *exponentIt || '+' == *exponentIt))
+			exponentIt++;
+
+		int32_t exponentValue = 0;
+		bool hasExponentDigits = false;
+
+		for (; exponentIt < end && IsDigit(*exponentIt); exponentIt++)
+		{
+			hasExponentDigits = true;
+			exponentValue = std::min(exponentValue * 10 + (*exponentIt - '0'), 10000);
+		}
+
+		if (hasExponentDigits)
+		{
+			exponent += isExponentNegative ? -exponentValue : exponentValue;
+			it = exponentIt;
+		}
+	}
+
+	if (mantissa < (1ULL << 53) && exponent >= -22 && exponent <= 22)
+	{
+		double result = static_cast<double>(mantissa);
+		result = (exponent < 0) ? result / s_PowersOf10[-exponent] : result * s_PowersOf10[exponent];
+
+		value = static_cast<float>(isNegative ? -result : result);
+
+		return it;
+	}
+
+	const auto [ptr, error] = std::from_chars(start, it, value);
+
+	// Out of range still parsed the whole number, keep the clamped value
+	return (std::errc() == error || std::errc::result_out_of_range == error) ? ptr : nullptr;
+}
+
+static const char* ParseIndex(const char* it, const char* end, int32_t& value)
+{
+	const bool isNegative = it < end && '-' == *it;
+	if (isNegative)
+		it++;
+
+	if (it >= end || !IsDigit(*it))
+		return nullptr;
+
+	int64_t result = 0;
+
+	for (; it < end && IsDigit(*it); it++)
+		result = std::min<int64_t>(result * 10 + (*it - '0'), std::numeric_limits<int32_t>::max());
+
+	value = static_cast<int32_t>(isNegative ? -result : result);
+
+	return it;
+}
+
+// 1-based, or negative for relative to the last element so far
+static bool ResolveIndex(int32_t index, size_t localCount, uint8_t relativeFlag, int32_t& outIndex, uint8_t& outFlags)
+{
+	if (index > 0)
+	{
+		outIndex = index - 1;
+	}
+	else if (index < 0)
+	{
+		outIndex = static_cast<int32_t>(localCount) + index;
+		outFlags |= relativeFlag;
+	}
+	else
+	{
+		return false;
+	}
+
+	return true;
+}
+
+static const char* ParseCorner(const char* it, const char* end, const ObjChunk& chunk, ObjCorner& corner)
+{
+	int32_t index = 0;
+
+	it = ParseIndex(it, end, index);
+	if (!it || !ResolveIndex(index, chunk.Positions.size(), OBJ_CORNER_RELATIVE_POSITION, corner.Position, corner.Flags))
+		return nullptr;
+
+	if (it >= end || '/' != *it)
+		return it;
+
+	it++;
+
+	// v//vn
+	if (it < end && '/' != *it)
+	{
+		it = ParseIndex(it, end, index);
+		if (!it || !ResolveIndex(index, chunk.TexCoords.size(), OBJ_CORNER_RELATIVE_TEXCOORD, corner.TexCoord, corner.Flags))
+			return nullptr;
+	}
+
+	if (it >= end || '/' != *it)
+		return it;
+
+	it++;
+
+	it = ParseIndex(it, end, index);
+	if (!it || !ResolveIndex(index, chunk.Normals.size(), OBJ_CORNER_RELATIVE_NORMAL, corner.Normal, corner.Flags))
+		return nullptr;
+
+	return it;
+}
+
+static bool ParseLine(const char* it, const char* end, ObjChunk& chunk, std::vector<ObjCorner>& polygon)
+{
+	it = SkipSpaces(it, end);
+
+	if (end - it < 2)
+		return true;
+
+	if ('v' == it[0] && IsSpace(it[1]))
+	{
+		glm::vec3 position = {};
+
+		for (int i = 0; i < 3 && it; i++)
+			it = ParseFloat(it + (0 == i ? 2 : 0), end, position[i]);
+
+		if (!it)
+			return false;
+
+		// Trailing vertex colors aren't used
+		chunk.Positions.emplace_back(position);
+	}
+	else if ('v' == it[0] && 'n' == it[1])
+	{
+		glm::vec3 normal = {};
+
+		for (int i = 0; i < 3 && it; i++)
+			it = ParseFloat(it + (0 == i ? 2 : 0), end, normal[i]);
+
+		if (!it)
+			return false;
+
+		chunk.Normals.emplace_back(normal);
+	}
+	else if ('v' == it[0] && 't' == it[1])
+	{
+		glm::vec2 texCoord = {};
+
+		it = ParseFloat(it + 2, end, texCoord.x);
+
+		if (!it)
+			return false;
+
+		// v is optional
+		if (!ParseFloat(it, end, texCoord.y))
+			texCoord.y = 0.0f;
+
+		chunk.TexCoords.emplace_back(texCoord);
+	}
+	else if ('f' == it[0] && IsSpace(it[1]))
+	{
+		polygon.clear();
+
+		for (it = SkipSpaces(it + 1, end); it < end; it = SkipSpaces(it, end))
+		{
+			ObjCorner& corner = polygon.emplace_back();
+
+			it = ParseCorner(it, end, chunk, corner);
+
+			if (!it)
+				return false;
+		}
+
+		if (polygon.size() < 3)
+			return false;
+
+		// Fan
+		for (size_t i = 1; i + 1 < polygon.size(); i++)
+		{
+			chunk.Corners.emplace_back(polygon[0]);
+			chunk.Corners.emplace_back(polygon[i]);
+			chunk.Corners.emplace_back(polygon[i + 1]);
+		}
+	}
+
+	return true;
+}
+
+static void ParseChunk(ObjChunk& chunk)
+{
+	std::vector<ObjCorner> polygon;
+
+	for (const char* it = chunk.Begin; it < chunk.End;)
+	{
+		// memchr is vectorized in every libc we ship on
+		const char* lineEnd = static_cast<const char*>(std::memchr(it, '\n', chunk.End - it));
+
+		if (!lineEnd)
+			lineEnd = chunk.End;
+
+		if (!ParseLine(it, lineEnd, chunk, polygon))
+			chunk.LineErrors++;
+
+		it = (lineEnd < chunk.End) ? lineEnd + 1 : chunk.End;
+	}
+}
+
+#pragma endregion
+
+static std::vector<ObjChunk> SplitIntoChunks(const char* data, size_t size)
+{
+	const uint32_t maxChunkCount = (JobSystem::GetWorkerCount() + 1) * 4;
+	const uint32_t chunkCount = static_cast<uint32_t>(std::clamp<size_t>(size / s_MinChunkSize, 1, maxChunkCount));
+
+	std::vector<ObjChunk> chunks(chunkCount);
+
+	const char* end = data + size;
+	const char* begin = data;
+
+	for (uint32_t i = 0; i < chunkCount; i++)
+	{
+		const char* chunkEnd = (i + 1 == chunkCount) ? end : data + size / chunkCount * (i + 1);
+
+		// Line aligned, the newline stays with the chunk it ends
+		if (chunkEnd < end && chunkEnd > begin)
+		{
+			const char* newline = static_cast<const char*>(std::memchr(chunkEnd, '\n', end - chunkEnd));
+			chunkEnd = newline ? newline + 1 : end;
+		}
+
+		chunks[i].Begin = begin;
+		chunks[i].End = std::max(begin, chunkEnd);
+
+		begin = chunks[i].End;
+	}
+
+	return chunks;
+}
+
+static bool ResolveCorner(const ObjCorner& corner, uint8_t relativeFlag, int32_t index, size_t offset, size_t count, int32_t& outIndex)
+{
+	if (s_MissingIndex == index)
+	{
+		outIndex = s_MissingIndex;
+		return true;
+	}
+
+	const int64_t resolved = (corner.Flags & relativeFlag) ? static_cast<int64_t>(offset) + index : index;
+
+	if (resolved < 0 || resolved >= static_cast<int64_t>(count))
+		return false;
+
+	outIndex = static_cast<int32_t>(resolved);
+
+	return true;
+}
+
+bool ParseObj(const std::filesystem::path& path, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+	Timer timer;
+
+	auto file = MappedFile::Create(path);
+
+	if (!file)
+	{
+		LOG_TAGGED(s_LogTag, "Failed to open %s", path.string().data());
+		return false;
+	}
+
+	auto chunks = SplitIntoChunks(reinterpret_cast<const char*>(file->GetData()), file->GetSize());
+
+	JobSystem::ParallelFor(static_cast<uint32_t>(chunks.size()), 1, [&chunks](uint32_t i)
+		{
+			ParseChunk(chunks[i]);
+		});
+
+	// Offsets in file order, the result doesn't depend on which job finished first
+	size_t positionCount = 0, normalCount = 0, texCoordCount = 0, cornerCount = 0;
+	uint32_t lineErrors = 0;
+
+	for (auto& chunk : chunks)
+	{
+		chunk.PositionOffset = positionCount;
+		chunk.NormalOffset = normalCount;
+		chunk.TexCoordOffset = texCoordCount;
+		chunk.CornerOffset = cornerCount;
+
+		positionCount += chunk.Positions.size();
+		normalCount += chunk.Normals.size();
+		texCoordCount += chunk.TexCoords.size();
+		cornerCount += chunk.Corners.size();
+
+		lineErrors += chunk.LineErrors;
+	}
+
+	if (lineErrors > 0)
+		LOG_TAGGED(s_LogTag, "%s: skipped %u malformed lines", path.string().data(), lineErrors);
+
+	if (cornerCount > std::numeric_limits<uint32_t>::max())
+	{
+		LOG_TAGGED(s_LogTag, "%s: too many vertices", path.string().data());
+		return false;
+	}
+
+	std::vector<glm::vec3> positions(positionCount);
+	std::vector<glm::vec3> normals(normalCount);
+	std::vector<glm::vec2> texCoords(texCoordCount);
+
+	JobSystem::ParallelFor(static_cast<uint32_t>(chunks.size()), 1, [&](uint32_t i)
+		{
+			const auto& chunk = chunks[i];
+
+			std::copy(chunk.Positions.begin(), chunk.Positions.end(), positions.begin() + chunk.PositionOffset);
+			std::copy(chunk.Normals.begin(), chunk.Normals.end(), normals.begin() + chunk.NormalOffset);
+			std::copy(chunk.TexCoords.begin(), chunk.TexCoords.end(), texCoords.begin() + chunk.TexCoordOffset);
+		});
+
+	vertices.resize(cornerCount);
+	indices.resize(cornerCount);
+
+	std::atomic<bool> isValid = true;
+
+	JobSystem::ParallelFor(static_cast<uint32_t>(chunks.size()), 1, [&](uint32_t i)
+		{
+			const auto& chunk = chunks[i];
+
+			for (size_t j = 0; j < chunk.Corners.size(); j++)
+			{
+				const ObjCorner& corner = chunk.Corners[j];
+				const size_t output = chunk.CornerOffset + j;
+
+				int32_t position = 0, texCoord = 0, normal = 0;
+
+				if (!ResolveCorner(corner, OBJ_CORNER_RELATIVE_POSITION, corner.Position, chunk.PositionOffset, positionCount, position) ||
+					!ResolveCorner(corner, OBJ_CORNER_RELATIVE_TEXCOORD, corner.TexCoord, chunk.TexCoordOffset, texCoordCount, texCoord) ||
+					!ResolveCorner(corner, OBJ_CORNER_RELATIVE_NORMAL, corner.Normal, chunk.NormalOffset, normalCount, normal))
+				{
+					isValid.store(false, std::memory_order_relaxed);
+					return;
+				}
+
+				Vertex vertex = {};
+
+				vertex.Position = positions[position];
+
+				if (s_MissingIndex != texCoord)
+					vertex.TexCoord = { texCoords[texCoord].x, 1.0f - texCoords[texCoord].y };
+
+				if (s_MissingIndex != normal)
+					vertex.Normal = normals[normal];
+
+				vertices[output] = vertex;
+				indices[output] = static_cast<uint32_t>(output);
+			}
+		});
+
+	if (!isValid)
+	{
+		LOG_TAGGED(s_LogTag, "%s: face index out of range", path.string().data());
+
+		vertices.clear();
+		indices.clear();
+
+		return false;
+	}
+
+	const float timeMS = timer.ElapsedMS();
+	const float sizeMB = static_cast<float>(file->GetSize()) / (1024.0f * 1024.0f);
+
+	LOG_TAGGED(s_LogTag, "%s: %.2f MB, %zu chunks in %.2f ms (%.1f MB/s)",
+		path.string().data(), sizeMB, chunks.size(), timeMS, sizeMB / (timeMS * 0.001f));
+
+	return true;
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "Vertex.h"
+
+#include <filesystem>
+#include <vector>
+
+// Memory-maps the file and parses line-aligned chunks of it on the JobSystem, results are merged in file order
+// Handles v/vn/vt/f records, everything else (o, g, usemtl, ...) is skipped
+// Emits one Vertex per face corner with indices 0..N-1 and fan-triangulates polygons, same as the tinyobj based loader did
+bool ParseObj(const std::filesystem::path& path, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
@@ -9,24 +9,129 @@
 #include "Vertex.h"
 #include "Layout.h"
 #include "Framebuffer.h"
+#include "PipelineCache.h"
+#include "Utils.h"
 
+#include "Timer.h"
 #include "Log.h"
 
 #include <volk.h>
 #include <vulkan/vulkan.h>
 
+#include <algorithm>
 #include <array>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+static constexpr const char* s_LogTag = "[Pipeline]";
+
+struct PipelineLibraryEntry
+{
+	// Rest of the key, the description and the shader are compared against the pipeline's own
+	uint64_t RenderPassCompatibilityHash = 0;
+	WeakRef<Pipeline> Instance;
+};
+
+// Identical descriptions share one VkPipeline, entries expire with the last Ref
+// A hash can collide, each one keeps all the entries it was computed for and a hit compares the actual key
+static std::mutex s_LibraryMutex;
+static std::unordered_map<uint64_t, std::vector<PipelineLibraryEntry>> s_PipelineLibrary;
+
+static uint64_t HashPipeline(const PipelineDescription& desc, const Shader& shader)
+{
+	uint64_t hash = shader.GetHash();
+
+	// Same content from other files still makes another pipeline, hot reload follows each description's own files
+	for (const auto& [stage, path] : desc.ShaderModules)
+	{
+		HashCombine(hash, HashBytes(stage));
+		HashCombine(hash, HashString(path.string()));
+	}
+
+	HashCombine(hash, Context::GetSwapchain().GetRenderPass()->GetCompatibilityHash());
+	HashCombine(hash, HashBytes(desc.CompareOp));
+	HashCombine(hash, HashBytes(desc.PolygonMode));
+	HashCombine(hash, HashBytes(desc.LineWidth));
+	HashCombine(hash, HashBytes(desc.CullMode));
+	HashCombine(hash, HashBytes(desc.Topology));
+	HashCombine(hash, HashBytes(desc.EnableTransparency));
+	HashCombine(hash, HashBytes(desc.EnableDynamicStates));
+
+	for (const auto& element : desc.VertexLayout.GetElements())
+	{
+		HashCombine(hash, HashString(element.Name));
+		HashCombine(hash, HashBytes(element.Format));
+		HashCombine(hash, HashBytes(element.Offset));
+	}
+
+	for (const auto& constant : desc.SpecializationConstants.GetConstants())
+	{
+		HashCombine(hash, HashString(constant.Name));
+		HashCombine(hash, HashBytes(constant.Type));
+		HashCombine(hash, HashBytes(constant.Value));
+	}
+
+	return hash;
+}
 
 Ref<Pipeline> Pipeline::Create(const PipelineDescription& desc)
 {
-	return CreateRef<Pipeline>(desc, Shader::Create(desc.ShaderModules));
+	return GetOrCreate(desc, Shader::Create(desc.ShaderModules, desc.DynamicUniformBuffers));
 }
 
 Ref<Pipeline> Pipeline::Create(const PipelineDescription& desc, Ref<Shader> shader)
 {
 	ASSERT(desc.ShaderModules.empty());
 
-	return CreateRef<Pipeline>(desc, shader);
+	return GetOrCreate(desc, shader);
+}
+
+Ref<Pipeline> Pipeline::GetOrCreate(const PipelineDescription& desc, Ref<Shader> shader)
+{
+	ASSERT(shader);
+
+	const uint64_t hash = HashPipeline(desc, *shader);
+	const uint64_t renderPassCompatibilityHash = Context::GetSwapchain().GetRenderPass()->GetCompatibilityHash();
+
+	std::scoped_lock lock(s_LibraryMutex);
+
+	auto& entries = s_PipelineLibrary[hash];
+	std::erase_if(entries, [](const auto& entry) { return entry.Instance.expired(); });
+
+	for (const auto& entry : entries)
+	{
+		auto pipeline = entry.Instance.lock();
+
+		if (pipeline && entry.RenderPassCompatibilityHash == renderPassCompatibilityHash && pipeline->m_Shader == shader && pipeline->m_Description == desc)
+		{
+			LOG_TAGGED(s_LogTag, "Reusing pipeline %llu", static_cast<unsigned long long>(hash));
+			return pipeline;
+		}
+	}
+
+	auto pipeline = CreateRef<Pipeline>(desc, std::move(shader));
+	entries.push_back({ .RenderPassCompatibilityHash = renderPassCompatibilityHash, .Instance = pipeline });
+
+	return pipeline;
+}
+
+std::vector<Ref<Pipeline>> Pipeline::GetPipelines()
+{
+	std::vector<Ref<Pipeline>> pipelines;
+
+	std::scoped_lock lock(s_LibraryMutex);
+
+	for (const auto& [_, entries] : s_PipelineLibrary)
+	{
+		for (const auto& entry : entries)
+		{
+			if (auto pipeline = entry.Instance.lock())
+				pipelines.emplace_back(std::move(pipeline));
+		}
+	}
+
+	return pipelines;
 }
 
 Pipeline::Pipeline(const PipelineDescription& desc, Ref<Shader> shader)
@@ -34,17 +139,23 @@ Pipeline::Pipeline(const PipelineDescription& desc, Ref<Shader> shader)
 	, m_Shader(std::move(shader))
 {
 	CreatePipelineLayout();
-	CreatePipeline();
+
+	Handle::GetHandle<VkPipeline>() = CreatePipeline(*m_Shader);
 }
 
 Pipeline::~Pipeline()
 {
 	m_Shader.reset();
+	m_ReloadedShader.reset();
+	m_PendingShader.reset();
 
 	const auto& device = Context::GetDevice().GetHandle();
 
 	vkDestroyPipelineLayout(device, Handle::GetHandle<VkPipelineLayout>(), nullptr);
 	vkDestroyPipeline(device, Handle::GetHandle<VkPipeline>(), nullptr);
+
+	if (m_PendingPipeline)
+		vkDestroyPipeline(device, m_PendingPipeline, nullptr);
 }
 
 WeakRef<Shader> Pipeline::GetShader() const
@@ -59,6 +170,57 @@ const PipelineDescription& Pipeline::GetDescription() const
 	return m_Description;
 }
 
+bool Pipeline::PrepareReload()
+{
+	ASSERT(!m_PendingPipeline, "The previous reload wasn't applied");
+
+	if (m_Description.ShaderModules.empty())
+		return false;
+
+	auto shader = Shader::Create(m_Description.ShaderModules, m_Description.DynamicUniformBuffers);
+
+	if (!shader)
+		return false;
+
+	// The layout stays, and with it the DescriptorSets made from m_Shader
+	if (shader->GetInterfaceHash() != m_Shader->GetInterfaceHash())
+	{
+		LOG_TAGGED(s_LogTag, "Not reloaded, the resources, push constants or vertex inputs of %s changed, a restart is needed",
+			QUOTED(m_Description.ShaderModules.front().second.string()));
+		return false;
+	}
+
+	const auto specializationConstants = FindSpecializationConstants(*shader);
+
+	if (std::ranges::find(specializationConstants, nullptr) != specializationConstants.end())
+	{
+		LOG_TAGGED(s_LogTag, "Not reloaded, the specialization constants of %s changed", QUOTED(m_Description.ShaderModules.front().second.string()));
+		return false;
+	}
+
+	const auto& current = m_ReloadedShader ? m_ReloadedShader : m_Shader;
+
+	if (shader->GetHash() == current->GetHash())
+		return false;
+
+	m_PendingPipeline = CreatePipeline(*shader);
+	m_PendingShader = std::move(shader);
+
+	return true;
+}
+
+std::pair<VkPipeline, Ref<Shader>> Pipeline::ApplyReload()
+{
+	ASSERT(m_PendingPipeline);
+
+	auto& pipelineHandle = Handle::GetHandle<VkPipeline>();
+
+	VkPipeline previousPipeline = std::exchange(pipelineHandle, std::exchange(m_PendingPipeline, VK_NULL_HANDLE));
+	Ref<Shader> previousShader = std::exchange(m_ReloadedShader, std::move(m_PendingShader));
+
+	return { previousPipeline, std::move(previousShader) };
+}
+
 void Pipeline::CreatePipelineLayout()
 {
 	ASSERT(m_Shader);
@@ -88,31 +250,103 @@ void Pipeline::CreatePipelineLayout()
 	ASSERT(pipelineLayoutHandle, "Pipeline layout creation failed");
 }
 
-void Pipeline::CreatePipeline()
+std::vector<const ShaderSpecializationConstant*> Pipeline::FindSpecializationConstants(const Shader& shader) const
 {
-	ASSERT(m_Shader);
+	const auto& constants = m_Description.SpecializationConstants.GetConstants();
 
+	std::vector<const ShaderSpecializationConstant*> result(constants.size(), nullptr);
+
+	for (size_t i = 0; i < constants.size(); i++)
+	{
+		const auto* reflected = shader.TryGetSpecializationConstant(constants[i].Name);
+
+		if (!reflected)
+			LOG_TAGGED(s_LogTag, "Specialization constant %s missing from the shader", QUOTED(constants[i].Name));
+		else if (reflected->Type != constants[i].Type)
+			LOG_TAGGED(s_LogTag, "Specialization constant %s is a %s in the shader", QUOTED(constants[i].Name), SpecializationConstantTypeString(reflected->Type));
+		else
+			result[i] = reflected;
+	}
+
+	return result;
+}
+
+VkPipeline Pipeline::CreatePipeline(const Shader& shader) const
+{
 	const auto& desc = m_Description;
 
-	const auto& vkDevice = Context::GetDevice().GetHandle();
+	const auto& device = Context::GetDevice();
+	const auto& vkDevice = device.GetHandle();
+	auto& pipelineCache = device.GetPipelineCache();
 	const auto& swapchain = Context::GetSwapchain();
 	const auto& msaaSamples = swapchain.GetRenderPass()->GetDescription().MSAAnumSamples;
-	const auto& swapchainDesc = swapchain.GetDescription();
 	const auto& renderPass = Context::GetSwapchain().GetRenderPass();
 
+	const auto& constants = desc.SpecializationConstants.GetConstants();
+	const auto reflectedConstants = FindSpecializationConstants(shader);
+	const auto shaderModules = shader.GetShaderModules();
+
+	// Values are laid out in the order of the description, each stage maps the ones it declares
+	std::vector<uint32_t> specializationData(constants.size());
+	std::vector<std::vector<VkSpecializationMapEntry>> specializationMapEntries(shaderModules.size());
+	std::vector<VkSpecializationInfo> specializationInfos(shaderModules.size());
+
 	std::vector<VkPipelineShaderStageCreateInfo> pipelineShaderStageCreateInfos;
-	for (const auto& shaderModule : m_Shader->GetShaderModules())
+	for (size_t i = 0; i < shaderModules.size(); i++)
 	{
-		auto module = shaderModule.lock();
+		auto module = shaderModules[i].lock();
 		ASSERT(module);
 
-		pipelineShaderStageCreateInfos.emplace_back(module->GetCreateInfoForPipeline());
+		auto& createInfo = pipelineShaderStageCreateInfos.emplace_back(module->GetCreateInfoForPipeline());
+
+		if (constants.empty())
+			continue;
+
+		auto& mapEntries = specializationMapEntries[i];
+
+		for (uint32_t j = 0; j < static_cast<uint32_t>(constants.size()); j++)
+		{
+			const auto* reflected = reflectedConstants[j];
+
+			specializationData[j] = constants[j].Value;
+
+			if (reflected && (reflected->Stage & createInfo.stage))
+				mapEntries.emplace_back(reflected->ConstantID, j * static_cast<uint32_t>(sizeof(uint32_t)), sizeof(uint32_t));
+		}
+
+		if (mapEntries.empty())
+			continue;
+
+		auto& specializationInfo = specializationInfos[i];
+		specializationInfo.mapEntryCount = static_cast<uint32_t>(mapEntries.size());
+		specializationInfo.pMapEntries = mapEntries.data();
+		specializationInfo.dataSize = specializationData.size() * sizeof(uint32_t);
+		specializationInfo.pData = specializationData.data();
+
+		createInfo.pSpecializationInfo = &specializationInfo;
 	}
 
-	auto stride = m_Shader->GetVertexInputStride();
+	auto stride = shader.GetVertexInputStride();
 	const bool hasStride = stride > 0;
 
-	const auto& attributeDescriptions = m_Shader->GetAttributeDescriptions();
+	auto attributeDescriptions = shader.GetAttributeDescriptions();
+
+	// The reflected formats are what the shader reads, the layout says what's in the buffer (e.g. snorm16 read as float)
+	if (hasStride && !desc.VertexLayout.IsEmpty())
+	{
+		const auto& names = shader.GetVertexInputNames();
+
+		for (size_t i = 0; i < attributeDescriptions.size(); i++)
+		{
+			const auto* element = desc.VertexLayout.TryGetElement(names[i]);
+			ASSERT(element, "Vertex shader input missing from the VertexLayout");
+
+			attributeDescriptions[i].format = Convert(element->Format);
+			attributeDescriptions[i].offset = element->Offset;
+		}
+
+		stride = desc.VertexLayout.GetStride();
+	}
 
 	VkVertexInputBindingDescription bindingDescription = {};
 
@@ -137,36 +371,23 @@ void Pipeline::CreatePipeline()
 	inputAssembly.topology = Convert(desc.Topology);
 	inputAssembly.primitiveRestartEnable = VK_FALSE;
 
-	VkViewport viewport = {};
-	viewport.x = 0.0f;
-	viewport.y = 0.0f;
-	viewport.width = static_cast<float>(swapchainDesc.Width);
-	viewport.height = static_cast<float>(swapchainDesc.Height);
-	viewport.minDepth = 0.0f;
-	viewport.maxDepth = 1.0f;
-
-	VkRect2D scissor = {};
-	scissor.offset = { 0, 0 };
-	scissor.extent = { .width = swapchainDesc.Width, .height = swapchainDesc.Height };
-
+	// Viewport and scissor are set by CommandBuffer::BeginRenderPass(), so the pipeline doesn't depend on the Swapchain size
 	VkPipelineViewportStateCreateInfo viewportState;
 	ZeroInitVkStruct(viewportState, VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO);
 
 	viewportState.viewportCount = 1;
-	viewportState.pViewports = &viewport;
+	viewportState.pViewports = nullptr;
 	viewportState.scissorCount = 1;
-	viewportState.pScissors = &scissor;
+	viewportState.pScissors = nullptr;
 
 	static constexpr std::array s_DynamicStates = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR, VK_DYNAMIC_STATE_LINE_WIDTH };
 
 	VkPipelineDynamicStateCreateInfo dynamicStateInfo;
 	ZeroInitVkStruct(dynamicStateInfo, VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO);
 
-	if (desc.EnableDynamicStates)
-	{
-		dynamicStateInfo.dynamicStateCount = static_cast<uint32_t>(s_DynamicStates.size());
-		dynamicStateInfo.pDynamicStates = s_DynamicStates.data();
-	}
+	// Line width is the last one
+	dynamicStateInfo.dynamicStateCount = static_cast<uint32_t>(desc.EnableDynamicStates ? s_DynamicStates.size() : s_DynamicStates.size() - 1);
+	dynamicStateInfo.pDynamicStates = s_DynamicStates.data();
 
 	VkPipelineRasterizationStateCreateInfo rasterizer;
 	ZeroInitVkStruct(rasterizer, VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO);
@@ -236,9 +457,32 @@ void Pipeline::CreatePipeline()
 	pipelineInfo.renderPass = renderPass->GetHandle();
 	pipelineInfo.subpass = 0;
 
-	auto& pipelineHandle = Handle::GetHandle<VkPipeline>();
+	VkPipelineCreationFeedbackEXT creationFeedback = {};
+
+	VkPipelineCreationFeedbackCreateInfoEXT creationFeedbackInfo;
+	ZeroInitVkStruct(creationFeedbackInfo, VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO_EXT);
+
+	creationFeedbackInfo.pPipelineCreationFeedback = &creationFeedback;
+
+	const bool hasCreationFeedback = device.IsExtensionEnabled(VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME);
+
+	if (hasCreationFeedback)
+		pipelineInfo.pNext = &creationFeedbackInfo;
 
-	VkResult result = vkCreateGraphicsPipelines(vkDevice, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipelineHandle);
+	VkPipeline pipelineHandle = VK_NULL_HANDLE;
+
+	Timer timer;
+
+	VkResult result = vkCreateGraphicsPipelines(vkDevice, pipelineCache.GetHandle(), 1, &pipelineInfo, nullptr, &pipelineHandle);
 	VK_CHECK_RESULT(result);
 	ASSERT(pipelineHandle, "Graphics pipeline creation failed");
+
+	std::optional<bool> isCacheHit;
+
+	if (hasCreationFeedback && (creationFeedback.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT_EXT))
+		isCacheHit = 0 != (creationFeedback.flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT_EXT);
+
+	pipelineCache.Record(isCacheHit, timer.ElapsedMS());
+
+	return pipelineHandle;
 }
@@ -5,41 +5,81 @@
 #include "VK.h"
 
 #include "Enums.h"
+#include "Layout.h"
+#include "SpecializationConstants.h"
 
 #include <vector>
 #include <filesystem>
+#include <string>
+#include <unordered_set>
+#include <utility>
 
 class Shader;
+struct ShaderSpecializationConstant;
 
 struct PipelineDescription
 {
 	std::vector<std::pair<StageFlag, std::filesystem::path>> ShaderModules;
+	// Names of the uniform buffers bound with a dynamic offset (see UniformRingBuffer)
+	// Used only when the Shader is created from ShaderModules
+	std::unordered_set<std::string> DynamicUniformBuffers;
+	// Vertex buffer formats, elements are matched to the vertex shader inputs by name
+	// Empty means the reflected 32-bit inputs, tightly packed (e.g. Vertex)
+	Layout VertexLayout;
+	// Passed to every stage declaring them, each set of values is a separate pipeline
+	SpecializationConstants SpecializationConstants;
 	CompareOp CompareOp = CompareOp::LESS;
 	PolygonMode PolygonMode = PolygonMode::FILL;
 	float LineWidth = 1.0f;
 	CullMode CullMode = CullMode::NONE;
 	PrimitiveTopology Topology = PrimitiveTopology::TRIANGLE_LIST;
 	bool EnableTransparency = false;
+	// Viewport and scissor are always dynamic, this adds the line width
 	bool EnableDynamicStates = false;
+
+	bool operator==(const PipelineDescription&) const = default;
 };
 
 class Pipeline : public Handle<VkPipeline, VkPipelineLayout>
 {
 public:
+	// Returns the existing pipeline when one with an identical description (shader paths included), shader and compatible render pass is alive
 	static Ref<Pipeline> Create(const PipelineDescription& desc);
 	static Ref<Pipeline> Create(const PipelineDescription& desc, Ref<Shader> shader);
 
+	// Every pipeline alive
+	static std::vector<Ref<Pipeline>> GetPipelines();
+
 	Pipeline(const PipelineDescription& desc, Ref<Shader> shader);
 	~Pipeline();
 
+	// The one it was created with, its layouts stay in use after a reload
 	WeakRef<Shader> GetShader() const;
 
 	const PipelineDescription& GetDescription() const;
+
+	// Hot reload (see ShaderReloader), from any thread, not concurrently with itself
+	// Builds a VkPipeline from the current content of ShaderModules, with this pipeline's layout
+	// False if nothing changed, or the shader's interface (see Shader::GetInterfaceHash()) or specialization constants did, the pipeline is left as it is then
+	bool PrepareReload();
+	// Main thread, between frames, swaps in what PrepareReload() built
+	// The replaced VkPipeline and its shader are returned, they have to outlive the frames in flight
+	std::pair<VkPipeline, Ref<Shader>> ApplyReload();
 private:
+	static Ref<Pipeline> GetOrCreate(const PipelineDescription& desc, Ref<Shader> shader);
+
 	void CreatePipelineLayout();
-	void CreatePipeline();
+	// Same order as the description's constants, null (and logged) where the shader doesn't declare one or declares another type
+	std::vector<const ShaderSpecializationConstant*> FindSpecializationConstants(const Shader& shader) const;
+	// Constants FindSpecializationConstants() can't match are left unspecialized
+	VkPipeline CreatePipeline(const Shader& shader) const;
 private:
 	PipelineDescription m_Description;
 
 	Ref<Shader> m_Shader = nullptr;
+	// Whose modules are in the VkPipeline once it was reloaded
+	Ref<Shader> m_ReloadedShader = nullptr;
+
+	Ref<Shader> m_PendingShader = nullptr;
+	VkPipeline m_PendingPipeline = nullptr;
 };
\ No newline at end of file
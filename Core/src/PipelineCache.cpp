@@ -0,0 +1,176 @@
+#include "PipelineCache.h"
+
+#include "Device.h"
+#include "FileStream.h"
+
+#include "Log.h"
+
+#include <volk.h>
+#include <vulkan/vulkan.h>
+
+#include <cstring>
+
+static constexpr const char* s_LogTag = "[PipelineCache]";
+
+PipelineCache::PipelineCache(const Device& device, const std::filesystem::path& path)
+	: m_Device(device), m_Path(path)
+{
+	CreatePipelineCache();
+}
+
+PipelineCache::~PipelineCache()
+{
+	Save();
+	LogStatistics();
+
+	vkDestroyPipelineCache(m_Device.GetHandle(), Handle::GetHandle(), nullptr);
+}
+
+void PipelineCache::Save() const
+{
+	const auto& device = m_Device.GetHandle();
+	const auto& pipelineCache = Handle::GetHandle();
+
+	size_t size = 0;
+	VkResult result = vkGetPipelineCacheData(device, pipelineCache, &size, nullptr);
+	VK_CHECK_RESULT(result);
+
+	if (0 == size)
+		return;
+
+	std::vector<char> data(size);
+	result = vkGetPipelineCacheData(device, pipelineCache, &size, data.data());
+	VK_CHECK_RESULT(result);
+
+	// Written next to the real file and renamed, a crash mid-write won't leave a truncated cache behind
+	auto tempPath = m_Path;
+	tempPath += ".tmp";
+
+	{
+		FileStreamWriter stream(tempPath);
+
+		if (!stream.IsStreamGood())
+		{
+			LOG_TAGGED(s_LogTag, "Failed to open %s", tempPath.string().data());
+			return;
+		}
+
+		stream.Write(data.data(), size);
+	}
+
+	std::error_code error;
+	std::filesystem::rename(tempPath, m_Path, error);
+
+	if (error)
+		LOG_TAGGED(s_LogTag, "Failed to write %s", m_Path.string().data());
+	else
+		LOG_TAGGED(s_LogTag, "Saved %zu bytes to %s", size, m_Path.string().data());
+}
+
+void PipelineCache::Record(std::optional<bool> isHit, float timeMS)
+{
+	std::scoped_lock lock(m_Mutex);
+
+	if (!isHit.has_value())
+	{
+		m_Statistics.Unknown++;
+		m_Statistics.UnknownTime += timeMS;
+	}
+	else if (isHit.value())
+	{
+		m_Statistics.Hits++;
+		m_Statistics.HitTime += timeMS;
+	}
+	else
+	{
+		m_Statistics.Misses++;
+		m_Statistics.MissTime += timeMS;
+	}
+}
+
+PipelineCacheStatistics PipelineCache::GetStatistics() const
+{
+	std::scoped_lock lock(m_Mutex);
+
+	return m_Statistics;
+}
+
+void PipelineCache::LogStatistics() const
+{
+	const auto& stats = GetStatistics();
+
+	LOG_TAGGED(s_LogTag, "%s start, %i pipelines created in %.2f ms",
+		stats.LoadedFromDisk ? "Warm" : "Cold", stats.GetPipelineCount(), stats.GetTotalTime());
+
+	if (stats.Hits > 0 || stats.Misses > 0)
+		LOG_TAGGED(s_LogTag, "Hits: %i (%.2f ms) | Misses: %i (%.2f ms)", stats.Hits, stats.HitTime, stats.Misses, stats.MissTime);
+}
+
+void PipelineCache::CreatePipelineCache()
+{
+	std::vector<char> data;
+
+	if (std::filesystem::exists(m_Path))
+	{
+		FileStreamReader stream(m_Path);
+
+		if (stream.IsStreamGood())
+		{
+			data.resize(stream.GetFileSize());
+			stream.Read(data.data(), data.size());
+		}
+
+		if (!IsCompatible(data))
+		{
+			LOG_TAGGED(s_LogTag, "Discarding incompatible cache %s", m_Path.string().data());
+			data.clear();
+		}
+	}
+
+	VkPipelineCacheCreateInfo createInfo;
+	ZeroInitVkStruct(createInfo, VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO);
+
+	createInfo.initialDataSize = data.size();
+	createInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+	VkResult result = vkCreatePipelineCache(m_Device.GetHandle(), &createInfo, nullptr, &Handle::GetHandle());
+
+	// The driver may still reject the data, start empty instead of failing
+	if (VK_SUCCESS != result && !data.empty())
+	{
+		LOG_TAGGED(s_LogTag, "Driver rejected cache %s", m_Path.string().data());
+
+		data.clear();
+		createInfo.initialDataSize = 0;
+		createInfo.pInitialData = nullptr;
+
+		result = vkCreatePipelineCache(m_Device.GetHandle(), &createInfo, nullptr, &Handle::GetHandle());
+	}
+
+	VK_CHECK_RESULT(result);
+	ASSERT(Handle::GetHandle(), "Pipeline cache creation failed");
+
+	m_Statistics.LoadedFromDisk = !data.empty();
+	m_Statistics.LoadedSize = data.size();
+
+	if (m_Statistics.LoadedFromDisk)
+		LOG_TAGGED(s_LogTag, "Loaded %zu bytes from %s", data.size(), m_Path.string().data());
+}
+
+bool PipelineCache::IsCompatible(const std::vector<char>& data) const
+{
+	VkPipelineCacheHeaderVersionOne header = {};
+
+	if (data.size() < sizeof(header))
+		return false;
+
+	std::memcpy(&header, data.data(), sizeof(header));
+
+	const auto& properties = m_Device.GetPhysicalDevice().GetProperties();
+
+	return header.headerSize >= sizeof(header) &&
+		header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+		header.vendorID == properties.vendorID &&
+		header.deviceID == properties.deviceID &&
+		0 == std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+}
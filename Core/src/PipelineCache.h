@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Base.h"
+
+#include "VK.h"
+
+#include <filesystem>
+#include <optional>
+#include <mutex>
+#include <vector>
+
+class Device;
+
+struct PipelineCacheStatistics
+{
+	// Whether a valid cache from a previous run was found on disk
+	bool LoadedFromDisk = false;
+	size_t LoadedSize = 0;
+
+	uint32_t Hits = 0;
+	uint32_t Misses = 0;
+	// Without creation feedback there's no way to tell if the cache was hit
+	uint32_t Unknown = 0;
+
+	// Accumulated creation time in ms
+	float HitTime = 0.0f;
+	float MissTime = 0.0f;
+	float UnknownTime = 0.0f;
+
+	uint32_t GetPipelineCount() const { return Hits + Misses + Unknown; }
+	float GetTotalTime() const { return HitTime + MissTime + UnknownTime; }
+};
+
+// Loaded from disk on creation and written back on destruction, so pipelines don't get compiled from scratch on every run
+class PipelineCache : public Handle<VkPipelineCache>
+{
+public:
+	PipelineCache(const Device& device, const std::filesystem::path& path);
+	~PipelineCache();
+
+	DELETE_COPY_AND_MOVE(PipelineCache);
+
+	void Save() const;
+
+	// Called after each pipeline creation, isHit is empty when VK_EXT_pipeline_creation_feedback isn't available
+	void Record(std::optional<bool> isHit, float timeMS);
+
+	PipelineCacheStatistics GetStatistics() const;
+	void LogStatistics() const;
+private:
+	void CreatePipelineCache();
+	// Checks the header against the current device, a cache from another GPU or driver is discarded
+	bool IsCompatible(const std::vector<char>& data) const;
+private:
+	const Device& m_Device;
+
+	std::filesystem::path m_Path;
+
+	PipelineCacheStatistics m_Statistics;
+
+	mutable std::mutex m_Mutex;
+};
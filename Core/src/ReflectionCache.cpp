@@ -0,0 +1,665 @@
+#include "ReflectionCache.h"
+
+#include "Buffer.h"
+#include "FileStream.h"
+#include "Timer.h"
+#include "Utils.h"
+
+#include "Log.h"
+
+#include <vulkan/vulkan.h>
+
+#include <spirv_reflect.h>
+
+#include <algorithm>
+#include <cstring>
+#include <span>
+#include <type_traits>
+
+static constexpr const char* s_LogTag = "[ReflectionCache]";
+
+static constexpr uint32_t s_Magic = 0x4C464552; // "REFL"
+// Bump whenever ShaderModuleReflection or its serialization changes
+static constexpr uint32_t s_Version = 2;
+
+struct ReflectionCacheHeader
+{
+	uint32_t Magic = s_Magic;
+	uint32_t Version = s_Version;
+
+	uint32_t EntryCount = 0;
+	uint32_t Padding = 0;
+
+	// Everything past the header
+	uint64_t DataSize = 0;
+	uint64_t DataHash = 0;
+};
+
+static_assert(std::is_trivially_copyable_v<ReflectionCacheHeader>);
+
+static VkDescriptorType Convert(SpvReflectDescriptorType type)
+{
+#define SPV_REFLECT_DESCRIPTOR_TYPE_CASE(X) \
+	case SPV_REFLECT_DESCRIPTOR_TYPE_##X: \
+		return VK_DESCRIPTOR_TYPE_##X
+
+	switch (type)
+	{
+		SPV_REFLECT_DESCRIPTOR_TYPE_CASE(UNIFORM_BUFFER);
+		SPV_REFLECT_DESCRIPTOR_TYPE_CASE(COMBINED_IMAGE_SAMPLER);
+	default:
+		break;
+	}
+
+	ASSERT(false);
+	return VK_DESCRIPTOR_TYPE_MAX_ENUM;
+}
+
+static VkFormat Convert(SpvReflectFormat type)
+{
+#define SPV_REFLECT_FORMAT_CASE(X) \
+	case SPV_REFLECT_FORMAT_##X: \
+		return VK_FORMAT_##X
+
+	switch (type)
+	{
+		// 16-bit inputs need shaderInt16/storageInputOutput16
+		SPV_REFLECT_FORMAT_CASE(R16_UINT);
+		SPV_REFLECT_FORMAT_CASE(R16_SINT);
+		SPV_REFLECT_FORMAT_CASE(R16_SFLOAT);
+		SPV_REFLECT_FORMAT_CASE(R16G16_UINT);
+		SPV_REFLECT_FORMAT_CASE(R16G16_SINT);
+		SPV_REFLECT_FORMAT_CASE(R16G16_SFLOAT);
+		SPV_REFLECT_FORMAT_CASE(R16G16B16_UINT);
+		SPV_REFLECT_FORMAT_CASE(R16G16B16_SINT);
+		SPV_REFLECT_FORMAT_CASE(R16G16B16_SFLOAT);
+		SPV_REFLECT_FORMAT_CASE(R16G16B16A16_UINT);
+		SPV_REFLECT_FORMAT_CASE(R16G16B16A16_SINT);
+		SPV_REFLECT_FORMAT_CASE(R16G16B16A16_SFLOAT);
+		SPV_REFLECT_FORMAT_CASE(R32_UINT);
+		SPV_REFLECT_FORMAT_CASE(R32_SINT);
+		SPV_REFLECT_FORMAT_CASE(R32_SFLOAT);
+		SPV_REFLECT_FORMAT_CASE(R32G32_UINT);
+		SPV_REFLECT_FORMAT_CASE(R32G32_SINT);
+		SPV_REFLECT_FORMAT_CASE(R32G32_SFLOAT);
+		SPV_REFLECT_FORMAT_CASE(R32G32B32_UINT);
+		SPV_REFLECT_FORMAT_CASE(R32G32B32_SINT);
+		SPV_REFLECT_FORMAT_CASE(R32G32B32_SFLOAT);
+		SPV_REFLECT_FORMAT_CASE(R32G32B32A32_UINT);
+		SPV_REFLECT_FORMAT_CASE(R32G32B32A32_SINT);
+		SPV_REFLECT_FORMAT_CASE(R32G32B32A32_SFLOAT);
+	default:
+		break;
+	}
+
+	ASSERT(false);
+	return VK_FORMAT_UNDEFINED;
+}
+
+// Not every SPIRV-Reflect version reports their types and defaults, so they're read straight from the instructions
+static std::vector<ShaderSpecializationConstant> ReflectSpecializationConstants(StageFlag stage, std::span<const uint32_t> spirv)
+{
+	enum Opcode : uint32_t
+	{
+		OpName = 5,
+		OpTypeBool = 20,
+		OpTypeInt = 21,
+		OpTypeFloat = 22,
+		OpSpecConstantTrue = 48,
+		OpSpecConstantFalse = 49,
+		OpSpecConstant = 50,
+		OpDecorate = 71
+	};
+
+	static constexpr uint32_t s_DecorationSpecId = 1;
+	static constexpr size_t s_HeaderWordCount = 5;
+
+	std::unordered_map<uint32_t, std::string> names;
+	std::unordered_map<uint32_t, uint32_t> specIds;
+	std::unordered_map<uint32_t, SpecializationConstantType> types;
+
+	struct Constant
+	{
+		uint32_t ID = 0;
+		SpecializationConstantType Type = SpecializationConstantType::UNDEFINED;
+		uint32_t Value = 0;
+	};
+
+	std::vector<Constant> constants;
+
+	for (size_t i = s_HeaderWordCount; i < spirv.size();)
+	{
+		const uint32_t wordCount = spirv[i] >> 16;
+		const uint32_t opcode = spirv[i] & 0xFFFF;
+
+		if (0 == wordCount || i + wordCount > spirv.size())
+			break;
+
+		const auto operands = spirv.subspan(i + 1, wordCount - 1);
+
+		switch (opcode)
+		{
+		case OpName:
+			if (operands.size() >= 2)
+			{
+				// Null-terminated, padded to a whole word
+				const auto* name = reinterpret_cast<const char*>(&operands[1]);
+				names[operands[0]] = std::string(name, strnlen(name, (operands.size() - 1) * sizeof(uint32_t)));
+			}
+			break;
+		case OpDecorate:
+			if (operands.size() >= 3 && s_DecorationSpecId == operands[1])
+				specIds[operands[0]] = operands[2];
+			break;
+		case OpTypeBool:
+			types[operands[0]] = SpecializationConstantType::BOOL;
+			break;
+		case OpTypeInt:
+			if (32 == operands[1])
+				types[operands[0]] = operands[2] ? SpecializationConstantType::INT : SpecializationConstantType::UINT;
+			break;
+		case OpTypeFloat:
+			if (32 == operands[1])
+				types[operands[0]] = SpecializationConstantType::FLOAT;
+			break;
+		case OpSpecConstantTrue:
+		case OpSpecConstantFalse:
+			constants.push_back({ .ID = operands[1], .Type = SpecializationConstantType::BOOL, .Value = OpSpecConstantTrue == opcode ? 1u : 0u });
+			break;
+		case OpSpecConstant:
+			// 64-bit ones have two value words and no type in the map, they're skipped below
+			if (const auto it = types.find(operands[0]); it != types.end() && 3 == operands.size())
+				constants.push_back({ .ID = operands[1], .Type = it->second, .Value = operands[2] });
+			break;
+		default:
+			break;
+		}
+
+		i += wordCount;
+	}
+
+	std::vector<ShaderSpecializationConstant> result;
+
+	for (const auto& constant : constants)
+	{
+		// Without a SpecId it's only used to build other constants
+		const auto specId = specIds.find(constant.ID);
+		if (specId == specIds.end())
+			continue;
+
+		const auto name = names.find(constant.ID);
+
+		auto& reflected = result.emplace_back();
+		reflected.Name = name != names.end() ? name->second : std::to_string(specId->second);
+		reflected.ConstantID = specId->second;
+		reflected.Type = constant.Type;
+		reflected.DefaultValue = constant.Value;
+		reflected.Stage = Convert(stage);
+	}
+
+	return result;
+}
+
+// Values are stored as they are in memory, the cache isn't meant to move between machines
+class BlobWriter
+{
+public:
+	template<typename T>
+		requires std::is_trivially_copyable_v<T>
+	void Write(const T& value)
+	{
+		const auto* bytes = reinterpret_cast<const char*>(&value);
+		m_Data.insert(m_Data.end(), bytes, bytes + sizeof(T));
+	}
+
+	void Write(const std::string& value)
+	{
+		Write(static_cast<uint32_t>(value.size()));
+		m_Data.insert(m_Data.end(), value.begin(), value.end());
+	}
+
+	const std::vector<char>& GetData() const { return m_Data; }
+private:
+	std::vector<char> m_Data;
+};
+
+// Every read is bounds checked, a truncated or corrupted file fails instead of reading past the end
+class BlobReader
+{
+public:
+	BlobReader(std::span<const char> data)
+		: m_Data(data)
+	{
+	}
+
+	template<typename T>
+		requires std::is_trivially_copyable_v<T>
+	bool Read(T& value)
+	{
+		if (sizeof(T) > GetRemaining())
+			return false;
+
+		std::memcpy(&value, m_Data.data() + m_Offset, sizeof(T));
+		m_Offset += sizeof(T);
+
+		return true;
+	}
+
+	bool Read(std::string& value)
+	{
+		uint32_t size = 0;
+		if (!Read(size) || size > GetRemaining())
+			return false;
+
+		value.assign(m_Data.data() + m_Offset, size);
+		m_Offset += size;
+
+		return true;
+	}
+
+	// Counts are checked against what's left, so a corrupted one can't trigger a huge allocation
+	bool ReadCount(uint32_t& count)
+	{
+		return Read(count) && count <= GetRemaining();
+	}
+
+	size_t GetRemaining() const { return m_Data.size() - m_Offset; }
+private:
+	std::span<const char> m_Data;
+	size_t m_Offset = 0;
+};
+
+static void Serialize(BlobWriter& writer, const ShaderModuleReflection& reflection)
+{
+	writer.Write(static_cast<uint32_t>(reflection.VertexInputs.size()));
+	for (const auto& input : reflection.VertexInputs)
+	{
+		writer.Write(input.Name);
+		writer.Write(input.Location);
+		writer.Write(input.Format);
+	}
+
+	writer.Write(static_cast<uint32_t>(reflection.Resources.size()));
+	for (const auto& resource : reflection.Resources)
+	{
+		writer.Write(resource.Name);
+		writer.Write(resource.Set);
+		writer.Write(resource.Binding);
+		writer.Write(resource.DescriptorCount);
+		writer.Write(resource.Size);
+		writer.Write(resource.Type);
+		writer.Write(resource.Stage);
+
+		writer.Write(static_cast<uint32_t>(resource.BufferInfos.size()));
+		for (const auto& bufferInfo : resource.BufferInfos)
+		{
+			writer.Write(bufferInfo.Name);
+			writer.Write(bufferInfo.Offset);
+			writer.Write(bufferInfo.Range);
+		}
+	}
+
+	writer.Write(static_cast<uint32_t>(reflection.PushConstants.size()));
+	for (const auto& pushConstant : reflection.PushConstants)
+	{
+		writer.Write(pushConstant.Name);
+		writer.Write(pushConstant.Offset);
+		writer.Write(pushConstant.Size);
+		writer.Write(pushConstant.Stage);
+	}
+
+	writer.Write(static_cast<uint32_t>(reflection.SpecializationConstants.size()));
+	for (const auto& constant : reflection.SpecializationConstants)
+	{
+		writer.Write(constant.Name);
+		writer.Write(constant.ConstantID);
+		writer.Write(constant.Type);
+		writer.Write(constant.DefaultValue);
+		writer.Write(constant.Stage);
+	}
+}
+
+static bool Deserialize(BlobReader& reader, ShaderModuleReflection& reflection)
+{
+	uint32_t count = 0;
+
+	if (!reader.ReadCount(count))
+		return false;
+
+	reflection.VertexInputs.resize(count);
+	for (auto& input : reflection.VertexInputs)
+	{
+		if (!reader.Read(input.Name) || !reader.Read(input.Location) || !reader.Read(input.Format))
+			return false;
+	}
+
+	if (!reader.ReadCount(count))
+		return false;
+
+	reflection.Resources.resize(count);
+	for (auto& resource : reflection.Resources)
+	{
+		if (!reader.Read(resource.Name) || !reader.Read(resource.Set) || !reader.Read(resource.Binding) ||
+			!reader.Read(resource.DescriptorCount) || !reader.Read(resource.Size) || !reader.Read(resource.Type) || !reader.Read(resource.Stage))
+			return false;
+
+		if (!reader.ReadCount(count))
+			return false;
+
+		resource.BufferInfos.resize(count);
+		for (auto& bufferInfo : resource.BufferInfos)
+		{
+			if (!reader.Read(bufferInfo.Name) || !reader.Read(bufferInfo.Offset) || !reader.Read(bufferInfo.Range))
+				return false;
+		}
+	}
+
+	if (!reader.ReadCount(count))
+		return false;
+
+	reflection.PushConstants.resize(count);
+	for (auto& pushConstant : reflection.PushConstants)
+	{
+		if (!reader.Read(pushConstant.Name) || !reader.Read(pushConstant.Offset) || !reader.Read(pushConstant.Size) || !reader.Read(pushConstant.Stage))
+			return false;
+	}
+
+	if (!reader.ReadCount(count))
+		return false;
+
+	reflection.SpecializationConstants.resize(count);
+	for (auto& constant : reflection.SpecializationConstants)
+	{
+		if (!reader.Read(constant.Name) || !reader.Read(constant.ConstantID) || !reader.Read(constant.Type) || !reader.Read(constant.DefaultValue) || !reader.Read(constant.Stage))
+			return false;
+	}
+
+	return true;
+}
+
+ReflectionCache::ReflectionCache(const std::filesystem::path& path)
+	: m_Path(path)
+{
+	Load();
+}
+
+ReflectionCache::~ReflectionCache()
+{
+	Save();
+	LogStatistics();
+}
+
+void ReflectionCache::Save() const
+{
+	BlobWriter writer;
+	uint32_t entryCount = 0;
+
+	{
+		std::scoped_lock lock(m_Mutex);
+
+		// Nothing new and nothing to drop, the file on disk is already up to date
+		const bool isUpToDate = 0 == m_Statistics.Misses && m_Statistics.Hits == m_Entries.size();
+		if (isUpToDate || m_Entries.empty())
+			return;
+
+		for (const auto& [hash, entry] : m_Entries)
+		{
+			if (!entry.IsUsed)
+				continue;
+
+			writer.Write(hash);
+			Serialize(writer, *entry.Reflection);
+
+			entryCount++;
+		}
+	}
+
+	const auto& data = writer.GetData();
+
+	ReflectionCacheHeader header;
+	header.EntryCount = entryCount;
+	header.DataSize = data.size();
+	header.DataHash = HashBytes(data.data(), data.size());
+
+	// Written next to the real file and renamed, a crash mid-write won't leave a truncated cache behind
+	auto tempPath = m_Path;
+	tempPath += ".tmp";
+
+	{
+		FileStreamWriter stream(tempPath);
+
+		if (!stream.IsStreamGood())
+		{
+			LOG_TAGGED(s_LogTag, "Failed to open %s", tempPath.string().data());
+			return;
+		}
+
+		stream.Write(header);
+		stream.Write(data.data(), data.size());
+	}
+
+	std::error_code error;
+	std::filesystem::rename(tempPath, m_Path, error);
+
+	if (error)
+		LOG_TAGGED(s_LogTag, "Failed to write %s", m_Path.string().data());
+	else
+		LOG_TAGGED(s_LogTag, "Saved %i modules to %s", entryCount, m_Path.string().data());
+}
+
+Ref<const ShaderModuleReflection> ReflectionCache::GetOrReflect(const ShaderModule& shaderModule)
+{
+	const uint64_t hash = shaderModule.GetHash();
+
+	{
+		std::scoped_lock lock(m_Mutex);
+
+		if (auto it = m_Entries.find(hash); it != m_Entries.end())
+		{
+			// Counted once per module, the same SPIR-V is usually shared anyway
+			if (!it->second.IsUsed)
+			{
+				it->second.IsUsed = true;
+				m_Statistics.Hits++;
+			}
+
+			return it->second.Reflection;
+		}
+	}
+
+	LOG_TAGGED(s_LogTag, "Reflecting: %s", QUOTED(shaderModule.GetPath().filename().string()));
+
+	Timer timer;
+	auto reflection = CreateRef<const ShaderModuleReflection>(Reflect(shaderModule.GetStage(), shaderModule.GetCode()));
+	const float time = timer.ElapsedMS();
+
+	std::scoped_lock lock(m_Mutex);
+
+	// Another thread may have reflected the same module meanwhile, keep the first one
+	auto [it, isInserted] = m_Entries.try_emplace(hash, Entry{ reflection, true });
+
+	if (isInserted)
+	{
+		m_Statistics.Misses++;
+		m_Statistics.ReflectionTime += time;
+	}
+
+	return it->second.Reflection;
+}
+
+ReflectionCacheStatistics ReflectionCache::GetStatistics() const
+{
+	std::scoped_lock lock(m_Mutex);
+
+	return m_Statistics;
+}
+
+void ReflectionCache::LogStatistics() const
+{
+	const auto& stats = GetStatistics();
+
+	LOG_TAGGED(s_LogTag, "%s start, Hits: %i | Misses: %i (%.2f ms)",
+		stats.LoadedFromDisk ? "Warm" : "Cold", stats.Hits, stats.Misses, stats.ReflectionTime);
+}
+
+ShaderModuleReflection ReflectionCache::Reflect(StageFlag stage, const Buffer& code)
+{
+	ShaderModuleReflection reflection;
+
+	SpvReflectShaderModule moduleToReflect;
+
+	auto result = spvReflectCreateShaderModule(code.GetSize(), code.As<const uint32_t*>(), &moduleToReflect);
+	ASSERT(result == SPV_REFLECT_RESULT_SUCCESS, "Failed to reflect shader");
+
+	uint32_t count = 0;
+	if (StageFlag::VERTEX == stage)
+	{
+		result = spvReflectEnumerateInputVariables(&moduleToReflect, &count, nullptr);
+		ASSERT(result == SPV_REFLECT_RESULT_SUCCESS);
+
+		std::vector<SpvReflectInterfaceVariable*> inputVars(count);
+		result = spvReflectEnumerateInputVariables(&moduleToReflect, &count, inputVars.data());
+		ASSERT(result == SPV_REFLECT_RESULT_SUCCESS);
+
+		std::ranges::sort(inputVars, [](const auto first, const auto second)
+			{
+				return first->location < second->location;
+			});
+
+		for (const auto& inputVar : inputVars)
+		{
+			auto& input = reflection.VertexInputs.emplace_back();
+			input.Name = inputVar->name ? inputVar->name : "";
+			input.Location = inputVar->location;
+			input.Format = Convert(inputVar->format);
+		}
+	}
+
+	count = 0;
+	result = spvReflectEnumerateDescriptorSets(&moduleToReflect, &count, nullptr);
+	ASSERT(result == SPV_REFLECT_RESULT_SUCCESS);
+
+	std::vector<SpvReflectDescriptorSet*> reflectedDescriptorSets(count);
+	spvReflectEnumerateDescriptorSets(&moduleToReflect, &count, reflectedDescriptorSets.data());
+
+	for (const auto& reflectedSet : reflectedDescriptorSets)
+	{
+		for (uint32_t i = 0; i < reflectedSet->binding_count; i++)
+		{
+			const SpvReflectDescriptorBinding* reflectedBinding = reflectedSet->bindings[i];
+			const auto reflectedBindingName = reflectedBinding->name;
+
+			auto& resource = reflection.Resources.emplace_back();
+			resource.Name = reflectedBindingName;
+			resource.Set = reflectedSet->set;
+			resource.Binding = reflectedBinding->binding;
+			resource.Type = Convert(reflectedBinding->descriptor_type);
+			resource.DescriptorCount = reflectedBinding->count;
+			resource.Size = reflectedBinding->block.size;
+			resource.Stage = Convert(stage);
+
+			const auto memberCount = reflectedBinding->block.member_count;
+
+			auto& bufferInfos = resource.BufferInfos;
+			bufferInfos.resize(memberCount);
+
+			// e.g layout (binding = 0) uniform UBO { mat4 Model; mat4 View; mat4 Projection; } ubo;
+			// Get the uniforms 'Model', 'View', 'Projection'
+			for (uint32_t j = 0; j < memberCount; j++)
+			{
+				const SpvReflectBlockVariable& member = reflectedBinding->block.members[j];
+
+				bufferInfos[j].Name = std::string(reflectedBindingName) + "." + member.name;
+				bufferInfos[j].Offset = member.offset;
+				bufferInfos[j].Range = member.size;
+			}
+		}
+	}
+
+	count = 0;
+	result = spvReflectEnumeratePushConstantBlocks(&moduleToReflect, &count, nullptr);
+	ASSERT(result == SPV_REFLECT_RESULT_SUCCESS);
+
+	std::vector<SpvReflectBlockVariable*> reflectedPushConstantRanges(count);
+	spvReflectEnumeratePushConstantBlocks(&moduleToReflect, &count, reflectedPushConstantRanges.data());
+
+	for (const auto& reflectedPC : reflectedPushConstantRanges)
+	{
+		for (uint32_t i = 0; i < reflectedPC->member_count; i++)
+		{
+			const auto& member = reflectedPC->members[i];
+
+			auto& pc = reflection.PushConstants.emplace_back();
+			pc.Name = std::string(reflectedPC->name) + "." + member.name;
+			pc.Stage = Convert(stage);
+			pc.Size = member.size;
+			pc.Offset = member.offset;
+		}
+	}
+
+	spvReflectDestroyShaderModule(&moduleToReflect);
+
+	reflection.SpecializationConstants = ReflectSpecializationConstants(stage, std::span(code.As<const uint32_t*>(), code.GetSize() / sizeof(uint32_t)));
+
+	return reflection;
+}
+
+void ReflectionCache::Load()
+{
+	std::error_code error;
+	if (!std::filesystem::exists(m_Path, error))
+		return;
+
+	std::vector<char> data;
+
+	{
+		FileStreamReader stream(m_Path);
+
+		if (!stream.IsStreamGood())
+			return;
+
+		data.resize(stream.GetFileSize());
+		stream.Read(data.data(), data.size());
+	}
+
+	ReflectionCacheHeader header;
+
+	if (data.size() >= sizeof(header))
+		std::memcpy(&header, data.data(), sizeof(header));
+
+	const bool isHeaderValid = data.size() >= sizeof(header) &&
+		header.Magic == s_Magic && header.Version == s_Version &&
+		header.DataSize == data.size() - sizeof(header) &&
+		header.DataHash == HashBytes(data.data() + sizeof(header), header.DataSize);
+
+	if (!isHeaderValid)
+	{
+		LOG_TAGGED(s_LogTag, "Discarding invalid cache %s", m_Path.string().data());
+		return;
+	}
+
+	BlobReader reader(std::span<const char>(data.data() + sizeof(header), header.DataSize));
+
+	std::unordered_map<uint64_t, Entry> entries;
+
+	for (uint32_t i = 0; i < header.EntryCount; i++)
+	{
+		uint64_t hash = 0;
+		ShaderModuleReflection reflection;
+
+		if (!reader.Read(hash) || !Deserialize(reader, reflection))
+		{
+			LOG_TAGGED(s_LogTag, "Discarding invalid cache %s", m_Path.string().data());
+			return;
+		}
+
+		entries.emplace(hash, Entry{ CreateRef<const ShaderModuleReflection>(std::move(reflection)) });
+	}
+
+	m_Entries = std::move(entries);
+
+	m_Statistics.LoadedFromDisk = true;
+	m_Statistics.LoadedCount = header.EntryCount;
+
+	LOG_TAGGED(s_LogTag, "Loaded %i modules from %s", header.EntryCount, m_Path.string().data());
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Base.h"
+
+#include "VK.h"
+
+#include "Enums.h"
+#include "Shader.h"
+
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Buffer;
+
+// What SPIRV-Reflect finds in a single ShaderModule, before the Shader merges its modules
+// Kept raw: uniform buffers aren't made dynamic yet and push constants keep the offsets of their blocks
+struct ShaderModuleReflection
+{
+	struct VertexInput
+	{
+		std::string Name;
+		uint32_t Location = 0;
+		VkFormat Format = (VkFormat)VK_MAX_VALUE_ENUM;
+	};
+
+	// Sorted by location, vertex stage only
+	std::vector<VertexInput> VertexInputs;
+	std::vector<ShaderResource> Resources;
+	std::vector<ShaderPushConstant> PushConstants;
+	// 32-bit scalars with a SpecId, in declaration order
+	std::vector<ShaderSpecializationConstant> SpecializationConstants;
+};
+
+struct ReflectionCacheStatistics
+{
+	// Whether a valid cache from a previous run was found on disk
+	bool LoadedFromDisk = false;
+	uint32_t LoadedCount = 0;
+
+	uint32_t Hits = 0;
+	uint32_t Misses = 0;
+
+	// Accumulated SPIRV-Reflect time in ms
+	float ReflectionTime = 0.0f;
+};
+
+// Reflection of every ShaderModule, keyed by its hash (see ShaderModule::GetHash())
+// Loaded from disk on creation and written back on destruction, on a warm start SPIRV-Reflect doesn't run at all
+// Only the entries used during the run are written back, stale SPIR-V doesn't pile up
+class ReflectionCache
+{
+public:
+	ReflectionCache(const std::filesystem::path& path);
+	~ReflectionCache();
+
+	DELETE_COPY_AND_MOVE(ReflectionCache);
+
+	void Save() const;
+
+	// Thread-safe, reflects the module on a miss
+	Ref<const ShaderModuleReflection> GetOrReflect(const ShaderModule& shaderModule);
+
+	ReflectionCacheStatistics GetStatistics() const;
+	void LogStatistics() const;
+
+	static ShaderModuleReflection Reflect(StageFlag stage, const Buffer& code);
+private:
+	void Load();
+private:
+	struct Entry
+	{
+		Ref<const ShaderModuleReflection> Reflection;
+		bool IsUsed = false;
+	};
+
+	std::filesystem::path m_Path;
+
+	std::unordered_map<uint64_t, Entry> m_Entries;
+
+	ReflectionCacheStatistics m_Statistics;
+
+	mutable std::mutex m_Mutex;
+};
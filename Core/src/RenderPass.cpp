@@ -8,6 +8,7 @@
 #include "Image.h"
 
 #include "Log.h"
+#include "Utils.h"
 
 #include <volk.h>
 #include <vulkan/vulkan.h>
@@ -35,6 +36,11 @@ const RenderPassDescription& RenderPass::GetDescription() const
 	return m_Description;
 }
 
+uint64_t RenderPass::GetCompatibilityHash() const
+{
+	return m_CompatibilityHash;
+}
+
 void RenderPass::CreateRenderPass()
 {
 	ASSERT(m_Description.MSAAnumSamples.has_value());
@@ -139,6 +145,13 @@ void RenderPass::CreateRenderPass()
 		attachmentRefs[2] = { .attachment = 2, .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
 	}
 
+	m_CompatibilityHash = HashBytes(isMultisampled);
+	for (const auto& attachment : attachments)
+	{
+		HashCombine(m_CompatibilityHash, HashBytes(attachment.format));
+		HashCombine(m_CompatibilityHash, HashBytes(attachment.samples));
+	}
+
 	std::array<VkSubpassDescription, 1> subpasses{};
 
 	subpasses[0].pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
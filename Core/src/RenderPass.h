@@ -24,8 +24,12 @@ public:
 	~RenderPass();
 
 	const RenderPassDescription& GetDescription() const;
+	// Equal for render passes with the same attachment formats and sample counts, pipelines can be shared between them
+	uint64_t GetCompatibilityHash() const;
 private:
 	void CreateRenderPass();
 private:
 	RenderPassDescription m_Description;
+
+	uint64_t m_CompatibilityHash = 0;
 };
\ No newline at end of file
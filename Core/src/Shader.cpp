@@ -2,6 +2,8 @@
 
 #include "Context.h"
 #include "Device.h"
+#include "ReflectionCache.h"
+#include "DescriptorSetLayoutCache.h"
 
 #include "Log.h"
 
@@ -12,11 +14,12 @@
 #include <volk.h>
 #include <vulkan/vulkan.h>
 
-#include <spirv_reflect.h>
-
+#include <algorithm>
+#include <cstring>
 #include <utility>
 #include <ranges>
 #include <map>
+#include <mutex>
 
 static constexpr const char* s_LogTag = "[Shader]";
 
@@ -26,43 +29,66 @@ static constexpr const char* s_LogTag = "[Shader]";
 #define REFLECTION_DEBUG_LOG(...) ((void)0)
 #endif
 
-static VkDescriptorType Convert(SpvReflectDescriptorType type)
+static uint64_t HashShaderModule(StageFlag stage, const Buffer& code)
 {
-#define SPV_REFLECT_DESCRIPTOR_TYPE_CASE(X) \
-	case SPV_REFLECT_DESCRIPTOR_TYPE_##X: \
-		return VK_DESCRIPTOR_TYPE_##X
+	uint64_t hash = HashBytes(code.As<const void*>(), static_cast<size_t>(code.GetSize()));
+	HashCombine(hash, HashBytes(stage));
 
-	switch (type)
-	{
-		SPV_REFLECT_DESCRIPTOR_TYPE_CASE(UNIFORM_BUFFER);
-		SPV_REFLECT_DESCRIPTOR_TYPE_CASE(COMBINED_IMAGE_SAMPLER);
-	default:
-		break;
-	}
+	return hash;
+}
+
+static uint64_t HashShader(const std::vector<Ref<ShaderModule>>& shaderModules, const std::unordered_set<std::string>& dynamicUniformBuffers)
+{
+	uint64_t hash = 0;
+
+	for (const auto& shaderModule : shaderModules)
+		HashCombine(hash, shaderModule->GetHash());
+
+	// Order independent, the set isn't ordered
+	uint64_t namesHash = 0;
+	for (const auto& name : dynamicUniformBuffers)
+		namesHash ^= HashString(name);
 
-	ASSERT(false);
-	return VK_DESCRIPTOR_TYPE_MAX_ENUM;
+	HashCombine(hash, namesHash);
+
+	return hash;
 }
 
-static VkFormat Convert(SpvReflectFormat type)
+// Entries expire with the last Ref, so nothing is kept alive past its users
+// A hash can collide, each one keeps all the entries it was computed for and a hit compares the actual key
+static std::mutex s_LibraryMutex;
+static std::unordered_map<uint64_t, std::vector<WeakRef<ShaderModule>>> s_ShaderModuleLibrary;
+static std::unordered_map<uint64_t, std::vector<WeakRef<Shader>>> s_ShaderLibrary;
+
+static bool IsSameCode(const Buffer& lhs, const Buffer& rhs)
 {
-#define SPV_REFLECT_FORMAT_CASE(X) \
-	case SPV_REFLECT_FORMAT_##X: \
-		return VK_FORMAT_##X
+	return lhs.GetSize() == rhs.GetSize() && 0 == std::memcmp(lhs.As<const void*>(), rhs.As<const void*>(), static_cast<size_t>(lhs.GetSize()));
+}
+
+static Ref<ShaderModule> GetOrCreateShaderModule(StageFlag stage, const std::filesystem::path& path, const Buffer& code)
+{
+	const uint64_t hash = HashShaderModule(stage, code);
+
+	std::scoped_lock lock(s_LibraryMutex);
+
+	auto& entries = s_ShaderModuleLibrary[hash];
+	std::erase_if(entries, [](const auto& entry) { return entry.expired(); });
 
-	switch (type)
+	for (const auto& entry : entries)
 	{
-		SPV_REFLECT_FORMAT_CASE(R32_UINT);
-		SPV_REFLECT_FORMAT_CASE(R32_SFLOAT);
-		SPV_REFLECT_FORMAT_CASE(R32G32_SFLOAT);
-		SPV_REFLECT_FORMAT_CASE(R32G32B32_SFLOAT);
-		SPV_REFLECT_FORMAT_CASE(R32G32B32A32_SFLOAT);
-	default:
-		break;
+		auto shaderModule = entry.lock();
+
+		if (shaderModule && stage == shaderModule->GetStage() && IsSameCode(shaderModule->GetCode(), code))
+		{
+			REFLECTION_DEBUG_LOG("Reusing %s for %s", QUOTED(shaderModule->GetPath().string()), QUOTED(path.string()));
+			return shaderModule;
+		}
 	}
 
-	ASSERT(false);
-	return VK_FORMAT_UNDEFINED;
+	auto shaderModule = CreateRef<ShaderModule>(stage, path, code);
+	entries.emplace_back(shaderModule);
+
+	return shaderModule;
 }
 
 Ref<ShaderModule> ShaderModule::Create(StageFlag stage, const std::filesystem::path& path)
@@ -72,7 +98,7 @@ Ref<ShaderModule> ShaderModule::Create(StageFlag stage, const std::filesystem::p
 	if (!ReadFromFile(buffer, path))
 		return nullptr;
 
-	Ref<ShaderModule> shaderModule = CreateRef<ShaderModule>(stage, path, buffer);
+	Ref<ShaderModule> shaderModule = GetOrCreateShaderModule(stage, path, buffer);
 
 	buffer.Release();
 
@@ -83,7 +109,12 @@ Ref<ShaderModule> ShaderModule::Create(StageFlag stage, const Buffer& buffer)
 {
 	const std::string& stringAsPath = std::string(ShaderStageString(stage)) + " " STR(ShaderModule) " created from " STR(Buffer);
 
-	return CreateRef<ShaderModule>(stage, stringAsPath, buffer);
+	return GetOrCreateShaderModule(stage, stringAsPath, buffer);
+}
+
+Ref<ShaderModule> ShaderModule::Create(StageFlag stage, const std::filesystem::path& path, const Buffer& buffer)
+{
+	return GetOrCreateShaderModule(stage, path, buffer);
 }
 
 ShaderModule::ShaderModule(StageFlag stage, const std::filesystem::path& path, const Buffer& buffer)
@@ -91,6 +122,8 @@ ShaderModule::ShaderModule(StageFlag stage, const std::filesystem::path& path, c
 	, m_Stage(stage), m_Path(path), m_Code(new Buffer())
 {
 	*m_Code = Buffer::Copy(buffer);
+	m_Hash = HashShaderModule(m_Stage, *m_Code);
+
 	CreateShaderModule();
 }
 
@@ -132,6 +165,11 @@ const Buffer& ShaderModule::GetCode() const
 	return *m_Code;
 }
 
+uint64_t ShaderModule::GetHash() const
+{
+	return m_Hash;
+}
+
 void ShaderModule::CreateShaderModule()
 {
 	ASSERT(m_Code && *m_Code);
@@ -164,7 +202,7 @@ void ShaderModule::PopulatePipelineShaderStageCreateInfo(StageFlag stage)
 	(*m_PipelineShaderStageCreateInfo).module = Handle::GetHandle();
 }
 
-Ref<Shader> Shader::Create(const std::vector<std::pair<StageFlag, std::filesystem::path>>& shaderModules)
+Ref<Shader> Shader::Create(const std::vector<std::pair<StageFlag, std::filesystem::path>>& shaderModules, const std::unordered_set<std::string>& dynamicUniformBuffers)
 {
 	std::vector<Ref<ShaderModule>> sm(shaderModules.size());
 	for (size_t i = 0; const auto & [stage, path] : shaderModules)
@@ -173,10 +211,10 @@ Ref<Shader> Shader::Create(const std::vector<std::pair<StageFlag, std::filesyste
 	ASSERT(std::ranges::all_of(sm, [](const auto& shaderModule) { return nullptr != shaderModule; }),
 		"Creation of one of the shader modules failed");
 
-	return CreateRef<Shader>(std::move(sm));
+	return GetOrCreate(std::move(sm), dynamicUniformBuffers);
 }
 
-Ref<Shader> Shader::Create(const std::vector<std::pair<StageFlag, Buffer>>& shaderModules)
+Ref<Shader> Shader::Create(const std::vector<std::pair<StageFlag, Buffer>>& shaderModules, const std::unordered_set<std::string>& dynamicUniformBuffers)
 {
 	std::vector<Ref<ShaderModule>> sm(shaderModules.size());
 	for (size_t i = 0; const auto & [stage, buffer] : shaderModules)
@@ -185,13 +223,25 @@ Ref<Shader> Shader::Create(const std::vector<std::pair<StageFlag, Buffer>>& shad
 	ASSERT(std::ranges::all_of(sm, [](const auto& shaderModule) { return nullptr != shaderModule; }),
 		"Creation of one of the shader modules failed");
 
-	return CreateRef<Shader>(std::move(sm));
+	return GetOrCreate(std::move(sm), dynamicUniformBuffers);
 }
 
-Shader::Shader(const std::vector<Ref<ShaderModule>>& shaderModules)
-	: m_ShaderModules(shaderModules)
+Ref<Shader> Shader::Create(std::vector<Ref<ShaderModule>> shaderModules, const std::unordered_set<std::string>& dynamicUniformBuffers)
 {
+	ASSERT(std::ranges::all_of(shaderModules, [](const auto& shaderModule) { return nullptr != shaderModule; }),
+		"One of the shader modules is missing");
+
+	return GetOrCreate(std::move(shaderModules), dynamicUniformBuffers);
+}
+
+Shader::Shader(const std::vector<Ref<ShaderModule>>& shaderModules, const std::unordered_set<std::string>& dynamicUniformBuffers)
+	: m_ShaderModules(shaderModules), m_DynamicUniformBuffers(dynamicUniformBuffers)
+{
+	m_Hash = HashShader(m_ShaderModules, m_DynamicUniformBuffers);
+
 	ReflectShaders();
+	m_InterfaceHash = HashInterface();
+
 	CreateDescriptorSetLayout();
 	CreatePushConstantRanges();
 }
@@ -200,9 +250,6 @@ Shader::~Shader()
 {
 	for (auto& shader : m_ShaderModules)
 		shader.reset();
-
-	for (auto& layout : m_SetLayouts)
-		vkDestroyDescriptorSetLayout(Context::GetDevice().GetHandle(), layout, nullptr);
 }
 
 const std::vector<VkVertexInputAttributeDescription>& Shader::GetAttributeDescriptions() const
@@ -217,6 +264,11 @@ const uint32_t Shader::GetVertexInputStride() const
 	return m_VertexInputStride;
 }
 
+const std::vector<std::string>& Shader::GetVertexInputNames() const
+{
+	return m_VertexInputNames;
+}
+
 const std::vector<WeakRef<ShaderModule>> Shader::GetShaderModules() const
 {
 	std::vector<WeakRef<ShaderModule>> result(m_ShaderModules.size());
@@ -248,6 +300,19 @@ const ShaderResource* Shader::TryGetResource(const std::string& name) const
 	return nullptr;
 }
 
+const ShaderResource* Shader::TryGetResource(uint32_t binding) const
+{
+	for (const auto& [_, resource] : m_ResourcesMap)
+	{
+		if (resource.Binding == binding)
+			return &resource;
+	}
+
+	LOG_TAGGED(s_LogTag, "Resource at binding %i not found", binding);
+
+	return nullptr;
+}
+
 const ShaderPushConstant* Shader::TryGetPushConstant(const std::string& name) const
 {
 	ID id = HashString(name);
@@ -260,164 +325,200 @@ const ShaderPushConstant* Shader::TryGetPushConstant(const std::string& name) co
 	return nullptr;
 }
 
+const ShaderSpecializationConstant* Shader::TryGetSpecializationConstant(const std::string& name) const
+{
+	ID id = HashString(name);
+
+	if (m_SpecializationConstantsMap.contains(id))
+		return &m_SpecializationConstantsMap.at(id);
+
+	LOG_TAGGED(s_LogTag, "Specialization constant %s not found", QUOTED(name));
+
+	return nullptr;
+}
+
+uint64_t Shader::GetHash() const
+{
+	return m_Hash;
+}
+
+uint64_t Shader::GetInterfaceHash() const
+{
+	return m_InterfaceHash;
+}
+
+Ref<Shader> Shader::GetOrCreate(std::vector<Ref<ShaderModule>>&& shaderModules, const std::unordered_set<std::string>& dynamicUniformBuffers)
+{
+	const uint64_t hash = HashShader(shaderModules, dynamicUniformBuffers);
+
+	std::scoped_lock lock(s_LibraryMutex);
+
+	auto& entries = s_ShaderLibrary[hash];
+	std::erase_if(entries, [](const auto& entry) { return entry.expired(); });
+
+	// Modules are shared by content, the same content is the same Ref
+	for (const auto& entry : entries)
+	{
+		auto shader = entry.lock();
+
+		if (shader && shader->m_ShaderModules == shaderModules && shader->m_DynamicUniformBuffers == dynamicUniformBuffers)
+			return shader;
+	}
+
+	auto shader = CreateRef<Shader>(std::move(shaderModules), dynamicUniformBuffers);
+	entries.emplace_back(shader);
+
+	return shader;
+}
+
 void Shader::ReflectShaders()
 {
+	auto& reflectionCache = Context::GetDevice().GetReflectionCache();
+
 	uint32_t offset = 0;
 	for (const auto& shaderModule : m_ShaderModules)
 	{
-		const auto& pathString = shaderModule->GetPath().filename().string();
-		const auto& code = shaderModule->GetCode();
 		const auto shaderStage = shaderModule->GetStage();
+		const auto reflection = reflectionCache.GetOrReflect(*shaderModule);
 
-		LOG_TAGGED(s_LogTag, "Reflecting: %s", QUOTED(pathString));
-
-		SpvReflectShaderModule moduleToReflect;
-
-		auto result = spvReflectCreateShaderModule(code.GetSize(), code.As<const uint32_t*>(), &moduleToReflect);
-		ASSERT(result == SPV_REFLECT_RESULT_SUCCESS, "Failed to reflect shader %s", QUOTED(pathString));
-
-		uint32_t count = 0;
 		if (StageFlag::VERTEX == shaderStage)
 		{
-			result = spvReflectEnumerateInputVariables(&moduleToReflect, &count, nullptr);
-			ASSERT(result == SPV_REFLECT_RESULT_SUCCESS);
-
-			std::vector<SpvReflectInterfaceVariable*> inputVars(count);
-			result = spvReflectEnumerateInputVariables(&moduleToReflect, &count, inputVars.data());
-			ASSERT(result == SPV_REFLECT_RESULT_SUCCESS);
-
-			//std::reverse(inputVars.begin(), inputVars.end());
-			std::ranges::sort(inputVars, [](const auto first, const auto second)
-				{
-					return first->location < second->location;
-				});
-
 			REFLECTION_DEBUG_LOG("Vertex input attributes:");
 
 			m_VertexInputStride = 0;
 
-			for (const auto& inputVar : inputVars)
+			for (const auto& input : reflection->VertexInputs)
 			{
 				VkVertexInputAttributeDescription& attributeDescription = m_VertexInputAttributeDescriptions.emplace_back();
 
-				attributeDescription.location = inputVar->location;
+				attributeDescription.location = input.Location;
 				attributeDescription.binding = 0;
-				attributeDescription.format = Convert(inputVar->format);
+				attributeDescription.format = input.Format;
 				attributeDescription.offset = m_VertexInputStride;
 
-				m_VertexInputStride += GetStrideFromFormat(Convert(inputVar->format));
+				m_VertexInputStride += GetStrideFromFormat(input.Format);
+
+				m_VertexInputNames.emplace_back(input.Name);
 
-				REFLECTION_DEBUG_LOG("\tlocation = %i %s", attributeDescription.location, QUOTED(inputVar->name));
+				REFLECTION_DEBUG_LOG("\tlocation = %i %s", attributeDescription.location, QUOTED(input.Name));
 			}
 		}
 
-		count = 0;
-		result = spvReflectEnumerateDescriptorSets(&moduleToReflect, &count, nullptr);
-		ASSERT(result == SPV_REFLECT_RESULT_SUCCESS);
-
-		std::vector<SpvReflectDescriptorSet*> reflectedDescriptorSets(count);
-		spvReflectEnumerateDescriptorSets(&moduleToReflect, &count, reflectedDescriptorSets.data());
-
-		for (const auto& reflectedSet : reflectedDescriptorSets)
+		for (ShaderResource resource : reflection->Resources)
 		{
-			const uint32_t set = reflectedSet->set;
-
-			ShaderResource resource;
-			for (uint32_t i = 0; i < reflectedSet->binding_count; i++)
-			{
-				const SpvReflectDescriptorBinding* reflectedBinding = reflectedSet->bindings[i];
-				const auto reflectedBindingName = reflectedBinding->name;
-
-				resource.Name = reflectedBindingName;
-				resource.Set = set;
-				resource.Binding = reflectedBinding->binding;
-				resource.Type = Convert(reflectedBinding->descriptor_type);
-				resource.DescriptorCount = reflectedBinding->count;
-				resource.Stage = Convert(shaderStage);
+			// SPIR-V has no notion of dynamic uniform buffers, it's decided when the layout is created
+			if (VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER == resource.Type && m_DynamicUniformBuffers.contains(resource.Name))
+				resource.Type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 
-				const auto memberCount = reflectedBinding->block.member_count;
+			REFLECTION_DEBUG_LOG("Set #%i:\n\t\tBinding #%i: %s %s",
+				resource.Set, resource.Binding, QUOTED(DescriptorTypeString(Convert(resource.Type))), QUOTED(resource.Name));
 
-				auto& bufferInfos = resource.BufferInfos;
-				bufferInfos.resize(memberCount);
+			ID id = HashString(resource.Name);
 
-				// e.g layout (binding = 0) uniform UBO { mat4 Model; mat4 View; mat4 Projection; } ubo;
-				// Get the uniforms 'Model', 'View', 'Projection'
-				// and then would be possible to do DescriptorSet->SetUniform("ubo.Model", &model); ?
-				for (uint32_t j = 0; j < memberCount; j++)
-				{
-					const SpvReflectBlockVariable& member = reflectedBinding->block.members[j];
+			// NOTE: Dangerous things can happen
+			m_ResourcesMap[id] = std::move(resource);
+		}
 
-					const std::string& combinedName = std::string(reflectedBindingName) + "." + member.name;
+		for (ShaderPushConstant pc : reflection->PushConstants)
+		{
+			// Packed one after the other across the stages, the offsets of the blocks aren't used
+			pc.Offset = offset;
+			offset += pc.Size;
 
-					bufferInfos[j].Name = combinedName;
-					bufferInfos[j].Offset = member.offset;
-					bufferInfos[j].Range = member.size;
-				}
+			REFLECTION_DEBUG_LOG("Push Constant:\n\t\t%s %s %i %i",
+				QUOTED(pc.Name), QUOTED(ShaderStageString(shaderStage)), pc.Size, pc.Offset);
 
-				ID id = HashString(resource.Name);
+			ID id = HashString(pc.Name);
 
-				// NOTE: Dangerous things can happen
-				m_ResourcesMap[id] = resource;
+			if (!m_PushConstantsMap.contains(id))
+			{
+				m_PushConstantsMap.emplace(id, std::move(pc));
+			}
+			else
+			{
+				// Not tested
+				m_PushConstantsMap.at(id).Stage |= Convert(shaderStage);
 			}
-
-			REFLECTION_DEBUG_LOG("Set #%i:\n\t\tBinding #%i: %s %s",
-				set, resource.Binding, QUOTED(DescriptorTypeString(Convert(resource.Type))), QUOTED(resource.Name));
-
 		}
 
-		count = 0;
-		result = spvReflectEnumeratePushConstantBlocks(&moduleToReflect, &count, nullptr);
-		ASSERT(result == SPV_REFLECT_RESULT_SUCCESS);
-
-		std::vector<SpvReflectBlockVariable*> reflectedPushConstantRanges(count);
-		spvReflectEnumeratePushConstantBlocks(&moduleToReflect, &count, reflectedPushConstantRanges.data());
-
-		for (const auto& reflectedPC : reflectedPushConstantRanges)
+		for (const auto& constant : reflection->SpecializationConstants)
 		{
-			const auto reflectedPCName = reflectedPC->name;
+			REFLECTION_DEBUG_LOG("Specialization Constant:\n\t\t%s %s %i %s",
+				QUOTED(constant.Name), QUOTED(SpecializationConstantTypeString(constant.Type)), constant.ConstantID, QUOTED(ShaderStageString(shaderStage)));
 
-			// TODO: Maybe ASSERT?
-			if (reflectedPC->size != reflectedPC->padded_size)
-				REFLECTION_DEBUG_LOG("Size missmatch for %s", QUOTED(reflectedPCName));
+			ID id = HashString(constant.Name);
 
-			for (uint32_t i = 0; i < reflectedPC->member_count; i++)
+			// One value per name, set for every stage declaring it
+			if (auto it = m_SpecializationConstantsMap.find(id); it != m_SpecializationConstantsMap.end())
 			{
-				const auto& member = reflectedPC->members[i];
+				const bool isSame = it->second.ConstantID == constant.ConstantID && it->second.Type == constant.Type;
 
-				// TODO: Maybe ASSERT?
-				if (member.size != member.padded_size)
-					REFLECTION_DEBUG_LOG("Size missmatch for %s", QUOTED(member.name));
+				if (!isSame)
+					LOG_TAGGED(s_LogTag, "Specialization constant %s declared differently across stages", QUOTED(constant.Name));
 
-				const std::string& combinedName = std::string(reflectedPCName) + "." + member.name;
+				ASSERT(isSame, "Specialization constant mismatch");
 
-				ShaderPushConstant pc;
-				pc.Name = combinedName;
-				pc.Stage = Convert(shaderStage);
-				pc.Size = member.size;
-				pc.Offset = member.offset;
+				it->second.Stage |= constant.Stage;
+			}
+			else
+			{
+				m_SpecializationConstantsMap.emplace(id, constant);
+			}
+		}
+	}
+}
 
-				pc.Offset = offset;
-				offset += pc.Size;
+uint64_t Shader::HashInterface() const
+{
+	// Order independent, like the maps
+	uint64_t resourcesHash = 0;
+	for (const auto& [id, resource] : m_ResourcesMap)
+	{
+		uint64_t hash = id;
+		HashCombine(hash, HashBytes(resource.Set));
+		HashCombine(hash, HashBytes(resource.Binding));
+		HashCombine(hash, HashBytes(resource.DescriptorCount));
+		HashCombine(hash, HashBytes(resource.Size));
+		HashCombine(hash, HashBytes(resource.Type));
+		HashCombine(hash, HashBytes(resource.Stage));
+
+		resourcesHash ^= hash;
+	}
 
-				ID id = HashString(combinedName);
+	uint64_t pushConstantsHash = 0;
+	for (const auto& [id, pushConstant] : m_PushConstantsMap)
+	{
+		uint64_t hash = id;
+		HashCombine(hash, HashBytes(pushConstant.Offset));
+		HashCombine(hash, HashBytes(pushConstant.Size));
+		HashCombine(hash, HashBytes(pushConstant.Stage));
 
-				if (!m_PushConstantsMap.contains(id))
-				{
-					m_PushConstantsMap.emplace(id, pc);
-				}
-				else
-				{
-					// Not tested
-					m_PushConstantsMap.at(id).Stage |= Convert(shaderStage);
-				}
+		pushConstantsHash ^= hash;
+	}
 
-				REFLECTION_DEBUG_LOG("Push Constant:\n\t\t%s %s %i %i",
-					QUOTED(pc.Name), QUOTED(ShaderStageString(shaderStage)), pc.Size, pc.Offset);
-			}
-		}
+	uint64_t specializationConstantsHash = 0;
+	for (const auto& [id, constant] : m_SpecializationConstantsMap)
+	{
+		uint64_t hash = id;
+		HashCombine(hash, HashBytes(constant.ConstantID));
+		HashCombine(hash, HashBytes(constant.Type));
+		HashCombine(hash, HashBytes(constant.Stage));
+
+		specializationConstantsHash ^= hash;
+	}
 
-		spvReflectDestroyShaderModule(&moduleToReflect);
+	uint64_t hash = resourcesHash;
+	HashCombine(hash, pushConstantsHash);
+	HashCombine(hash, specializationConstantsHash);
+
+	for (size_t i = 0; i < m_VertexInputAttributeDescriptions.size(); i++)
+	{
+		HashCombine(hash, HashString(m_VertexInputNames[i]));
+		HashCombine(hash, HashBytes(m_VertexInputAttributeDescriptions[i].location));
+		HashCombine(hash, HashBytes(m_VertexInputAttributeDescriptions[i].format));
 	}
+
+	return hash;
 }
 
 void Shader::CreateDescriptorSetLayout()
@@ -433,18 +534,8 @@ void Shader::CreateDescriptorSetLayout()
 		i++;
 	}
 
-	VkDescriptorSetLayoutCreateInfo layoutInfo;
-	ZeroInitVkStruct(layoutInfo, VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO);
-
-	layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
-	layoutInfo.pBindings = bindings.data();
-
-	VkDescriptorSetLayout setLayout = {};
-	VkResult result = vkCreateDescriptorSetLayout(Context::GetDevice().GetHandle(), &layoutInfo, nullptr, &setLayout);
-	VK_CHECK_RESULT(result);
-	ASSERT(setLayout, "Desriptor set layout creation failed");
-
-	m_SetLayouts.emplace_back(setLayout);
+	// Owned by the cache, shaders with the same bindings get the same layout
+	m_SetLayouts.emplace_back(Context::GetDevice().GetDescriptorSetLayoutCache().GetOrCreate(bindings));
 }
 
 void Shader::CreatePushConstantRanges()
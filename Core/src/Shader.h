@@ -9,6 +9,8 @@
 #include <filesystem>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 class Buffer;
 
@@ -17,6 +19,8 @@ class ShaderModule : public Handle<VkShaderModule>
 public:
 	static Ref<ShaderModule> Create(StageFlag stage, const std::filesystem::path& path);
 	static Ref<ShaderModule> Create(StageFlag stage, const Buffer& buffer);
+	// SPIR-V compiled at runtime, path only names it in the logs
+	static Ref<ShaderModule> Create(StageFlag stage, const std::filesystem::path& path, const Buffer& buffer);
 
 	ShaderModule(StageFlag stage, const std::filesystem::path& path, const Buffer& buffer);
 	~ShaderModule();
@@ -25,6 +29,8 @@ public:
 	const std::filesystem::path& GetPath() const;
 	const StageFlag GetStage() const;
 	const Buffer& GetCode() const;
+	// Content hash of the SPIR-V and the stage
+	uint64_t GetHash() const;
 private:
 	void CreateShaderModule();
 	void PopulatePipelineShaderStageCreateInfo(StageFlag stage);
@@ -32,6 +38,7 @@ private:
 	std::filesystem::path m_Path;
 	StageFlag m_Stage = StageFlag::UNDEFINED;
 	Buffer* m_Code = nullptr;
+	uint64_t m_Hash = 0;
 
 	VkPipelineShaderStageCreateInfo* m_PipelineShaderStageCreateInfo = nullptr;
 };
@@ -51,6 +58,8 @@ struct ShaderResource
 	uint32_t Set = ~0;
 	uint32_t Binding = ~0;
 	uint32_t DescriptorCount = ~0;
+	// Size of the uniform block, used as the range of dynamic uniform buffers
+	uint32_t Size = 0;
 	VkDescriptorType Type = (VkDescriptorType)VK_MAX_VALUE_ENUM;
 	VkShaderStageFlags Stage = (VkShaderStageFlags)VK_MAX_VALUE_ENUM;
 };
@@ -63,37 +72,71 @@ struct ShaderPushConstant
 	VkShaderStageFlags Stage = (VkShaderStageFlags)VK_MAX_VALUE_ENUM;
 };
 
+struct ShaderSpecializationConstant
+{
+	std::string Name;
+	uint32_t ConstantID = ~0;
+	SpecializationConstantType Type = SpecializationConstantType::UNDEFINED;
+	// Bit pattern of the default from the shader
+	uint32_t DefaultValue = 0;
+	VkShaderStageFlags Stage = (VkShaderStageFlags)VK_MAX_VALUE_ENUM;
+};
+
 class Shader
 {
 	using ID = uint64_t;
 public:
-	static Ref<Shader> Create(const std::vector<std::pair<StageFlag, std::filesystem::path>>& shaderModules);
-	static Ref<Shader> Create(const std::vector<std::pair<StageFlag, Buffer>>& shaderModules);
-
-	Shader(const std::vector<Ref<ShaderModule>>& shaderModules);
+	// Uniform buffers named in dynamicUniformBuffers are reflected as VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC
+	// Shaders and ShaderModules with identical SPIR-V are shared while a Ref to them is alive
+	static Ref<Shader> Create(const std::vector<std::pair<StageFlag, std::filesystem::path>>& shaderModules, const std::unordered_set<std::string>& dynamicUniformBuffers = {});
+	static Ref<Shader> Create(const std::vector<std::pair<StageFlag, Buffer>>& shaderModules, const std::unordered_set<std::string>& dynamicUniformBuffers = {});
+	// e.g. variants from ShaderPermutations
+	static Ref<Shader> Create(std::vector<Ref<ShaderModule>> shaderModules, const std::unordered_set<std::string>& dynamicUniformBuffers = {});
+
+	Shader(const std::vector<Ref<ShaderModule>>& shaderModules, const std::unordered_set<std::string>& dynamicUniformBuffers = {});
 	~Shader();
 
+	// Reflected, tightly packed in location order, PipelineDescription::VertexLayout overrides formats and offsets
 	const std::vector<VkVertexInputAttributeDescription>& GetAttributeDescriptions() const;
 	const uint32_t GetVertexInputStride() const;
+	// Same order as GetAttributeDescriptions()
+	const std::vector<std::string>& GetVertexInputNames() const;
 
 	const std::vector<WeakRef<ShaderModule>> GetShaderModules() const;
 	const std::vector<VkDescriptorSetLayout>& GetLayouts() const;
 	const std::vector<VkPushConstantRange>& GetPushConstants() const;
 
 	const ShaderResource* TryGetResource(const std::string& name) const;
+	const ShaderResource* TryGetResource(uint32_t binding) const;
 	const ShaderPushConstant* TryGetPushConstant(const std::string& name) const;
+	const ShaderSpecializationConstant* TryGetSpecializationConstant(const std::string& name) const;
+
+	// Combined hash of the modules and the dynamic uniform buffers
+	uint64_t GetHash() const;
+	// Hash of the reflected resources, push constants, specialization constants and vertex inputs, not the code
+	// Equal for shaders whose pipeline layouts and DescriptorSets are interchangeable
+	uint64_t GetInterfaceHash() const;
 private:
+	static Ref<Shader> GetOrCreate(std::vector<Ref<ShaderModule>>&& shaderModules, const std::unordered_set<std::string>& dynamicUniformBuffers);
+
 	void ReflectShaders();
+	uint64_t HashInterface() const;
 	void CreateDescriptorSetLayout();
 	void CreatePushConstantRanges();
 private:
 	std::vector<VkVertexInputAttributeDescription> m_VertexInputAttributeDescriptions;
 	uint32_t m_VertexInputStride = 0;
+	std::vector<std::string> m_VertexInputNames;
 
 	std::vector<Ref<ShaderModule>> m_ShaderModules;
+	std::unordered_set<std::string> m_DynamicUniformBuffers;
 	std::vector<VkDescriptorSetLayout> m_SetLayouts;
 	std::vector<VkPushConstantRange> m_Ranges;
 
 	std::unordered_map<ID, ShaderResource> m_ResourcesMap;
 	std::unordered_map<ID, ShaderPushConstant> m_PushConstantsMap;
+	std::unordered_map<ID, ShaderSpecializationConstant> m_SpecializationConstantsMap;
+
+	uint64_t m_Hash = 0;
+	uint64_t m_InterfaceHash = 0;
 };
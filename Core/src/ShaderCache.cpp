@@ -0,0 +1,312 @@
+#include "ShaderCache.h"
+
+#include "ShaderCompiler.h"
+#include "MappedFile.h"
+#include "FileStream.h"
+#include "Utils.h"
+
+#include "Log.h"
+
+#include <algorithm>
+#include <cstring>
+#include <format>
+#include <functional>
+#include <thread>
+
+static constexpr const char* s_LogTag = "[ShaderCache]";
+
+static constexpr uint32_t s_Magic = 0x43565053; // "SPVC"
+static constexpr uint32_t s_RecordMagic = 0x53504544; // "DEPS"
+// Bump whenever the layout or the key changes
+static constexpr uint32_t s_Version = 1;
+static constexpr uint32_t s_SpirVMagic = 0x07230203;
+
+struct ShaderCacheHeader
+{
+	uint32_t Magic = s_Magic;
+	uint32_t Version = s_Version;
+
+	uint64_t Key = 0;
+	uint64_t CompilerHash = 0;
+
+	uint32_t WordCount = 0;
+	float CompileTime = 0.0f;
+};
+
+static_assert(std::is_trivially_copyable_v<ShaderCacheHeader>);
+
+// Followed by IncludeCount entries of: Timestamp | Size | PathLength | path
+struct ShaderRecordHeader
+{
+	uint32_t Magic = s_RecordMagic;
+	uint32_t Version = s_Version;
+
+	uint64_t Key = 0;
+	uint64_t CompilerHash = 0;
+	uint64_t CodeHash = 0;
+
+	uint32_t IncludeCount = 0;
+	uint32_t Padding = 0;
+};
+
+static_assert(std::is_trivially_copyable_v<ShaderRecordHeader>);
+
+static uint64_t HashDefines(const ShaderSource& source)
+{
+	uint64_t hash = HashBytes(source.Stage);
+
+	for (const auto& define : source.Defines)
+	{
+		HashCombine(hash, HashString(define.Name));
+		HashCombine(hash, HashString(define.Value));
+	}
+
+	return hash;
+}
+
+// Unique per thread, concurrent writes of the same entry each get their own file and the last rename wins
+static std::filesystem::path GetTempPath(const std::filesystem::path& path)
+{
+	auto tempPath = path;
+	tempPath += std::format(".{:x}.tmp", std::hash<std::thread::id>()(std::this_thread::get_id()));
+
+	return tempPath;
+}
+
+static bool Replace(const std::filesystem::path& tempPath, const std::filesystem::path& path)
+{
+	std::error_code error;
+	std::filesystem::rename(tempPath, path, error);
+
+	if (error)
+	{
+		LOG_TAGGED(s_LogTag, "Failed to write %s", path.string().data());
+		std::filesystem::remove(tempPath, error);
+
+		return false;
+	}
+
+	return true;
+}
+
+ShaderCache::ShaderCache(const std::filesystem::path& directory, uint64_t compilerHash)
+	: m_Directory(directory), m_CompilerHash(compilerHash)
+{
+	std::error_code error;
+	std::filesystem::create_directories(m_Directory, error);
+
+	if (error)
+		LOG_TAGGED(s_LogTag, "Failed to create %s", m_Directory.string().data());
+}
+
+ShaderCache::~ShaderCache()
+{
+}
+
+const std::filesystem::path& ShaderCache::GetDirectory() const
+{
+	return m_Directory;
+}
+
+uint64_t ShaderCache::ComputeKey(const ShaderSource& source, std::string_view preprocessedCode) const
+{
+	uint64_t key = HashBytes(preprocessedCode.data(), preprocessedCode.size());
+
+	HashCombine(key, HashDefines(source));
+	HashCombine(key, m_CompilerHash);
+	HashCombine(key, s_Version);
+
+	// 0 means no key
+	return key ? key : 1;
+}
+
+uint64_t ShaderCache::FindKey(const ShaderSource& source) const
+{
+	auto file = MappedFile::Create(GetRecordPath(source));
+
+	if (!file || file->GetSize() < sizeof(ShaderRecordHeader))
+		return 0;
+
+	ShaderRecordHeader header;
+	std::memcpy(&header, file->GetData(), sizeof(header));
+
+	if (header.Magic != s_RecordMagic || header.Version != s_Version || header.CompilerHash != m_CompilerHash)
+		return 0;
+
+	if (header.CodeHash != HashBytes(source.Code.data(), source.Code.size()))
+		return 0;
+
+	size_t offset = sizeof(header);
+
+	for (uint32_t i = 0; i < header.IncludeCount; i++)
+	{
+		int64_t timestamp = 0;
+		uint64_t size = 0;
+		uint32_t pathLength = 0;
+
+		if (offset + sizeof(timestamp) + sizeof(size) + sizeof(pathLength) > file->GetSize())
+			return 0;
+
+		std::memcpy(&timestamp, file->GetData() + offset, sizeof(timestamp));
+		offset += sizeof(timestamp);
+		std::memcpy(&size, file->GetData() + offset, sizeof(size));
+		offset += sizeof(size);
+		std::memcpy(&pathLength, file->GetData() + offset, sizeof(pathLength));
+		offset += sizeof(pathLength);
+
+		if (offset + pathLength > file->GetSize())
+			return 0;
+
+		const std::filesystem::path include(std::string(reinterpret_cast<const char*>(file->GetData() + offset), pathLength));
+		offset += pathLength;
+
+		std::error_code error;
+		const uint64_t includeSize = static_cast<uint64_t>(std::filesystem::file_size(include, error));
+
+		if (error || includeSize != size || GetFileTimestamp(include) != timestamp)
+			return 0;
+	}
+
+	return header.Key;
+}
+
+void ShaderCache::StoreKey(const ShaderSource& source, uint64_t key, std::span<const std::filesystem::path> includes)
+{
+	const auto recordPath = GetRecordPath(source);
+	const auto tempPath = GetTempPath(recordPath);
+
+	{
+		FileStreamWriter stream(tempPath);
+
+		if (!stream.IsStreamGood())
+		{
+			LOG_TAGGED(s_LogTag, "Failed to open %s", tempPath.string().data());
+			return;
+		}
+
+		ShaderRecordHeader header;
+		header.Key = key;
+		header.CompilerHash = m_CompilerHash;
+		header.CodeHash = HashBytes(source.Code.data(), source.Code.size());
+		header.IncludeCount = static_cast<uint32_t>(includes.size());
+
+		stream.Write(header);
+
+		for (const auto& include : includes)
+		{
+			std::error_code error;
+			const std::string path = include.string();
+
+			stream.Write(GetFileTimestamp(include));
+			stream.Write(static_cast<uint64_t>(std::filesystem::file_size(include, error)));
+			stream.Write(static_cast<uint32_t>(path.size()));
+			stream.Write(path.data(), path.size());
+		}
+	}
+
+	Replace(tempPath, recordPath);
+}
+
+bool ShaderCache::Load(uint64_t key, CompiledShader& shader) const
+{
+	auto file = MappedFile::Create(GetEntryPath(key));
+
+	if (!file || file->GetSize() < sizeof(ShaderCacheHeader))
+		return false;
+
+	ShaderCacheHeader header;
+	std::memcpy(&header, file->GetData(), sizeof(header));
+
+	if (header.Magic != s_Magic || header.Version != s_Version || header.Key != key || header.CompilerHash != m_CompilerHash)
+		return false;
+
+	if (0 == header.WordCount || sizeof(header) + header.WordCount * sizeof(uint32_t) != file->GetSize())
+	{
+		LOG_TAGGED(s_LogTag, "Discarding invalid entry %s", GetEntryPath(key).string().data());
+		return false;
+	}
+
+	shader.SpirV.resize(header.WordCount);
+	std::memcpy(shader.SpirV.data(), file->GetData() + sizeof(header), header.WordCount * sizeof(uint32_t));
+
+	if (shader.SpirV[0] != s_SpirVMagic)
+	{
+		shader.SpirV.clear();
+		return false;
+	}
+
+	shader.CompileTime = header.CompileTime;
+
+	return true;
+}
+
+bool ShaderCache::Store(uint64_t key, const CompiledShader& shader)
+{
+	ASSERT(shader.IsValid());
+
+	const auto entryPath = GetEntryPath(key);
+	const auto tempPath = GetTempPath(entryPath);
+
+	{
+		FileStreamWriter stream(tempPath);
+
+		if (!stream.IsStreamGood())
+		{
+			LOG_TAGGED(s_LogTag, "Failed to open %s", tempPath.string().data());
+			return false;
+		}
+
+		ShaderCacheHeader header;
+		header.Key = key;
+		header.CompilerHash = m_CompilerHash;
+		header.WordCount = static_cast<uint32_t>(shader.SpirV.size());
+		header.CompileTime = shader.CompileTime;
+
+		stream.Write(header);
+		stream.Write(reinterpret_cast<const char*>(shader.SpirV.data()), shader.SpirV.size() * sizeof(uint32_t));
+	}
+
+	return Replace(tempPath, entryPath);
+}
+
+void ShaderCache::RecordHit(float timeSaved)
+{
+	m_Hits++;
+	m_TimeSaved += static_cast<uint64_t>(std::max(timeSaved, 0.0f) * 1000.0f);
+}
+
+void ShaderCache::RecordMiss()
+{
+	m_Misses++;
+}
+
+ShaderCacheStatistics ShaderCache::GetStatistics() const
+{
+	ShaderCacheStatistics statistics;
+	statistics.Hits = m_Hits;
+	statistics.Misses = m_Misses;
+	statistics.TimeSaved = static_cast<float>(m_TimeSaved) / 1000.0f;
+
+	return statistics;
+}
+
+void ShaderCache::ResetStatistics()
+{
+	m_Hits = 0;
+	m_Misses = 0;
+	m_TimeSaved = 0;
+}
+
+std::filesystem::path ShaderCache::GetEntryPath(uint64_t key) const
+{
+	return m_Directory / std::format("{:016x}.spvcache", key);
+}
+
+std::filesystem::path ShaderCache::GetRecordPath(const ShaderSource& source) const
+{
+	// Sources without a name are told apart by their code
+	uint64_t hash = source.Name.empty() ? HashBytes(source.Code.data(), source.Code.size()) : HashString(source.Name);
+	HashCombine(hash, HashDefines(source));
+
+	return m_Directory / std::format("{:016x}.deps", hash);
+}
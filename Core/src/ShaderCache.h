@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Base.h"
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string_view>
+
+struct ShaderSource;
+struct CompiledShader;
+
+struct ShaderCacheStatistics
+{
+	uint32_t Hits = 0;
+	uint32_t Misses = 0;
+	// Compile time of the hits minus the time spent looking them up, in ms
+	float TimeSaved = 0.0f;
+};
+
+// SPIR-V stored in a directory under a key hashed from the preprocessed source (includes expanded), its defines,
+// the compiler version and the target environment, as <key>.spvcache
+// A <source>.deps record keeps the last key of each source, along with the includes it was built from,
+// so unchanged sources skip the preprocessing too
+// Thread-safe, different sources can be looked up and stored concurrently
+class ShaderCache
+{
+public:
+	// compilerHash covers the compiler version, its target environment and options, entries built with another one are ignored
+	ShaderCache(const std::filesystem::path& directory, uint64_t compilerHash);
+	~ShaderCache();
+
+	DELETE_COPY_AND_MOVE(ShaderCache);
+
+	const std::filesystem::path& GetDirectory() const;
+
+	// Same source, defines, compiler and target gives the same key
+	uint64_t ComputeKey(const ShaderSource& source, std::string_view preprocessedCode) const;
+
+	// Key recorded by StoreKey(), 0 if there's none, the code or any of the includes changed since
+	uint64_t FindKey(const ShaderSource& source) const;
+	void StoreKey(const ShaderSource& source, uint64_t key, std::span<const std::filesystem::path> includes);
+
+	// Fills SpirV and CompileTime, the time it originally took
+	bool Load(uint64_t key, CompiledShader& shader) const;
+	bool Store(uint64_t key, const CompiledShader& shader);
+
+	void RecordHit(float timeSaved);
+	void RecordMiss();
+
+	ShaderCacheStatistics GetStatistics() const;
+	void ResetStatistics();
+private:
+	std::filesystem::path GetEntryPath(uint64_t key) const;
+	std::filesystem::path GetRecordPath(const ShaderSource& source) const;
+private:
+	std::filesystem::path m_Directory;
+	uint64_t m_CompilerHash;
+
+	std::atomic<uint32_t> m_Hits = 0;
+	std::atomic<uint32_t> m_Misses = 0;
+	// In us, summed from every worker
+	std::atomic<uint64_t> m_TimeSaved = 0;
+};
@@ -1,34 +1,38 @@
 #include "ShaderCompiler.h"
+#include "ShaderCache.h"
 
 #include "Log.h"
 
 #include "Buffer.h"
 
+#include "FileStream.h"
+#include "MappedFile.h"
 #include "Utils.h"
 #include "Timer.h"
-#include "Thread.h"
+#include "JobSystem.h"
 
 #include <glslang/SPIRV/GlslangToSpv.h>
 #include <glslang/Public/ShaderLang.h>
 #include <glslang/Include/ResourceLimits.h>
 
+#include <spirv-tools/optimizer.hpp>
+
 #include <algorithm>
-#include <ranges>
-#include <sstream>
+#include <cstring>
+#include <format>
+#include <utility>
 
 static constexpr const char* s_SpvExtention = ".spv";
-static constexpr const char* const s_ShaderExtensions[] = { ".vert", ".frag" };
+static constexpr std::pair<const char*, StageFlag> s_ShaderExtensions[] = {
+	{ ".vert", StageFlag::VERTEX },
+	{ ".frag", StageFlag::FRAGMENT },
+	{ ".geom", StageFlag::GEOMETRY },
+	{ ".tesc", StageFlag::TESSELLATION_CONTROL },
+	{ ".tese", StageFlag::TESSELLATION_EVALUATION },
+	{ ".comp", StageFlag::COMPUTE }
+};
 
 static constexpr const char* s_LogTag = "[Shader Compiler]";
-static constexpr bool s_SuppressOutput = true;
-
-static bool HasVertOrFragExtension(const std::filesystem::path& path)
-{
-	const auto range = std::ranges::subrange(s_ShaderExtensions, s_ShaderExtensions + std::size(s_ShaderExtensions));
-
-	return std::ranges::find_if(range, [&path](const char* extension) { return path.extension() == extension; }) != range.end();
-	//return path.extension() == s_ShaderExtensions[0] || path.extension() == s_ShaderExtensions[1];
-}
 
 // Taken from: https://github.com/KhronosGroup/glslang/issues/2207
 static TBuiltInResource DefaultResources()
@@ -141,208 +145,606 @@ static TBuiltInResource DefaultResources()
 	return Resources;
 }
 
-bool ShaderCompiler::CompileWithValidator(const std::filesystem::path& file, bool suppressOutput)
+static EShLanguage GetLanguage(StageFlag stage)
 {
-	if (file.empty() || !std::filesystem::exists(file) || std::filesystem::is_directory(file))
+	switch (stage)
+	{
+	case StageFlag::VERTEX:
+		return EShLanguage::EShLangVertex;
+	case StageFlag::FRAGMENT:
+		return EShLanguage::EShLangFragment;
+	case StageFlag::GEOMETRY:
+		return EShLanguage::EShLangGeometry;
+	case StageFlag::TESSELLATION_CONTROL:
+		return EShLanguage::EShLangTessControl;
+	case StageFlag::TESSELLATION_EVALUATION:
+		return EShLanguage::EShLangTessEvaluation;
+	case StageFlag::COMPUTE:
+		return EShLanguage::EShLangCompute;
+	default:
+		break;
+	}
+
+	ASSERT(false, "Unknown shader stage");
+	return EShLanguage::EShLangCount;
+}
+
+// Only if its content changed, the timestamp stays put otherwise
+static bool WriteSpirV(const std::filesystem::path& path, const std::vector<uint32_t>& spirv, bool& written)
+{
+	const size_t size = spirv.size() * sizeof(spirv[0]);
+
+	written = false;
+
+	if (auto file = MappedFile::Create(path); file && file->GetSize() == size && 0 == std::memcmp(file->GetData(), spirv.data(), size))
+		return true;
+
+	FileStreamWriter stream(path);
+
+	if (!stream.IsStreamGood())
 		return false;
 
-	auto p = file;
-	const auto& pathString = p.string();
-	std::filesystem::path pathWithSpvExtension = pathString + s_SpvExtention;
+	stream.Write(reinterpret_cast<const char*>(spirv.data()), size);
+	written = true;
 
-	NormalizePath(p);
-	NormalizePath(pathWithSpvExtension);
+	return true;
+}
+
+static bool s_IsInitialized = false;
+static TBuiltInResource s_Resources;
+static Scope<ShaderCache> s_Cache;
+static ShaderOptimization s_Optimization = ShaderOptimization::NONE;
+
+// Resolves #include "..." relative to the including file and #include <...> relative to the source, keeps track of what was included
+class FileIncluder : public glslang::TShader::Includer
+{
+public:
+	FileIncluder(const std::filesystem::path& source)
+		: m_SourceDirectory(source.parent_path())
+	{
+	}
+
+	virtual IncludeResult* includeLocal(const char* headerName, const char* includerName, size_t inclusionDepth) override
+	{
+		return Include(std::filesystem::path(includerName).parent_path() / headerName);
+	}
+
+	virtual IncludeResult* includeSystem(const char* headerName, const char* includerName, size_t inclusionDepth) override
+	{
+		return Include(m_SourceDirectory / headerName);
+	}
+
+	virtual void releaseInclude(IncludeResult* result) override
+	{
+		if (result)
+		{
+			delete static_cast<std::string*>(result->userData);
+			delete result;
+		}
+	}
 
-	std::stringstream cmd;
+	std::vector<std::filesystem::path> TakeIncludes()
+	{
+		return std::move(m_Includes);
+	}
+private:
+	IncludeResult* Include(std::filesystem::path path)
+	{
+		NormalizePath(path);
 
-	// TODO: Workaround, find a better way dealing with this
-	std::filesystem::path validatorPath("../");
-	validatorPath /= GLSLANG_VALIDATOR_EXECUTABLE_RELATIVE_PATH;
+		Buffer buffer;
 
-	NormalizePath(validatorPath);
+		// glslang reports the missing header
+		if (!ReadFromFile(buffer, path))
+			return nullptr;
 
-	cmd << validatorPath.string();
+		auto* content = new std::string(buffer.As<const char*>(), buffer.GetSize());
+		buffer.Release();
 
-#ifdef _WIN32
-	cmd << "\\glslangValidator.exe -o ";
-#else
-	cmd << "/glslangValidator -o ";
-#endif
-	cmd << std::quoted(pathWithSpvExtension.string()) << " -V " << std::quoted(p.string());
+		if (std::ranges::find(m_Includes, path) == m_Includes.end())
+			m_Includes.push_back(path);
 
-	// Suppress system() output
-	if (suppressOutput)
+		return new IncludeResult(path.string(), content->data(), content->size(), content);
+	}
+private:
+	std::filesystem::path m_SourceDirectory;
+	std::vector<std::filesystem::path> m_Includes;
+};
+
+static constexpr auto s_TargetVulkanVersion = glslang::EShTargetVulkan_1_2;
+static constexpr auto s_TargetSpirVVersion = glslang::EShTargetSpv_1_5;
+static constexpr auto s_Messages = EShMessages(EShMessages::EShMsgSpvRules | EShMessages::EShMsgVulkanRules);
+static constexpr int s_DefaultVersion = 450;
+static constexpr auto s_TargetEnvironment = SPV_ENV_VULKAN_1_2;
+
+static constexpr size_t s_SpirVHeaderWordCount = 5;
+
+// Source text, file names and line info, the names reflection relies on (OpName, OpMemberName) are kept
+static constexpr uint32_t s_DebugSourceOpcodes[] = {
+	2, // OpSourceContinued
+	3, // OpSource
+	4, // OpSourceExtension
+	7, // OpString
+	8, // OpLine
+	317, // OpNoLine
+	330 // OpModuleProcessed
+};
+
+// glslang keeps pointers to these until the shader is parsed
+struct ShaderInput
+{
+	ShaderInput(const ShaderSource& source)
+		: Code(source.Code.data()), Length(static_cast<int>(source.Code.size())), Name(source.Name.data())
 	{
-#ifdef _WIN32
-		cmd << " > nul";
-#else
-		cmd << " > /dev/null";
-#endif
+		Preamble = "#extension GL_GOOGLE_include_directive : enable\n";
+
+		for (const auto& define : source.Defines)
+			Preamble += std::format("#define {} {}\n", define.Name, define.Value);
 	}
 
-	int executed = system(cmd.str().data());
+	std::string Preamble;
+
+	// Not necessarily null-terminated
+	const char* Code;
+	int Length;
+	const char* Name;
+};
+
+static void SetInput(glslang::TShader& shader, EShLanguage stage, const ShaderInput& input)
+{
+	shader.setEnvInput(glslang::EShSourceGlsl, stage, glslang::EShClientVulkan, s_TargetVulkanVersion);
+	shader.setEnvClient(glslang::EShClientVulkan, s_TargetVulkanVersion);
+	shader.setEnvTarget(glslang::EshTargetSpv, s_TargetSpirVVersion);
 
-	return (0 < executed) ? true : false;
+	shader.setPreamble(input.Preamble.data());
+	shader.setStringsWithLengthsAndNames(&input.Code, &input.Length, &input.Name, 1);
 }
 
-bool ShaderCompiler::CompileWithValidator(const std::filesystem::path& shaderDirectory)
+// Every option that changes the generated SPIR-V
+static uint64_t GetCompilerHash(ShaderOptimization optimization)
 {
-	if (shaderDirectory.empty() || !std::filesystem::exists(shaderDirectory) || !std::filesystem::is_directory(shaderDirectory))
+	const auto version = glslang::GetVersion();
+
+	uint64_t hash = HashBytes(version.major);
+	HashCombine(hash, HashBytes(version.minor));
+	HashCombine(hash, HashBytes(version.patch));
+	HashCombine(hash, HashString(version.flavor));
+	HashCombine(hash, HashBytes(s_TargetVulkanVersion));
+	HashCombine(hash, HashBytes(s_TargetSpirVVersion));
+	HashCombine(hash, HashBytes(s_Messages));
+	HashCombine(hash, HashBytes(s_DefaultVersion));
+	HashCombine(hash, HashBytes(optimization));
+
+	return hash;
+}
+
+// Expands includes and macros, the result is what the cache key is hashed from
+static bool Preprocess(const ShaderSource& source, std::string& output, std::vector<std::filesystem::path>& includes, std::string& log)
+{
+	const auto stage = GetLanguage(source.Stage);
+	const ShaderInput input(source);
+
+	glslang::TShader shader(stage);
+	SetInput(shader, stage, input);
+
+	FileIncluder includer(source.Name);
+
+	if (!shader.preprocess(&s_Resources, s_DefaultVersion, ENoProfile, false, false, s_Messages, &output, includer))
+	{
+		log = shader.getInfoLog();
 		return false;
+	}
+
+	includes = includer.TakeIncludes();
 
-	uint32_t totalShadersCount = 0;
-	std::vector<std::filesystem::path> paths;
-	for (const auto& entry : std::filesystem::directory_iterator(shaderDirectory))
+	return true;
+}
+
+static void StripDebugSource(std::vector<uint32_t>& spirv)
+{
+	if (spirv.size() <= s_SpirVHeaderWordCount)
+		return;
+
+	size_t dst = s_SpirVHeaderWordCount;
+
+	for (size_t src = s_SpirVHeaderWordCount; src < spirv.size();)
 	{
-		if (entry.is_regular_file())
-		{
-			std::filesystem::path p;
-			if (HasVertOrFragExtension(entry.path()))
-			{
-				totalShadersCount++;
+		const uint32_t wordCount = spirv[src] >> 16;
+		const uint32_t opcode = spirv[src] & 0xFFFF;
 
-				p = entry.path();
-				p += s_SpvExtention;
-			}
+		if (0 == wordCount || src + wordCount > spirv.size())
+			return;
 
-			if (!p.empty() && !std::filesystem::exists(p))
-				paths.emplace_back(entry.path());
+		if (std::ranges::find(s_DebugSourceOpcodes, opcode) == std::end(s_DebugSourceOpcodes))
+		{
+			std::copy_n(spirv.begin() + src, wordCount, spirv.begin() + dst);
+			dst += wordCount;
 		}
+
+		src += wordCount;
 	}
 
+	spirv.resize(dst);
+}
+
+// The module is left untouched if any pass fails
+static bool Optimize(std::vector<uint32_t>& spirv, ShaderOptimization optimization, std::string& log)
+{
+	spvtools::Optimizer optimizer(s_TargetEnvironment);
+
+	optimizer.SetMessageConsumer([&log](spv_message_level_t level, const char*, const spv_position_t&, const char* message)
+		{
+			if (level <= SPV_MSG_WARNING)
+				log += std::format("spirv-opt: {}\n", message);
+		});
+
+	// Interface variables are kept, the vertex layout is reflected from the inputs
+	if (ShaderOptimization::SIZE == optimization)
+		optimizer.RegisterSizePasses(true);
+	else
+		optimizer.RegisterPerformancePasses(true);
+
+	optimizer.RegisterPass(spvtools::CreateStripNonSemanticInfoPass());
+
+	// Unused bindings stay in the descriptor set layouts, spec constants stay settable
+	spvtools::OptimizerOptions options;
+	options.set_preserve_bindings(true);
+	options.set_preserve_spec_constants(true);
+
+	std::vector<uint32_t> optimized;
+
+	if (!optimizer.Run(spirv.data(), spirv.size(), &optimized, options))
+		return false;
+
+	StripDebugSource(optimized);
+	spirv = std::move(optimized);
+
+	return true;
+}
+
+static CompiledShader CompileSource(const ShaderSource& source)
+{
+	CompiledShader result;
+
+	const auto stage = GetLanguage(source.Stage);
+	const ShaderInput input(source);
+
+	glslang::TShader shader(stage);
+	SetInput(shader, stage, input);
+
+	FileIncluder includer(source.Name);
+
+	if (!shader.parse(&s_Resources, s_DefaultVersion, false, s_Messages, includer))
+	{
+		result.Log = shader.getInfoLog();
+		return result;
+	}
+
+	glslang::TProgram program;
+	program.addShader(&shader);
+
+	if (!program.link(s_Messages))
+	{
+		result.Log = program.getInfoLog();
+		return result;
+	}
+
+	glslang::SpvOptions options = { .validate = true };
+	spv::SpvBuildLogger logger;
+
+	glslang::GlslangToSpv(*program.getIntermediate(stage), result.SpirV, &logger, &options);
+
+	result.Log = logger.getAllMessages();
+
+	if (ShaderOptimization::NONE == s_Optimization || result.SpirV.empty())
+		return result;
+
+	result.Unoptimized = ShaderCompiler::GetStatistics(result.SpirV);
+
+	if (Optimize(result.SpirV, s_Optimization, result.Log))
+		result.Optimized = ShaderCompiler::GetStatistics(result.SpirV);
+	else
+		result.Unoptimized = {};
+
+	return result;
+}
+
+void ShaderCompiler::Init(const std::filesystem::path& cacheDirectory, ShaderOptimization optimization)
+{
+	ASSERT(!s_IsInitialized);
+
+	glslang::InitializeProcess();
+
+	s_Resources = DefaultResources();
+	s_Optimization = optimization;
+
+	if (!cacheDirectory.empty())
+		s_Cache = CreateScope<ShaderCache>(cacheDirectory, GetCompilerHash(optimization));
+
+	s_IsInitialized = true;
+}
+
+void ShaderCompiler::Shutdown()
+{
+	ASSERT(s_IsInitialized);
+
+	s_Cache.reset();
+
+	glslang::FinalizeProcess();
+
+	s_IsInitialized = false;
+}
+
+bool ShaderCompiler::IsInitialized()
+{
+	return s_IsInitialized;
+}
+
+ShaderCache* ShaderCompiler::GetCache()
+{
+	return s_Cache.get();
+}
+
+ShaderOptimization ShaderCompiler::GetOptimization()
+{
+	return s_Optimization;
+}
+
+CompiledShader ShaderCompiler::Compile(const ShaderSource& source)
+{
+	ASSERT(s_IsInitialized);
+
 	Timer timer;
 
-	std::vector<Thread> threads(paths.size());
+	if (!s_Cache)
+	{
+		auto result = CompileSource(source);
+		result.CompileTime = timer.ElapsedMS();
 
-	for (size_t i = 0; const auto & path : paths)
+		return result;
+	}
+
+	CompiledShader result;
+
+	// Neither the code nor its includes changed, nothing to preprocess
+	if (const uint64_t key = s_Cache->FindKey(source); key && s_Cache->Load(key, result))
 	{
-#define WITH_MT 1
-#if WITH_MT
-		auto& thread = threads[i++];
+		result.Cached = true;
+		s_Cache->RecordHit(result.CompileTime - timer.ElapsedMS());
+		result.CompileTime = timer.ElapsedMS();
 
-		thread.Start();
+		return result;
+	}
 
-		thread.Submit([&path]()
-			{
-				CompileWithValidator(path, s_SuppressOutput);
-			});
-#else
-		CompileWithValidator(path, s_SuppressOutput);
-#endif
+	std::string preprocessed;
+	std::vector<std::filesystem::path> includes;
+
+	if (!Preprocess(source, preprocessed, includes, result.Log))
+	{
+		s_Cache->RecordMiss();
+		result.CompileTime = timer.ElapsedMS();
+
+		return result;
 	}
 
-	std::ranges::for_each(threads, [](auto& thread) { thread.Stop(); });
+	const uint64_t key = s_Cache->ComputeKey(source, preprocessed);
 
-	bool success = true;
-	uint32_t shadersCompiledCount = 0;
-	for (const auto& path : paths)
+	// Only an include's timestamp, a comment or the formatting changed, or it was compiled before from another source
+	if (s_Cache->Load(key, result))
 	{
-		const auto& pathString = path.string();
-		std::filesystem::path pathWithSpvExtension = pathString + s_SpvExtention;
-		NormalizePath(pathWithSpvExtension);
+		s_Cache->StoreKey(source, key, includes);
 
-		if (/*executed*/std::filesystem::exists(pathWithSpvExtension))
-		{
-			LOG_TAGGED(s_LogTag, "Compiled: %s", QUOTED(pathString));
-			shadersCompiledCount++;
-		}
-		else
-		{
-			LOG_TAGGED(s_LogTag, "Failed to compile shader %s", QUOTED(pathString));
-			success &= false;
-		}
+		result.Cached = true;
+		s_Cache->RecordHit(result.CompileTime - timer.ElapsedMS());
+		result.CompileTime = timer.ElapsedMS();
+
+		return result;
 	}
 
-	LOG_TAGGED(s_LogTag, "Total shaders: %i. Files to compile %i, successfully %i. Total compilation time: %.2f ms",
-		totalShadersCount, paths.size(), shadersCompiledCount, timer.ElapsedMS());
+	s_Cache->RecordMiss();
 
-	return success;
+	result = CompileSource(source);
+	result.CompileTime = timer.ElapsedMS();
+
+	if (result.IsValid() && s_Cache->Store(key, result))
+		s_Cache->StoreKey(source, key, includes);
+
+	return result;
+}
+
+static void LogOptimization(const std::string& name, const CompiledShader& result)
+{
+	const auto& before = result.Unoptimized;
+	const auto& after = result.Optimized;
+
+	LOG_TAGGED(s_LogTag, "Optimized: %s words %u -> %u (%.1f%%), instructions %u -> %u (%.1f%%)", QUOTED(name),
+		before.WordCount, after.WordCount, 100.0f * after.WordCount / before.WordCount,
+		before.InstructionCount, after.InstructionCount, 100.0f * after.InstructionCount / before.InstructionCount);
+}
+
+CompiledShader ShaderCompiler::Compile(StageFlag stage, std::string_view code, std::string_view name)
+{
+	return Compile({ .Stage = stage, .Name = std::string(name), .Code = std::string(code) });
+}
+
+std::vector<CompiledShader> ShaderCompiler::CompileBatch(std::span<const ShaderSource> sources)
+{
+	std::vector<CompiledShader> results(sources.size());
+
+	// One shader per job, compilation times vary a lot between shaders
+	JobSystem::ParallelFor(static_cast<uint32_t>(sources.size()), 1, [&sources, &results](uint32_t i)
+		{
+			results[i] = Compile(sources[i]);
+		});
+
+	return results;
 }
 
 bool ShaderCompiler::Compile(Buffer& buffer, StageFlag stage, const std::string_view code)
 {
-	glslang::InitializeProcess();
+	const auto result = Compile(stage, code, ShaderStageString(stage));
+
+	if (!result.Log.empty())
+		LOG_TAGGED(s_LogTag, "%s shader: %s", ShaderStageString(stage), result.Log.data());
+
+	LOG_TAGGED(s_LogTag, "%s shader compiled in %.2f ms", ShaderStageString(stage), result.CompileTime);
+
+	if (result.IsOptimized())
+		LogOptimization(ShaderStageString(stage), result);
+
+	if (!result.IsValid())
+	{
+		LOG_TAGGED(s_LogTag, "Failed to generate SPIR-V");
+		return false;
+	}
+
+	buffer = Buffer::Copy(result.SpirV.data(), result.SpirV.size() * sizeof(result.SpirV[0]));
+
+	return true;
+}
 
+bool ShaderCompiler::CompileDirectory(const std::filesystem::path& shaderDirectory)
+{
+	if (shaderDirectory.empty() || !std::filesystem::exists(shaderDirectory) || !std::filesystem::is_directory(shaderDirectory))
+		return false;
+
+	return CompileFiles(GetSources(shaderDirectory));
+}
+
+bool ShaderCompiler::CompileFiles(std::span<const std::filesystem::path> files, std::vector<std::filesystem::path>* writtenFiles)
+{
 	Timer timer;
 
+	std::vector<ShaderSource> sources;
+	sources.reserve(files.size());
+
 	bool success = true;
 
-	auto Convert = [](StageFlag stage)
+	for (const auto& file : files)
+	{
+		const StageFlag stage = GetStage(file);
+		ASSERT(StageFlag::UNDEFINED != stage);
+
+		Buffer code;
+
+		// Counted as failed in the totals below, ReadFromFile() logs why
+		if (!ReadFromFile(code, file))
 		{
-			switch (stage)
-			{
-			case StageFlag::VERTEX:
-				return EShLanguage::EShLangVertex;
-			case StageFlag::FRAGMENT:
-				return EShLanguage::EShLangFragment;
-			default:
-				break;
-			}
+			success = false;
+			continue;
+		}
 
-			ASSERT(false, "Unknown shader stage");
-			return EShLanguage::EShLangCount;
-		};
+		sources.push_back({ .Stage = stage, .Name = file.string(), .Code = std::string(code.As<const char*>(), code.GetSize()) });
 
-	const auto shaderStage = Convert(stage);
-	const auto targetVulkanVersion = glslang::EShTargetVulkan_1_2;
+		code.Release();
+	}
 
-	glslang::TShader shader(shaderStage);
+	const auto results = CompileBatch(sources);
 
-	shader.setEnvInput(glslang::EShSourceGlsl, shaderStage, glslang::EShClientVulkan, targetVulkanVersion);
-	shader.setEnvClient(glslang::EShClientVulkan, targetVulkanVersion);
-	shader.setEnvTarget(glslang::EshTargetSpv, glslang::EShTargetSpv_1_5);
+	uint32_t shadersCompiledCount = 0;
+	uint32_t shadersCachedCount = 0;
 
-	const char* ptr = code.data();
-	shader.setStrings(&ptr, 1);
+	for (size_t i = 0; i < sources.size(); i++)
+	{
+		const auto& source = sources[i];
+		const auto& result = results[i];
 
-	TBuiltInResource defaultResource = {};
+		if (!result.Log.empty())
+			LOG_TAGGED(s_LogTag, "%s: %s", QUOTED(source.Name), result.Log.data());
 
-	// https://stackoverflow.com/questions/64549729/getting-location-too-large-for-fragment-output-error-while-using-glslang
-	defaultResource.maxDrawBuffers = true;
+		const auto spvPath = GetSpvPath(source.Name);
+		bool written = false;
 
-	EShMessages messages = EShMessages::EShMsgDefault;
-	bool result = shader.parse(&defaultResource, 450, false, messages);
-	if (!result)
-	{
-		LOG_TAGGED(s_LogTag, "Parse failed: %s", QUOTED(shader.getInfoLog()));
-		success &= false;
+		if (result.IsValid() && WriteSpirV(spvPath, result.SpirV, written))
+		{
+			if (written && writtenFiles)
+				writtenFiles->push_back(spvPath);
+
+			if (result.Cached)
+			{
+				shadersCachedCount++;
+			}
+			else
+			{
+				LOG_TAGGED(s_LogTag, "Compiled: %s in %.2f ms", QUOTED(source.Name), result.CompileTime);
+				shadersCompiledCount++;
+
+				if (result.IsOptimized())
+					LogOptimization(source.Name, result);
+			}
+		}
+		else
+		{
+			LOG_TAGGED(s_LogTag, "Failed to compile shader %s", QUOTED(source.Name));
+			success = false;
+		}
 	}
 
-	glslang::TProgram program;
-	program.addShader(&shader);
+	LOG_TAGGED(s_LogTag, "Total shaders: %i. Compiled %i, up to date %i, failed %i. Total compilation time: %.2f ms",
+		static_cast<uint32_t>(files.size()), shadersCompiledCount, shadersCachedCount,
+		static_cast<uint32_t>(files.size()) - shadersCompiledCount - shadersCachedCount, timer.ElapsedMS());
 
-	messages = EShMessages(EShMessages::EShMsgSpvRules | EShMessages::EShMsgVulkanRules);
-	result = program.link(messages);
-	if (!result)
+	if (s_Cache)
 	{
-		LOG_TAGGED(s_LogTag, "Link failed: %s", QUOTED(program.getInfoLog()));
-		success &= false;
+		const auto statistics = s_Cache->GetStatistics();
+
+		LOG_TAGGED(s_LogTag, "Cache hits: %i, misses: %i, time saved: %.2f ms", statistics.Hits, statistics.Misses, statistics.TimeSaved);
 	}
 
-	glslang::SpvOptions options = { .validate = true };
-	spv::SpvBuildLogger logger;
+	return success;
+}
 
-	std::vector<uint32_t> spirv;
-	glslang::GlslangToSpv(*program.getIntermediate(shader.getStage()), spirv, &logger, &options);
+std::vector<std::filesystem::path> ShaderCompiler::GetSources(const std::filesystem::path& shaderDirectory)
+{
+	std::vector<std::filesystem::path> sources;
+
+	std::error_code error;
 
-	if (!logger.getAllMessages().empty())
+	for (const auto& entry : std::filesystem::directory_iterator(shaderDirectory, error))
 	{
-		LOG_TAGGED(s_LogTag, "%s", QUOTED(logger.getAllMessages()));
+		if (entry.is_regular_file() && StageFlag::UNDEFINED != GetStage(entry.path()))
+			sources.push_back(entry.path());
 	}
 
-	LOG_TAGGED(s_LogTag, "Total compilation time: %.2f ms", timer.ElapsedMS());
+	return sources;
+}
+
+std::filesystem::path ShaderCompiler::GetSpvPath(const std::filesystem::path& source)
+{
+	std::filesystem::path spvPath = source.string() + s_SpvExtention;
+	NormalizePath(spvPath);
+
+	return spvPath;
+}
+
+SpirVStatistics ShaderCompiler::GetStatistics(std::span<const uint32_t> spirv)
+{
+	SpirVStatistics statistics;
+	statistics.WordCount = static_cast<uint32_t>(spirv.size());
 
-	if (spirv.empty())
+	for (size_t i = s_SpirVHeaderWordCount; i < spirv.size();)
 	{
-		LOG_TAGGED(s_LogTag, "Failed to generate SPIR-V");
-		success &= false;
+		const uint32_t wordCount = spirv[i] >> 16;
+
+		if (0 == wordCount)
+			break;
+
+		statistics.InstructionCount++;
+		i += wordCount;
 	}
-	else
+
+	return statistics;
+}
+
+StageFlag ShaderCompiler::GetStage(const std::filesystem::path& path)
+{
+	const auto extension = path.extension();
+
+	for (const auto& [stageExtension, stage] : s_ShaderExtensions)
 	{
-		buffer = Buffer::Copy(spirv.data(), spirv.size() * sizeof(spirv[0]) /* or sizeof(uint32_t) */);
+		if (extension == stageExtension)
+			return stage;
 	}
 
-	glslang::FinalizeProcess();
-
-	return success;
+	return StageFlag::UNDEFINED;
 }
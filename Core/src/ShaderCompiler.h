@@ -3,15 +3,109 @@
 #include "Enums.h"
 
 #include <filesystem>
+#include <span>
+#include <string>
 #include <string_view>
+#include <vector>
 
 class Buffer;
+class ShaderCache;
 
+struct ShaderDefine
+{
+	std::string Name;
+	std::string Value;
+};
+
+struct ShaderSource
+{
+	StageFlag Stage = StageFlag::UNDEFINED;
+	// The path for shaders read from disk, #include "..." is resolved relative to it
+	std::string Name;
+	std::string Code;
+	// Prepended as #define Name Value
+	std::vector<ShaderDefine> Defines;
+};
+
+// spirv-opt presets, run on the SPIR-V before it's cached
+// Reflected names, descriptor bindings, vertex inputs and specialization constants are always preserved
+enum class ShaderOptimization
+{
+	NONE,
+	// Inlining, dead code elimination, constant folding, ...
+	PERFORMANCE,
+	// Favors the smallest module, over speed where they disagree
+	SIZE
+};
+
+struct SpirVStatistics
+{
+	uint32_t WordCount = 0;
+	uint32_t InstructionCount = 0;
+};
+
+struct CompiledShader
+{
+	std::vector<uint32_t> SpirV;
+	// Parser, linker and SPIR-V generator messages, empty if there were none or it came from the cache
+	std::string Log;
+	// Including the cache lookup
+	float CompileTime = 0.0f;
+	bool Cached = false;
+
+	// Before and after the optimizer, only filled when it ran, so not for cached shaders
+	SpirVStatistics Unoptimized;
+	SpirVStatistics Optimized;
+
+	bool IsValid() const { return !SpirV.empty(); }
+	bool IsOptimized() const { return 0 != Optimized.WordCount; }
+};
+
+// glslang in-process, initialized once for the lifetime of the Application
+// Thread-safe, batches are spread over the JobSystem's workers
+// Results go through a ShaderCache, only shaders whose preprocessed source changed are compiled
+// In release builds the SPIR-V is also run through spirv-opt before it's cached (see ShaderOptimization)
 class ShaderCompiler
 {
 public:
-	static bool CompileWithValidator(const std::filesystem::path& file, bool suppressOutput);
-	static bool CompileWithValidator(const std::filesystem::path& shaderDirectory);
+	// An empty cacheDirectory disables the cache
+	// The optimization is part of the cache key, changing it recompiles everything
+	static void Init(const std::filesystem::path& cacheDirectory = s_DefaultCacheDirectory, ShaderOptimization optimization = s_DefaultOptimization);
+	static void Shutdown();
+
+	static bool IsInitialized();
+	// nullptr if it's disabled
+	static ShaderCache* GetCache();
+	static ShaderOptimization GetOptimization();
 
+	static CompiledShader Compile(const ShaderSource& source);
+	static CompiledShader Compile(StageFlag stage, std::string_view code, std::string_view name = {});
+	// One job per shader, the result is in the order of sources
+	static std::vector<CompiledShader> CompileBatch(std::span<const ShaderSource> sources);
+	// Buffer owns a copy of the SPIR-V, Release() it
 	static bool Compile(Buffer& buffer, StageFlag stage, const std::string_view code);
-};
\ No newline at end of file
+
+	// Every shader of the directory as one batch, each .spv is written next to its source when its content changed
+	static bool CompileDirectory(const std::filesystem::path& shaderDirectory);
+	// Same for a list of shaders, the .spv files that were (re)written are added to writtenFiles
+	static bool CompileFiles(std::span<const std::filesystem::path> files, std::vector<std::filesystem::path>* writtenFiles = nullptr);
+
+	// Shaders in the directory, not its subdirectories (those are for includes)
+	static std::vector<std::filesystem::path> GetSources(const std::filesystem::path& shaderDirectory);
+	// <source>.spv
+	static std::filesystem::path GetSpvPath(const std::filesystem::path& source);
+	// From the extension: .vert, .frag, .geom, .tesc, .tese or .comp, UNDEFINED for anything else
+	static StageFlag GetStage(const std::filesystem::path& path);
+
+	// Counted from the instruction headers, a valid module is assumed
+	static SpirVStatistics GetStatistics(std::span<const uint32_t> spirv);
+
+	// Relative to the working directory
+	static constexpr const char* s_DefaultCacheDirectory = "ShaderCache";
+	// Debug builds keep the SPIR-V as glslang generated it
+#if _DEBUG
+	static constexpr ShaderOptimization s_DefaultOptimization = ShaderOptimization::NONE;
+#else
+	static constexpr ShaderOptimization s_DefaultOptimization = ShaderOptimization::PERFORMANCE;
+#endif
+};
@@ -0,0 +1,287 @@
+#include "ShaderPermutations.h"
+
+#include "ShaderCompiler.h"
+#include "Shader.h"
+
+#include "Buffer.h"
+#include "Utils.h"
+
+#include "Log.h"
+
+#include <algorithm>
+#include <sstream>
+
+static constexpr const char* s_LogTag = "[ShaderPermutations]";
+
+// Entries expire with the last Ref, like the Shader library
+static std::mutex s_LibraryMutex;
+static std::unordered_map<std::string, WeakRef<ShaderPermutations>> s_Library;
+
+// Every #pragma keywords line of the source itself, not of its includes
+static std::vector<std::string> ParseKeywords(const std::string& code)
+{
+	std::vector<std::string> keywords;
+
+	std::istringstream stream(code);
+	std::string line;
+
+	while (std::getline(stream, line))
+	{
+		std::istringstream tokens(line);
+		std::string token;
+
+		if (!(tokens >> token) || "#pragma" != token || !(tokens >> token) || "keywords" != token)
+			continue;
+
+		while (tokens >> token)
+		{
+			if (std::ranges::find(keywords, token) == keywords.end())
+				keywords.push_back(token);
+		}
+	}
+
+	return keywords;
+}
+
+Ref<ShaderPermutations> ShaderPermutations::Create(const std::filesystem::path& source)
+{
+	auto path = source;
+	NormalizePath(path);
+
+	const StageFlag stage = ShaderCompiler::GetStage(path);
+
+	if (StageFlag::UNDEFINED == stage)
+	{
+		LOG_TAGGED(s_LogTag, "Unknown shader stage for %s", QUOTED(path.string()));
+		return nullptr;
+	}
+
+	std::scoped_lock lock(s_LibraryMutex);
+
+	auto& entry = s_Library[path.string()];
+
+	if (auto permutations = entry.lock())
+		return permutations;
+
+	Buffer code;
+
+	if (!ReadFromFile(code, path))
+		return nullptr;
+
+	auto permutations = CreateRef<ShaderPermutations>(path, stage, std::string(code.As<const char*>(), code.GetSize()));
+	entry = permutations;
+
+	code.Release();
+
+	return permutations;
+}
+
+ShaderPermutationStatistics ShaderPermutations::GetTotalStatistics()
+{
+	ShaderPermutationStatistics total;
+
+	std::scoped_lock lock(s_LibraryMutex);
+
+	for (const auto& [_, entry] : s_Library)
+	{
+		const auto permutations = entry.lock();
+
+		if (!permutations)
+			continue;
+
+		const auto stats = permutations->GetStatistics();
+
+		total.PossibleCount += stats.PossibleCount;
+		total.RequestedCount += stats.RequestedCount;
+		total.CompiledCount += stats.CompiledCount;
+		total.CachedCount += stats.CachedCount;
+		total.FailedCount += stats.FailedCount;
+		total.CompileTime += stats.CompileTime;
+	}
+
+	return total;
+}
+
+ShaderPermutations::ShaderPermutations(const std::filesystem::path& source, StageFlag stage, std::string&& code)
+	: m_Source(source), m_Stage(stage), m_Code(std::move(code))
+{
+	ASSERT(ShaderCompiler::IsInitialized());
+
+	m_Keywords = ParseKeywords(m_Code);
+
+	const auto keywordCount = static_cast<uint32_t>(m_Keywords.size());
+
+	LOG_TAGGED(s_LogTag, "%s: %i keywords, at most %i are supported", QUOTED(m_Source.string()), keywordCount, s_MaxKeywordCount);
+	ASSERT(keywordCount <= s_MaxKeywordCount, "Too many keywords");
+
+	m_Statistics.PossibleCount = keywordCount < s_MaxKeywordCount ? (1ull << keywordCount) : ~0ull;
+}
+
+ShaderPermutations::~ShaderPermutations()
+{
+	const auto& stats = GetStatistics();
+
+	if (stats.RequestedCount > 0)
+	{
+		LOG_TAGGED(s_LogTag, "%s: %i of %llu variants used, compiled %i, cached %i, failed %i in %.2f ms", QUOTED(m_Source.string()),
+			stats.RequestedCount, static_cast<unsigned long long>(stats.PossibleCount), stats.CompiledCount, stats.CachedCount, stats.FailedCount, stats.CompileTime);
+	}
+
+	m_Variants.clear();
+}
+
+const std::vector<std::string>& ShaderPermutations::GetKeywords() const
+{
+	return m_Keywords;
+}
+
+uint64_t ShaderPermutations::GetMask(std::span<const std::string> keywords) const
+{
+	uint64_t mask = 0;
+
+	for (size_t i = 0; i < m_Keywords.size(); i++)
+	{
+		if (std::ranges::find(keywords, m_Keywords[i]) != keywords.end())
+			mask |= 1ull << i;
+	}
+
+	return mask;
+}
+
+Ref<ShaderModule> ShaderPermutations::GetVariant(std::span<const std::string> keywords)
+{
+	return GetVariant(GetMask(keywords));
+}
+
+Ref<ShaderModule> ShaderPermutations::GetVariant(uint64_t mask)
+{
+	{
+		std::scoped_lock lock(m_Mutex);
+
+		if (auto it = m_Variants.find(mask); it != m_Variants.end())
+			return it->second;
+	}
+
+	Prepare({ &mask, 1 });
+
+	std::scoped_lock lock(m_Mutex);
+
+	return m_Variants.at(mask);
+}
+
+void ShaderPermutations::Prepare(std::span<const uint64_t> masks)
+{
+	const uint64_t declaredMask = m_Keywords.size() < s_MaxKeywordCount ? (1ull << m_Keywords.size()) - 1 : ~0ull;
+
+	std::vector<uint64_t> missing;
+
+	{
+		std::scoped_lock lock(m_Mutex);
+
+		for (const uint64_t mask : masks)
+		{
+			ASSERT(0 == (mask & ~declaredMask), "Mask has keywords the source doesn't declare");
+
+			if (!m_Variants.contains(mask) && std::ranges::find(missing, mask) == missing.end())
+				missing.push_back(mask);
+		}
+	}
+
+	if (missing.empty())
+		return;
+
+	std::vector<ShaderSource> sources(missing.size());
+
+	for (size_t i = 0; i < missing.size(); i++)
+	{
+		auto& source = sources[i];
+		source.Stage = m_Stage;
+		source.Name = m_Source.string();
+		source.Code = m_Code;
+
+		for (size_t j = 0; j < m_Keywords.size(); j++)
+		{
+			if (missing[i] & (1ull << j))
+				source.Defines.push_back({ .Name = m_Keywords[j], .Value = "1" });
+		}
+	}
+
+	auto results = ShaderCompiler::CompileBatch(sources);
+
+	std::scoped_lock lock(m_Mutex);
+
+	for (size_t i = 0; i < missing.size(); i++)
+	{
+		const uint64_t mask = missing[i];
+		auto& result = results[i];
+
+		// Asked for from another thread meanwhile
+		if (m_Variants.contains(mask))
+			continue;
+
+		const auto name = GetVariantName(mask);
+
+		m_Statistics.RequestedCount++;
+		m_Statistics.CompileTime += result.CompileTime;
+
+		if (!result.IsValid())
+		{
+			LOG_TAGGED(s_LogTag, "Failed to compile %s: %s", QUOTED(name), result.Log.data());
+
+			m_Statistics.FailedCount++;
+			m_Variants.emplace(mask, nullptr);
+
+			continue;
+		}
+
+		if (result.Cached)
+		{
+			m_Statistics.CachedCount++;
+		}
+		else
+		{
+			LOG_TAGGED(s_LogTag, "Compiled: %s in %.2f ms", QUOTED(name), result.CompileTime);
+			m_Statistics.CompiledCount++;
+		}
+
+		// Copied by the ShaderModule
+		const Buffer code(result.SpirV.data(), result.SpirV.size() * sizeof(result.SpirV[0]));
+
+		m_Variants.emplace(mask, ShaderModule::Create(m_Stage, name, code));
+	}
+}
+
+StageFlag ShaderPermutations::GetStage() const
+{
+	return m_Stage;
+}
+
+const std::filesystem::path& ShaderPermutations::GetSource() const
+{
+	return m_Source;
+}
+
+ShaderPermutationStatistics ShaderPermutations::GetStatistics() const
+{
+	std::scoped_lock lock(m_Mutex);
+
+	return m_Statistics;
+}
+
+std::string ShaderPermutations::GetVariantName(uint64_t mask) const
+{
+	std::string name = m_Source.filename().string() + " [";
+
+	for (size_t i = 0, count = 0; i < m_Keywords.size(); i++)
+	{
+		if (0 == (mask & (1ull << i)))
+			continue;
+
+		if (count++ > 0)
+			name += " ";
+
+		name += m_Keywords[i];
+	}
+
+	return name + "]";
+}
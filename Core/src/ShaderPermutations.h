@@ -0,0 +1,82 @@
+#pragma once
+
+#include "Base.h"
+
+#include "Enums.h"
+
+#include <filesystem>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class ShaderModule;
+
+struct ShaderPermutationStatistics
+{
+	// 2^keywords, what compiling every variant upfront would take
+	uint64_t PossibleCount = 0;
+	// Distinct variants asked for
+	uint32_t RequestedCount = 0;
+	// Of those, compiled by glslang, loaded from the ShaderCache or failed
+	uint32_t CompiledCount = 0;
+	uint32_t CachedCount = 0;
+	uint32_t FailedCount = 0;
+
+	// Accumulated, including the cache lookups, in ms
+	float CompileTime = 0.0f;
+};
+
+// Variants of one shader source, for what specialization constants can't do (vertex inputs, optional bindings, ...)
+// Keywords are declared in the source, e.g. #pragma keywords USE_TEXTURE USE_NORMAL_MAP, and tested with #ifdef
+// A variant defines the enabled ones, it's compiled the first time it's asked for and kept by its keyword mask
+// Compilation goes through the ShaderCache like any other shader, so a variant is compiled once across runs
+// Sources and their permutations are shared while a Ref to them is alive
+class ShaderPermutations
+{
+public:
+	// nullptr if the source can't be read or its extension isn't a known stage (see ShaderCompiler::GetStage())
+	static Ref<ShaderPermutations> Create(const std::filesystem::path& source);
+
+	// Of every ShaderPermutations alive
+	static ShaderPermutationStatistics GetTotalStatistics();
+
+	ShaderPermutations(const std::filesystem::path& source, StageFlag stage, std::string&& code);
+	~ShaderPermutations();
+
+	DELETE_COPY_AND_MOVE(ShaderPermutations);
+
+	// In declaration order, bit i of a mask is the keyword i
+	const std::vector<std::string>& GetKeywords() const;
+	// Keywords the source doesn't declare are ignored, a material's keywords can be passed to every stage
+	uint64_t GetMask(std::span<const std::string> keywords) const;
+
+	// Thread-safe, compiles the variant on first use, nullptr if it failed to
+	Ref<ShaderModule> GetVariant(std::span<const std::string> keywords);
+	Ref<ShaderModule> GetVariant(uint64_t mask);
+	// Compiles the variants not compiled yet as one batch, one job each, and waits for them
+	void Prepare(std::span<const uint64_t> masks);
+
+	StageFlag GetStage() const;
+	const std::filesystem::path& GetSource() const;
+	ShaderPermutationStatistics GetStatistics() const;
+
+	static constexpr uint32_t s_MaxKeywordCount = 64;
+private:
+	// "Phong.frag [USE_TEXTURE USE_NORMAL_MAP]", for the logs
+	std::string GetVariantName(uint64_t mask) const;
+private:
+	std::filesystem::path m_Source;
+	StageFlag m_Stage = StageFlag::UNDEFINED;
+	std::string m_Code;
+
+	std::vector<std::string> m_Keywords;
+
+	// nullptr for the variants that failed, they aren't retried
+	std::unordered_map<uint64_t, Ref<ShaderModule>> m_Variants;
+
+	ShaderPermutationStatistics m_Statistics;
+
+	mutable std::mutex m_Mutex;
+};
@@ -0,0 +1,180 @@
+#include "ShaderReloader.h"
+
+#include "Device.h"
+#include "Pipeline.h"
+#include "Shader.h"
+#include "ShaderCompiler.h"
+#include "Utils.h"
+
+#include "Log.h"
+#include "Profiler.h"
+
+#include <volk.h>
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+
+static constexpr const char* s_LogTag = "[ShaderReloader]";
+
+static bool UsesAny(const PipelineDescription& desc, const std::vector<std::filesystem::path>& files)
+{
+	return std::ranges::any_of(desc.ShaderModules, [&files](const auto& shaderModule)
+		{
+			return std::ranges::any_of(files, [&shaderModule](const std::filesystem::path& file)
+				{
+					std::error_code error;
+					return std::filesystem::equivalent(shaderModule.second, file, error);
+				});
+		});
+}
+
+ShaderReloader::ShaderReloader(const Device& device)
+	: m_Device(device)
+{
+}
+
+ShaderReloader::~ShaderReloader()
+{
+	if (m_IsReloading)
+		JobSystem::WaitFor(m_Counter);
+
+	// Never applied, each pipeline destroys what it prepared
+	m_ReloadedPipelines.clear();
+
+	for (const auto& retired : m_Retired)
+		vkDestroyPipeline(m_Device.GetHandle(), retired.Pipeline, nullptr);
+
+	m_Retired.clear();
+}
+
+void ShaderReloader::Watch(const std::filesystem::path& shaderDirectory)
+{
+	auto directory = shaderDirectory;
+	NormalizePath(directory);
+
+	if (std::ranges::find(m_Directories, directory) != m_Directories.end())
+		return;
+
+	if (m_Watcher.Watch(directory))
+	{
+		m_Directories.push_back(directory);
+
+		LOG_TAGGED(s_LogTag, "Watching %s", QUOTED(directory.string()));
+	}
+}
+
+void ShaderReloader::Update(uint32_t framesInFlight)
+{
+	PROFILE_FUNCTION();
+
+	m_Frame++;
+
+	// Every frame that could still use them is done
+	while (!m_Retired.empty() && m_Retired.front().Frame + framesInFlight <= m_Frame)
+	{
+		vkDestroyPipeline(m_Device.GetHandle(), m_Retired.front().Pipeline, nullptr);
+		m_Retired.pop_front();
+	}
+
+	if (m_Directories.empty())
+		return;
+
+	for (auto& file : m_Watcher.Poll())
+	{
+		// Written by the reload itself
+		if (file.extension() == ".spv")
+			continue;
+
+		if (std::ranges::find(m_Changes, file) == m_Changes.end())
+			m_Changes.push_back(std::move(file));
+
+		m_SettleTimer.Reset();
+	}
+
+	if (m_IsReloading)
+	{
+		if (!m_Counter.IsDone())
+			return;
+
+		for (const auto& pipeline : m_ReloadedPipelines)
+		{
+			auto [previousPipeline, previousShader] = pipeline->ApplyReload();
+
+			m_Retired.push_back({ previousPipeline, std::move(previousShader), m_Frame });
+		}
+
+		m_ReloadedPipelines.clear();
+		m_IsReloading = false;
+	}
+
+	if (m_Changes.empty() || m_SettleTimer.Elapsed() < s_SettleTime)
+		return;
+
+	m_ChangedFiles = std::move(m_Changes);
+	m_Changes.clear();
+
+	m_IsReloading = true;
+
+	// Off the calling thread's deque, its next WaitFor() would pick the whole reload up mid-frame
+	JobSystem::ExecuteInBackground([this]() { Reload(); }, &m_Counter);
+}
+
+void ShaderReloader::Reload()
+{
+	Timer timer;
+
+	std::vector<std::filesystem::path> sources;
+	bool hasIncludeChanged = false;
+
+	for (const auto& file : m_ChangedFiles)
+	{
+		if (StageFlag::UNDEFINED != ShaderCompiler::GetStage(file))
+			sources.push_back(file);
+		else
+			hasIncludeChanged = true;
+	}
+
+	// Which shaders include it isn't known here, the ShaderCache makes recompiling the others cheap
+	if (hasIncludeChanged)
+	{
+		sources.clear();
+
+		for (const auto& directory : m_Directories)
+		{
+			const auto directorySources = ShaderCompiler::GetSources(directory);
+			sources.insert(sources.end(), directorySources.begin(), directorySources.end());
+		}
+	}
+
+	std::erase_if(sources, [](const std::filesystem::path& source) { return !std::filesystem::exists(source); });
+
+	if (sources.empty())
+		return;
+
+	std::vector<std::filesystem::path> writtenFiles;
+
+	if (!ShaderCompiler::CompileFiles(sources, &writtenFiles))
+		LOG_TAGGED(s_LogTag, "Compilation failed, the affected pipelines keep their previous shaders");
+
+	if (writtenFiles.empty())
+		return;
+
+	auto pipelines = Pipeline::GetPipelines();
+
+	std::erase_if(pipelines, [&writtenFiles](const Ref<Pipeline>& pipeline) { return !UsesAny(pipeline->GetDescription(), writtenFiles); });
+
+	std::vector<uint8_t> isReloaded(pipelines.size(), 0);
+
+	JobSystem::ParallelFor(static_cast<uint32_t>(pipelines.size()), 1, [&pipelines, &isReloaded](uint32_t i)
+		{
+			isReloaded[i] = pipelines[i]->PrepareReload();
+		});
+
+	for (size_t i = 0; i < pipelines.size(); i++)
+	{
+		if (isReloaded[i])
+			m_ReloadedPipelines.push_back(std::move(pipelines[i]));
+	}
+
+	LOG_TAGGED(s_LogTag, "Reloaded %i of %i pipeline(s) in %.2f ms", static_cast<int>(m_ReloadedPipelines.size()), static_cast<int>(pipelines.size()), timer.ElapsedMS());
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Base.h"
+
+#include "VK.h"
+
+#include "FileWatcher.h"
+#include "JobSystem.h"
+#include "Timer.h"
+
+#include <deque>
+#include <filesystem>
+#include <vector>
+
+class Device;
+class Pipeline;
+class Shader;
+
+// Recompiles the shaders of the watched directories when they change and reloads the Pipelines created from them
+// Compilation and pipeline creation run on the JobSystem workers, never the frame's thread, through the ShaderCache and the PipelineCache
+// The new VkPipelines are swapped in by Update() between frames, the replaced ones are destroyed once no frame in flight uses them
+// A shader that fails to compile leaves its pipelines running as they are, the error is logged
+class ShaderReloader
+{
+	// Replaced pipelines can still be in use by the frames in flight
+	struct Retired
+	{
+		VkPipeline Pipeline = nullptr;
+		Ref<Shader> Shader;
+
+		uint64_t Frame = 0;
+	};
+public:
+	ShaderReloader(const Device& device);
+	// Waits for the running reload, if any
+	~ShaderReloader();
+
+	DELETE_COPY_AND_MOVE(ShaderReloader);
+
+	// Shaders directly in it, includes in it or its subdirectories
+	void Watch(const std::filesystem::path& shaderDirectory);
+
+	// Once per frame, from the main thread, before anything is recorded
+	void Update(uint32_t framesInFlight);
+
+	// Changes are batched until none came for this long, editors can save a file in several steps
+	static constexpr float s_SettleTime = 0.1f;
+private:
+	// On a worker, compiles m_ChangedFiles and prepares the affected pipelines into m_ReloadedPipelines
+	void Reload();
+private:
+	const Device& m_Device;
+
+	FileWatcher m_Watcher;
+	std::vector<std::filesystem::path> m_Directories;
+
+	// Seen since the last reload started
+	std::vector<std::filesystem::path> m_Changes;
+	Timer m_SettleTimer;
+
+	// Owned by the job while m_IsReloading
+	std::vector<std::filesystem::path> m_ChangedFiles;
+	std::vector<Ref<Pipeline>> m_ReloadedPipelines;
+
+	JobCounter m_Counter;
+	bool m_IsReloading = false;
+
+	std::deque<Retired> m_Retired;
+	uint64_t m_Frame = 0;
+};
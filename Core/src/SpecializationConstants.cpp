@@ -0,0 +1,35 @@
+#include "SpecializationConstants.h"
+
+#include <algorithm>
+
+const std::vector<SpecializationConstant>& SpecializationConstants::GetConstants() const
+{
+	return m_Constants;
+}
+
+const SpecializationConstant* SpecializationConstants::TryGetConstant(const std::string& name) const
+{
+	const auto it = std::ranges::lower_bound(m_Constants, name, {}, &SpecializationConstant::Name);
+
+	return (it != m_Constants.end() && it->Name == name) ? &(*it) : nullptr;
+}
+
+bool SpecializationConstants::IsEmpty() const
+{
+	return m_Constants.empty();
+}
+
+void SpecializationConstants::Set(const std::string& name, SpecializationConstantType type, uint32_t value)
+{
+	const auto it = std::ranges::lower_bound(m_Constants, name, {}, &SpecializationConstant::Name);
+
+	if (it != m_Constants.end() && it->Name == name)
+	{
+		it->Type = type;
+		it->Value = value;
+	}
+	else
+	{
+		m_Constants.insert(it, SpecializationConstant{ .Name = name, .Type = type, .Value = value });
+	}
+}
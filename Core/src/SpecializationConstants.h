@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Enums.h"
+
+#include <bit>
+#include <string>
+#include <vector>
+
+struct SpecializationConstant
+{
+	std::string Name;
+	SpecializationConstantType Type = SpecializationConstantType::UNDEFINED;
+	// Bit pattern of the value
+	uint32_t Value = 0;
+
+	bool operator==(const SpecializationConstant&) const = default;
+};
+
+// Values of a shader's specialization constants, e.g. layout (constant_id = 0) const uint LIGHT_COUNT = 4;
+// Matched by name to the reflected constants, the types have to agree, the ones left out keep their default
+// The driver folds them in when the pipeline is created, so each set of values is its own pipeline
+class SpecializationConstants
+{
+public:
+	SpecializationConstants() = default;
+
+	template <typename T>
+	void Set(const std::string& name, T value)
+	{
+		static_assert(sizeof(T) == 0, "Unsupported type");
+	}
+
+	// Sorted by name, the order of the Set() calls doesn't matter
+	const std::vector<SpecializationConstant>& GetConstants() const;
+	const SpecializationConstant* TryGetConstant(const std::string& name) const;
+
+	bool IsEmpty() const;
+
+	bool operator==(const SpecializationConstants&) const = default;
+private:
+	void Set(const std::string& name, SpecializationConstantType type, uint32_t value);
+private:
+	std::vector<SpecializationConstant> m_Constants;
+};
+
+#define SPECIALIZATION_CONSTANT_TYPE(TYPE, CONSTANT_TYPE, VALUE) \
+template <> \
+inline void SpecializationConstants::Set<TYPE>(const std::string& name, TYPE value) \
+{ \
+	Set(name, CONSTANT_TYPE, VALUE); \
+}
+
+SPECIALIZATION_CONSTANT_TYPE(bool, SpecializationConstantType::BOOL, value ? 1u : 0u)
+SPECIALIZATION_CONSTANT_TYPE(int32_t, SpecializationConstantType::INT, std::bit_cast<uint32_t>(value))
+SPECIALIZATION_CONSTANT_TYPE(uint32_t, SpecializationConstantType::UINT, value)
+SPECIALIZATION_CONSTANT_TYPE(float, SpecializationConstantType::FLOAT, std::bit_cast<uint32_t>(value))
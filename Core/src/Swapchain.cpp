@@ -1,5 +1,6 @@
 #include "Swapchain.h"
 
+#include "Context.h"
 #include "Device.h"
 #include "Surface.h"
 #include "Image.h"
@@ -7,6 +8,9 @@
 #include "CommandBuffer.h"
 #include "Synchronization.h"
 #include "Framebuffer.h"
+#include "UniformRingBuffer.h"
+#include "UploadQueue.h"
+#include "ThreadCommandPools.h"
 
 #include "Log.h"
 #include "Profiler.h"
@@ -23,10 +27,22 @@ Swapchain::Swapchain(Device& device, Surface& surface, const SwapchainDescriptio
 	: m_Device(device), m_Surface(surface), m_Description(desc)
 {
 	CreateAll();
+
+	UniformRingBufferDescription ringBufferDesc;
+
+	ringBufferDesc.SizePerFrame = m_Description.UniformRingBufferSizePerFrame;
+	ringBufferDesc.FrameCount = GetImageCount();
+
+	m_UniformRingBuffer = UniformRingBuffer::Create(m_Device, ringBufferDesc);
+
+	m_ThreadCommandPools = ThreadCommandPools::Create(m_Device, GetImageCount());
 }
 
 Swapchain::~Swapchain()
 {
+	m_ThreadCommandPools.reset();
+	m_UniformRingBuffer.reset();
+
 	Destroy();
 }
 
@@ -42,24 +58,42 @@ void Swapchain::BeginFrame()
 	auto& presentFinished = GetCurrentSemaphores().PresentFinished->GetHandle();
 
 	VkResult result = vkAcquireNextImageKHR(m_Device.GetHandle(), Handle::GetHandle(), timeout, presentFinished, VK_NULL_HANDLE, &m_ImageIndex);
-	VK_CHECK_RESULT(result);
-
-	currentFence.Reset();
 
+	// The surface changed without a resize reaching OnResize() (same size), nothing was acquired
 	if (result == VK_ERROR_OUT_OF_DATE_KHR)
 	{
-		OnResize(m_Description.Width, m_Description.Height);
+		Recreate();
+
+		result = vkAcquireNextImageKHR(m_Device.GetHandle(), Handle::GetHandle(), timeout, presentFinished, VK_NULL_HANDLE, &m_ImageIndex);
 	}
+
+	VK_CHECK_RESULT(result);
 	ASSERT(result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR, "Failed to acquire Swapchain image");
+
+	// Only once an image was acquired, a frame is submitted to signal it again
+	currentFence.Reset();
+
+	// The GPU is done with this frame's partition
+	m_UniformRingBuffer->BeginFrame(m_CurrentFrame);
+	m_ThreadCommandPools->BeginFrame(m_CurrentFrame);
+
+	Context::GetUploadQueue().Collect();
 }
 
 void Swapchain::EndFrame()
 {
-	std::array waitSemaphores = { GetCurrentSemaphores().PresentFinished->GetHandle() };
+	auto& uploadQueue = Context::GetUploadQueue();
+
+	// Kick off whatever was uploaded during this frame, the frame's vertex input waits for it on the GPU
+	uploadQueue.Submit();
+
+	std::array waitSemaphores = { GetCurrentSemaphores().PresentFinished->GetHandle(), uploadQueue.GetSemaphore().GetHandle() };
+	std::array<VkPipelineStageFlags, 2> waitStages = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT };
+	std::array<uint64_t, 2> waitValues = { 0, uploadQueue.GetSubmittedValue() };
 	std::array signalSemaphores = { GetCurrentSemaphores().RenderFinished->GetHandle() };
 	std::array commandBuffers = { GetCurrentCommandBuffer().GetHandle() };
 
-	Submit(waitSemaphores, signalSemaphores, commandBuffers);
+	Submit(waitSemaphores, waitStages, waitValues, signalSemaphores, commandBuffers);
 
 	Present(signalSemaphores);
 
@@ -76,13 +110,7 @@ void Swapchain::OnResize(uint32_t width, uint32_t height)
 	m_Description.Width = width;
 	m_Description.Height = height;
 
-	//m_Device.WaitIdle();
-
-	Destroy();
-
-	CreateAll();
-
-	//m_Device.WaitIdle();
+	Recreate();
 }
 
 const SwapchainDescription& Swapchain::GetDescription() const
@@ -133,7 +161,17 @@ const Framebuffer& Swapchain::GetCurrentFramebuffer() const
 	return *GetFrameData(m_ImageIndex).Framebuffer;
 }
 
-void Swapchain::CreateSwapchain()
+UniformRingBuffer& Swapchain::GetUniformRingBuffer()
+{
+	return *m_UniformRingBuffer;
+}
+
+ThreadCommandPools& Swapchain::GetThreadCommandPools()
+{
+	return *m_ThreadCommandPools;
+}
+
+void Swapchain::CreateSwapchain(VkSwapchainKHR oldSwapchain)
 {
 	ASSERT(0 < m_Description.FramesInFlight, STR(m_Description.FramesInFlight) " <= 0");
 	ASSERT(0 < m_Description.Width && 0 < m_Description.Height, STR(m_Description.Width, m_Description.Height) " == 0");
@@ -151,6 +189,9 @@ void Swapchain::CreateSwapchain()
 	uint32_t& framesInFlight = m_Description.FramesInFlight;
 	framesInFlight = glm::clamp(m_Description.FramesInFlight, surfaceCapabilities.minImageCount, surfaceCapabilities.maxImageCount);
 
+	// Per frame command buffers and sync objects survive a resize, the image count must not change
+	ASSERT(m_FrameData.empty() || m_FrameData.size() == framesInFlight);
+
 	m_FrameData.resize(framesInFlight);
 
 	VkSwapchainCreateInfoKHR createInfo;
@@ -185,7 +226,8 @@ void Swapchain::CreateSwapchain()
 	createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
 	createInfo.presentMode = presentMode;
 	createInfo.clipped = VK_TRUE;
-	createInfo.oldSwapchain = VK_NULL_HANDLE;
+	// Lets the presentation engine hand the images over without a gap
+	createInfo.oldSwapchain = oldSwapchain;
 
 	VkResult result = vkCreateSwapchainKHR(m_Device.GetHandle(), &createInfo, nullptr, &Handle::GetHandle());
 	VK_CHECK_RESULT(result);
@@ -386,21 +428,60 @@ void Swapchain::Destroy()
 	vkDestroySwapchainKHR(device, Handle::GetHandle(), nullptr);
 }
 
-void Swapchain::Submit(const std::span<const VkSemaphore> waitSemaphore, const std::span<const VkSemaphore> signalSemaphore,
-	const std::span<const VkCommandBuffer> commandBuffer)
+void Swapchain::Recreate()
 {
 	PROFILE_FUNCTION();
 
-	ASSERT(waitSemaphore.size() == 1 || signalSemaphore.size() == 1 || commandBuffer.size() == 1);
+	m_Device.WaitIdle();
+
+	auto oldSwapchain = Handle::GetHandle();
+
+	DestroySizeDependent();
+
+	CreateSwapchain(oldSwapchain);
+
+	// Retired, can be destroyed once the new one exists
+	vkDestroySwapchainKHR(m_Device.GetHandle(), oldSwapchain, nullptr);
+
+	CreateImagesAndViews();
+	CreateColorResources();
+	CreateDepthResources();
+	CreateFramebuffers();
+}
+
+void Swapchain::DestroySizeDependent()
+{
+	for (auto& frameData : m_FrameData)
+	{
+		frameData.Framebuffer.reset();
+		frameData.Image.reset();
+	}
+
+	m_ColorImage.reset();
+	m_DepthImage.reset();
+}
+
+void Swapchain::Submit(const std::span<const VkSemaphore> waitSemaphore, const std::span<const VkPipelineStageFlags> waitStages, const std::span<const uint64_t> waitValues,
+	const std::span<const VkSemaphore> signalSemaphore, const std::span<const VkCommandBuffer> commandBuffer)
+{
+	PROFILE_FUNCTION();
+
+	ASSERT(waitSemaphore.size() == waitStages.size() && waitSemaphore.size() == waitValues.size());
+	ASSERT(signalSemaphore.size() == 1 || commandBuffer.size() == 1);
+
+	VkTimelineSemaphoreSubmitInfo timelineInfo;
+	ZeroInitVkStruct(timelineInfo, VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO);
 
-	VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+	timelineInfo.waitSemaphoreValueCount = static_cast<uint32_t>(waitValues.size());
+	timelineInfo.pWaitSemaphoreValues = waitValues.data();
 
 	VkSubmitInfo submitInfo;
 	ZeroInitVkStruct(submitInfo, VK_STRUCTURE_TYPE_SUBMIT_INFO);
 
+	submitInfo.pNext = &timelineInfo;
 	submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphore.size());
 	submitInfo.pWaitSemaphores = waitSemaphore.data();
-	submitInfo.pWaitDstStageMask = waitStages;
+	submitInfo.pWaitDstStageMask = waitStages.data();
 	submitInfo.commandBufferCount = static_cast<uint32_t>(commandBuffer.size());
 	submitInfo.pCommandBuffers = commandBuffer.data();
 	submitInfo.signalSemaphoreCount = static_cast<uint32_t>(signalSemaphore.size());
@@ -428,9 +509,10 @@ void Swapchain::Present(const std::span<const VkSemaphore> signalSemaphore)
 	VkResult result = vkQueuePresentKHR(m_Device.GetPresentQueue(), &presentInfo);
 	VK_CHECK_RESULT(result);
 
+	// OnResize() would skip it, the size didn't change
 	if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
 	{
-		OnResize(m_Description.Width, m_Description.Height);
+		Recreate();
 	}
 	else if (result != VK_SUCCESS)
 	{
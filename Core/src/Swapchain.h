@@ -19,6 +19,9 @@ class Framebuffer;
 class Semaphore;
 class Fence;
 
+class UniformRingBuffer;
+class ThreadCommandPools;
+
 struct SwapchainDescription
 {
 	uint32_t FramesInFlight = 3;
@@ -27,6 +30,9 @@ struct SwapchainDescription
 	uint32_t Height = 0;
 
 	bool VSync = false;
+
+	// Size of each frame's partition of the UniformRingBuffer
+	VkDeviceSize UniformRingBufferSizePerFrame = 1024 * 1024;
 };
 
 class Swapchain : public Handle<VkSwapchainKHR>
@@ -52,6 +58,7 @@ public:
 	void BeginFrame();
 	void EndFrame();
 
+	// Recreates only the size dependent resources, the RenderPass and with it every Pipeline stays valid
 	void OnResize(uint32_t width, uint32_t height);
 
 	const SwapchainDescription& GetDescription() const;
@@ -66,8 +73,11 @@ public:
 	CommandBuffer& GetCurrentCommandBuffer();
 
 	const Framebuffer& GetCurrentFramebuffer() const;
+
+	UniformRingBuffer& GetUniformRingBuffer();
+	ThreadCommandPools& GetThreadCommandPools();
 private:
-	void CreateSwapchain();
+	void CreateSwapchain(VkSwapchainKHR oldSwapchain = nullptr);
 	void CreateImagesAndViews();
 	void CreateColorResources();
 	void CreateDepthResources();
@@ -79,7 +89,12 @@ private:
 	void CreateAll();
 	void Destroy();
 
-	void Submit(const std::span<const VkSemaphore> waitSemaphore, const std::span<const VkSemaphore> signalSemaphore, const std::span<const VkCommandBuffer> commandBuffer);
+	void Recreate();
+	void DestroySizeDependent();
+
+	// waitValues are used only for timeline semaphores, ignored for binary ones
+	void Submit(const std::span<const VkSemaphore> waitSemaphore, const std::span<const VkPipelineStageFlags> waitStages, const std::span<const uint64_t> waitValues,
+		const std::span<const VkSemaphore> signalSemaphore, const std::span<const VkCommandBuffer> commandBuffer);
 	void Present(const std::span<const VkSemaphore> signalSemaphore);
 
 	const FrameData& GetFrameData(uint32_t index) const;
@@ -103,6 +118,10 @@ private:
 
 	Ref<RenderPass> m_RenderPass;
 
+	// Not recreated on resize
+	Scope<UniformRingBuffer> m_UniformRingBuffer;
+	Scope<ThreadCommandPools> m_ThreadCommandPools;
+
 	uint32_t m_CurrentFrame = 0;
 	uint32_t m_ImageIndex = 0;
 };
\ No newline at end of file
@@ -36,6 +36,65 @@ void Semaphore::CreateSemaphore()
 
 #pragma endregion
 
+#pragma region TimelineSemaphore
+
+Ref<TimelineSemaphore> TimelineSemaphore::Create(const Device& device, uint64_t initialValue)
+{
+	return CreateRef<TimelineSemaphore>(device, initialValue);
+}
+
+TimelineSemaphore::TimelineSemaphore(const Device& device, uint64_t initialValue)
+	: m_Device(device)
+{
+	CreateSemaphore(initialValue);
+}
+
+TimelineSemaphore::~TimelineSemaphore()
+{
+	vkDestroySemaphore(m_Device.GetHandle(), Handle::GetHandle(), nullptr);
+}
+
+uint64_t TimelineSemaphore::GetValue() const
+{
+	uint64_t value = 0;
+
+	VkResult result = vkGetSemaphoreCounterValue(m_Device.GetHandle(), Handle::GetHandle(), &value);
+	VK_CHECK_RESULT(result);
+
+	return value;
+}
+
+void TimelineSemaphore::Wait(uint64_t value, uint64_t timeout) const
+{
+	VkSemaphoreWaitInfo waitInfo;
+	ZeroInitVkStruct(waitInfo, VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO);
+
+	waitInfo.semaphoreCount = 1;
+	waitInfo.pSemaphores = &Handle::GetHandle();
+	waitInfo.pValues = &value;
+
+	vkWaitSemaphores(m_Device.GetHandle(), &waitInfo, timeout);
+}
+
+void TimelineSemaphore::CreateSemaphore(uint64_t initialValue)
+{
+	VkSemaphoreTypeCreateInfo typeInfo;
+	ZeroInitVkStruct(typeInfo, VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO);
+
+	typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+	typeInfo.initialValue = initialValue;
+
+	VkSemaphoreCreateInfo semaphoreInfo;
+	ZeroInitVkStruct(semaphoreInfo, VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO);
+
+	semaphoreInfo.pNext = &typeInfo;
+
+	vkCreateSemaphore(m_Device.GetHandle(), &semaphoreInfo, nullptr, &Handle::GetHandle());
+	ASSERT(Handle::GetHandle(), "TimelineSemaphore creation failed");
+}
+
+#pragma endregion
+
 #pragma region Fence
 
 FenceDescription::FenceDescription()
@@ -69,6 +128,11 @@ void Fence::Reset()
 	vkResetFences(m_Device.GetHandle(), 1, &Handle::GetHandle());
 }
 
+bool Fence::IsSignaled() const
+{
+	return VK_SUCCESS == vkGetFenceStatus(m_Device.GetHandle(), Handle::GetHandle());
+}
+
 void Fence::CreateFence(const FenceDescription& desc)
 {
 	VkFenceCreateInfo fenceInfo;
@@ -23,6 +23,27 @@ private:
 
 #pragma endregion
 
+#pragma region TimelineSemaphore
+
+// Monotonically increasing 64-bit counter, can be waited on from the host and from other queues
+class TimelineSemaphore : public Handle<VkSemaphore>
+{
+public:
+	static Ref<TimelineSemaphore> Create(const Device& device, uint64_t initialValue = 0);
+
+	TimelineSemaphore(const Device& device, uint64_t initialValue);
+	~TimelineSemaphore();
+
+	uint64_t GetValue() const;
+	void Wait(uint64_t value, uint64_t timeout) const;
+private:
+	void CreateSemaphore(uint64_t initialValue);
+private:
+	const Device& m_Device;
+};
+
+#pragma endregion
+
 #pragma region Fence
 
 struct FenceDescription
@@ -42,6 +63,9 @@ public:
 
 	void Wait(uint64_t timeout);
 	void Reset();
+
+	// Non-blocking
+	bool IsSignaled() const;
 private:
 	void CreateFence(const FenceDescription& desc);
 private:
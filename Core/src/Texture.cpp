@@ -6,6 +6,12 @@
 #include "Buffer.h"
 #include "GBuffer.h"
 #include "Sampler.h"
+#include "UploadContext.h"
+#include "JobSystem.h"
+#include "MipGenerator.h"
+#include "TextureCache.h"
+#include "TextureCompressor.h"
+#include "TextureStreamer.h"
 
 #include "Log.h"
 
@@ -16,107 +22,338 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
+#include <atomic>
 #include <span>
+#include <cstring>
+#include <utility>
 
-static uint8_t* LoadFromFile(const std::string_view filename, uint32_t& width, uint32_t& height, uint32_t& channels)
+struct PendingTexture
 {
-	if (filename.empty())
-		return nullptr;
+	std::span<const std::string_view> Paths;
 
-	uint8_t* data = nullptr;
+	TextureDescription Description;
+	// Null if probing failed or the texture is still to be processed
+	Scope<GBuffer> StagingBuffer;
 
-	data = (uint8_t*)stbi_load(filename.data(), (int*)&width, (int*)&height, (int*)&channels, STBI_rgb_alpha);
+	// Textures with CPU mips or compression only, either the cache hit or the decoded pixels to process
+	Scope<TextureCache> Cache;
+	std::vector<uint8_t> Pixels;
+	MipChain Chain;
+	// Empty unless the mip chain comes with the data
+	std::vector<uint64_t> LevelOffsets;
 
-	if (!data)
-		LOG("Failed to load texture image, %s not found", filename.data());
+	// Set by the decode jobs when an image fails to decode after a successful probe
+	std::atomic<bool> DecodeFailed = false;
 
-	return data;
-}
+	bool IsValid() const { return StagingBuffer || !Pixels.empty(); }
+};
 
-template<typename T>
-static Ref<T> TryCreate(const std::span<const std::string_view> paths)
+static uint64_t GetImageSize(const TextureDescription& desc)
 {
-	if (paths.empty())
-		return nullptr;
-
-	const uint32_t imageCount = static_cast<uint32_t>(paths.size());
-
-	uint32_t width = 0, height = 0, channels = 0;
-	int32_t curWidth = -1, curHeight = -1, curChannels = -1;
+	return FormatImageSize(desc.Format, desc.Width, desc.Height);
+}
 
-	for (uint32_t i = 0; i < imageCount; i++)
+// Only the headers are read, the pixels are decoded once, in DecodeImages()
+static bool ProbeImages(const std::span<const std::string_view> paths, TextureDescription& desc)
+{
+	for (uint32_t i = 0; i < paths.size(); i++)
 	{
 		const auto& path = paths[i];
 
-		// Don't care about the actual image just yet, only for the image metadata
-		uint8_t* data = LoadFromFile(path, width, height, channels);
+		int width = 0, height = 0, channels = 0;
 
-		stbi_image_free(data);
+		if (path.empty() || !stbi_info(path.data(), &width, &height, &channels))
+		{
+			LOG("Failed to load texture image, %s not found", path.data());
+			return false;
+		}
 
-		if (i == 0)
+		if (0 == i)
 		{
-			curWidth = width;
-			curHeight = height;
-			curChannels = channels;
+			desc.Width = static_cast<uint32_t>(width);
+			desc.Height = static_cast<uint32_t>(height);
 		}
-		else
+		else if (desc.Width != static_cast<uint32_t>(width) || desc.Height != static_cast<uint32_t>(height))
 		{
-			ASSERT(!((curWidth != width) || (curHeight != height) || (curChannels != channels)), "All images must have the same size");
+			LOG("Failed to load texture image, %s is (%ix%i), the first image is (%ix%i), all images must have the same size",
+				path.data(), width, height, desc.Width, desc.Height);
+			return false;
 		}
 	}
 
-	ASSERT((width != 0) || (height != 0) || (channels != 0));
+	ASSERT(desc.Width != 0 && desc.Height != 0);
 
-	// R8G8B8 isn't supported by Vulkan?
-	if (3 == channels)
-		channels = 4;
+	desc.ImageCount = static_cast<uint32_t>(paths.size());
+	// Always decoded as RGBA, R8G8B8 isn't supported by Vulkan?
+	desc.Format = FormatBytesPerPixel(4);
 
-	TextureDescription desc;
+	return true;
+}
 
-	desc.Width = width;
-	desc.Height = height;
-	desc.ImageCount = imageCount;
-	desc.Format = FormatBytesPerPixel(channels);
+// Mips built on the CPU and/or compression, the result is cached when the texture comes from a single file
+static bool NeedsProcessing(const TextureDescription& desc)
+{
+	return desc.Streamed || TextureCompression::NONE != desc.Compression || (desc.GenerateMipLevels && MipGeneration::CPU == desc.MipGeneration);
+}
 
-	const uint64_t imageSize = width * height * channels;
-	const uint64_t totalImagesSize = imageSize * imageCount;
+static uint32_t GetLevelCount(const TextureDescription& desc)
+{
+	return desc.GenerateMipLevels ? MipGenerator::GetLevelCount(desc.Width, desc.Height) : 1;
+}
+
+// Cached textures skip decoding and probing altogether
+static bool OpenCache(PendingTexture& texture)
+{
+	auto& desc = texture.Description;
 
-	Buffer buffer;
-	buffer.Allocate(totalImagesSize);
+	const Format format = (TextureCompression::NONE != desc.Compression) ? TextureCompressor::GetFormat(desc.Compression) : FormatBytesPerPixel(4);
 
-	for (uint32_t i = 0; i < imageCount; i++)
+	auto cache = TextureCache::Open(texture.Paths.front(), format, desc.MipFilter);
+
+	if (!cache)
+		return false;
+
+	desc.Width = cache->GetWidth();
+	desc.Height = cache->GetHeight();
+	desc.ImageCount = 1;
+	desc.Format = cache->GetFormat();
+
+	// Stored without mips, but they're wanted now
+	const uint32_t levelCount = GetLevelCount(desc);
+
+	if (cache->GetLevelCount() < levelCount)
+		return false;
+
+	texture.LevelOffsets.assign(cache->GetLevelOffsets().begin(), cache->GetLevelOffsets().begin() + levelCount);
+	texture.Cache = std::move(cache);
+
+	// Streamed textures upload straight from the mapping, see StreamedTexture
+	if (!desc.Streamed)
+		texture.StagingBuffer = GBuffer::CreateStaging(texture.Cache->GetData().size());
+
+	return true;
+}
+
+// One job per image, across all textures, each writes its own slice of the mapped staging memory
+// Textures to be processed are decoded to Pixels instead
+static void DecodeImages(std::span<PendingTexture> textures)
+{
+	std::vector<std::pair<PendingTexture*, uint32_t>> images;
+
+	for (auto& texture : textures)
 	{
-		const auto& path = paths[i];
+		if (!texture.IsValid())
+			continue;
 
-		uint8_t* data = LoadFromFile(path, width, height, channels);
+		for (uint32_t i = 0; i < texture.Paths.size(); i++)
+			images.emplace_back(&texture, i);
+	}
 
-		if (data)
+	JobSystem::ParallelFor(static_cast<uint32_t>(images.size()), 1, [&images](uint32_t i)
 		{
-			buffer.Write(data, imageSize, imageSize * i);
+			const auto& [texture, imageIndex] = images[i];
+
+			const auto& path = texture->Paths[imageIndex];
+			const auto& desc = texture->Description;
+
+			if (texture->Cache)
+			{
+				const auto data = texture->Cache->GetData();
+				std::memcpy(texture->StagingBuffer->GetMappedSpan().data(), data.data(), data.size());
+
+				LOG("Loaded %s from cache, size: (%ix%i), levels: %i", QUOTED(path), desc.Width, desc.Height, texture->Cache->GetLevelCount());
+				return;
+			}
+
+			int width = 0, height = 0, channels = 0;
+			stbi_uc* data = stbi_load(path.data(), &width, &height, &channels, STBI_rgb_alpha);
+
+			if (!data || desc.Width != static_cast<uint32_t>(width) || desc.Height != static_cast<uint32_t>(height))
+			{
+				LOG("Failed to decode %s", QUOTED(path));
+				texture->DecodeFailed = true;
+
+				stbi_image_free(data);
+				return;
+			}
+
+			const uint64_t imageSize = GetImageSize(desc);
+			std::byte* dst = texture->Pixels.empty() ? texture->StagingBuffer->GetMappedSpan().data() : reinterpret_cast<std::byte*>(texture->Pixels.data());
+
+			std::memcpy(dst + imageSize * imageIndex, data, static_cast<size_t>(imageSize));
 
 			stbi_image_free(data);
 
 			LOG("Loaded %s, size: (%ix%i), channels: %i", QUOTED(path), width, height, channels);
+		});
+
+	for (auto& texture : textures)
+	{
+		// Partly written, it's neither uploaded nor processed and cached
+		if (texture.DecodeFailed)
+		{
+			texture.StagingBuffer.reset();
+			texture.Pixels = {};
+
+			continue;
 		}
+
+		if (texture.StagingBuffer)
+			texture.StagingBuffer->Flush();
 	}
+}
+
+// First load only, the result is cached next to the source
+// A job per texture, MipGenerator and TextureCompressor split their rows across the workers too
+static void ProcessImages(std::span<PendingTexture> textures)
+{
+	std::vector<PendingTexture*> pending;
 
-	Ref<T> texture = T::Create(desc, buffer);
+	for (auto& texture : textures)
+	{
+		if (!texture.Pixels.empty())
+			pending.emplace_back(&texture);
+	}
 
-	buffer.Release();
+	JobSystem::ParallelFor(static_cast<uint32_t>(pending.size()), 1, [&pending](uint32_t i)
+		{
+			auto& texture = *pending[i];
+			auto& desc = texture.Description;
+
+			// Linear data, e.g. normal maps, mustn't be filtered through the sRGB curve
+			const bool isLinear = TextureCompression::NONE != desc.Compression && !IsSRGB(TextureCompressor::GetFormat(desc.Compression));
+			const Format format = isLinear ? Format::RGBA_8_UNORM : desc.Format;
+
+			texture.Chain = MipGenerator::Generate(texture.Pixels.data(), desc.Width, desc.Height, desc.ImageCount, format, desc.MipFilter, GetLevelCount(desc));
+			texture.Pixels = {};
+
+			if (TextureCompression::NONE != desc.Compression)
+				texture.Chain = TextureCompressor::Compress(texture.Chain, desc.Compression);
+
+			if (1 == texture.Paths.size())
+				TextureCache::Write(texture.Paths.front(), texture.Chain, desc.MipFilter);
+		});
+
+	for (auto* texture : pending)
+	{
+		auto& chain = texture->Chain;
+
+		texture->Description.Format = chain.Format;
+		texture->LevelOffsets = chain.LevelOffsets;
+
+		// Streamed from what was just written, or loaded whole if that failed
+		if (texture->Description.Streamed)
+		{
+			texture->Cache = TextureCache::Open(texture->Paths.front(), chain.Format, texture->Description.MipFilter);
 
-	return texture;
+			if (texture->Cache)
+			{
+				chain = {};
+				continue;
+			}
+
+			texture->Description.Streamed = false;
+		}
+
+		texture->StagingBuffer = GBuffer::CreateStaging(chain.Data.size());
+		texture->StagingBuffer->SetData(chain.Data.data(), chain.Data.size());
+
+		chain = {};
+	}
 }
 
-Ref<Texture> Texture::Create(const std::string_view path)
+// Each element of textures is the list of images of one texture, only single image ones get compressed or streamed
+template<typename T>
+static std::vector<Ref<Texture>> TryCreate(const std::span<const std::span<const std::string_view>> textures, TextureDescription description, UploadContext* context = nullptr)
 {
-	std::array<std::string_view, 1> paths = { path };
+	if (TextureCompression::NONE != description.Compression && !Context::GetDevice().IsTextureCompressionBCEnabled())
+	{
+		LOG("BC texture compression isn't supported, loading uncompressed");
+		description.Compression = TextureCompression::NONE;
+	}
+
+	std::vector<PendingTexture> pending(textures.size());
+
+	for (size_t i = 0; i < textures.size(); i++)
+	{
+		auto& texture = pending[i];
+		auto& desc = texture.Description;
+
+		texture.Paths = textures[i];
+		desc = description;
+
+		if (texture.Paths.empty())
+			continue;
+
+		if (texture.Paths.size() > 1)
+		{
+			desc.Compression = TextureCompression::NONE;
+			desc.Streamed = false;
+		}
+
+		if (desc.Streamed)
+			desc.GenerateMipLevels = true;
+
+		if (1 == texture.Paths.size() && NeedsProcessing(desc) && OpenCache(texture))
+			continue;
 
-	return TryCreate<Texture2D>(paths);
+		if (!ProbeImages(texture.Paths, desc))
+			continue;
+
+		if (NeedsProcessing(desc))
+			texture.Pixels.resize(GetImageSize(desc) * desc.ImageCount);
+		else
+			texture.StagingBuffer = GBuffer::CreateStaging(GetImageSize(desc) * desc.ImageCount);
+	}
+
+	DecodeImages(pending);
+	ProcessImages(pending);
+
+	std::vector<Ref<Texture>> result;
+	result.reserve(pending.size());
+
+	for (auto& texture : pending)
+	{
+		if (texture.Description.Streamed && texture.Cache)
+			result.emplace_back(StreamedTexture::Create(texture.Description, std::move(texture.Cache), texture.Paths.front(), context));
+		else if (texture.StagingBuffer)
+			result.emplace_back(T::Create(texture.Description, std::move(texture.StagingBuffer), texture.LevelOffsets, context));
+		else
+			result.emplace_back(nullptr);
+	}
+
+	return result;
 }
 
-Ref<Texture> Texture::Create(const std::array<std::string_view, s_MaxImageCount>& paths)
+Ref<Texture> Texture::Create(const std::string_view path, const TextureDescription& desc)
 {
-	return TryCreate<TextureCube>(paths);
+	const std::array<std::span<const std::string_view>, 1> textures = { std::span(&path, 1) };
+
+	return TryCreate<Texture2D>(textures, desc).front();
+}
+
+Ref<Texture> Texture::Create(const std::array<std::string_view, s_MaxImageCount>& paths, const TextureDescription& desc)
+{
+	const std::array<std::span<const std::string_view>, 1> textures = { std::span(paths) };
+
+	return TryCreate<TextureCube>(textures, desc).front();
+}
+
+std::vector<Ref<Texture>> Texture::CreateBatch(const std::span<const std::string_view> paths, const TextureDescription& desc)
+{
+	std::vector<std::span<const std::string_view>> textures;
+	textures.reserve(paths.size());
+
+	for (const auto& path : paths)
+		textures.emplace_back(&path, 1);
+
+	UploadContext context;
+
+	auto created = TryCreate<Texture2D>(textures, desc, &context);
+
+	context.Flush();
+
+	return created;
 }
 
 template<>
@@ -175,10 +412,25 @@ const TextureDescription& Texture::GetDescription() const
 	return m_Description;
 }
 
-void Texture::CreateTexture(const Buffer& buffer)
+uint32_t Texture::GetMipLevels() const
+{
+	return m_MipLevels;
+}
+
+void Texture::CreateTexture(const Buffer& buffer, UploadContext* context)
 {
 	ASSERT(buffer);
 
+	Scope<GBuffer> stagingBuffer = GBuffer::CreateStaging(buffer.GetSize());
+	stagingBuffer->SetData(buffer.As<const uint8_t*>());
+
+	CreateTexture(std::move(stagingBuffer), {}, context);
+}
+
+void Texture::CreateTexture(Scope<GBuffer>&& stagingBuffer, std::span<const uint64_t> levelOffsets, UploadContext* context)
+{
+	ASSERT(stagingBuffer);
+
 	const uint32_t width = m_Description.Width;
 	const uint32_t height = m_Description.Height;
 	const uint32_t imageCount = m_Description.ImageCount;
@@ -186,17 +438,47 @@ void Texture::CreateTexture(const Buffer& buffer)
 	ASSERT(width != 0 && height != 0);
 	ASSERT(imageCount > 0 && imageCount <= s_MaxImageCount);
 
-	const uint64_t imageSize = width * height * FormatBytesPerPixel(m_Description.Format);
+	const uint64_t imageSize = FormatImageSize(m_Description.Format, width, height);
 	const uint64_t totalImagesSize = imageSize * imageCount;
-	ASSERT(buffer.GetSize() == totalImagesSize);
+	ASSERT(levelOffsets.empty() ? stagingBuffer->GetDescription().Size == totalImagesSize : stagingBuffer->GetDescription().Size >= totalImagesSize);
 
-	Scope<GBuffer> stagingBuffer = GBuffer::CreateStaging(buffer.GetSize());
+	// Block compressed formats can't be blitted, their mips have to come with the data
+	ASSERT(!levelOffsets.empty() || !IsBlockCompressed(m_Description.Format) || !m_Description.GenerateMipLevels, "Compressed textures need precomputed mip levels");
+
+	// The vkCmdBlitImage chain needs linear filtering, without it the mips are built on the CPU
+	MipChain chain;
+
+	if (levelOffsets.empty() && m_Description.GenerateMipLevels &&
+		!Context::GetDevice().GetPhysicalDevice().HasFormatFeatures(Convert(m_Description.Format), VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT))
+	{
+		if (FormatBytesPerPixel(m_Description.Format) == 4)
+		{
+			const auto pixels = stagingBuffer->GetMappedSpan();
+
+			chain = MipGenerator::Generate(reinterpret_cast<const uint8_t*>(pixels.data()), width, height, imageCount, m_Description.Format, m_Description.MipFilter, GenerateMips());
+
+			stagingBuffer = GBuffer::CreateStaging(chain.Data.size());
+			stagingBuffer->SetData(chain.Data.data(), chain.Data.size());
+
+			levelOffsets = chain.LevelOffsets;
+		}
+		else
+		{
+			LOG("Format doesn't support linear blitting and MipGenerator only takes RGBA8, loading without mips");
+			m_Description.GenerateMipLevels = false;
+		}
+	}
+
+	if (levelOffsets.empty())
+		m_MipLevels = m_Description.GenerateMipLevels ? GenerateMips() : 1;
+	else
+		m_MipLevels = static_cast<uint32_t>(levelOffsets.size());
 
 	ImageDescription desc;
 
 	desc.Width = width;
 	desc.Height = height;
-	desc.MipLevels = m_Description.GenerateMipLevels ? GenerateMips() : 1;
+	desc.MipLevels = m_MipLevels;
 	desc.ImageCount = imageCount;
 	desc.MSAAnumSamples = 1;
 	desc.Format = m_Description.Format;
@@ -208,40 +490,57 @@ void Texture::CreateTexture(const Buffer& buffer)
 	{
 		desc.ImageCreateFlags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
 		desc.ViewType = VK_IMAGE_VIEW_TYPE_CUBE;
-
-		// Technically the else case works for this one too
-		// Just a different approach
-		for (uint32_t i = 0; i < imageCount; i++)
-		{
-			const uint64_t offset = imageSize * i;
-			stagingBuffer->SetData(&buffer[offset], imageSize, offset);
-		}
 	}
 	else
 	{
 		desc.ImageCreateFlags = 0;
 		desc.ViewType = VK_IMAGE_VIEW_TYPE_2D;
-
-		stagingBuffer->SetData(buffer.As<const uint8_t*>());
 	}
 
 	m_Image = Image2D::Create(desc);
 
-	m_Image->TransitionImageLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-	m_Image->CopyFrom(*stagingBuffer);
+	Scope<UploadContext> localContext;
+
+	if (!context)
+	{
+		localContext = CreateScope<UploadContext>();
+		context = localContext.get();
+	}
+
+	auto& commandBuffer = context->GetCommandBuffer();
+
+	m_Image->TransitionImageLayout(commandBuffer, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_UNDEFINED);
+	if (levelOffsets.empty())
+		m_Image->CopyFrom(commandBuffer, *stagingBuffer);
+	else
+		m_Image->CopyFrom(commandBuffer, *stagingBuffer, levelOffsets);
+
+	context->KeepAlive(std::move(stagingBuffer));
+
+	if (localContext)
+		localContext->Flush();
 }
 
 void Texture::CreateSampler()
 {
 	SamplerDescription desc;
 
-	desc.MipLevels = Texture::GetDescription().GenerateMipLevels ? GenerateMips() : 1;
+	desc.MipLevels = m_MipLevels;
 	desc.MagFilter = Filter::NEAREST;
 	desc.MinFilter = Filter::NEAREST;
 
 	m_Sampler = Sampler::Create(desc);
 }
 
+Ref<Image2D> Texture::SetImage(const Ref<Image2D>& image, uint32_t mipLevels)
+{
+	ASSERT(image);
+
+	m_MipLevels = mipLevels;
+
+	return std::exchange(m_Image, image);
+}
+
 const Image2D& Texture::GetImage() const
 {
 	ASSERT(m_Image);
@@ -254,29 +553,57 @@ const Ref<Sampler> Texture::GetSampler() const
 	return m_Sampler;
 }
 
-Ref<Texture2D> Texture2D::Create(const TextureDescription& desc, const Buffer& buffer)
+Ref<Texture2D> Texture2D::Create(const TextureDescription& desc, const Buffer& buffer, UploadContext* context)
 {
-	return CreateRef<Texture2D>(desc, buffer);
+	return CreateRef<Texture2D>(desc, buffer, context);
 }
 
-Texture2D::Texture2D(const TextureDescription& desc, const Buffer& buffer)
+Ref<Texture2D> Texture2D::Create(const TextureDescription& desc, Scope<GBuffer>&& stagingBuffer, std::span<const uint64_t> levelOffsets, UploadContext* context)
+{
+	return CreateRef<Texture2D>(desc, std::move(stagingBuffer), levelOffsets, context);
+}
+
+Texture2D::Texture2D(const TextureDescription& desc, const Buffer& buffer, UploadContext* context)
+	: Texture(TextureType::TEXTURE2D, desc)
+{
+	CreateTexture(buffer, context);
+
+	if (desc.CreateSampler)
+		CreateSampler();
+}
+
+Texture2D::Texture2D(const TextureDescription& desc, Scope<GBuffer>&& stagingBuffer, std::span<const uint64_t> levelOffsets, UploadContext* context)
 	: Texture(TextureType::TEXTURE2D, desc)
 {
-	CreateTexture(buffer);
+	CreateTexture(std::move(stagingBuffer), levelOffsets, context);
 
 	if (desc.CreateSampler)
 		CreateSampler();
 }
 
-Ref<TextureCube> TextureCube::Create(const TextureDescription& desc, const Buffer& buffer)
+Ref<TextureCube> TextureCube::Create(const TextureDescription& desc, const Buffer& buffer, UploadContext* context)
 {
-	return CreateRef<TextureCube>(desc, buffer);
+	return CreateRef<TextureCube>(desc, buffer, context);
+}
+
+Ref<TextureCube> TextureCube::Create(const TextureDescription& desc, Scope<GBuffer>&& stagingBuffer, std::span<const uint64_t> levelOffsets, UploadContext* context)
+{
+	return CreateRef<TextureCube>(desc, std::move(stagingBuffer), levelOffsets, context);
+}
+
+TextureCube::TextureCube(const TextureDescription& desc, const Buffer& buffer, UploadContext* context)
+	: Texture(TextureType::CUBE, desc)
+{
+	CreateTexture(buffer, context);
+
+	if (desc.CreateSampler)
+		CreateSampler();
 }
 
-TextureCube::TextureCube(const TextureDescription& desc, const Buffer& buffer)
+TextureCube::TextureCube(const TextureDescription& desc, Scope<GBuffer>&& stagingBuffer, std::span<const uint64_t> levelOffsets, UploadContext* context)
 	: Texture(TextureType::CUBE, desc)
 {
-	CreateTexture(buffer);
+	CreateTexture(std::move(stagingBuffer), levelOffsets, context);
 
 	if (desc.CreateSampler)
 		CreateSampler();
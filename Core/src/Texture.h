@@ -8,6 +8,8 @@
 
 #include <string_view>
 #include <array>
+#include <vector>
+#include <span>
 
 struct TextureDescription
 {
@@ -16,6 +18,16 @@ struct TextureDescription
 	uint32_t ImageCount = 0;
 
 	bool GenerateMipLevels = true;
+	// CPU mips are cached with single image textures, compressed and streamed textures always get them on the CPU
+	MipGeneration MipGeneration = MipGeneration::GPU;
+	// CPU mips only
+	MipFilter MipFilter = MipFilter::KAISER;
+	// Only for single image textures loaded from file
+	TextureCompression Compression = TextureCompression::NONE;
+	// Same, only the smallest mips are uploaded at first, the TextureStreamer brings in the rest on demand
+	// Always goes through the TextureCache, the mips are built on the CPU
+	bool Streamed = false;
+
 	bool CreateSampler = true;
 	Format Format = Format::UNDEFINED;
 };
@@ -23,6 +35,8 @@ struct TextureDescription
 class Image2D;
 class Sampler;
 class Buffer;
+class GBuffer;
+class UploadContext;
 
 // TODO: Rework Texture, Texture2D, TextureCube classes <- Better now?
 
@@ -31,8 +45,14 @@ class Texture
 public:
 	static constexpr size_t s_MaxImageCount = 6;
 
-	static Ref<Texture> Create(const std::string_view path);
-	static Ref<Texture> Create(const std::array<std::string_view, s_MaxImageCount>& paths);
+	// Images are probed by their header and then decoded in parallel, straight into the staging buffer
+	// Size, image count and format come from the file(s), everything else from desc
+	// CPU mips and compression are done on the first load, single image textures are then cached as <file>.texcache
+	static Ref<Texture> Create(const std::string_view path, const TextureDescription& desc = {});
+	static Ref<Texture> Create(const std::array<std::string_view, s_MaxImageCount>& paths, const TextureDescription& desc = {});
+	// All uploads are recorded into one command buffer and waited on with a single fence
+	// Every image of the batch is decoded in parallel, a texture that fails to load is nullptr
+	static std::vector<Ref<Texture>> CreateBatch(const std::span<const std::string_view> paths, const TextureDescription& desc = {});
 
 	template<TextureType Type>
 	static Ref<Texture> White();
@@ -42,17 +62,25 @@ public:
 
 	TextureType GetType() const;
 	uint32_t GenerateMips();
+	uint32_t GetMipLevels() const;
 
 	const Image2D& GetImage() const;
 	const Ref<Sampler> GetSampler() const;
 
 	const TextureDescription& GetDescription() const;
 protected:
-	void CreateTexture(const Buffer& buffer);
+	// Submits and waits on its own if context is nullptr
+	void CreateTexture(const Buffer& buffer, UploadContext* context);
+	// stagingBuffer holds the images back to back, it's kept alive by the context
+	// levelOffsets is where each precomputed mip level starts in it, if empty the mips are generated on the GPU
+	void CreateTexture(Scope<GBuffer>&& stagingBuffer, std::span<const uint64_t> levelOffsets, UploadContext* context);
 	void CreateSampler();
+	// mipLevels is the texture's, the image can hold fewer of them (see StreamedTexture), returns the previous image
+	Ref<Image2D> SetImage(const Ref<Image2D>& image, uint32_t mipLevels);
 private:
 	TextureDescription m_Description;
 	TextureType m_Type;
+	uint32_t m_MipLevels = 1;
 
 	Ref<Image2D> m_Image;
 	Ref<Sampler> m_Sampler;
@@ -61,17 +89,21 @@ private:
 class Texture2D : public Texture
 {
 public:
-	static Ref<Texture2D> Create(const TextureDescription& desc, const Buffer& buffer);
+	static Ref<Texture2D> Create(const TextureDescription& desc, const Buffer& buffer, UploadContext* context = nullptr);
+	static Ref<Texture2D> Create(const TextureDescription& desc, Scope<GBuffer>&& stagingBuffer, std::span<const uint64_t> levelOffsets = {}, UploadContext* context = nullptr);
 
-	Texture2D(const TextureDescription& desc, const Buffer& buffer);
+	Texture2D(const TextureDescription& desc, const Buffer& buffer, UploadContext* context = nullptr);
+	Texture2D(const TextureDescription& desc, Scope<GBuffer>&& stagingBuffer, std::span<const uint64_t> levelOffsets = {}, UploadContext* context = nullptr);
 	~Texture2D() = default;
 };
 
 class TextureCube : public Texture
 {
 public:
-	static Ref<TextureCube> Create(const TextureDescription& desc, const Buffer& buffer);
+	static Ref<TextureCube> Create(const TextureDescription& desc, const Buffer& buffer, UploadContext* context = nullptr);
+	static Ref<TextureCube> Create(const TextureDescription& desc, Scope<GBuffer>&& stagingBuffer, std::span<const uint64_t> levelOffsets = {}, UploadContext* context = nullptr);
 
-	TextureCube(const TextureDescription& desc, const Buffer& buffer);
+	TextureCube(const TextureDescription& desc, const Buffer& buffer, UploadContext* context = nullptr);
+	TextureCube(const TextureDescription& desc, Scope<GBuffer>&& stagingBuffer, std::span<const uint64_t> levelOffsets = {}, UploadContext* context = nullptr);
 	~TextureCube() = default;
 };
\ No newline at end of file
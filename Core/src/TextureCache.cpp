@@ -0,0 +1,275 @@
+#include "TextureCache.h"
+
+#include "MipGenerator.h"
+#include "MappedFile.h"
+#include "FileStream.h"
+#include "Utils.h"
+
+#include "Log.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+
+static constexpr const char* s_LogTag = "[TextureCache]";
+
+static constexpr uint32_t s_Magic = 0x43584554; // "TEXC"
+// Bump whenever the layout, an encoder or the mip filtering changes
+static constexpr uint32_t s_Version = 3;
+static constexpr uint64_t s_BlockAlignment = 16;
+
+struct TextureCacheHeader
+{
+	uint32_t Magic = s_Magic;
+	uint32_t Version = s_Version;
+
+	int32_t Format = 0;
+	// The generation parameters, another filter asked for is a miss
+	int32_t MipFilter = 0;
+
+	uint32_t Width = 0;
+	uint32_t Height = 0;
+	uint32_t LevelCount = 0;
+	uint32_t Padding = 0;
+
+	// Level index, offsets are relative to DataOffset
+	uint64_t LevelOffsets[TextureCache::s_MaxLevelCount] = {};
+
+	uint64_t DataOffset = 0;
+	uint64_t DataSize = 0;
+
+	// Same checks as the MeshCache
+	uint64_t SourceSize = 0;
+	int64_t SourceTimestamp = 0;
+	uint64_t SourceHash = 0;
+};
+
+static_assert(std::is_trivially_copyable_v<TextureCacheHeader>);
+
+static uint64_t AlignUp(uint64_t value)
+{
+	return (value + s_BlockAlignment - 1) & ~(s_BlockAlignment - 1);
+}
+
+static bool IsValid(const TextureCacheHeader& header, size_t fileSize)
+{
+	if (header.Magic != s_Magic || header.Version != s_Version)
+		return false;
+
+	if (0 == header.Width || 0 == header.Height || 0 == header.LevelCount || header.LevelCount > TextureCache::s_MaxLevelCount)
+		return false;
+
+	if (header.DataOffset % s_BlockAlignment != 0 || header.DataOffset < sizeof(TextureCacheHeader) || header.DataOffset + header.DataSize > fileSize)
+		return false;
+
+	const Format format = static_cast<Format>(header.Format);
+
+	for (uint32_t level = 0; level < header.LevelCount; level++)
+	{
+		const uint64_t levelSize = FormatImageSize(format, std::max(header.Width >> level, 1u), std::max(header.Height >> level, 1u));
+
+		if (header.LevelOffsets[level] + levelSize > header.DataSize)
+			return false;
+	}
+
+	return true;
+}
+
+// Read before the file is mapped, the timestamp in it may have to be rewritten
+static bool ReadHeader(const std::filesystem::path& cachePath, TextureCacheHeader& header, size_t& fileSize)
+{
+	FileStreamReader stream(cachePath);
+
+	if (!stream.IsStreamGood())
+		return false;
+
+	fileSize = stream.GetFileSize();
+
+	if (fileSize < sizeof(TextureCacheHeader))
+		return false;
+
+	stream.Read(header);
+
+	return stream.IsStreamGood();
+}
+
+// Same as the MeshCache, a touched but unchanged source isn't rehashed on every launch
+static void RewriteTimestamp(const std::filesystem::path& cachePath, int64_t timestamp)
+{
+	std::fstream stream(cachePath, std::ios::in | std::ios::out | std::ios::binary);
+
+	if (stream)
+	{
+		stream.seekp(offsetof(TextureCacheHeader, SourceTimestamp));
+		stream.write(reinterpret_cast<const char*>(&timestamp), sizeof(timestamp));
+	}
+
+	if (!stream)
+		LOG_TAGGED(s_LogTag, "Failed to update %s", cachePath.string().data());
+}
+
+std::filesystem::path TextureCache::GetCachePath(const std::filesystem::path& source)
+{
+	auto path = source;
+	path += ".texcache";
+
+	return path;
+}
+
+Scope<TextureCache> TextureCache::Open(const std::filesystem::path& source, Format format, MipFilter filter)
+{
+	const auto cachePath = GetCachePath(source);
+
+	std::error_code error;
+	if (!std::filesystem::exists(cachePath, error))
+		return nullptr;
+
+	const uint64_t sourceSize = static_cast<uint64_t>(std::filesystem::file_size(source, error));
+	if (error)
+		return nullptr;
+
+	TextureCacheHeader header;
+	size_t fileSize = 0;
+
+	if (!ReadHeader(cachePath, header, fileSize))
+		return nullptr;
+
+	// Asked for another compression, it will be re-encoded and overwritten
+	// Checked first, the level sizes below depend on the format
+	if (header.Format != static_cast<int32_t>(format))
+		return nullptr;
+
+	// Same, filtered again and overwritten
+	if (header.MipFilter != static_cast<int32_t>(filter))
+		return nullptr;
+
+	if (!IsValid(header, fileSize))
+	{
+		LOG_TAGGED(s_LogTag, "Discarding invalid cache %s", cachePath.string().data());
+		return nullptr;
+	}
+
+	if (header.SourceSize != sourceSize)
+		return nullptr;
+
+	if (const int64_t sourceTimestamp = GetFileTimestamp(source); header.SourceTimestamp != sourceTimestamp)
+	{
+		if (header.SourceHash != HashFile(source))
+		{
+			LOG_TAGGED(s_LogTag, "Stale cache %s", cachePath.string().data());
+			return nullptr;
+		}
+
+		RewriteTimestamp(cachePath, sourceTimestamp);
+	}
+
+	auto file = MappedFile::Create(cachePath);
+	if (!file || file->GetSize() != fileSize)
+		return nullptr;
+
+	const std::span<const std::byte> data(file->GetData() + header.DataOffset, header.DataSize);
+	const std::span<const uint64_t> levelOffsets(header.LevelOffsets, header.LevelCount);
+
+	return CreateScope<TextureCache>(std::move(file), format, header.Width, header.Height, levelOffsets, data);
+}
+
+bool TextureCache::Write(const std::filesystem::path& source, const MipChain& chain, MipFilter filter)
+{
+	ASSERT(chain.GetLevelCount() > 0 && chain.GetLevelCount() <= s_MaxLevelCount);
+	ASSERT(1 == chain.LayerCount);
+
+	std::error_code error;
+	const uint64_t sourceSize = static_cast<uint64_t>(std::filesystem::file_size(source, error));
+	if (error)
+		return false;
+
+	TextureCacheHeader header;
+	header.Format = static_cast<int32_t>(chain.Format);
+	header.MipFilter = static_cast<int32_t>(filter);
+	header.Width = chain.Width;
+	header.Height = chain.Height;
+	header.LevelCount = chain.GetLevelCount();
+
+	std::memcpy(header.LevelOffsets, chain.LevelOffsets.data(), chain.LevelOffsets.size() * sizeof(uint64_t));
+
+	header.DataOffset = AlignUp(sizeof(TextureCacheHeader));
+	header.DataSize = chain.Data.size();
+
+	header.SourceSize = sourceSize;
+	header.SourceTimestamp = GetFileTimestamp(source);
+	header.SourceHash = HashFile(source);
+
+	const auto cachePath = GetCachePath(source);
+
+	auto tempPath = cachePath;
+	tempPath += ".tmp";
+
+	{
+		FileStreamWriter stream(tempPath);
+
+		if (!stream.IsStreamGood())
+		{
+			LOG_TAGGED(s_LogTag, "Failed to open %s", tempPath.string().data());
+			return false;
+		}
+
+		static constexpr std::array<char, s_BlockAlignment> padding = {};
+
+		stream.Write(header);
+		stream.Write(padding.data(), header.DataOffset - sizeof(TextureCacheHeader));
+
+		stream.Write(reinterpret_cast<const char*>(chain.Data.data()), chain.Data.size());
+	}
+
+	std::filesystem::rename(tempPath, cachePath, error);
+
+	if (error)
+	{
+		LOG_TAGGED(s_LogTag, "Failed to write %s", cachePath.string().data());
+		return false;
+	}
+
+	return true;
+}
+
+TextureCache::TextureCache(Scope<MappedFile>&& file, Format format, uint32_t width, uint32_t height, std::span<const uint64_t> levelOffsets, std::span<const std::byte> data)
+	: m_File(std::move(file)), m_Format(format), m_Width(width), m_Height(height), m_LevelOffsets(levelOffsets.begin(), levelOffsets.end()), m_Data(data)
+{
+}
+
+TextureCache::~TextureCache()
+{
+	m_File.reset();
+}
+
+Format TextureCache::GetFormat() const
+{
+	return m_Format;
+}
+
+uint32_t TextureCache::GetWidth() const
+{
+	return m_Width;
+}
+
+uint32_t TextureCache::GetHeight() const
+{
+	return m_Height;
+}
+
+uint32_t TextureCache::GetLevelCount() const
+{
+	return static_cast<uint32_t>(m_LevelOffsets.size());
+}
+
+std::span<const uint64_t> TextureCache::GetLevelOffsets() const
+{
+	return m_LevelOffsets;
+}
+
+std::span<const std::byte> TextureCache::GetData() const
+{
+	return m_Data;
+}
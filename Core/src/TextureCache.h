@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Base.h"
+
+#include "Enums.h"
+
+#include <filesystem>
+#include <span>
+#include <vector>
+
+class MappedFile;
+struct MipChain;
+
+// Texture and its mip chain stored next to its source as <file>.texcache, memory-mapped on later loads
+// Laid out like KTX2: header | level index | levels, smallest level first, blocks are 16-byte aligned
+class TextureCache
+{
+public:
+	// Plenty for 32k x 32k
+	static constexpr uint32_t s_MaxLevelCount = 16;
+
+	static std::filesystem::path GetCachePath(const std::filesystem::path& source);
+
+	// nullptr if there's no cache for source, it's stale or was stored in another format or with another mip filter
+	static Scope<TextureCache> Open(const std::filesystem::path& source, Format format, MipFilter filter);
+	// Single layer only, filter is the one the chain was generated with
+	static bool Write(const std::filesystem::path& source, const MipChain& chain, MipFilter filter);
+
+	TextureCache(Scope<MappedFile>&& file, Format format, uint32_t width, uint32_t height, std::span<const uint64_t> levelOffsets, std::span<const std::byte> data);
+	~TextureCache();
+
+	DELETE_COPY_AND_MOVE(TextureCache);
+
+	Format GetFormat() const;
+	uint32_t GetWidth() const;
+	uint32_t GetHeight() const;
+	uint32_t GetLevelCount() const;
+
+	// Relative to GetData(), same as MipChain::LevelOffsets
+	std::span<const uint64_t> GetLevelOffsets() const;
+	// Every level, points into the mapping, valid as long as the cache is alive
+	std::span<const std::byte> GetData() const;
+private:
+	Scope<MappedFile> m_File;
+
+	Format m_Format;
+	uint32_t m_Width;
+	uint32_t m_Height;
+
+	std::vector<uint64_t> m_LevelOffsets;
+	std::span<const std::byte> m_Data;
+};
@@ -0,0 +1,666 @@
+#include "TextureCompressor.h"
+
+#include "JobSystem.h"
+#include "Timer.h"
+
+#include "Log.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+static constexpr const char* s_LogTag = "[TextureCompressor]";
+
+static constexpr uint32_t s_BlockExtent = 4;
+static constexpr uint32_t s_BlockTexelCount = s_BlockExtent * s_BlockExtent;
+
+// Texels in row-major order, RGBA
+using Block = std::array<std::array<float, 4>, s_BlockTexelCount>;
+
+static Block LoadBlock(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY)
+{
+	Block block;
+
+	for (uint32_t y = 0; y < s_BlockExtent; y++)
+	{
+		const uint32_t sourceY = std::min(blockY * s_BlockExtent + y, height - 1);
+
+		for (uint32_t x = 0; x < s_BlockExtent; x++)
+		{
+			const uint32_t sourceX = std::min(blockX * s_BlockExtent + x, width - 1);
+			const uint8_t* texel = rgba + (static_cast<size_t>(sourceY) * width + sourceX) * 4;
+
+			for (uint32_t c = 0; c < 4; c++)
+				block[y * s_BlockExtent + x][c] = static_cast<float>(texel[c]);
+		}
+	}
+
+	return block;
+}
+
+// Little-endian bit writer, blocks are at most 128 bits
+class BitWriter
+{
+public:
+	void Write(uint64_t value, uint32_t bitCount)
+	{
+		for (uint32_t i = 0; i < bitCount; i++, m_Position++)
+		{
+			const uint64_t bit = (value >> i) & 1;
+			m_Bits[m_Position / 64] |= bit << (m_Position % 64);
+		}
+	}
+
+	void Store(std::byte* dst, size_t size) const
+	{
+		std::memcpy(dst, m_Bits.data(), size);
+	}
+private:
+	std::array<uint64_t, 2> m_Bits = {};
+	uint32_t m_Position = 0;
+};
+
+#pragma region EndpointFitting
+
+// Direction of largest variance of the first channelCount channels, by power iteration on the covariance matrix
+// Texels with mask[i] == false are ignored
+static void ComputePrincipalAxis(const Block& block, uint32_t channelCount, const std::array<bool, s_BlockTexelCount>& mask,
+	std::array<float, 4>& mean, std::array<float, 4>& axis)
+{
+	mean = {};
+	axis = {};
+
+	uint32_t count = 0;
+
+	for (uint32_t i = 0; i < s_BlockTexelCount; i++)
+	{
+		if (!mask[i])
+			continue;
+
+		for (uint32_t c = 0; c < channelCount; c++)
+			mean[c] += block[i][c];
+
+		count++;
+	}
+
+	if (0 == count)
+		return;
+
+	for (uint32_t c = 0; c < channelCount; c++)
+		mean[c] /= static_cast<float>(count);
+
+	float covariance[4][4] = {};
+
+	for (uint32_t i = 0; i < s_BlockTexelCount; i++)
+	{
+		if (!mask[i])
+			continue;
+
+		for (uint32_t a = 0; a < channelCount; a++)
+		{
+			for (uint32_t b = 0; b < channelCount; b++)
+				covariance[a][b] += (block[i][a] - mean[a]) * (block[i][b] - mean[b]);
+		}
+	}
+
+	// Seeded with the diagonal, works for the common case of a mostly gray gradient
+	for (uint32_t c = 0; c < channelCount; c++)
+		axis[c] = 1.0f;
+
+	for (uint32_t iteration = 0; iteration < 8; iteration++)
+	{
+		std::array<float, 4> next = {};
+
+		for (uint32_t a = 0; a < channelCount; a++)
+		{
+			for (uint32_t b = 0; b < channelCount; b++)
+				next[a] += covariance[a][b] * axis[b];
+		}
+
+		float length = 0.0f;
+		for (uint32_t c = 0; c < channelCount; c++)
+			length = std::max(length, std::abs(next[c]));
+
+		// Flat block, any axis will do
+		if (length < 1e-6f)
+			break;
+
+		for (uint32_t c = 0; c < channelCount; c++)
+			axis[c] = next[c] / length;
+	}
+}
+
+// Endpoints at the extremes of the texels projected on the principal axis
+static void FitEndpoints(const Block& block, uint32_t channelCount, const std::array<bool, s_BlockTexelCount>& mask,
+	std::array<float, 4>& low, std::array<float, 4>& high)
+{
+	std::array<float, 4> mean, axis;
+	ComputePrincipalAxis(block, channelCount, mask, mean, axis);
+
+	float minT = 0.0f, maxT = 0.0f;
+
+	float axisLengthSquared = 0.0f;
+	for (uint32_t c = 0; c < channelCount; c++)
+		axisLengthSquared += axis[c] * axis[c];
+
+	if (axisLengthSquared > 0.0f)
+	{
+		minT = std::numeric_limits<float>::max();
+		maxT = std::numeric_limits<float>::lowest();
+
+		for (uint32_t i = 0; i < s_BlockTexelCount; i++)
+		{
+			if (!mask[i])
+				continue;
+
+			float t = 0.0f;
+			for (uint32_t c = 0; c < channelCount; c++)
+				t += (block[i][c] - mean[c]) * axis[c];
+
+			t /= axisLengthSquared;
+
+			minT = std::min(minT, t);
+			maxT = std::max(maxT, t);
+		}
+	}
+
+	for (uint32_t c = 0; c < 4; c++)
+	{
+		low[c] = std::clamp(mean[c] + axis[c] * minT, 0.0f, 255.0f);
+		high[c] = std::clamp(mean[c] + axis[c] * maxT, 0.0f, 255.0f);
+	}
+}
+
+// Least squares fit of both endpoints for the given per-texel weights of high, see "Real-Time DXT Compression" (van Waveren 2006)
+// Returns false if the system is degenerate, e.g. all texels picked the same weight
+static bool RefineEndpoints(const Block& block, uint32_t channelCount, const std::array<bool, s_BlockTexelCount>& mask,
+	const std::array<float, s_BlockTexelCount>& weights, std::array<float, 4>& low, std::array<float, 4>& high)
+{
+	float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+	std::array<float, 4> ax = {}, bx = {};
+
+	for (uint32_t i = 0; i < s_BlockTexelCount; i++)
+	{
+		if (!mask[i])
+			continue;
+
+		const float b = weights[i];
+		const float a = 1.0f - b;
+
+		aa += a * a;
+		ab += a * b;
+		bb += b * b;
+
+		for (uint32_t c = 0; c < channelCount; c++)
+		{
+			ax[c] += a * block[i][c];
+			bx[c] += b * block[i][c];
+		}
+	}
+
+	const float determinant = aa * bb - ab * ab;
+
+	if (std::abs(determinant) < 1e-6f)
+		return false;
+
+	const float inverse = 1.0f / determinant;
+
+	for (uint32_t c = 0; c < channelCount; c++)
+	{
+		low[c] = std::clamp((ax[c] * bb - bx[c] * ab) * inverse, 0.0f, 255.0f);
+		high[c] = std::clamp((bx[c] * aa - ax[c] * ab) * inverse, 0.0f, 255.0f);
+	}
+
+	return true;
+}
+
+#pragma endregion
+
+#pragma region BC1
+
+static uint16_t PackRGB565(const std::array<float, 4>& color)
+{
+	const uint32_t r = static_cast<uint32_t>(color[0] * 31.0f / 255.0f + 0.5f);
+	const uint32_t g = static_cast<uint32_t>(color[1] * 63.0f / 255.0f + 0.5f);
+	const uint32_t b = static_cast<uint32_t>(color[2] * 31.0f / 255.0f + 0.5f);
+
+	return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+static std::array<float, 4> UnpackRGB565(uint16_t color)
+{
+	const uint32_t r = (color >> 11) & 0x1F;
+	const uint32_t g = (color >> 5) & 0x3F;
+	const uint32_t b = color & 0x1F;
+
+	return { static_cast<float>((r << 3) | (r >> 2)), static_cast<float>((g << 2) | (g >> 4)), static_cast<float>((b << 3) | (b >> 2)), 255.0f };
+}
+
+static float ColorDistance(const std::array<float, 4>& lhs, const std::array<float, 4>& rhs, uint32_t channelCount)
+{
+	float distance = 0.0f;
+
+	for (uint32_t c = 0; c < channelCount; c++)
+		distance += (lhs[c] - rhs[c]) * (lhs[c] - rhs[c]);
+
+	return distance;
+}
+
+struct BC1Block
+{
+	uint16_t Color0 = 0;
+	uint16_t Color1 = 0;
+	uint32_t Indices = 0;
+
+	float Error = 0.0f;
+};
+
+// Color0 > Color1 selects the 4 color mode, otherwise the 3 color + transparent black one
+static BC1Block EncodeBC1Colors(const Block& block, const std::array<bool, s_BlockTexelCount>& mask, uint16_t color0, uint16_t color1, bool hasTransparency)
+{
+	if (hasTransparency ? color0 > color1 : color0 < color1)
+		std::swap(color0, color1);
+
+	const auto c0 = UnpackRGB565(color0);
+	const auto c1 = UnpackRGB565(color1);
+
+	std::array<std::array<float, 4>, 4> palette = { c0, c1 };
+	uint32_t paletteSize = 4;
+
+	if (color0 > color1)
+	{
+		for (uint32_t c = 0; c < 3; c++)
+		{
+			palette[2][c] = (2.0f * c0[c] + c1[c]) / 3.0f;
+			palette[3][c] = (c0[c] + 2.0f * c1[c]) / 3.0f;
+		}
+	}
+	else
+	{
+		for (uint32_t c = 0; c < 3; c++)
+			palette[2][c] = (c0[c] + c1[c]) * 0.5f;
+
+		// Index 3 is transparent black
+		paletteSize = 3;
+	}
+
+	BC1Block result;
+	result.Color0 = color0;
+	result.Color1 = color1;
+
+	for (uint32_t i = 0; i < s_BlockTexelCount; i++)
+	{
+		uint32_t bestIndex = 3;
+
+		if (mask[i])
+		{
+			float bestDistance = std::numeric_limits<float>::max();
+
+			for (uint32_t p = 0; p < paletteSize; p++)
+			{
+				const float distance = ColorDistance(block[i], palette[p], 3);
+
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					bestIndex = p;
+				}
+			}
+
+			result.Error += bestDistance;
+		}
+
+		result.Indices |= bestIndex << (2 * i);
+	}
+
+	return result;
+}
+
+// Weight of Color0 for each index of the 4 color mode
+static constexpr std::array<float, 4> s_BC1Weights = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+
+static void EncodeBC1(const Block& block, std::byte* dst, bool allowTransparency)
+{
+	// Punch-through alpha, texels under half are left out of the fit and mapped to transparent black
+	std::array<bool, s_BlockTexelCount> mask;
+	bool hasTransparency = false;
+
+	for (uint32_t i = 0; i < s_BlockTexelCount; i++)
+	{
+		mask[i] = !allowTransparency || block[i][3] >= 128.0f;
+		hasTransparency |= !mask[i];
+	}
+
+	std::array<float, 4> low, high;
+	FitEndpoints(block, 3, mask, low, high);
+
+	BC1Block best = EncodeBC1Colors(block, mask, PackRGB565(high), PackRGB565(low), hasTransparency);
+
+	// One refinement pass with the indices picked above, only worth it in the 4 color mode
+	if (!hasTransparency && best.Color0 > best.Color1)
+	{
+		std::array<float, s_BlockTexelCount> weights;
+		for (uint32_t i = 0; i < s_BlockTexelCount; i++)
+			weights[i] = s_BC1Weights[(best.Indices >> (2 * i)) & 3];
+
+		if (RefineEndpoints(block, 3, mask, weights, low, high))
+		{
+			const BC1Block refined = EncodeBC1Colors(block, mask, PackRGB565(high), PackRGB565(low), hasTransparency);
+
+			if (refined.Error < best.Error)
+				best = refined;
+		}
+	}
+
+	std::memcpy(dst, &best.Color0, sizeof(uint16_t));
+	std::memcpy(dst + 2, &best.Color1, sizeof(uint16_t));
+	std::memcpy(dst + 4, &best.Indices, sizeof(uint32_t));
+}
+
+#pragma endregion
+
+#pragma region BC4
+
+// Single channel, 8 interpolated values, used for BC3 alpha and both BC5 channels
+static void EncodeBC4(const Block& block, uint32_t channel, std::byte* dst)
+{
+	float minValue = 255.0f, maxValue = 0.0f;
+
+	for (const auto& texel : block)
+	{
+		minValue = std::min(minValue, texel[channel]);
+		maxValue = std::max(maxValue, texel[channel]);
+	}
+
+	const uint32_t value0 = static_cast<uint32_t>(maxValue + 0.5f);
+	const uint32_t value1 = static_cast<uint32_t>(minValue + 0.5f);
+
+	uint64_t bits = value0 | (value1 << 8);
+
+	if (value0 > value1)
+	{
+		// value0 > value1 selects the 8 value mode, index 0 and 1 are the endpoints
+		std::array<float, 8> palette;
+		palette[0] = static_cast<float>(value0);
+		palette[1] = static_cast<float>(value1);
+
+		for (uint32_t p = 1; p < 7; p++)
+			palette[p + 1] = (static_cast<float>(7 - p) * palette[0] + static_cast<float>(p) * palette[1]) / 7.0f;
+
+		for (uint32_t i = 0; i < s_BlockTexelCount; i++)
+		{
+			uint64_t bestIndex = 0;
+			float bestDistance = std::numeric_limits<float>::max();
+
+			for (uint32_t p = 0; p < 8; p++)
+			{
+				const float distance = std::abs(block[i][channel] - palette[p]);
+
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					bestIndex = p;
+				}
+			}
+
+			bits |= bestIndex << (16 + 3 * i);
+		}
+	}
+
+	std::memcpy(dst, &bits, 8);
+}
+
+#pragma endregion
+
+#pragma region BC7
+
+// Mode 6 only: one subset, 7.7.7.7 RGBA endpoints with a p-bit each and 4-bit indices
+// Lower quality ceiling than a full mode search, but it's fast and has no block artifacts on alpha
+static constexpr uint32_t s_BC7Mode = 6;
+static constexpr std::array<uint32_t, 16> s_BC7Weights = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+struct BC7Block
+{
+	// 7-bit endpoints and their p-bits
+	std::array<uint32_t, 4> Low = {};
+	std::array<uint32_t, 4> High = {};
+	uint32_t LowPBit = 0;
+	uint32_t HighPBit = 0;
+
+	std::array<uint32_t, s_BlockTexelCount> Indices = {};
+
+	float Error = std::numeric_limits<float>::max();
+};
+
+static BC7Block EncodeBC7Endpoints(const Block& block, const std::array<float, 4>& low, const std::array<float, 4>& high, uint32_t lowPBit, uint32_t highPBit)
+{
+	BC7Block result;
+	result.LowPBit = lowPBit;
+	result.HighPBit = highPBit;
+
+	std::array<uint32_t, 4> low8, high8;
+
+	for (uint32_t c = 0; c < 4; c++)
+	{
+		result.Low[c] = static_cast<uint32_t>(std::clamp((low[c] - static_cast<float>(lowPBit)) * 0.5f + 0.5f, 0.0f, 127.0f));
+		result.High[c] = static_cast<uint32_t>(std::clamp((high[c] - static_cast<float>(highPBit)) * 0.5f + 0.5f, 0.0f, 127.0f));
+
+		low8[c] = (result.Low[c] << 1) | lowPBit;
+		high8[c] = (result.High[c] << 1) | highPBit;
+	}
+
+	std::array<std::array<float, 4>, 16> palette;
+
+	for (uint32_t p = 0; p < 16; p++)
+	{
+		for (uint32_t c = 0; c < 4; c++)
+			palette[p][c] = static_cast<float>(((64 - s_BC7Weights[p]) * low8[c] + s_BC7Weights[p] * high8[c] + 32) >> 6);
+	}
+
+	result.Error = 0.0f;
+
+	for (uint32_t i = 0; i < s_BlockTexelCount; i++)
+	{
+		float bestDistance = std::numeric_limits<float>::max();
+
+		for (uint32_t p = 0; p < 16; p++)
+		{
+			const float distance = ColorDistance(block[i], palette[p], 4);
+
+			if (distance < bestDistance)
+			{
+				bestDistance = distance;
+				result.Indices[i] = p;
+			}
+		}
+
+		result.Error += bestDistance;
+	}
+
+	return result;
+}
+
+static BC7Block EncodeBC7PBits(const Block& block, const std::array<float, 4>& low, const std::array<float, 4>& high)
+{
+	BC7Block best;
+
+	for (uint32_t pBits = 0; pBits < 4; pBits++)
+	{
+		const BC7Block candidate = EncodeBC7Endpoints(block, low, high, pBits & 1, pBits >> 1);
+
+		if (candidate.Error < best.Error)
+			best = candidate;
+	}
+
+	return best;
+}
+
+static void EncodeBC7(const Block& block, std::byte* dst)
+{
+	std::array<bool, s_BlockTexelCount> mask;
+	mask.fill(true);
+
+	std::array<float, 4> low, high;
+	FitEndpoints(block, 4, mask, low, high);
+
+	BC7Block best = EncodeBC7PBits(block, low, high);
+
+	std::array<float, s_BlockTexelCount> weights;
+	for (uint32_t i = 0; i < s_BlockTexelCount; i++)
+		weights[i] = static_cast<float>(s_BC7Weights[best.Indices[i]]) / 64.0f;
+
+	if (RefineEndpoints(block, 4, mask, weights, low, high))
+	{
+		const BC7Block refined = EncodeBC7PBits(block, low, high);
+
+		if (refined.Error < best.Error)
+			best = refined;
+	}
+
+	// The most significant bit of the first index is implied 0, swap the endpoints to make it so
+	if (best.Indices[0] >= 8)
+	{
+		std::swap(best.Low, best.High);
+		std::swap(best.LowPBit, best.HighPBit);
+
+		for (auto& index : best.Indices)
+			index = 15 - index;
+	}
+
+	BitWriter writer;
+
+	writer.Write(1u << s_BC7Mode, s_BC7Mode + 1);
+
+	for (uint32_t c = 0; c < 4; c++)
+	{
+		writer.Write(best.Low[c], 7);
+		writer.Write(best.High[c], 7);
+	}
+
+	writer.Write(best.LowPBit, 1);
+	writer.Write(best.HighPBit, 1);
+
+	writer.Write(best.Indices[0], 3);
+	for (uint32_t i = 1; i < s_BlockTexelCount; i++)
+		writer.Write(best.Indices[i], 4);
+
+	writer.Store(dst, 16);
+}
+
+#pragma endregion
+
+Format TextureCompressor::GetFormat(TextureCompression compression)
+{
+	switch (compression)
+	{
+	case TextureCompression::BC1:
+		return Format::BC1_RGBA_SRGB;
+	case TextureCompression::BC3:
+		return Format::BC3_RGBA_SRGB;
+	case TextureCompression::BC5:
+		return Format::BC5_RG_UNORM;
+	case TextureCompression::BC7:
+		return Format::BC7_RGBA_SRGB;
+	default:
+		break;
+	}
+
+	ASSERT(false, "Unknown texture compression");
+	return Format::UNDEFINED;
+}
+
+void TextureCompressor::CompressLevel(const uint8_t* rgba, uint32_t width, uint32_t height, TextureCompression compression, std::byte* dst)
+{
+	ASSERT(rgba && dst);
+	ASSERT(width != 0 && height != 0);
+
+	const uint32_t blocksX = (width + s_BlockExtent - 1) / s_BlockExtent;
+	const uint32_t blocksY = (height + s_BlockExtent - 1) / s_BlockExtent;
+
+	const uint32_t blockSize = FormatBytesPerBlock(GetFormat(compression));
+
+	// A row of blocks per job, blocks are independent
+	JobSystem::ParallelFor(blocksY, [&](uint32_t blockY)
+		{
+			for (uint32_t blockX = 0; blockX < blocksX; blockX++)
+			{
+				const Block block = LoadBlock(rgba, width, height, blockX, blockY);
+				std::byte* blockDst = dst + (static_cast<size_t>(blockY) * blocksX + blockX) * blockSize;
+
+				switch (compression)
+				{
+				case TextureCompression::BC1:
+					EncodeBC1(block, blockDst, true);
+					break;
+				case TextureCompression::BC3:
+					EncodeBC4(block, 3, blockDst);
+					EncodeBC1(block, blockDst + 8, false);
+					break;
+				case TextureCompression::BC5:
+					EncodeBC4(block, 0, blockDst);
+					EncodeBC4(block, 1, blockDst + 8);
+					break;
+				case TextureCompression::BC7:
+					EncodeBC7(block, blockDst);
+					break;
+				default:
+					break;
+				}
+			}
+		});
+}
+
+MipChain TextureCompressor::Compress(const MipChain& source, TextureCompression compression)
+{
+	ASSERT(FormatBytesPerPixel(source.Format) == 4);
+	ASSERT(source.GetLevelCount() > 0);
+
+	Timer timer;
+
+	MipChain result;
+
+	result.Format = GetFormat(compression);
+	result.Width = source.Width;
+	result.Height = source.Height;
+	result.LayerCount = source.LayerCount;
+
+	const uint32_t levelCount = source.GetLevelCount();
+
+	// Smallest level first, same as the source
+	result.LevelOffsets.resize(levelCount);
+
+	uint64_t size = 0;
+
+	for (uint32_t level = levelCount; level-- > 0;)
+	{
+		result.LevelOffsets[level] = size;
+		size += result.GetLevelSize(level);
+	}
+
+	result.Data.resize(size);
+
+	for (uint32_t level = 0; level < levelCount; level++)
+	{
+		const uint32_t width = source.GetLevelWidth(level);
+		const uint32_t height = source.GetLevelHeight(level);
+
+		const uint64_t sourceLayerSize = source.GetLevelSize(level) / source.LayerCount;
+		const uint64_t resultLayerSize = result.GetLevelSize(level) / result.LayerCount;
+
+		for (uint32_t layer = 0; layer < source.LayerCount; layer++)
+		{
+			const auto* rgba = reinterpret_cast<const uint8_t*>(source.GetLevel(level).data() + sourceLayerSize * layer);
+			std::byte* dst = result.Data.data() + result.LevelOffsets[level] + resultLayerSize * layer;
+
+			CompressLevel(rgba, width, height, compression, dst);
+		}
+	}
+
+	const float sourceSize = static_cast<float>(source.Data.size());
+	LOG_TAGGED(s_LogTag, "%ux%u, %u levels, %.2f MB -> %.2f MB in %.2f ms", result.Width, result.Height, levelCount,
+		sourceSize / (1024.0f * 1024.0f), static_cast<float>(size) / (1024.0f * 1024.0f), timer.ElapsedMS());
+
+	return result;
+}
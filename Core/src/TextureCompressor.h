@@ -0,0 +1,22 @@
+#pragma once
+
+#include "Enums.h"
+#include "MipGenerator.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// CPU block compression of RGBA8 images, meant to run once per texture, the result is cached (see TextureCache)
+// Blocks are encoded in parallel on the JobSystem
+class TextureCompressor
+{
+public:
+	static Format GetFormat(TextureCompression compression);
+
+	// Every level and layer of an RGBA8 chain (see MipGenerator), the result has the same levels in the same order
+	static MipChain Compress(const MipChain& source, TextureCompression compression);
+
+	// Single level, dst holds FormatImageSize(GetFormat(compression), width, height) bytes
+	// Blocks past the edges repeat the last row/column
+	static void CompressLevel(const uint8_t* rgba, uint32_t width, uint32_t height, TextureCompression compression, std::byte* dst);
+};
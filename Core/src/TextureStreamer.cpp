@@ -0,0 +1,416 @@
+#include "TextureStreamer.h"
+
+#include "Context.h"
+#include "Device.h"
+#include "Allocator.h"
+#include "Image.h"
+#include "GBuffer.h"
+#include "CommandBuffer.h"
+#include "UploadContext.h"
+#include "TextureCache.h"
+
+#include "Log.h"
+#include "Profiler.h"
+
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <queue>
+#include <tuple>
+
+static constexpr const char* s_LogTag = "[TextureStreamer]";
+
+// Levels this size and smaller are uploaded on creation and never evicted
+static constexpr uint32_t s_TailExtent = 64;
+// Textures not requested for this many frames are considered off screen, only their tail is kept
+static constexpr uint64_t s_IdleFrameCount = 120;
+// Caps the copies recorded into a single frame, so a burst of requests doesn't stall it
+static constexpr uint64_t s_MaxUploadSizePerFrame = 32ull * 1024 * 1024;
+// Of what VK_EXT_memory_budget reports as available, the rest is headroom for everything else
+static constexpr uint64_t s_BudgetPercentage = 80;
+
+#pragma region StreamedTexture
+
+Ref<StreamedTexture> StreamedTexture::Create(const TextureDescription& desc, Scope<TextureCache>&& cache, std::string_view name, UploadContext* context)
+{
+	return CreateRef<StreamedTexture>(desc, std::move(cache), name, context);
+}
+
+StreamedTexture::StreamedTexture(const TextureDescription& desc, Scope<TextureCache>&& cache, std::string_view name, UploadContext* context)
+	: Texture(TextureType::TEXTURE2D, desc), m_Name(name), m_Cache(std::move(cache))
+{
+	ASSERT(m_Cache);
+	ASSERT(desc.Width == m_Cache->GetWidth() && desc.Height == m_Cache->GetHeight() && desc.Format == m_Cache->GetFormat());
+
+	const uint32_t levelCount = m_Cache->GetLevelCount();
+
+	while (m_TailLevel + 1 < levelCount && std::max(desc.Width >> m_TailLevel, desc.Height >> m_TailLevel) > s_TailExtent)
+		m_TailLevel++;
+
+	m_ResidentLevel = m_TailLevel;
+	m_RequestedLevel = m_TailLevel;
+
+	Scope<UploadContext> localContext;
+
+	if (!context)
+	{
+		localContext = CreateScope<UploadContext>();
+		context = localContext.get();
+	}
+
+	auto stagingBuffer = CreateStagingBuffer(m_TailLevel);
+	std::memcpy(stagingBuffer->GetMappedSpan().data(), m_Cache->GetData().data(), stagingBuffer->GetDescription().Size);
+
+	SetImage(CreateImage(context->GetCommandBuffer(), m_TailLevel, *stagingBuffer), levelCount);
+
+	context->KeepAlive(std::move(stagingBuffer));
+
+	if (localContext)
+		localContext->Flush();
+
+	// Covers the whole chain, the view clamps it to what's resident
+	if (desc.CreateSampler)
+		CreateSampler();
+
+	Context::GetTextureStreamer().Register(this);
+}
+
+StreamedTexture::~StreamedTexture()
+{
+	Context::GetTextureStreamer().Unregister(this);
+
+	if (m_PendingLoad)
+		JobSystem::WaitFor(m_PendingLoad->Counter);
+}
+
+void StreamedTexture::RequestScreenSize(float screenSize)
+{
+	const auto& desc = GetDescription();
+
+	// One texel per pixel
+	const float ratio = static_cast<float>(std::max(desc.Width, desc.Height)) / std::max(screenSize, 1.0f);
+
+	RequestLevel(ratio > 1.0f ? static_cast<uint32_t>(std::log2(ratio)) : 0);
+}
+
+void StreamedTexture::RequestLevel(uint32_t level)
+{
+	level = std::min(level, m_TailLevel);
+
+	uint32_t current = m_FrameRequest.load(std::memory_order_relaxed);
+
+	while (level < current && !m_FrameRequest.compare_exchange_weak(current, level, std::memory_order_relaxed))
+	{
+	}
+}
+
+const std::string& StreamedTexture::GetName() const
+{
+	return m_Name;
+}
+
+uint32_t StreamedTexture::GetResidentLevel() const
+{
+	return m_ResidentLevel;
+}
+
+uint32_t StreamedTexture::GetRequestedLevel() const
+{
+	return m_RequestedLevel;
+}
+
+uint32_t StreamedTexture::GetTailLevel() const
+{
+	return m_TailLevel;
+}
+
+uint64_t StreamedTexture::GetSize(uint32_t level) const
+{
+	ASSERT(level < m_Cache->GetLevelCount());
+
+	const auto& desc = GetDescription();
+
+	// Smallest level first, [level, level count) is a prefix of the cache's data
+	return m_Cache->GetLevelOffsets()[level] + FormatImageSize(desc.Format, std::max(desc.Width >> level, 1u), std::max(desc.Height >> level, 1u));
+}
+
+uint64_t StreamedTexture::GetResidentSize() const
+{
+	return GetSize(m_ResidentLevel);
+}
+
+uint64_t StreamedTexture::GetRequestedSize() const
+{
+	return GetSize(m_RequestedLevel);
+}
+
+Ref<Image2D> StreamedTexture::CreateImage(CommandBuffer& commandBuffer, uint32_t level, const GBuffer& stagingBuffer) const
+{
+	const auto& textureDesc = GetDescription();
+
+	ImageDescription desc;
+
+	desc.Width = std::max(textureDesc.Width >> level, 1u);
+	desc.Height = std::max(textureDesc.Height >> level, 1u);
+	desc.MipLevels = m_Cache->GetLevelCount() - level;
+	desc.ImageCount = 1;
+	desc.MSAAnumSamples = 1;
+	desc.Format = textureDesc.Format;
+	desc.ImageUsage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+	desc.Properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+	desc.ImageAspectFlags = VK_IMAGE_ASPECT_COLOR_BIT;
+	desc.ImageCreateFlags = 0;
+	desc.ViewType = VK_IMAGE_VIEW_TYPE_2D;
+
+	auto image = Image2D::Create(desc);
+
+	image->TransitionImageLayout(commandBuffer, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_UNDEFINED);
+	image->CopyFrom(commandBuffer, stagingBuffer, m_Cache->GetLevelOffsets().subspan(level));
+
+	return image;
+}
+
+Scope<GBuffer> StreamedTexture::CreateStagingBuffer(uint32_t level) const
+{
+	return GBuffer::CreateStaging(GetSize(level));
+}
+
+void StreamedTexture::Load(uint32_t level)
+{
+	ASSERT(!m_PendingLoad);
+
+	m_PendingLoad = CreateScope<PendingLoad>();
+	m_PendingLoad->Level = level;
+	m_PendingLoad->StagingBuffer = CreateStagingBuffer(level);
+
+	// Touching the mapping is what reads the file, so it's kept off the main thread
+	JobSystem::Execute([load = m_PendingLoad.get(), cache = m_Cache.get()]()
+		{
+			const auto destination = load->StagingBuffer->GetMappedSpan();
+
+			std::memcpy(destination.data(), cache->GetData().data(), load->StagingBuffer->GetDescription().Size);
+		}, &m_PendingLoad->Counter);
+}
+
+std::pair<Ref<Image2D>, Scope<GBuffer>> StreamedTexture::ApplyLoad(CommandBuffer& commandBuffer)
+{
+	ASSERT(m_PendingLoad && m_PendingLoad->Counter.IsDone());
+
+	auto load = std::move(m_PendingLoad);
+
+	auto previous = SetImage(CreateImage(commandBuffer, load->Level, *load->StagingBuffer), m_Cache->GetLevelCount());
+	m_ResidentLevel = load->Level;
+
+	return { std::move(previous), std::move(load->StagingBuffer) };
+}
+
+#pragma endregion
+
+#pragma region TextureStreamer
+
+TextureStreamer::TextureStreamer(const Device& device)
+	: m_Device(device)
+{
+	LOG_TAGGED(s_LogTag, "Budget from %s", m_Device.IsExtensionEnabled(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) ? "VK_EXT_memory_budget" : "the default");
+}
+
+TextureStreamer::~TextureStreamer()
+{
+	if (!m_Textures.empty())
+		LOG_TAGGED(s_LogTag, "Destroyed with %i texture(s) still alive", static_cast<int>(m_Textures.size()));
+
+	m_Retired.clear();
+}
+
+void TextureStreamer::SetBudget(uint64_t budget)
+{
+	std::scoped_lock lock(m_Mutex);
+
+	m_Budget = budget;
+}
+
+void TextureStreamer::Update(CommandBuffer& commandBuffer, uint32_t framesInFlight)
+{
+	PROFILE_FUNCTION();
+
+	std::scoped_lock lock(m_Mutex);
+
+	m_Frame++;
+
+	// Every frame that could still sample them is done
+	while (!m_Retired.empty() && m_Retired.front().Frame + framesInFlight <= m_Frame)
+		m_Retired.pop_front();
+
+	if (m_Textures.empty())
+		return;
+
+	ResolveRequests();
+
+	m_EffectiveBudget = ComputeBudget();
+
+	const auto levels = PlanLevels(m_EffectiveBudget);
+
+	uint64_t uploadSize = 0;
+
+	for (size_t i = 0; i < m_Textures.size(); i++)
+	{
+		auto& texture = *m_Textures[i];
+
+		if (texture.m_PendingLoad)
+		{
+			if (!texture.m_PendingLoad->Counter.IsDone())
+				continue;
+
+			auto [image, stagingBuffer] = texture.ApplyLoad(commandBuffer);
+
+			m_Retired.push_back({ std::move(image), std::move(stagingBuffer), m_Frame });
+		}
+
+		const uint32_t level = levels[i];
+
+		if (level == texture.m_ResidentLevel)
+			continue;
+
+		// Evictions only copy what's left, they're let through regardless
+		if (level < texture.m_ResidentLevel)
+		{
+			const uint64_t size = texture.GetSize(level);
+
+			if (uploadSize > 0 && uploadSize + size > s_MaxUploadSizePerFrame)
+				continue;
+
+			uploadSize += size;
+		}
+
+		texture.Load(level);
+	}
+}
+
+TextureStreamerStatistics TextureStreamer::GetStatistics() const
+{
+	std::scoped_lock lock(m_Mutex);
+
+	TextureStreamerStatistics statistics;
+
+	statistics.Budget = m_EffectiveBudget;
+	statistics.TextureCount = static_cast<uint32_t>(m_Textures.size());
+
+	for (const auto* texture : m_Textures)
+	{
+		statistics.ResidentSize += texture->GetResidentSize();
+		statistics.RequestedSize += texture->GetRequestedSize();
+
+		if (texture->m_PendingLoad)
+			statistics.PendingLoadCount++;
+	}
+
+	return statistics;
+}
+
+const std::vector<StreamedTexture*>& TextureStreamer::GetTextures() const
+{
+	return m_Textures;
+}
+
+void TextureStreamer::Register(StreamedTexture* texture)
+{
+	std::scoped_lock lock(m_Mutex);
+
+	m_Textures.emplace_back(texture);
+}
+
+void TextureStreamer::Unregister(StreamedTexture* texture)
+{
+	std::scoped_lock lock(m_Mutex);
+
+	std::erase(m_Textures, texture);
+}
+
+uint64_t TextureStreamer::ComputeBudget() const
+{
+	if (0 != m_Budget)
+		return m_Budget;
+
+	const auto& allocator = m_Device.GetAllocator();
+	const auto heap = allocator.GetStatistics()[allocator.FindHeapIndex(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)];
+
+	if (0 == heap.Budget)
+		return s_DefaultBudget;
+
+	uint64_t residentSize = 0;
+
+	for (const auto* texture : m_Textures)
+		residentSize += texture->GetResidentSize();
+
+	// What the streamed textures hold now is theirs to redistribute, the rest of the process' usage isn't
+	const uint64_t otherUsage = heap.Usage > residentSize ? heap.Usage - residentSize : 0;
+	const uint64_t available = heap.Budget > otherUsage ? heap.Budget - otherUsage : 0;
+
+	return available / 100 * s_BudgetPercentage;
+}
+
+void TextureStreamer::ResolveRequests()
+{
+	for (auto* texture : m_Textures)
+	{
+		const uint32_t request = texture->m_FrameRequest.exchange(StreamedTexture::s_NoRequest, std::memory_order_relaxed);
+
+		if (StreamedTexture::s_NoRequest != request)
+		{
+			texture->m_RequestedLevel = request;
+			texture->m_LastRequestFrame = m_Frame;
+		}
+		else if (0 != texture->m_LastRequestFrame && m_Frame - texture->m_LastRequestFrame > s_IdleFrameCount)
+		{
+			texture->m_RequestedLevel = texture->m_TailLevel;
+		}
+	}
+}
+
+std::vector<uint32_t> TextureStreamer::PlanLevels(uint64_t budget) const
+{
+	std::vector<uint32_t> levels(m_Textures.size());
+
+	// Levels finer than requested go first, then the biggest ones
+	// Dropping the biggest level frees the most for the least loss of detail, resolutions even out across textures
+	using Candidate = std::tuple<bool, uint64_t, size_t>;
+	std::priority_queue<Candidate> candidates;
+
+	const auto pushCandidate = [&](size_t i)
+		{
+			const auto& texture = *m_Textures[i];
+
+			if (levels[i] < texture.m_TailLevel)
+				candidates.emplace(levels[i] < texture.m_RequestedLevel, texture.GetSize(levels[i]) - texture.GetSize(levels[i] + 1), i);
+		};
+
+	uint64_t totalSize = 0;
+
+	for (size_t i = 0; i < m_Textures.size(); i++)
+	{
+		const auto& texture = *m_Textures[i];
+
+		// Finer levels than requested are kept while they fit, so they're not streamed in again as soon as they're needed
+		levels[i] = std::min(texture.m_RequestedLevel, texture.m_ResidentLevel);
+		totalSize += texture.GetSize(levels[i]);
+
+		pushCandidate(i);
+	}
+
+	while (totalSize > budget && !candidates.empty())
+	{
+		const auto [_, size, i] = candidates.top();
+		candidates.pop();
+
+		totalSize -= size;
+		levels[i]++;
+
+		pushCandidate(i);
+	}
+
+	return levels;
+}
+
+#pragma endregion
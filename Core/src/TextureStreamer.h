@@ -0,0 +1,147 @@
+#pragma once
+
+#include "Base.h"
+
+#include "Texture.h"
+#include "JobSystem.h"
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+class TextureCache;
+class TextureStreamer;
+class CommandBuffer;
+class Device;
+
+// Texture whose finest mips are brought in and evicted by the TextureStreamer, always backed by a TextureCache
+// Its image only holds the resident levels [GetResidentLevel(), GetMipLevels()), it gets replaced whenever they change
+// Created with TextureDescription::Streamed, only the tail of the chain is uploaded then
+class StreamedTexture : public Texture
+{
+	// Levels [Level, GetMipLevels()) read from the cache into StagingBuffer on a job
+	struct PendingLoad
+	{
+		uint32_t Level = 0;
+		Scope<GBuffer> StagingBuffer;
+
+		JobCounter Counter;
+	};
+public:
+	static Ref<StreamedTexture> Create(const TextureDescription& desc, Scope<TextureCache>&& cache, std::string_view name, UploadContext* context = nullptr);
+
+	StreamedTexture(const TextureDescription& desc, Scope<TextureCache>&& cache, std::string_view name, UploadContext* context = nullptr);
+	// Waits for its pending load, if any
+	~StreamedTexture();
+
+	// From the draws using it, any thread, the finest request of the frame wins
+	// screenSize is about how many pixels the texture spans on screen, along its largest axis
+	void RequestScreenSize(float screenSize);
+	void RequestLevel(uint32_t level);
+
+	const std::string& GetName() const;
+
+	// Finest level in memory, 0 is full resolution
+	uint32_t GetResidentLevel() const;
+	// What it asked for, before the budget was applied
+	uint32_t GetRequestedLevel() const;
+	// Coarsest level it can be evicted to, the tail below it is always resident
+	uint32_t GetTailLevel() const;
+
+	// Size of the levels [level, GetMipLevels())
+	uint64_t GetSize(uint32_t level) const;
+	uint64_t GetResidentSize() const;
+	uint64_t GetRequestedSize() const;
+private:
+	friend class TextureStreamer;
+
+	Ref<Image2D> CreateImage(CommandBuffer& commandBuffer, uint32_t level, const GBuffer& stagingBuffer) const;
+	Scope<GBuffer> CreateStagingBuffer(uint32_t level) const;
+	// Reads the levels [level, GetMipLevels()) on a job, ApplyLoad() once it's done
+	void Load(uint32_t level);
+
+	// Swaps in the pending load, the previous image and the staging buffer are returned for deferred release
+	std::pair<Ref<Image2D>, Scope<GBuffer>> ApplyLoad(CommandBuffer& commandBuffer);
+private:
+	static constexpr uint32_t s_NoRequest = ~0U;
+
+	std::string m_Name;
+	Scope<TextureCache> m_Cache;
+
+	uint32_t m_TailLevel = 0;
+	uint32_t m_ResidentLevel = 0;
+	uint32_t m_RequestedLevel = 0;
+
+	// Finest level asked for this frame, s_NoRequest if none
+	std::atomic<uint32_t> m_FrameRequest = s_NoRequest;
+	// 0 if it was never requested, such textures stay at the tail until their first request
+	uint64_t m_LastRequestFrame = 0;
+
+	Scope<PendingLoad> m_PendingLoad;
+};
+
+struct TextureStreamerStatistics
+{
+	uint64_t Budget = 0;
+	uint64_t ResidentSize = 0;
+	uint64_t RequestedSize = 0;
+
+	uint32_t TextureCount = 0;
+	uint32_t PendingLoadCount = 0;
+};
+
+// Decides, once per frame, which mips of every StreamedTexture should be resident and streams them in or out
+// Requested levels are kept resident, along with finer ones loaded earlier, until the budget is reached
+// Past it levels are evicted, the ones no longer requested first, then the biggest ones
+// Levels are read from the memory-mapped TextureCache on the JobSystem, the copies are recorded into the frame's command buffer
+class TextureStreamer
+{
+	// Replaced images can still be in use by the frames in flight
+	struct Retired
+	{
+		Ref<Image2D> Image;
+		Scope<GBuffer> StagingBuffer;
+
+		uint64_t Frame = 0;
+	};
+public:
+	TextureStreamer(const Device& device);
+	~TextureStreamer();
+
+	DELETE_COPY_AND_MOVE(TextureStreamer);
+
+	// In bytes, 0 means derived from VK_EXT_memory_budget, or s_DefaultBudget without it
+	void SetBudget(uint64_t budget);
+
+	// Once per frame, from the main thread, before the render pass is begun
+	void Update(CommandBuffer& commandBuffer, uint32_t framesInFlight);
+
+	TextureStreamerStatistics GetStatistics() const;
+	// Main thread only, valid until the next texture is created or destroyed
+	const std::vector<StreamedTexture*>& GetTextures() const;
+
+	static constexpr uint64_t s_DefaultBudget = 256ull * 1024 * 1024;
+private:
+	friend class StreamedTexture;
+
+	void Register(StreamedTexture* texture);
+	void Unregister(StreamedTexture* texture);
+
+	uint64_t ComputeBudget() const;
+	void ResolveRequests();
+	std::vector<uint32_t> PlanLevels(uint64_t budget) const;
+private:
+	const Device& m_Device;
+
+	std::vector<StreamedTexture*> m_Textures;
+	std::deque<Retired> m_Retired;
+
+	uint64_t m_Budget = 0;
+	uint64_t m_EffectiveBudget = s_DefaultBudget;
+	uint64_t m_Frame = 0;
+
+	mutable std::mutex m_Mutex;
+};
@@ -0,0 +1,77 @@
+#include "ThreadCommandPools.h"
+
+#include "Device.h"
+#include "CommandPool.h"
+#include "CommandBuffer.h"
+#include "JobSystem.h"
+
+#include "Log.h"
+
+Scope<ThreadCommandPools> ThreadCommandPools::Create(const Device& device, uint32_t frameCount)
+{
+	return CreateScope<ThreadCommandPools>(device, frameCount);
+}
+
+ThreadCommandPools::ThreadCommandPools(const Device& device, uint32_t frameCount)
+	: m_Device(device)
+{
+	ASSERT(0 < frameCount);
+
+	// Workers plus the thread that initialized the JobSystem
+	const uint32_t threadCount = JobSystem::GetWorkerCount() + 1;
+	const uint32_t graphicsIndex = m_Device.GetPhysicalDevice().GetQueueFamilyIndices().GraphicsIndex.value();
+
+	m_Frames.resize(frameCount);
+
+	for (auto& threads : m_Frames)
+	{
+		threads.resize(threadCount);
+
+		for (auto& thread : threads)
+			thread.Pool = CreateScope<CommandPool>(m_Device, graphicsIndex);
+	}
+}
+
+ThreadCommandPools::~ThreadCommandPools()
+{
+	// Command buffers go before their pool
+	for (auto& threads : m_Frames)
+	{
+		for (auto& thread : threads)
+		{
+			thread.SecondaryBuffers.clear();
+			thread.Pool.reset();
+		}
+	}
+}
+
+void ThreadCommandPools::BeginFrame(uint32_t frameIndex)
+{
+	ASSERT(frameIndex < m_Frames.size());
+
+	m_CurrentFrame = frameIndex;
+
+	for (auto& thread : m_Frames[m_CurrentFrame])
+	{
+		if (0 == thread.UsedCount)
+			continue;
+
+		thread.Pool->Reset();
+		thread.UsedCount = 0;
+	}
+}
+
+CommandBuffer& ThreadCommandPools::GetSecondary()
+{
+	const uint32_t threadIndex = JobSystem::GetThreadIndex();
+
+	auto& threads = m_Frames[m_CurrentFrame];
+	ASSERT(threadIndex < threads.size(), "Not a JobSystem thread");
+
+	auto& thread = threads[threadIndex];
+
+	if (thread.UsedCount == thread.SecondaryBuffers.size())
+		thread.SecondaryBuffers.emplace_back(CommandBuffer::Create(false, *thread.Pool));
+
+	return *thread.SecondaryBuffers[thread.UsedCount++];
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Base.h"
+
+#include <vector>
+
+class Device;
+class CommandPool;
+class CommandBuffer;
+
+// One graphics CommandPool per frame in flight and per JobSystem thread, Vulkan pools can't be shared between threads
+// Secondary command buffers are handed out from the calling thread's pool and recycled when their frame comes around again
+class ThreadCommandPools
+{
+	struct ThreadData
+	{
+		Scope<CommandPool> Pool;
+		std::vector<Ref<CommandBuffer>> SecondaryBuffers;
+		uint32_t UsedCount = 0;
+	};
+public:
+	static Scope<ThreadCommandPools> Create(const Device& device, uint32_t frameCount);
+
+	ThreadCommandPools(const Device& device, uint32_t frameCount);
+	~ThreadCommandPools();
+
+	DELETE_COPY_AND_MOVE(ThreadCommandPools);
+
+	// Resets the pools of the frame, must be called after the fence of the frame is waited on
+	void BeginFrame(uint32_t frameIndex);
+
+	// Valid until the next BeginFrame() of the same frame index, only from the JobSystem's threads
+	CommandBuffer& GetSecondary();
+private:
+	const Device& m_Device;
+
+	// [Frame][Thread]
+	std::vector<std::vector<ThreadData>> m_Frames;
+
+	uint32_t m_CurrentFrame = 0;
+};
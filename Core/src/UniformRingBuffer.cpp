@@ -0,0 +1,85 @@
+#include "UniformRingBuffer.h"
+
+#include "Device.h"
+#include "GBuffer.h"
+
+#include "Log.h"
+
+#include <volk.h>
+#include <vulkan/vulkan.h>
+
+#include <cstring>
+
+static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+Scope<UniformRingBuffer> UniformRingBuffer::Create(const Device& device, const UniformRingBufferDescription& desc)
+{
+	return CreateScope<UniformRingBuffer>(device, desc);
+}
+
+UniformRingBuffer::UniformRingBuffer(const Device& device, const UniformRingBufferDescription& desc)
+	: m_Device(device), m_Description(desc)
+{
+	ASSERT(0 < m_Description.FrameCount);
+
+	m_Alignment = m_Device.GetPhysicalDevice().GetProperties().limits.minUniformBufferOffsetAlignment;
+
+	// Every partition has to start at an aligned offset
+	m_Description.SizePerFrame = AlignUp(m_Description.SizePerFrame, m_Alignment);
+
+	GBufferDescription bufferDesc;
+
+	bufferDesc.Size = m_Description.SizePerFrame * m_Description.FrameCount;
+	bufferDesc.Usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+	bufferDesc.Properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+	m_Buffer = CreateScope<GBuffer>(bufferDesc);
+	ASSERT(m_Buffer->IsMapped());
+}
+
+UniformRingBuffer::~UniformRingBuffer()
+{
+	m_Buffer.reset();
+}
+
+void UniformRingBuffer::BeginFrame(uint32_t frameIndex)
+{
+	ASSERT(frameIndex < m_Description.FrameCount);
+
+	m_FrameOffset = frameIndex * m_Description.SizePerFrame;
+	m_Head = 0;
+}
+
+uint32_t UniformRingBuffer::Push(const void* data, VkDeviceSize size)
+{
+	ASSERT(data && 0 < size);
+
+	const VkDeviceSize offset = AlignUp(m_Head, m_Alignment);
+	ASSERT(offset + size <= m_Description.SizePerFrame, "UniformRingBuffer frame partition is full");
+
+	const VkDeviceSize dynamicOffset = m_FrameOffset + offset;
+
+	memcpy(m_Buffer->GetMappedSpan().data() + dynamicOffset, data, static_cast<size_t>(size));
+
+	m_Head = offset + size;
+
+	return static_cast<uint32_t>(dynamicOffset);
+}
+
+const GBuffer& UniformRingBuffer::GetBuffer() const
+{
+	return *m_Buffer;
+}
+
+const UniformRingBufferDescription& UniformRingBuffer::GetDescription() const
+{
+	return m_Description;
+}
+
+VkDeviceSize UniformRingBuffer::GetUsedSize() const
+{
+	return m_Head;
+}
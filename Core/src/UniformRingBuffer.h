@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Base.h"
+
+#include "VK.h"
+
+class Device;
+class GBuffer;
+
+struct UniformRingBufferDescription
+{
+	VkDeviceSize SizePerFrame = 1024 * 1024;
+	uint32_t FrameCount = 0;
+};
+
+// Per-frame linear allocator for transient uniform data, on top of one persistently mapped uniform buffer
+// The buffer is split in FrameCount partitions, a partition is reset only after the fence of its frame is signaled,
+// so data of the frames still in flight is never overwritten
+// Push() returns the dynamic offset to be passed to CommandBuffer::BindDescriptorSet
+class UniformRingBuffer
+{
+public:
+	static Scope<UniformRingBuffer> Create(const Device& device, const UniformRingBufferDescription& desc);
+
+	UniformRingBuffer(const Device& device, const UniformRingBufferDescription& desc);
+	~UniformRingBuffer();
+
+	DELETE_COPY_AND_MOVE(UniformRingBuffer);
+
+	// Must be called after the fence of the frame is waited on
+	void BeginFrame(uint32_t frameIndex);
+
+	uint32_t Push(const void* data, VkDeviceSize size);
+
+	template<typename T>
+	uint32_t Push(const T& data)
+	{
+		return Push(&data, sizeof(T));
+	}
+
+	const GBuffer& GetBuffer() const;
+
+	const UniformRingBufferDescription& GetDescription() const;
+	VkDeviceSize GetUsedSize() const;
+private:
+	const Device& m_Device;
+
+	UniformRingBufferDescription m_Description;
+
+	Scope<GBuffer> m_Buffer;
+
+	VkDeviceSize m_Alignment = 0;
+	VkDeviceSize m_FrameOffset = 0;
+	VkDeviceSize m_Head = 0;
+};
@@ -0,0 +1,95 @@
+#include "UploadContext.h"
+
+#include "Context.h"
+#include "Device.h"
+#include "CommandBuffer.h"
+#include "GBuffer.h"
+#include "Synchronization.h"
+
+#include "Log.h"
+#include "Profiler.h"
+
+#include <volk.h>
+#include <vulkan/vulkan.h>
+
+#include <limits>
+
+Ref<UploadContext> UploadContext::Create()
+{
+	return CreateRef<UploadContext>();
+}
+
+UploadContext::UploadContext()
+{
+	FenceDescription desc;
+	desc.CreateFlags = 0;
+
+	m_Fence = Fence::Create(Context::GetDevice(), desc);
+
+	m_CommandBuffer = CommandBuffer::Create(true);
+	m_CommandBuffer->BeginRecording(true);
+}
+
+UploadContext::~UploadContext()
+{
+	if (m_IsSubmitted)
+		Wait();
+
+	m_StagingBuffers.clear();
+
+	m_CommandBuffer.reset();
+	m_Fence.reset();
+}
+
+CommandBuffer& UploadContext::GetCommandBuffer()
+{
+	ASSERT(!m_IsSubmitted, "UploadContext is already submitted");
+
+	return *m_CommandBuffer;
+}
+
+void UploadContext::KeepAlive(Scope<GBuffer> stagingBuffer)
+{
+	ASSERT(!m_IsSubmitted, "UploadContext is already submitted");
+
+	m_StagingBuffers.emplace_back(std::move(stagingBuffer));
+}
+
+void UploadContext::Submit()
+{
+	PROFILE_FUNCTION();
+
+	ASSERT(!m_IsSubmitted, "UploadContext is already submitted");
+
+	m_CommandBuffer->EndRecording();
+	m_CommandBuffer->Submit(m_Fence.get());
+
+	m_IsSubmitted = true;
+}
+
+bool UploadContext::IsComplete() const
+{
+	return m_IsSubmitted && m_Fence->IsSignaled();
+}
+
+void UploadContext::Wait()
+{
+	PROFILE_FUNCTION();
+
+	ASSERT(m_IsSubmitted, "Waiting on an UploadContext that was never submitted");
+
+	m_Fence->Wait(std::numeric_limits<uint64_t>::max());
+
+	m_StagingBuffers.clear();
+}
+
+void UploadContext::Flush()
+{
+	Submit();
+	Wait();
+}
+
+bool UploadContext::IsSubmitted() const
+{
+	return m_IsSubmitted;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Base.h"
+
+#include "VK.h"
+
+#include <vector>
+
+class CommandBuffer;
+class GBuffer;
+class Fence;
+
+// Records many one-shot graphics queue commands (layout transitions, buffer to image copies, mip blits)
+// into a single command buffer, submitted once with a fence that can be waited on or polled
+// Staging buffers handed to KeepAlive() are released only after the fence is signaled
+// Blits need a graphics queue, buffer-only uploads should go through the UploadQueue instead
+class UploadContext
+{
+public:
+	static Ref<UploadContext> Create();
+
+	UploadContext();
+	// Waits for the submitted work, so staging buffers aren't destroyed while in use
+	~UploadContext();
+
+	DELETE_COPY_AND_MOVE(UploadContext);
+
+	CommandBuffer& GetCommandBuffer();
+
+	void KeepAlive(Scope<GBuffer> stagingBuffer);
+
+	// Ends recording and submits, doesn't wait
+	void Submit();
+	bool IsComplete() const;
+	void Wait();
+
+	// Submit() and Wait()
+	void Flush();
+
+	bool IsSubmitted() const;
+private:
+	Ref<CommandBuffer> m_CommandBuffer;
+	Ref<Fence> m_Fence;
+
+	std::vector<Scope<GBuffer>> m_StagingBuffers;
+
+	bool m_IsSubmitted = false;
+};
@@ -0,0 +1,168 @@
+#include "UploadQueue.h"
+
+#include "Device.h"
+#include "CommandPool.h"
+#include "CommandBuffer.h"
+#include "GBuffer.h"
+#include "Synchronization.h"
+
+#include "Log.h"
+#include "Profiler.h"
+
+#include <volk.h>
+#include <vulkan/vulkan.h>
+
+#include <limits>
+
+static constexpr const char* s_LogTag = "[UploadQueue]";
+
+UploadQueue::UploadQueue(const Device& device)
+	: m_Device(device)
+{
+	const auto& indices = m_Device.GetPhysicalDevice().GetQueueFamilyIndices();
+
+	m_CommandPool = CreateScope<CommandPool>(m_Device, indices.GetTransferIndex());
+	m_Semaphore = TimelineSemaphore::Create(m_Device);
+
+	LOG_TAGGED(s_LogTag, "Using %s queue family #%i", indices.HasDedicatedTransfer() ? "transfer" : "graphics", indices.GetTransferIndex());
+}
+
+UploadQueue::~UploadQueue()
+{
+	WaitIdle();
+
+	m_RecordingBatch.reset();
+	m_SubmittedBatches.clear();
+	m_FreeCommandBuffers.clear();
+
+	m_Semaphore.reset();
+	m_CommandPool.reset();
+}
+
+void UploadQueue::Upload(const GBuffer& destination, const void* data, VkDeviceSize size, VkDeviceSize offset)
+{
+	ASSERT(data && 0 < size);
+	ASSERT(offset + size <= destination.GetDescription().Size);
+	ASSERT(destination.GetDescription().Usage & VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+
+	Scope<GBuffer> stagingBuffer = GBuffer::CreateStaging(size);
+	stagingBuffer->SetData(data, size);
+
+	std::scoped_lock lock(m_Mutex);
+
+	Batch& batch = GetRecordingBatch();
+
+	VkBufferCopy copyRegion = {};
+	copyRegion.srcOffset = 0;
+	copyRegion.dstOffset = offset;
+	copyRegion.size = size;
+
+	vkCmdCopyBuffer(batch.CommandBuffer->GetHandle(), stagingBuffer->GetHandle<VkBuffer>(), destination.GetHandle<VkBuffer>(), 1, &copyRegion);
+
+	batch.StagingBuffers.emplace_back(std::move(stagingBuffer));
+}
+
+void UploadQueue::Submit()
+{
+	PROFILE_FUNCTION();
+
+	std::scoped_lock lock(m_Mutex);
+
+	if (!m_RecordingBatch)
+		return;
+
+	Batch& batch = *m_RecordingBatch;
+	batch.CommandBuffer->EndRecording();
+	batch.Value = ++m_SubmittedValue;
+
+	VkTimelineSemaphoreSubmitInfo timelineInfo;
+	ZeroInitVkStruct(timelineInfo, VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO);
+
+	timelineInfo.signalSemaphoreValueCount = 1;
+	timelineInfo.pSignalSemaphoreValues = &batch.Value;
+
+	VkSubmitInfo submitInfo;
+	ZeroInitVkStruct(submitInfo, VK_STRUCTURE_TYPE_SUBMIT_INFO);
+
+	submitInfo.pNext = &timelineInfo;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &batch.CommandBuffer->GetHandle();
+	submitInfo.signalSemaphoreCount = 1;
+	submitInfo.pSignalSemaphores = &m_Semaphore->GetHandle();
+
+	VkResult result = vkQueueSubmit(m_Device.GetTransferQueue(), 1, &submitInfo, VK_NULL_HANDLE);
+	VK_CHECK_RESULT(result);
+
+	m_SubmittedBatches.emplace_back(std::move(batch));
+	m_RecordingBatch.reset();
+}
+
+void UploadQueue::Collect()
+{
+	std::scoped_lock lock(m_Mutex);
+
+	if (m_SubmittedBatches.empty())
+		return;
+
+	const uint64_t completedValue = m_Semaphore->GetValue();
+
+	while (!m_SubmittedBatches.empty() && m_SubmittedBatches.front().Value <= completedValue)
+	{
+		auto& batch = m_SubmittedBatches.front();
+
+		batch.CommandBuffer->Reset();
+		m_FreeCommandBuffers.emplace_back(std::move(batch.CommandBuffer));
+
+		m_SubmittedBatches.pop_front();
+	}
+}
+
+void UploadQueue::WaitIdle()
+{
+	Submit();
+
+	m_Semaphore->Wait(GetSubmittedValue(), std::numeric_limits<uint64_t>::max());
+
+	Collect();
+}
+
+const TimelineSemaphore& UploadQueue::GetSemaphore() const
+{
+	return *m_Semaphore;
+}
+
+uint64_t UploadQueue::GetSubmittedValue() const
+{
+	std::scoped_lock lock(m_Mutex);
+
+	return m_SubmittedValue;
+}
+
+uint64_t UploadQueue::GetCompletedValue() const
+{
+	return m_Semaphore->GetValue();
+}
+
+UploadQueue::Batch& UploadQueue::GetRecordingBatch()
+{
+	if (m_RecordingBatch)
+		return *m_RecordingBatch;
+
+	m_RecordingBatch = CreateScope<Batch>();
+
+	auto& commandBuffer = m_RecordingBatch->CommandBuffer;
+
+	if (!m_FreeCommandBuffers.empty())
+	{
+		commandBuffer = std::move(m_FreeCommandBuffers.back());
+		m_FreeCommandBuffers.pop_back();
+	}
+	else
+	{
+		commandBuffer = CommandBuffer::Create(true, *m_CommandPool);
+	}
+
+	commandBuffer->BeginRecording(true);
+
+	return *m_RecordingBatch;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Base.h"
+
+#include "VK.h"
+
+#include <vector>
+#include <deque>
+#include <mutex>
+
+class Device;
+class CommandPool;
+class CommandBuffer;
+class GBuffer;
+class TimelineSemaphore;
+
+// Batches staging copies into device-local buffers into one command buffer per submit
+// Runs on the dedicated transfer queue when there's one, completion is tracked with a timeline semaphore,
+// so neither the recording nor the submitting thread ever waits for the copies
+class UploadQueue
+{
+	struct Batch
+	{
+		Ref<CommandBuffer> CommandBuffer;
+		std::vector<Scope<GBuffer>> StagingBuffers;
+
+		// Signaled on the timeline semaphore once the copies are done
+		uint64_t Value = 0;
+	};
+public:
+	UploadQueue(const Device& device);
+	~UploadQueue();
+
+	DELETE_COPY_AND_MOVE(UploadQueue);
+
+	// Records a copy into the pending batch, data is copied to a staging buffer right away
+	void Upload(const GBuffer& destination, const void* data, VkDeviceSize size, VkDeviceSize offset = 0);
+
+	// Submits the pending batch, doesn't wait for it
+	void Submit();
+	// Releases the staging buffers and recycles the command buffers of completed batches
+	void Collect();
+
+	void WaitIdle();
+
+	// Wait on it with GetSubmittedValue() before using the uploaded buffers on another queue
+	const TimelineSemaphore& GetSemaphore() const;
+	uint64_t GetSubmittedValue() const;
+	uint64_t GetCompletedValue() const;
+private:
+	Batch& GetRecordingBatch();
+private:
+	const Device& m_Device;
+
+	Scope<CommandPool> m_CommandPool;
+	Ref<TimelineSemaphore> m_Semaphore;
+
+	Scope<Batch> m_RecordingBatch;
+	std::deque<Batch> m_SubmittedBatches;
+	std::vector<Ref<CommandBuffer>> m_FreeCommandBuffers;
+
+	uint64_t m_SubmittedValue = 0;
+
+	// Command pools must be externally synchronized
+	mutable std::mutex m_Mutex;
+};
@@ -4,6 +4,7 @@
 
 #include "Buffer.h"
 #include "FileStream.h"
+#include "MappedFile.h"
 
 #include <filesystem>
 
@@ -67,6 +68,47 @@ uint64_t HashString(const std::string& str)
 	return hash;
 }
 
+uint64_t HashBytes(const void* data, size_t size)
+{
+	static constexpr uint64_t s_OffsetBasis = 14695981039346656037ULL;
+	static constexpr uint64_t s_Prime = 1099511628211ULL;
+
+	const auto* bytes = static_cast<const uint8_t*>(data);
+
+	uint64_t hash = s_OffsetBasis;
+
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= static_cast<uint64_t>(bytes[i]);
+		hash *= s_Prime;
+	}
+
+	return hash;
+}
+
+void HashCombine(uint64_t& seed, uint64_t value)
+{
+	seed ^= value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+}
+
+int64_t GetFileTimestamp(const std::filesystem::path& path)
+{
+	std::error_code error;
+	const auto time = std::filesystem::last_write_time(path, error);
+
+	return error ? 0 : static_cast<int64_t>(time.time_since_epoch().count());
+}
+
+uint64_t HashFile(const std::filesystem::path& path)
+{
+	auto file = MappedFile::Create(path);
+
+	if (!file)
+		return 0;
+
+	return HashBytes(file->GetData(), file->GetSize());
+}
+
 void Delete(const std::filesystem::path& path, const std::string& what)
 {
 	if (std::filesystem::exists(path) && std::filesystem::is_directory(path))
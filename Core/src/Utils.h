@@ -2,6 +2,7 @@
 
 #include <string>
 #include <filesystem>
+#include <type_traits>
 
 class Buffer;
 
@@ -15,5 +16,22 @@ bool WriteToFile(const std::filesystem::path& path, const Buffer& buffer);
 // Taken from: https://www.strchr.com/hash_functions
 uint64_t HashString(const std::string& str);
 
+// 64-bit FNV-1a, used for content hashes (SPIR-V, pipeline state)
+uint64_t HashBytes(const void* data, size_t size);
+
+template<typename T>
+	requires std::is_trivially_copyable_v<T>
+uint64_t HashBytes(const T& value)
+{
+	return HashBytes(&value, sizeof(value));
+}
+
+// Taken from boost::hash_combine
+void HashCombine(uint64_t& seed, uint64_t value);
+
+// Used by the on-disk caches to tell whether their source changed, 0 if the file can't be read
+int64_t GetFileTimestamp(const std::filesystem::path& path);
+uint64_t HashFile(const std::filesystem::path& path);
+
 // Convenient way to delete .spv files after each run
 void Delete(const std::filesystem::path& path, const std::string& what);
\ No newline at end of file
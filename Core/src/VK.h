@@ -106,6 +106,7 @@ typedef VkFlags VkCommandPoolCreateFlags;
 typedef VkFlags VkFenceCreateFlags;
 typedef VkFlags VkImageCreateFlags;
 typedef VkFlags VkShaderStageFlags;
+typedef VkFlags VkPipelineStageFlags;
 
 VK_FWD_DECL_HANDLE(VkInstance)
 VK_FWD_DECL_HANDLE(VkDebugUtilsMessengerEXT)
@@ -122,6 +123,7 @@ VK_FWD_DECL_HANDLE(VkShaderModule)
 VK_FWD_DECL_HANDLE(VkRenderPass)
 VK_FWD_DECL_HANDLE(VkPipeline)
 VK_FWD_DECL_HANDLE(VkPipelineLayout)
+VK_FWD_DECL_HANDLE(VkPipelineCache)
 VK_FWD_DECL_HANDLE(VkDescriptorSet)
 VK_FWD_DECL_HANDLE(VkDescriptorSetLayout)
 VK_FWD_DECL_HANDLE(VkCommandPool)
@@ -143,6 +145,7 @@ VK_FWD_DECL_STRUCT(VkPhysicalDeviceProperties)
 VK_FWD_DECL_STRUCT(VkQueueFamilyProperties)
 VK_FWD_DECL_STRUCT(VkDescriptorSetLayoutBinding)
 VK_FWD_DECL_STRUCT(VkPushConstantRange)
+VK_FWD_DECL_STRUCT(VkMemoryRequirements)
 
 VK_FWD_DECL_ENUM(VkResult)
 VK_FWD_DECL_ENUM(VkPresentModeKHR)
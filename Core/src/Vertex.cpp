@@ -1,2 +1,80 @@
 #include "Vertex.h"
 
+#include <glm/gtc/packing.hpp>
+
+#include <cmath>
+
+// See "A Survey of Efficient Representations for Independent Unit Vectors" (Cigolle et al. 2014)
+// Decoded in the shader with:
+// vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y)); float t = max(-n.z, 0.0); n.xy += mix(vec2(t), vec2(-t), greaterThanEqual(n.xy, vec2(0.0))); n = normalize(n);
+static glm::vec2 EncodeOctahedral(const glm::vec3& normal)
+{
+	const float length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+
+	if (0.0f == length)
+		return glm::vec2(0.0f);
+
+	const glm::vec3 n = normal / length;
+
+	if (n.z >= 0.0f)
+		return glm::vec2(n.x, n.y);
+
+	// Fold the lower hemisphere over the diagonals
+	return glm::vec2(
+		(1.0f - std::abs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f),
+		(1.0f - std::abs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f));
+}
+
+Layout GetVertexLayout(VertexFormat format)
+{
+	Layout layout;
+
+	switch (format)
+	{
+	case VertexFormat::FULL:
+		layout.Add<glm::vec3>("inPosition");
+		layout.Add<glm::vec3>("inNormal");
+		layout.Add<glm::vec2>("inTexCoord");
+		layout.Add<glm::vec4>("inColor");
+		break;
+	case VertexFormat::PACKED:
+		layout.Add("inPosition", Format::RGBA_16_SNORM);
+		layout.Add("inNormal", Format::RG_16_SNORM);
+		layout.Add("inTexCoord", Format::RG_16_SFLOAT);
+		layout.Add("inColor", Format::RGBA_8_UNORM);
+		break;
+	default:
+		break;
+	}
+
+	return layout;
+}
+
+uint32_t GetVertexStride(VertexFormat format)
+{
+	return (VertexFormat::PACKED == format) ? sizeof(PackedVertex) : sizeof(Vertex);
+}
+
+PackedVertex PackVertex(const Vertex& vertex, const glm::vec3& center, const glm::vec3& halfExtent)
+{
+	PackedVertex packed;
+
+	// Flat meshes have a zero extent along one axis
+	const glm::vec3 position = (vertex.Position - center) / glm::max(halfExtent, glm::vec3(1e-6f));
+
+	for (int i = 0; i < 3; i++)
+		packed.Position[i] = static_cast<int16_t>(glm::packSnorm1x16(position[i]));
+
+	const glm::vec2 normal = EncodeOctahedral(vertex.Normal);
+
+	for (int i = 0; i < 2; i++)
+	{
+		packed.Normal[i] = static_cast<int16_t>(glm::packSnorm1x16(normal[i]));
+		packed.TexCoord[i] = glm::packHalf1x16(vertex.TexCoord[i]);
+	}
+
+	for (int i = 0; i < 4; i++)
+		packed.Color[i] = glm::packUnorm1x8(vertex.Color[i]);
+
+	return packed;
+}
@@ -2,8 +2,12 @@
 
 #include "VK.h"
 
+#include "Layout.h"
+
 #include <glm/glm.hpp>
 
+#include <cstdint>
+
 struct SimpleVertex
 {
 	glm::vec3 Position;
@@ -16,4 +20,35 @@ struct Vertex
 	glm::vec3 Normal = glm::vec3(0.0f);
 	glm::vec2 TexCoord = glm::vec2(0.0f);
 	glm::vec4 Color = glm::vec4(0.0f);
-};
\ No newline at end of file
+};
+
+// 20 bytes instead of 48, for large static meshes
+// Position is relative to the mesh bounds, see Mesh::GetDequantizationTransform()
+struct PackedVertex
+{
+	// snorm16, w is padding
+	int16_t Position[4] = {};
+	// Octahedral encoded, snorm16
+	int16_t Normal[2] = {};
+	// half
+	uint16_t TexCoord[2] = {};
+	// unorm8
+	uint8_t Color[4] = {};
+};
+
+static_assert(sizeof(PackedVertex) == 20);
+
+enum class VertexFormat
+{
+	// Vertex
+	FULL,
+	// PackedVertex
+	PACKED
+};
+
+// Names match the vertex shader inputs: inPosition, inNormal, inTexCoord, inColor
+Layout GetVertexLayout(VertexFormat format);
+uint32_t GetVertexStride(VertexFormat format);
+
+// center and halfExtent of the mesh bounds
+PackedVertex PackVertex(const Vertex& vertex, const glm::vec3& center, const glm::vec3& halfExtent);
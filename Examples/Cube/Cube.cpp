@@ -15,7 +15,8 @@ protected:
 		const auto& [width, height] = Application::GetSize();
 		m_Camera = Camera(float(width) / float(height));
 
-		ShaderCompiler::CompileWithValidator(GetProjectDirectory() + "/Shaders/");
+		ShaderCompiler::CompileDirectory(GetProjectDirectory() + "/Shaders/");
+		WatchShaders(GetProjectDirectory() + "/Shaders/");
 
 		std::vector<::Vertex> vertices = {
 				 {.Position = { -0.5f, -0.5f, -0.5f }, .TexCoord = { 0.0f, 0.0f } },
@@ -64,7 +65,7 @@ protected:
 		m_VertexBuffer = GBuffer::CreateVertex(vertices.size() * sizeof(::Vertex), vertices.data());
 		m_UniformBuffer = GBuffer::CreateUniform(sizeof(Cube::UBO));
 
-		m_Texture = Texture::Create("Textures/container.jpg");
+		m_Texture = Texture::Create("Textures/container.jpg", { .Compression = TextureCompression::BC1 });
 
 		PipelineDescription desc;
 
@@ -128,6 +129,11 @@ protected:
 	virtual void OnEvent(Event& event) override
 	{
 	}
+
+	virtual void OnSwapchainRecreated(uint32_t width, uint32_t height) override
+	{
+		m_Camera.SetAspectRatio(float(width) / float(height));
+	}
 private:
 	Camera m_Camera;
 
@@ -30,33 +30,41 @@ private:
 		const auto& [width, height] = Application::GetSize();
 		m_Camera = Camera(float(width) / float(height));
 
-		ShaderCompiler::CompileWithValidator(GetProjectDirectory() + "/Shaders/");
+		ShaderCompiler::CompileDirectory(GetProjectDirectory() + "/Shaders/");
+		WatchShaders(GetProjectDirectory() + "/Shaders/");
+
+		// Per-draw data is pushed to it every frame, see OnRender()
+		const auto& uniformBuffer = GetUniformRingBuffer().GetBuffer();
+
+		// Uploaded with a single submit, the models' finer mips are streamed in as they get closer, see RequestTexture()
+		{
+			constexpr std::array<std::string_view, 2> texturePaths = { "Textures/XwingColors.png", "Textures/VikingRoom.png" };
+			const auto textures = Texture::CreateBatch(texturePaths, { .Compression = TextureCompression::BC7, .Streamed = true });
+
+			m_Textures[s_AssetsNames[0]] = textures[0];
+			m_Textures[s_AssetsNames[2]] = textures[1];
+			// Glyph edges blur under block compression, the atlas stays uncompressed
+			m_Textures[s_AssetsNames[3]] = Texture::Create("Textures/Fonts.png");
+		}
 
 		// Xwing
 		{
 			const auto xWingAssetName = s_AssetsNames[0];
 
-			m_Meshes[xWingAssetName] = Mesh::Create("Models/Xwing.obj");
-			m_Textures[xWingAssetName] = Texture::Create("Textures/XwingColors.png");
-
-			m_UniformBuffers.insert({ xWingAssetName, GBuffer::CreateUniform(sizeof(Sandbox::UBO)) });
-			m_UniformBuffers.insert({ xWingAssetName, GBuffer::CreateUniform(sizeof(Sandbox::GUBO)) });
+			m_Meshes[xWingAssetName] = Mesh::Create("Models/Xwing.obj", VertexFormat::PACKED);
 
 			PipelineDescription desc;
 
-			desc.ShaderModules = { { StageFlag::VERTEX, "Shaders/Phong.vert.spv" }, { StageFlag::FRAGMENT, "Shaders/Phong.frag.spv" } };
+			desc.ShaderModules = { { StageFlag::VERTEX, "Shaders/PhongPacked.vert.spv" }, { StageFlag::FRAGMENT, "Shaders/Phong.frag.spv" } };
+			desc.DynamicUniformBuffers = { "ubo", "gubo" };
+			desc.VertexLayout = GetVertexLayout(VertexFormat::PACKED);
 
 			m_Pipelines[xWingAssetName] = Pipeline::Create(desc);
 
 			m_DescriptorSets[xWingAssetName] = DescriptorSet::Create({ m_Pipelines[xWingAssetName]->GetShader() });
 
-			uint32_t binding = 0;
-			auto range = m_UniformBuffers.equal_range(xWingAssetName);
-			for (auto it = range.first; it != range.second; it++)
-			{
-				m_DescriptorSets[xWingAssetName]->SetBuffer(binding, *(it->second));
-				binding += 2;
-			}
+			m_DescriptorSets[xWingAssetName]->SetBuffer("ubo", uniformBuffer);
+			m_DescriptorSets[xWingAssetName]->SetBuffer("gubo", uniformBuffer);
 
 			m_DescriptorSets[xWingAssetName]->SetTexture(1, static_cast<const Texture&>(*m_Textures[xWingAssetName]));
 		}
@@ -70,18 +78,17 @@ private:
 				"Textures/sky/top.png",   "Textures/sky/bottom.png",
 				"Textures/sky/front.png", "Textures/sky/back.png" });
 
-			const auto& skyboxUniform = m_UniformBuffers.insert({ skyboxAssetName, GBuffer::CreateUniform(sizeof(Sandbox::UBO)) });
-
 			PipelineDescription desc;
 
 			desc.ShaderModules = { { StageFlag::VERTEX, "Shaders/Skybox.vert.spv" }, { StageFlag::FRAGMENT, "Shaders/Skybox.frag.spv" } };
+			desc.DynamicUniformBuffers = { "ubo" };
 			desc.CompareOp = CompareOp::LESS_OR_EQUAL;
 
 			m_Pipelines[skyboxAssetName] = Pipeline::Create(desc);
 
 			m_DescriptorSets[skyboxAssetName] = DescriptorSet::Create({ m_Pipelines[skyboxAssetName]->GetShader() });
 
-			m_DescriptorSets[skyboxAssetName]->SetBuffer(0, *(skyboxUniform->second));
+			m_DescriptorSets[skyboxAssetName]->SetBuffer("ubo", uniformBuffer);
 			m_DescriptorSets[skyboxAssetName]->SetTexture(1, static_cast<const Texture&>(m_Skybox->GetTexture()));
 		}
 
@@ -89,28 +96,21 @@ private:
 		{
 			const auto roomAssetName = s_AssetsNames[2];
 
-			m_Meshes[roomAssetName] = Mesh::Create("Models/VikingRoom.obj");
-			m_Textures[roomAssetName] = Texture::Create("Textures/VikingRoom.png");
-
-			m_UniformBuffers.insert({ roomAssetName, GBuffer::CreateUniform(sizeof(Sandbox::UBO)) });
-			m_UniformBuffers.insert({ roomAssetName, GBuffer::CreateUniform(sizeof(Sandbox::GUBO)) });
+			m_Meshes[roomAssetName] = Mesh::Create("Models/VikingRoom.obj", VertexFormat::PACKED);
 
 			PipelineDescription desc;
 
-			desc.ShaderModules = { { StageFlag::VERTEX, "Shaders/Phong.vert.spv" }, { StageFlag::FRAGMENT, "Shaders/Phong.frag.spv" } };
+			desc.ShaderModules = { { StageFlag::VERTEX, "Shaders/PhongPacked.vert.spv" }, { StageFlag::FRAGMENT, "Shaders/Phong.frag.spv" } };
+			desc.DynamicUniformBuffers = { "ubo", "gubo" };
+			desc.VertexLayout = GetVertexLayout(VertexFormat::PACKED);
 			desc.CullMode = CullMode::NONE;
 
 			m_Pipelines[roomAssetName] = Pipeline::Create(desc);
 
 			m_DescriptorSets[roomAssetName] = DescriptorSet::Create({ m_Pipelines[roomAssetName]->GetShader() });
 
-			uint32_t binding = 0;
-			auto range = m_UniformBuffers.equal_range(roomAssetName);
-			for (auto it = range.first; it != range.second; it++)
-			{
-				m_DescriptorSets[roomAssetName]->SetBuffer(binding, *(it->second));
-				binding += 2;
-			}
+			m_DescriptorSets[roomAssetName]->SetBuffer("ubo", uniformBuffer);
+			m_DescriptorSets[roomAssetName]->SetBuffer("gubo", uniformBuffer);
 
 			m_DescriptorSets[roomAssetName]->SetTexture(1, static_cast<const Texture&>(*m_Textures[roomAssetName]));
 		}
@@ -124,13 +124,11 @@ private:
 			CreateTextMesh(demoText, textVertices, textIndices);
 
 			m_Meshes[textAssetName] = Mesh::Create(textVertices, textIndices);
-			m_Textures[textAssetName] = Texture::Create("Textures/Fonts.png");
-
-			const auto& textUniform = m_UniformBuffers.insert({ textAssetName, GBuffer::CreateUniform(sizeof(Sandbox::UBO)) });
 
 			PipelineDescription desc;
 
 			desc.ShaderModules = { { StageFlag::VERTEX, "Shaders/Text.vert.spv" }, { StageFlag::FRAGMENT, "Shaders/Text.frag.spv" } };
+			desc.DynamicUniformBuffers = { "ubo" };
 			desc.CompareOp = CompareOp::LESS_OR_EQUAL;
 			desc.CullMode = CullMode::NONE;
 			desc.EnableTransparency = true;
@@ -139,7 +137,7 @@ private:
 
 			m_DescriptorSets[textAssetName] = DescriptorSet::Create({ m_Pipelines[textAssetName]->GetShader() });
 
-			m_DescriptorSets[textAssetName]->SetBuffer(0, *(textUniform->second));
+			m_DescriptorSets[textAssetName]->SetBuffer("ubo", uniformBuffer);
 			m_DescriptorSets[textAssetName]->SetTexture(1, static_cast<const Texture&>(*m_Textures[textAssetName]));
 		}
 	}
@@ -151,37 +149,19 @@ private:
 		m_Camera.OnUpdate(dt);
 
 		UpdateModels();
-
-		UpdateUniformBuffers();
 	}
 
 	virtual void OnRender(CommandBuffer& commandBuffer) override
 	{
-		for (size_t i = 0; i < s_AssetsNames.size(); i++)
-		{
-			const auto assetName = s_AssetsNames[i];
-			commandBuffer.BindPipeline(*m_Pipelines[assetName]);
-			commandBuffer.BindDescriptorSet(*(m_DescriptorSets.find(assetName)->second));
+		// Before recording, the ring buffer isn't thread-safe
+		PushUniformBuffers();
 
-			if (i == 1)
-			{
-				const auto& skyboxMesh = m_Skybox->GetMesh();
-				commandBuffer.BindVertexBuffer(skyboxMesh.GetVertexBuffer());
-				commandBuffer.BindIndexBuffer(skyboxMesh.GetIndexBuffer());
-				commandBuffer.DrawIndexed(skyboxMesh.GetIndexCount());
-			}
-			else
+		// The maps are only read from here on, using at() so nothing gets inserted from the workers
+		RecordParallel(static_cast<uint32_t>(s_AssetsNames.size()), [this](CommandBuffer& commandBuffer, uint32_t begin, uint32_t end)
 			{
-				const auto& mesh = m_Meshes[assetName];
-				commandBuffer.BindVertexBuffer(mesh->GetVertexBuffer());
-				commandBuffer.BindIndexBuffer(mesh->GetIndexBuffer());
-				if (i != 3)
-					commandBuffer.DrawIndexed(m_Meshes[assetName]->GetIndexCount());
-				else
-					commandBuffer.DrawIndexed(static_cast<uint32_t>(demoText[0].len), static_cast<uint32_t>(demoText[0].start));
-			}
-
-		}
+				for (uint32_t i = begin; i < end; i++)
+					RecordAsset(commandBuffer, i);
+			});
 	}
 
 	virtual void OnShutdown() override
@@ -190,7 +170,7 @@ private:
 		m_DescriptorSets.clear();
 		m_Textures.clear();
 		m_Meshes.clear();
-		m_UniformBuffers.clear();
+		m_DynamicOffsets.clear();
 
 		m_Skybox.reset();
 	}
@@ -198,6 +178,11 @@ private:
 	virtual void OnEvent(Event& event) override
 	{
 	}
+
+	virtual void OnSwapchainRecreated(uint32_t width, uint32_t height) override
+	{
+		m_Camera.SetAspectRatio(float(width) / float(height));
+	}
 private:
 	void UpdateModels()
 	{
@@ -224,35 +209,81 @@ private:
 		}
 	}
 
-	void UpdateUniformBuffers()
+	void RecordAsset(CommandBuffer& commandBuffer, uint32_t i)
 	{
+		const auto assetName = s_AssetsNames[i];
+		const auto& dynamicOffsets = m_DynamicOffsets.at(assetName);
+
+		commandBuffer.BindPipeline(*m_Pipelines.at(assetName));
+		commandBuffer.BindDescriptorSet(*m_DescriptorSets.at(assetName), dynamicOffsets);
+
+		if (i == 1)
+		{
+			const auto& skyboxMesh = m_Skybox->GetMesh();
+			commandBuffer.BindVertexBuffer(skyboxMesh.GetVertexBuffer());
+			commandBuffer.BindIndexBuffer(skyboxMesh.GetIndexBuffer());
+			commandBuffer.DrawIndexed(skyboxMesh.GetIndexCount());
+		}
+		else
+		{
+			const auto& mesh = m_Meshes.at(assetName);
+			commandBuffer.BindVertexBuffer(mesh->GetVertexBuffer());
+			commandBuffer.BindIndexBuffer(mesh->GetIndexBuffer());
+			if (i != 3)
+				commandBuffer.DrawIndexed(mesh->GetIndexCount());
+			else
+				commandBuffer.DrawIndexed(static_cast<uint32_t>(demoText[0].len), static_cast<uint32_t>(demoText[0].start));
+		}
+	}
+
+	// Asks for the mips matching how big the mesh's bounding sphere is on screen
+	void RequestTexture(const std::string& assetName)
+	{
+		auto* texture = dynamic_cast<StreamedTexture*>(m_Textures.at(assetName).get());
+
+		if (!texture)
+			return;
+
+		const auto& bounds = m_Meshes.at(assetName)->GetBounds();
+		const auto& model = m_Models.at(assetName);
+
+		const glm::vec3 center = glm::vec3(model * glm::vec4((bounds.Min + bounds.Max) * 0.5f, 1.0f));
+		const float radius = glm::length(bounds.Max - bounds.Min) * 0.5f * glm::length(glm::vec3(model[0]));
+		const float distance = std::max(glm::distance(center, m_Camera.GetPosition()), radius);
+
+		const auto& [width, height] = GetSize();
+
+		// Projection[1][1] is 1 / tan(fovY / 2)
+		texture->RequestScreenSize(radius / distance * m_Camera.GetProjection()[1][1] * static_cast<float>(height));
+	}
+
+	void PushUniformBuffers()
+	{
+		auto& uniformBuffer = GetUniformRingBuffer();
+
 		const auto& cameraPosition = m_Camera.GetPosition();
 		const auto& cameraViewProjection = m_Camera.GetViewProjection();
 
+		Sandbox::GUBO gubo = {};
+		gubo.LightDir = glm::vec3(glm::cos(glm::radians(135.0f)), glm::sin(glm::radians(135.0f)), 0.0f);
+		gubo.LightColor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+		gubo.CameraPosition = cameraPosition;
+
+		const uint32_t guboOffset = uniformBuffer.Push(gubo);
+
 		// Xwing
 		{
 			const auto xWingAssetName = s_AssetsNames[0];
 
 			Sandbox::UBO ubo = {};
-			ubo.Model = m_Models[xWingAssetName];
+			ubo.Model = m_Models[xWingAssetName] * m_Meshes[xWingAssetName]->GetDequantizationTransform();
 			ubo.MVP = cameraViewProjection * ubo.Model;
-			ubo.Normal = glm::inverseTranspose(ubo.Model);
-
-			Sandbox::GUBO gubo = {};
-			gubo.LightDir = glm::vec3(glm::cos(glm::radians(135.0f)), glm::sin(glm::radians(135.0f)), 0.0f);
-			gubo.LightColor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
-			gubo.CameraPosition = cameraPosition;
+			ubo.Normal = glm::inverseTranspose(m_Models[xWingAssetName]);
 
+			// In binding order
+			m_DynamicOffsets[xWingAssetName] = { uniformBuffer.Push(ubo), guboOffset };
 
-			uint32_t binding = 0;
-			auto range = m_UniformBuffers.equal_range(xWingAssetName);
-			for (auto it = range.first; it != range.second; it++)
-			{
-				Ref<GBuffer> buffer = it->second;
-				(binding == 0) ? buffer->SetData(&ubo) : buffer->SetData(&gubo);
-
-				binding += 2;
-			}
+			RequestTexture(xWingAssetName);
 		}
 
 		// Skybox
@@ -264,7 +295,7 @@ private:
 			sbubo.Model = glm::mat4(1.0f);
 			sbubo.Normal = glm::mat4(1.0f);
 
-			m_UniformBuffers.find(skyboxAssetName)->second->SetData(&sbubo);
+			m_DynamicOffsets[skyboxAssetName] = { uniformBuffer.Push(sbubo) };
 		}
 
 		// Room
@@ -272,24 +303,22 @@ private:
 			const auto roomAssetName = s_AssetsNames[2];
 
 			Sandbox::UBO ubo = {};
-			ubo.Model = m_Models[roomAssetName];
-			ubo.MVP = m_Camera.GetViewProjection() * ubo.Model;
-			ubo.Normal = glm::inverseTranspose(ubo.Model);
-
-			Sandbox::GUBO gubo = {};
-			gubo.LightDir = glm::vec3(glm::cos(glm::radians(135.0f)), glm::sin(glm::radians(135.0f)), 0.0f);
-			gubo.LightColor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
-			gubo.CameraPosition = cameraPosition;
-
-			uint32_t binding = 0;
-			auto range = m_UniformBuffers.equal_range(roomAssetName);
-			for (auto it = range.first; it != range.second; it++)
-			{
-				Ref<GBuffer> buffer = it->second;
-				(0 == binding) ? buffer->SetData(&ubo) : buffer->SetData(&gubo);
+			ubo.Model = m_Models[roomAssetName] * m_Meshes[roomAssetName]->GetDequantizationTransform();
+			ubo.MVP = cameraViewProjection * ubo.Model;
+			ubo.Normal = glm::inverseTranspose(m_Models[roomAssetName]);
+
+			m_DynamicOffsets[roomAssetName] = { uniformBuffer.Push(ubo), guboOffset };
+
+			RequestTexture(roomAssetName);
+		}
+
+		// Text
+		{
+			const auto textAssetName = s_AssetsNames[3];
+
+			Sandbox::UBO ubo = {};
 
-				binding += 2;
-			}
+			m_DynamicOffsets[textAssetName] = { uniformBuffer.Push(ubo) };
 		}
 	}
 private:
@@ -304,7 +333,7 @@ private:
 	std::unordered_map<std::string, Ref<Texture>> m_Textures;
 	std::unordered_map<std::string, Ref<Pipeline>> m_Pipelines;
 	std::unordered_map<std::string, Ref<Mesh>> m_Meshes;
-	std::unordered_multimap<std::string, Ref<GBuffer>> m_UniformBuffers;
+	std::unordered_map<std::string, std::vector<uint32_t>> m_DynamicOffsets;
 };
 
 int main(int argc, char** argv)
@@ -0,0 +1,35 @@
+#version 450
+
+// PackedVertex, the fetch converts to float (see GetVertexLayout(VertexFormat::PACKED))
+layout (location = 0) in vec3 inPosition;
+layout (location = 1) in vec2 inNormal;
+layout (location = 2) in vec2 inTexCoord;
+layout (location = 3) in vec4 inColor;
+
+layout(location = 0) out vec3 outPosition;
+layout(location = 1) out vec3 outNormal;
+layout(location = 2) out vec2 outTexCoord;
+
+layout (set = 0, binding = 0) uniform UBO 
+{
+    // Include the mesh's dequantization transform
+    mat4 MVP;
+    mat4 Model;
+    mat4 Normal;
+} ubo;
+
+vec3 DecodeOctahedral(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.xy += mix(vec2(t), vec2(-t), greaterThanEqual(n.xy, vec2(0.0)));
+    return normalize(n);
+}
+
+void main()
+{
+    gl_Position = ubo.MVP * vec4(inPosition, 1.0);
+    outPosition = (ubo.Model * vec4(inPosition, 1.0)).xyz;
+    outNormal = mat3(ubo.Normal[0].xyz, ubo.Normal[1].xyz, ubo.Normal[2].xyz) * DecodeOctahedral(inNormal);
+    outTexCoord = inTexCoord;
+}
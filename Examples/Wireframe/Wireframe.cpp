@@ -26,7 +26,8 @@ protected:
 		m_Camera = Camera(float(width) / float(height));
 #endif
 
-		ShaderCompiler::CompileWithValidator(GetProjectDirectory() + "/Shaders/");
+		ShaderCompiler::CompileDirectory(GetProjectDirectory() + "/Shaders/");
+		WatchShaders(GetProjectDirectory() + "/Shaders/");
 
 		m_UniformBuffer = GBuffer::CreateUniform(sizeof(UBO));
 
@@ -140,6 +141,15 @@ protected:
 	virtual void OnEvent(Event& event) override
 	{
 	}
+
+	virtual void OnSwapchainRecreated(uint32_t width, uint32_t height) override
+	{
+#if DYNAMIC_VIEWPORT
+		m_Camera.SetAspectRatio(float(width) * 0.5f / float(height));
+#else
+		m_Camera.SetAspectRatio(float(width) / float(height));
+#endif
+	}
 private:
 	Camera m_Camera;
 
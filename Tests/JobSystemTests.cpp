@@ -0,0 +1,210 @@
+#include "Tests.h"
+
+#include "JobSystem.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+TEST(JobSystem_BackgroundJobsSkipTheInitThread)
+{
+	JobSystem::Init(2);
+
+	std::atomic<uint32_t> onInitThread = 0;
+	std::atomic<uint32_t> ranCount = 0;
+
+	JobCounter background;
+
+	for (uint32_t i = 0; i < 16; i++)
+	{
+		JobSystem::ExecuteInBackground([&]()
+			{
+				if (0 == JobSystem::GetThreadIndex())
+					onInitThread++;
+
+				// Nested work still spreads out
+				JobSystem::ParallelFor(1000, 16, [](uint32_t) {});
+
+				ranCount++;
+			}, &background);
+	}
+
+	// Helping out here mustn't pick them up
+	JobCounter counter;
+
+	for (uint32_t i = 0; i < 256; i++)
+		JobSystem::Execute([]() {}, &counter);
+
+	JobSystem::WaitFor(counter);
+	JobSystem::WaitFor(background);
+
+	CHECK(0 == onInitThread);
+	CHECK(16 == ranCount);
+
+	// Still queued ones are run by Shutdown()
+	JobSystem::ExecuteInBackground([&]() { ranCount++; });
+	JobSystem::Shutdown();
+
+	CHECK(17 == ranCount);
+}
+
+TEST(JobSystem_ParallelForVisitsEveryIndexOnce)
+{
+	JobSystem::Init(3);
+
+	for (const uint32_t count : { 0u, 1u, 7u, 1000u, 10007u })
+	{
+		std::vector<std::atomic<uint32_t>> visits(count);
+
+		JobSystem::ParallelFor(count, 13, [&visits](uint32_t i) { visits[i]++; });
+
+		for (const auto& visit : visits)
+			CHECK(1 == visit);
+
+		// Batch size picked from the worker count
+		JobSystem::ParallelFor(count, [&visits](uint32_t i) { visits[i]++; });
+
+		for (const auto& visit : visits)
+			CHECK(2 == visit);
+	}
+
+	// Nested, the inner loops run while the outer batches wait for them
+	std::atomic<uint32_t> total = 0;
+
+	JobSystem::ParallelFor(64, 1, [&total](uint32_t)
+		{
+			JobSystem::ParallelFor(100, 10, [&total](uint32_t) { total++; });
+		});
+
+	CHECK(6400 == total);
+
+	JobSystem::Shutdown();
+}
+
+TEST(JobSystem_DependentCounters)
+{
+	JobSystem::Init(3);
+
+	constexpr uint32_t jobCount = 200;
+
+	std::atomic<uint32_t> first = 0;
+	std::atomic<uint32_t> second = 0;
+	std::atomic<uint32_t> early = 0;
+
+	JobCounter firstCounter;
+	JobCounter secondCounter;
+	JobCounter thirdCounter;
+
+	// Queued before the jobs they depend on are done, or even queued
+	for (uint32_t i = 0; i < jobCount; i++)
+	{
+		JobSystem::Execute([&]()
+			{
+				std::this_thread::sleep_for(std::chrono::microseconds(50));
+				first++;
+			}, &firstCounter);
+	}
+
+	for (uint32_t i = 0; i < jobCount; i++)
+	{
+		JobSystem::Execute([&]()
+			{
+				if (jobCount != first)
+					early++;
+
+				second++;
+			}, &secondCounter, &firstCounter);
+	}
+
+	JobSystem::Execute([&]()
+		{
+			if (jobCount != second)
+				early++;
+		}, &thirdCounter, &secondCounter);
+
+	CHECK(secondCounter.GetValue() <= jobCount);
+
+	JobSystem::WaitFor(thirdCounter);
+
+	CHECK(firstCounter.IsDone() && secondCounter.IsDone());
+	CHECK(jobCount == first && jobCount == second);
+	CHECK(0 == early);
+
+	JobSystem::Shutdown();
+}
+
+TEST(JobSystem_WaitFor)
+{
+	JobSystem::Init(2);
+
+	// Jobs waiting on their own children, more of them than there are workers
+	std::atomic<uint32_t> childCount = 0;
+	std::atomic<uint32_t> unfinished = 0;
+
+	JobCounter parents;
+
+	for (uint32_t i = 0; i < 32; i++)
+	{
+		JobSystem::Execute([&]()
+			{
+				JobCounter children;
+
+				for (uint32_t j = 0; j < 32; j++)
+					JobSystem::Execute([&childCount]() { childCount++; }, &children);
+
+				JobSystem::WaitFor(children);
+
+				if (!children.IsDone())
+					unfinished++;
+			}, &parents);
+	}
+
+	JobSystem::WaitFor(parents);
+
+	CHECK(parents.IsDone());
+	CHECK(32 * 32 == childCount);
+	CHECK(0 == unfinished);
+
+	// Not a JobSystem thread, its jobs run inline and the wait returns right away
+	uint32_t external = JobSystem::GetThreadIndex();
+
+	std::thread([&external]()
+		{
+			JobCounter counter;
+			JobSystem::Execute([&external]() { external = JobSystem::GetThreadIndex(); }, &counter);
+			JobSystem::WaitFor(counter);
+		}).join();
+
+	CHECK(JobSystem::InvalidThreadIndex == external);
+
+	JobSystem::Shutdown();
+}
+
+TEST(JobSystem_ShutdownRunsJobsQueuedWhileStopping)
+{
+	JobSystem::Init(2);
+
+	std::atomic<bool> started = false;
+	std::atomic<uint32_t> childCount = 0;
+
+	// Still running when Shutdown() is called, its children are queued after the workers were told to stop
+	JobSystem::ExecuteInBackground([&]()
+		{
+			started = true;
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+			for (uint32_t i = 0; i < 100; i++)
+				JobSystem::Execute([&childCount]() { childCount++; });
+
+			JobSystem::ExecuteInBackground([&childCount]() { childCount++; });
+		});
+
+	while (!started)
+		std::this_thread::yield();
+
+	JobSystem::Shutdown();
+
+	CHECK(101 == childCount);
+}
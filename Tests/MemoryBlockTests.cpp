@@ -0,0 +1,242 @@
+#include "Tests.h"
+
+#include "MemoryBlock.h"
+
+#include <algorithm>
+#include <random>
+
+struct Range
+{
+	VkDeviceSize Offset = 0;
+	VkDeviceSize Size = 0;
+};
+
+static Range Allocate(MemoryBlock& block, VkDeviceSize size, VkDeviceSize alignment = 1)
+{
+	const auto offset = block.Allocate(size, alignment);
+	CHECK(offset.has_value());
+
+	return { offset.value_or(0), size };
+}
+
+static void Free(MemoryBlock& block, const Range& range)
+{
+	block.Free(range.Offset, range.Size);
+}
+
+TEST(MemoryBlock_BestFit)
+{
+	MemoryBlock block(1000);
+
+	const auto a = Allocate(block, 100);
+	Allocate(block, 50);
+	const auto c = Allocate(block, 300);
+	Allocate(block, 50);
+
+	// Free ranges: 100 at 0, 300 at 150, 500 at 500
+	Free(block, a);
+	Free(block, c);
+	CHECK(3 == block.GetFreeRangeCount());
+
+	CHECK(0 == Allocate(block, 90).Offset);
+	CHECK(150 == Allocate(block, 250).Offset);
+	CHECK(500 == Allocate(block, 400).Offset);
+}
+
+TEST(MemoryBlock_BestFitAccountsForAlignment)
+{
+	MemoryBlock block(256);
+
+	Allocate(block, 4);
+	const auto x = Allocate(block, 72);
+	Allocate(block, 52);
+	const auto y = Allocate(block, 66);
+	Allocate(block, 62);
+
+	// 72 at 4 and 66 at 128, aligned to 16 the first one fits 60 exactly
+	Free(block, x);
+	Free(block, y);
+
+	CHECK(16 == Allocate(block, 60, 16).Offset);
+
+	// The padding in front of it is still free
+	CHECK(4 == Allocate(block, 12).Offset);
+	CHECK(128 == Allocate(block, 66).Offset);
+	CHECK(0 == block.GetFreeRangeCount());
+}
+
+TEST(MemoryBlock_Alignment)
+{
+	MemoryBlock block(4096);
+
+	Allocate(block, 10);
+
+	const auto aligned = Allocate(block, 64, 256);
+	CHECK(256 == aligned.Offset);
+
+	// The padding stays allocatable
+	CHECK(10 == Allocate(block, 200).Offset);
+
+	for (const VkDeviceSize alignment : { 1, 4, 16, 64, 256, 1024 })
+		CHECK(0 == Allocate(block, 3, alignment).Offset % alignment);
+
+	// 0 means no requirement
+	CHECK(block.Allocate(1, 0).has_value());
+}
+
+TEST(MemoryBlock_CoalesceLeft)
+{
+	MemoryBlock block(300);
+
+	const auto a = Allocate(block, 100);
+	const auto b = Allocate(block, 100);
+	Allocate(block, 100);
+
+	Free(block, a);
+	Free(block, b);
+
+	CHECK(1 == block.GetFreeRangeCount());
+	CHECK(200 == block.GetLargestFreeRange());
+	CHECK(0 == Allocate(block, 200).Offset);
+}
+
+TEST(MemoryBlock_CoalesceRight)
+{
+	MemoryBlock block(300);
+
+	const auto a = Allocate(block, 100);
+	const auto b = Allocate(block, 100);
+	Allocate(block, 100);
+
+	Free(block, b);
+	Free(block, a);
+
+	CHECK(1 == block.GetFreeRangeCount());
+	CHECK(200 == block.GetLargestFreeRange());
+	CHECK(0 == Allocate(block, 200).Offset);
+}
+
+TEST(MemoryBlock_CoalesceBoth)
+{
+	MemoryBlock block(300);
+
+	const auto a = Allocate(block, 100);
+	const auto b = Allocate(block, 100);
+	const auto c = Allocate(block, 100);
+
+	Free(block, a);
+	Free(block, c);
+	CHECK(2 == block.GetFreeRangeCount());
+
+	Free(block, b);
+	CHECK(1 == block.GetFreeRangeCount());
+	CHECK(300 == block.GetLargestFreeRange());
+	CHECK(block.IsEmpty());
+}
+
+TEST(MemoryBlock_Exhaustion)
+{
+	MemoryBlock block(256);
+
+	Allocate(block, 256);
+	CHECK(!block.Allocate(1, 1).has_value());
+	CHECK(0 == block.GetFreeRangeCount());
+
+	MemoryBlock fragmented(256);
+
+	Allocate(fragmented, 200);
+
+	// 56 bytes are free, but not once aligned
+	CHECK(!fragmented.Allocate(32, 64).has_value());
+	CHECK(!fragmented.Allocate(57, 1).has_value());
+	CHECK(fragmented.Allocate(56, 8).has_value());
+}
+
+TEST(MemoryBlock_EmptyAfterFreeingEverything)
+{
+	constexpr VkDeviceSize blockSize = 1 << 20;
+
+	MemoryBlock block(blockSize);
+
+	std::mt19937 random(1234);
+	std::vector<Range> ranges;
+
+	for (uint32_t round = 0; round < 8; round++)
+	{
+		// Fill it up with random sizes and alignments
+		while (true)
+		{
+			const VkDeviceSize size = 1 + random() % 4096;
+			const VkDeviceSize alignment = 1ull << (random() % 9);
+
+			const auto offset = block.Allocate(size, alignment);
+			if (!offset.has_value())
+				break;
+
+			CHECK(0 == offset.value() % alignment);
+			ranges.push_back({ offset.value(), size });
+		}
+
+		std::ranges::sort(ranges, {}, &Range::Offset);
+
+		for (size_t i = 1; i < ranges.size(); i++)
+			CHECK(ranges[i - 1].Offset + ranges[i - 1].Size <= ranges[i].Offset);
+
+		CHECK(ranges.back().Offset + ranges.back().Size <= blockSize);
+		CHECK(ranges.size() == block.GetAllocationCount());
+
+		// Free a random half, then the rest in the last round
+		std::ranges::shuffle(ranges, random);
+
+		const size_t keepCount = round < 7 ? ranges.size() / 2 : 0;
+
+		for (size_t i = keepCount; i < ranges.size(); i++)
+			Free(block, ranges[i]);
+
+		ranges.resize(keepCount);
+	}
+
+	CHECK(block.IsEmpty());
+	CHECK(0 == block.GetUsedSize());
+	CHECK(1 == block.GetFreeRangeCount());
+	CHECK(blockSize == block.GetLargestFreeRange());
+}
+
+TEST(MemoryBlock_NonCoherentRangesStayInside)
+{
+	constexpr VkDeviceSize atomSize = 64;
+
+	MemoryBlock block(1 << 16);
+
+	std::mt19937 random(4321);
+	std::vector<Range> ranges;
+
+	while (true)
+	{
+		VkDeviceSize size = 1 + random() % 300;
+		VkDeviceSize alignment = 1ull << (random() % 5);
+
+		const VkDeviceSize requestedSize = size;
+		AlignToAtom(size, alignment, atomSize);
+
+		const auto offset = block.Allocate(size, alignment);
+		if (!offset.has_value())
+			break;
+
+		// What a whole-allocation flush or invalidate expands to, see DeviceAllocator::GetNonCoherentRange()
+		const VkDeviceSize begin = offset.value() / atomSize * atomSize;
+		const VkDeviceSize end = (offset.value() + requestedSize + atomSize - 1) / atomSize * atomSize;
+
+		CHECK(begin >= offset.value());
+		CHECK(end <= offset.value() + size);
+
+		ranges.push_back({ offset.value(), size });
+	}
+
+	CHECK(ranges.size() > 1);
+
+	std::ranges::sort(ranges, {}, &Range::Offset);
+
+	for (size_t i = 1; i < ranges.size(); i++)
+		CHECK(ranges[i - 1].Offset + ranges[i - 1].Size <= ranges[i].Offset);
+}
@@ -0,0 +1,38 @@
+#include "Tests.h"
+
+static int s_FailureCount = 0;
+
+std::vector<TestCase>& GetTestCases()
+{
+	static std::vector<TestCase> testCases;
+
+	return testCases;
+}
+
+void ReportFailure(const char* condition, const char* file, int line)
+{
+	printf("\t%s(%i): CHECK(%s) failed\n", file, line, condition);
+
+	s_FailureCount++;
+}
+
+int main()
+{
+	int failedCount = 0;
+
+	for (const auto& testCase : GetTestCases())
+	{
+		const int failuresBefore = s_FailureCount;
+
+		testCase.Function();
+
+		const bool passed = s_FailureCount == failuresBefore;
+		failedCount += passed ? 0 : 1;
+
+		printf("[%s] %s\n", passed ? "PASSED" : "FAILED", testCase.Name);
+	}
+
+	printf("%zu tests, %i failed\n", GetTestCases().size(), failedCount);
+
+	return failedCount > 0 ? 1 : 0;
+}
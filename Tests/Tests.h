@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdio>
+#include <vector>
+
+// Minimal test runner, for the parts of Core that run without a GPU
+// Tests register themselves through TEST(), CHECK() reports the failure and keeps going
+
+struct TestCase
+{
+	const char* Name = nullptr;
+	void(*Function)() = nullptr;
+};
+
+std::vector<TestCase>& GetTestCases();
+void ReportFailure(const char* condition, const char* file, int line);
+
+struct TestRegistrar
+{
+	TestRegistrar(const char* name, void(*function)()) { GetTestCases().push_back({ name, function }); }
+};
+
+#define TEST(NAME) \
+static void NAME(); \
+static TestRegistrar NAME##Registrar(#NAME, NAME); \
+static void NAME()
+
+#define CHECK(COND) do { if (!(COND)) ReportFailure(#COND, __FILE__, __LINE__); } while (false)
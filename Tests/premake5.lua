@@ -0,0 +1,30 @@
+project "Tests"
+	kind "ConsoleApp"
+
+	targetdir ("%{wks.location}/bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("%{wks.location}/bin-int/" .. outputdir .. "/%{prj.name}")
+
+	files
+	{
+		"*.h",
+		"*.cpp"
+	}
+
+	includedirs
+	{
+		"%{wks.location}/Core/src"
+	}
+
+	links
+	{
+		"Core",
+	}
+
+	filter "system:windows"
+		systemversion "latest"
+
+	filter "configurations:Debug"
+		symbols "On"
+
+	filter "configurations:Release"
+		optimize "On"
@@ -40,9 +40,6 @@ IncludeDir["glslang"] = thirdparty .. "glslang/include"
 LibDir = {}
 LibDir["glslang"] = thirdparty .. "glslang/lib"
 
-BinDir = {}
-BinDir["glslang"] = thirdparty .. "glslang/bin"
-
 group "3rdparty"
 	include "3rdparty/glfw"
 	include "3rdparty/imgui"
@@ -62,4 +59,9 @@ group "Examples"
 	include "Examples/Triangle"
 	include "Examples/Cube"
 	include "Examples/Wireframe"
-group ""
\ No newline at end of file
+group ""
+
+group "Tests"
+	include "Tests"
+	include "Benchmarks"
+group ""